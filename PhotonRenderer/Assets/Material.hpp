@@ -5,8 +5,7 @@
 #include <glm/vec4.hpp>
 #include <string>
 #include <unordered_map>
-#include "Graphics/Shader.hpp"
-#include "Renderer/RenderData.hpp"
+#include "Renderer/MaterialTable.hpp"
 #include "Texture.hpp"
 
 namespace photon::asset {
@@ -28,8 +27,6 @@ struct MaterialFactors {
 };
 
 struct PBRMaterial {
-  void BindTextures(Ref<gl::ShaderProgram>& shader, PBRSamplerData& samplerData) const;
-
   std::unordered_map<PBRComponent, Ref<Texture2D>> textures;
   double metallicFactor{1.0};  // default 1
   double roughnessFactor{1.0};
@@ -41,5 +38,7 @@ struct PBRMaterial {
   int alphaMode{0};
   float alphaCutoff{0.5};
   std::string name;
+  // row in the MaterialTable, taken when first drawn; call slot.MarkChanged() after editing fields
+  mutable MaterialSlot slot;
 };
 }  // namespace photon::asset
@@ -1,41 +1,79 @@
 #include "Mesh.hpp"
+#include <algorithm>
+#include "Utils/MeshUtils.hpp"
+#include "Utils/ScratchArena.hpp"
 
 namespace photon::asset {
-Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+Mesh::Mesh(std::span<const Vertex> vertices, std::span<const uint32_t> indices)
     : numVertices(vertices.size()), numIndices(indices.size()) {
-  Setup(vertices, indices);
+  Setup(vertices.data(), indices.data());
 }
 
-Mesh::Mesh(const std::vector<Vertex>& vertices) : numVertices(vertices.size()), numIndices(0) {
-  Setup(vertices);
+Mesh::Mesh(std::span<const Vertex> vertices) : numVertices(vertices.size()), numIndices(0) {
+  Setup(vertices.data(), nullptr);
 }
 
-void Mesh::Setup(const std::vector<Vertex>& vertices) {
-  //  vao = std::make_unique<SimpleVAO>();
-  vao = gl::VertexArray::Create();
-  vao->Bind();
-  auto vbo = gl::VertexBuffer::Create(vertices.size() * sizeof(Vertex), vertices.data());
-  vbo->SetBufferView({
-      {"aPos", gl::BufferDataType::Vec3f},
-      {"aTexCoords", gl::BufferDataType::Vec2f},
-      {"aNormal", gl::BufferDataType::Vec3f},
-  });
-  vao->AttachVertexBuffer(vbo);
+Mesh::Mesh(std::span<const PackedVertex> vertices, const VertexQuantization& quantization,
+           std::span<const uint32_t> indices)
+    : numVertices(vertices.size()), numIndices(indices.size()), quantization(quantization) {
+  Upload(vertices.data(), indices.data());
 }
 
-void Mesh::Setup(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
-  vao = gl::VertexArray::Create();
-  vao->Bind();
-  auto vbo = gl::VertexBuffer::Create(vertices.size() * sizeof(Vertex), vertices.data());
-  vbo->SetBufferView({
-      {"aPos", gl::BufferDataType::Vec3f},
-      {"aTexCoords", gl::BufferDataType::Vec2f},
-      {"aNormal", gl::BufferDataType::Vec3f},
-  });
+Mesh::Mesh(GLsizei numVertices, GLsizei numIndices)
+    : numVertices(numVertices), numIndices(numIndices) {
+  Setup(nullptr, nullptr);
+}
+
+void Mesh::Setup(const Vertex* vertices, const uint32_t* indices) {
+  if (vertices == nullptr) {
+    Upload(nullptr, nullptr);
+    return;
+  }
+  util::ScratchArena scratch;
+  auto& packed = scratch.Vector<PackedVertex>();
+  quantization = util::PackVertices({vertices, static_cast<size_t>(numVertices)}, packed);
+  Upload(packed.data(), indices);
+}
+
+void Mesh::Upload(const PackedVertex* vertices, const uint32_t* indices) {
+  auto& pool = gl::GeometryPool::GetShared();
+  geometry   = pool.Allocate(numVertices, numIndices);
+  if (vertices != nullptr && numVertices > 0) {
+    pool.WriteVertices(geometry, vertices);
+  }
+  if (indices != nullptr && numIndices > 0) {
+    pool.WriteIndices(geometry, indices);
+  }
+}
+
+uint32_t Mesh::SelectLod(const glm::mat4& modelMatrix, const glm::mat4& viewMatrix,
+                         const glm::mat4& projMatrix, float viewportHeight, float maxPixelError,
+                         uint32_t current) const {
+  if (lods.size() < 2 || maxPixelError <= 0.0f) {
+    return 0;
+  }
+  // the sphere around the quantization bounds, which are the bounds of the vertices
+  const auto center = quantization.positionOffset + quantization.positionScale * 0.5f;
+  const float scale = std::max({glm::length(glm::vec3(modelMatrix[0])),
+                                glm::length(glm::vec3(modelMatrix[1])),
+                                glm::length(glm::vec3(modelMatrix[2]))});
+  const float radius        = glm::length(quantization.positionScale) * 0.5f * scale;
+  const float pixelsPerUnit =
+      GetPixelsPerUnit(viewMatrix, projMatrix, viewportHeight,
+                       glm::vec3(modelMatrix * glm::vec4(center, 1.0f)), radius);
+  // errors are in model units, the matrix scales them like the sphere
+  return photon::SelectLod(lods, pixelsPerUnit * scale, maxPixelError, current);
+}
+
+AABB Mesh::GetBounds() const {
+  return {quantization.positionOffset, quantization.positionOffset + quantization.positionScale};
+}
 
-  auto ibo = gl::IndexBuffer::Create(indices.size(), indices.data());
-  vao->AttachVertexBuffer(vbo);
-  vao->AttachIndexBuffer(ibo);
+uint32_t Mesh::GetNumTriangles(uint32_t lod) const {
+  if (lod < lods.size()) {
+    return lods[lod].numIndices / 3;
+  }
+  return static_cast<uint32_t>(numIndices != 0 ? numIndices : numVertices) / 3;
 }
 
-}  // namespace photon::asset
\ No newline at end of file
+}  // namespace photon::asset
@@ -2,27 +2,60 @@
 
 #include <glm/ext/matrix_float4x4.hpp>
 
+#include <span>
 #include <vector>
-#include "Graphics/VertexArray.hpp"
+#include "Graphics/GeometryPool.hpp"
 #include "Material.hpp"
+#include "Renderer/AABB.hpp"
+#include "Renderer/MeshLod.hpp"
+#include "Renderer/Meshlet.hpp"
 #include "Renderer/Vertex.hpp"
 
 namespace photon::asset {
 
 struct Mesh {
-  Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
-  explicit Mesh(const std::vector<Vertex>& vertices);
+  Mesh(std::span<const Vertex> vertices, std::span<const uint32_t> indices);
+  explicit Mesh(std::span<const Vertex> vertices);
+  /** Upload vertices packed ahead of time, indices may be empty. */
+  Mesh(std::span<const PackedVertex> vertices, const VertexQuantization& quantization,
+       std::span<const uint32_t> indices);
+  /** Allocate the pool ranges only, their PackedVertex contents and quantization come later. */
+  Mesh(GLsizei numVertices, GLsizei numIndices);
+  // owns its ranges of the geometry pool, so it is handed over rather than copied
+  Mesh(const Mesh&)            = delete;
+  Mesh& operator=(const Mesh&) = delete;
+  Mesh(Mesh&&)                 = default;
 
   const GLsizei numVertices;
   const GLsizei numIndices;
 
-  Ref<gl::VertexArray> vao;
-  glm::mat4 modelMatrix{1.0f};
+  // where the vertices and indices live in gl::GeometryPool::GetShared(), indices are relative
+  // to the base vertex
+  gl::GeometryAllocation geometry;
+  // the pool holds PackedVertex, this decodes it
+  VertexQuantization quantization;
   PBRMaterial material;
+  // levels of detail inside the index buffer, empty when the whole buffer is one level
+  std::vector<MeshLod> lods;
+  // clusters of the full level, for drawing it with cluster culling
+  std::vector<Meshlet> meshlets;
+
+  /**
+   * Pick the level to draw under modelMatrix from the projected size of the bounding sphere, with
+   * hysteresis around current, the level picked last frame. A maxPixelError of 0 draws the full
+   * mesh.
+   */
+  uint32_t SelectLod(const glm::mat4& modelMatrix, const glm::mat4& viewMatrix,
+                     const glm::mat4& projMatrix, float viewportHeight, float maxPixelError,
+                     uint32_t current) const;
+  /** Bounds of the vertices in model space, which are the quantization bounds. */
+  [[nodiscard]] AABB GetBounds() const;
+  /** Triangles drawn at a level. */
+  [[nodiscard]] uint32_t GetNumTriangles(uint32_t lod) const;
 
 private:
-  void Setup(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
-  void Setup(const std::vector<Vertex>& vertices);
+  void Setup(const Vertex* vertices, const uint32_t* indices);
+  void Upload(const PackedVertex* vertices, const uint32_t* indices);
 };
 
 }  // namespace photon::asset
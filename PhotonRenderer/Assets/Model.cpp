@@ -1,5 +1,6 @@
 #include "Model.hpp"
 #include <glm/gtc/matrix_transform.hpp>
+#include <numeric>
 #include "Common/Logging.hpp"
 
 namespace photon::asset {
@@ -7,30 +8,92 @@ namespace photon::asset {
 Model::Model(const std::string& name, const std::vector<Vertex>& vertices,
              const std::vector<GLuint>& indices)
     : m_name(name) {
-  m_meshes.emplace_back(vertices, indices);
+  AttachMesh(Mesh(vertices, indices));
   LOGI("Model {}: {} vertices, {} indices", name, vertices.size(), indices.size());
 }
 
 Model::Model(const std::string& name, const std::vector<Vertex>& vertices) : m_name(name) {
   LOGI("Model {}: {} vertices", name, vertices.size());
-  m_meshes.emplace_back(vertices);
+  AttachMesh(Mesh(vertices));
 }
 
-void Model::Translate(const glm::vec3& targetPos) {
-  glm::vec3 delta = targetPos - m_aabb.GetCenter();
-  for (auto& mesh : m_meshes) {
-    auto translation = glm::translate(glm::mat4(1.0), delta);
-    mesh.modelMatrix = translation * mesh.modelMatrix;
+void Model::AttachMesh(Mesh&& mesh) {
+  auto& instance = m_instances.emplace_back();
+  instance.mesh  = static_cast<uint32_t>(m_meshes.size());
+  instance.aabb  = mesh.GetBounds();
+  m_batches.push_back({instance.mesh, static_cast<uint32_t>(m_instances.size() - 1), 1});
+  m_meshes.push_back(std::move(mesh));
+  RefitBounds();
+}
+
+void Model::SetMeshes(std::vector<Mesh> meshes, std::vector<MeshInstance> instances) {
+  m_meshes = std::move(meshes);
+  if (instances.empty()) {
+    for (uint32_t i = 0; i < m_meshes.size(); i++) {
+      instances.emplace_back().mesh = i;
+    }
+  }
+  // group by mesh with a counting sort, linear in the number of instances
+  std::vector<uint32_t> offsets(m_meshes.size() + 1, 0);
+  for (const auto& instance : instances) {
+    if (instance.mesh < m_meshes.size()) {
+      offsets[instance.mesh + 1]++;
+    }
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  m_instances.resize(offsets.back());
+  std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+  for (const auto& instance : instances) {
+    if (instance.mesh < m_meshes.size()) {
+      auto& target = m_instances[cursor[instance.mesh]++];
+      target       = instance;
+      target.aabb  = m_meshes[instance.mesh].GetBounds().Transform(instance.modelMatrix);
+    }
   }
+  m_batches.clear();
+  for (uint32_t i = 0; i < m_meshes.size(); i++) {
+    if (offsets[i + 1] > offsets[i]) {
+      m_batches.push_back({i, offsets[i], offsets[i + 1] - offsets[i]});
+    }
+  }
+  RefitBounds();
+}
 
-  m_aabb.Translate(targetPos);
+void Model::ReplaceProxy(std::vector<Mesh> meshes, std::vector<MeshInstance> instances) {
+  const glm::mat4 transform = m_instances.empty() ? glm::mat4(1.0f) : m_instances[0].modelMatrix;
+  SetMeshes(std::move(meshes), std::move(instances));
+  TransformInstances(transform);
 }
 
-void Model::Rotate(float angle) {
-  for (auto& mesh : m_meshes) {
-    mesh.modelMatrix =
-        glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f)) * mesh.modelMatrix;
+void Model::TransformInstances(const glm::mat4& transform) {
+  for (auto& instance : m_instances) {
+    instance.modelMatrix = transform * instance.modelMatrix;
+    instance.aabb        = m_meshes[instance.mesh].GetBounds().Transform(instance.modelMatrix);
+  }
+  RefitBounds();
+}
+
+void Model::RefitBounds() {
+  m_instanceBounds.Clear();
+  if (m_instances.empty()) {
+    return;
+  }
+  AABB bounds = m_instances[0].aabb;
+  for (const auto& instance : m_instances) {
+    m_instanceBounds.Add(instance.aabb);
+    bounds.posMin = glm::min(bounds.posMin, instance.aabb.posMin);
+    bounds.posMax = glm::max(bounds.posMax, instance.aabb.posMax);
   }
+  m_aabb = {bounds.posMin, bounds.posMax};
+}
+
+void Model::Translate(const glm::vec3& targetPos) {
+  glm::vec3 delta = targetPos - m_aabb.GetCenter();
+  TransformInstances(glm::translate(glm::mat4(1.0), delta));
+}
+
+void Model::Rotate(float angle) {
+  TransformInstances(glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f)));
 }
 
 void Model::Rotate(float angle, const glm::vec3& point) {
@@ -38,18 +101,10 @@ void Model::Rotate(float angle, const glm::vec3& point) {
   auto r  = glm::rotate(glm::mat4(1), angle, glm::vec3(0.0f, 1.0f, 0.0f));
   auto t2 = glm::translate(glm::mat4(1), point);
   auto T  = t2 * r * t1;
-  for (auto& mesh : m_meshes) {
-    mesh.modelMatrix = T * mesh.modelMatrix;
-  }
-  m_aabb.posMin = T * glm::vec4(m_aabb.posMin, 0.0f);
-  m_aabb.posMax = T * glm::vec4(m_aabb.posMax, 0.0f);
+  TransformInstances(T);
 }
 
 void Model::Scale(float factor) {
-  for (auto& mesh : m_meshes) {
-    const auto scale = glm::scale(glm::mat4(1.0f), glm::vec3(factor));
-    mesh.modelMatrix = scale * mesh.modelMatrix;
-  }
-  m_aabb.Scale(factor);
+  TransformInstances(glm::scale(glm::mat4(1.0f), glm::vec3(factor)));
 }
 }  // namespace photon::asset
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <span>
 #include <string>
+#include <vector>
 #include "Mesh.hpp"
 #include "Renderer/AABB.hpp"
+#include "Renderer/MeshInstance.hpp"
 
 namespace photon::asset {
 class Model {
@@ -14,8 +17,25 @@ public:
 
   Model(const std::string& name, const std::vector<Vertex>& vertices);
   [[nodiscard]] const std::vector<Mesh>& GetMeshes() const { return m_meshes; };
+  /** Instances grouped by mesh, mutable for the level of detail each view remembers. */
+  [[nodiscard]] std::span<MeshInstance> GetInstances() { return m_instances; }
+  [[nodiscard]] std::span<const MeshInstance> GetInstances() const { return m_instances; }
+  [[nodiscard]] const std::vector<InstanceBatch>& GetBatches() const { return m_batches; }
+  /** World bounds of the instances in their order, for culling many at a time. */
+  [[nodiscard]] const AABBArray& GetInstanceBounds() const { return m_instanceBounds; }
 
-  void AttachMesh(const Mesh& mesh) { m_meshes.push_back(mesh); }
+  /** Add a mesh drawn once, where its vertices are. */
+  void AttachMesh(Mesh&& mesh);
+  /**
+   * Take the meshes and their instances, which may come in any order. Without instances every
+   * mesh is drawn once, where its vertices are.
+   */
+  void SetMeshes(std::vector<Mesh> meshes, std::vector<MeshInstance> instances);
+  /**
+   * Swap the bounding-box proxy of a streamed model for its real meshes, carrying over whatever
+   * transform the proxy was given in the meantime. The bounds are refit to the real instances.
+   */
+  void ReplaceProxy(std::vector<Mesh> meshes, std::vector<MeshInstance> instances);
 
   void SetAABB(const AABB& aabb) { m_aabb = aabb; }
 
@@ -33,8 +53,16 @@ public:
   PBRMaterial& GetSingleMeshMaterial() { return m_meshes[0].material; }
 
 private:
+  /** Apply a transform to every instance and refit their bounds. */
+  void TransformInstances(const glm::mat4& transform);
+  /** Copy the instance bounds into their arrays, the model's box becomes the union of them. */
+  void RefitBounds();
+
   std::string m_name;
   std::vector<Mesh> m_meshes;
+  std::vector<MeshInstance> m_instances;
+  std::vector<InstanceBatch> m_batches;
+  AABBArray m_instanceBounds;
   AABB m_aabb{};
 };
 
@@ -1,8 +1,39 @@
 #include "Texture.hpp"
 #include <stb_image.h>
+#include <algorithm>
+#include <utility>
 #include "Common/Logging.hpp"
+#include "Graphics/StateCache.hpp"
 
 namespace photon::asset {
+namespace {
+// drivers pad three-component formats to four
+uint64_t GetTexelSize(GLenum internalFormat) {
+  switch (internalFormat) {
+    case GL_R8:
+      return 1;
+    case GL_RG8:
+      return 2;
+    case GL_RGB16F:
+    case GL_RGBA16F:
+      return 8;
+    case GL_RGB32F:
+    case GL_RGBA32F:
+      return 16;
+    default:
+      return 4;
+  }
+}
+
+int GetNumMipLevels(int width, int height) {
+  int levels = 1;
+  while ((std::max(width, height) >> levels) > 0) {
+    levels++;
+  }
+  return levels;
+}
+}  // namespace
+
 Texture2D::Texture2D(const std::string& path) {
   m_internalFormat = GL_RGBA8;
   m_dataFormat     = GL_RGBA;
@@ -24,6 +55,7 @@ Texture2D::Texture2D(const std::string& path) {
     }
     glCreateTextures(GL_TEXTURE_2D, 1, &m_id);
     glTextureStorage2D(m_id, 1, m_internalFormat, m_width, m_height);
+    m_memorySize = static_cast<uint64_t>(m_width) * m_height * GetTexelSize(m_internalFormat);
 
     glTextureParameteri(m_id, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTextureParameteri(m_id, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -32,6 +64,8 @@ Texture2D::Texture2D(const std::string& path) {
 
     glTextureSubImage2D(m_id, 0, 0, 0, m_width, m_height, m_dataFormat, GL_UNSIGNED_BYTE, data);
     //    glGenerateTextureMipmap(m_id);
+    m_handle = glGetTextureHandleARB(m_id);
+    glMakeTextureHandleResidentARB(m_handle);
 
     stbi_image_free(data);
   } else {
@@ -45,8 +79,14 @@ Texture2D::Texture2D(const TextureInfo& info, const void* data) {
   m_width          = info.width;
   m_height         = info.height;
 
+  // room for the mip chain glGenerateTextureMipmap fills in
+  const int levels = info.generateMipmap ? GetNumMipLevels(m_width, m_height) : 1;
   glCreateTextures(GL_TEXTURE_2D, 1, &m_id);
-  glTextureStorage2D(m_id, 1, m_internalFormat, m_width, m_height);
+  glTextureStorage2D(m_id, levels, m_internalFormat, m_width, m_height);
+  m_memorySize = static_cast<uint64_t>(m_width) * m_height * GetTexelSize(m_internalFormat);
+  if (levels > 1) {
+    m_memorySize = m_memorySize * 4 / 3;
+  }
 
   glTextureParameteri(m_id, GL_TEXTURE_WRAP_S, info.wrapS);
   glTextureParameteri(m_id, GL_TEXTURE_WRAP_T, info.wrapT);
@@ -54,30 +94,79 @@ Texture2D::Texture2D(const TextureInfo& info, const void* data) {
   glTextureParameteri(m_id, GL_TEXTURE_MIN_FILTER, info.minFilter);
   glTextureParameteri(m_id, GL_TEXTURE_MAG_FILTER, info.magFilter);
 
-  glTextureSubImage2D(m_id, 0, 0, 0, m_width, m_height, m_dataFormat, info.dataType, data);
-  if (info.generateMipmap) {
-    glGenerateTextureMipmap(m_id);
+  if (data != nullptr) {
+    glTextureSubImage2D(m_id, 0, 0, 0, m_width, m_height, m_dataFormat, info.dataType, data);
+    if (info.generateMipmap) {
+      glGenerateTextureMipmap(m_id);
+    }
   }
 
   m_handle = glGetTextureHandleARB(m_id);
   glMakeTextureHandleResidentARB(m_handle);
 }
 
-Ref<Texture2D> Texture2D::CreateDefaultWhite() {
-  return std::make_shared<Texture2D>("Data/Textures/white.png");
+Texture2D::Texture2D(const TextureInfo& info, std::span<const TextureLevel> levels,
+                     const void* data) {
+  m_internalFormat = info.internalFormat;
+  m_dataFormat     = info.dataFormat;
+  m_width          = info.width;
+  m_height         = info.height;
+
+  glCreateTextures(GL_TEXTURE_2D, 1, &m_id);
+  glTextureStorage2D(m_id, static_cast<GLsizei>(levels.size()), m_internalFormat, m_width,
+                     m_height);
+
+  glTextureParameteri(m_id, GL_TEXTURE_WRAP_S, info.wrapS);
+  glTextureParameteri(m_id, GL_TEXTURE_WRAP_T, info.wrapT);
+  glTextureParameteri(m_id, GL_TEXTURE_MIN_FILTER, info.minFilter);
+  glTextureParameteri(m_id, GL_TEXTURE_MAG_FILTER, info.magFilter);
+
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  for (size_t level = 0; level < levels.size(); level++) {
+    const auto& mip = levels[level];
+    if (bytes != nullptr) {
+      glCompressedTextureSubImage2D(m_id, static_cast<GLint>(level), 0, 0, mip.width, mip.height,
+                                    m_internalFormat, static_cast<GLsizei>(mip.size),
+                                    bytes + mip.offset);
+    }
+    m_memorySize += mip.size;
+  }
+
+  m_handle = glGetTextureHandleARB(m_id);
+  glMakeTextureHandleResidentARB(m_handle);
 }
 
 Texture2D::~Texture2D() {
+  Evict();
+}
+
+void Texture2D::Evict() {
   if (m_handle != 0) {
     glMakeTextureHandleNonResidentARB(m_handle);
     m_handle = 0;
   }
   if (m_id != 0) {
+    gl::StateCache::GetShared().ForgetTexture(m_id);
     glDeleteTextures(1, &m_id);
+    m_id = 0;
   }
 }
+
+void Texture2D::Swap(Texture2D& other) noexcept {
+  std::swap(m_id, other.m_id);
+  std::swap(m_handle, other.m_handle);
+  std::swap(m_memorySize, other.m_memorySize);
+  std::swap(m_width, other.m_width);
+  std::swap(m_height, other.m_height);
+  std::swap(m_internalFormat, other.m_internalFormat);
+  std::swap(m_dataFormat, other.m_dataFormat);
+}
 void Texture2D::Bind(GLenum slot) const {
-  glBindTextureUnit(slot, m_id);
+  gl::StateCache::GetShared().BindTextureUnit(slot, m_id);
+}
+
+void Texture2D::GenerateMipmap() const {
+  glGenerateTextureMipmap(m_id);
 }
 
 Ref<TextureCubeMap> TextureCubeMap::Create(const TextureInfo& info,
@@ -121,11 +210,12 @@ TextureCubeMap::TextureCubeMap(const TextureInfo& info,
 }
 
 void TextureCubeMap::Bind(GLenum slot) const {
-  glBindTextureUnit(slot, m_id);
+  gl::StateCache::GetShared().BindTextureUnit(slot, m_id);
 }
 
 TextureCubeMap::~TextureCubeMap() {
   if (m_id != 0) {
+    gl::StateCache::GetShared().ForgetTexture(m_id);
     glDeleteTextures(1, &m_id);
   }
 }
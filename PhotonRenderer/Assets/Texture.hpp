@@ -1,5 +1,6 @@
 #pragma once
 #include <glad/glad.h>
+#include <span>
 #include <string>
 #include "Common/Base.hpp"
 
@@ -17,27 +18,51 @@ struct TextureInfo {
   GLenum dataFormat{GL_RGBA};
   GLenum dataType{GL_UNSIGNED_BYTE};
 };
+/** One level of a block-compressed mip chain, stored at offset inside the chain's data. */
+struct TextureLevel {
+  int width{0};
+  int height{0};
+  size_t offset{0};
+  size_t size{0};
+};
+
 class Texture2D {
 public:
   static Ref<Texture2D> Create(const TextureInfo& info, const void* data) {
     return CreateRef<Texture2D>(info, data);
   }
-
-  static Ref<Texture2D> CreateDefaultWhite();
+  static Ref<Texture2D> Create(const TextureInfo& info, std::span<const TextureLevel> levels,
+                               const void* data) {
+    return CreateRef<Texture2D>(info, levels, data);
+  }
 
   explicit Texture2D(const std::string& path);
+  /** Without data only the storage is allocated, for the contents to be streamed in later. */
   Texture2D(const TextureInfo& info, const void* data);
+  /** Block-compressed levels in info.internalFormat, without data only the storage is allocated. */
+  Texture2D(const TextureInfo& info, std::span<const TextureLevel> levels, const void* data);
   ~Texture2D();
 
   void Bind(GLenum slot) const;
+  void GenerateMipmap() const;
 
   uint32_t GetId() const { return m_id; }
 
   GLuint64 GetHandle() const { return m_handle; }
+  /** False once evicted, the handle is 0 then and the object can only be refilled with Swap. */
+  bool IsResident() const { return m_handle != 0; }
+  /** Make the handle non-resident and free the video memory, keeping the description. */
+  void Evict();
+  /** Exchange GL objects with other, how an evicted texture is refilled. */
+  void Swap(Texture2D& other) noexcept;
+
+  /** Video memory taken by every level, estimated from the internal format. */
+  uint64_t GetMemorySize() const { return m_memorySize; }
 
 private:
   uint32_t m_id{0};
   GLuint64 m_handle{0};
+  uint64_t m_memorySize{0};
   int m_width;
   int m_height;
   GLenum m_internalFormat, m_dataFormat;
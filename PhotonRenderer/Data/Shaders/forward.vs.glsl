@@ -1,12 +1,15 @@
 #version 450 core
+#extension GL_ARB_shader_draw_parameters : require
+// PackedVertex: unorm16 position and uv within the mesh bounds, snorm16 octahedral normal
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoords;
-layout (location = 2) in vec3 aNormal;
+layout (location = 2) in vec2 aNormal;
 
 out vec3 vWorldSpacePos;
 out vec4 vLightSpacePos;
 out vec3 vWorldSpaceNormal;
 out vec2 vTexCoords;
+flat out uint vMaterialIndex;
 
 layout(std140, binding = 0) uniform Camera
 {
@@ -14,17 +17,40 @@ layout(std140, binding = 0) uniform Camera
     mat4 uView;
     mat4 uProjection;
 };
-layout(std140, binding = 1) uniform Model
+// DrawData, one per draw of the list, found at the base instance of its commands
+struct Draw
 {
-    mat4 uModel;
+    mat4 model;
+    mat3 normalMatrix;
+    vec4 positionOffset;
+    vec4 positionScale;
+    vec4 texCoordTransform;
+    uint materialIndex;
+};
+layout(std430, binding = 0) readonly buffer Draws
+{
+    Draw uDraws[];
 };
 uniform mat4 uLightSpaceMat;
 
+vec3 octahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
 void main()
 {
-    vWorldSpaceNormal = vec3((transpose(inverse(uModel))) * vec4(aNormal, 0.0));
-    vWorldSpacePos = vec3(uModel * vec4(aPos, 1.0));
-    vTexCoords = aTexCoords;
+    Draw draw = uDraws[gl_BaseInstanceARB];
+    vec3 position = draw.positionOffset.xyz + draw.positionScale.xyz * aPos;
+    vec3 normal = octahedralDecode(aNormal);
+    vWorldSpaceNormal = draw.normalMatrix * normal;
+    vWorldSpacePos = vec3(draw.model * vec4(position, 1.0));
+    vTexCoords = draw.texCoordTransform.xy + draw.texCoordTransform.zw * aTexCoords;
+    vMaterialIndex = draw.materialIndex;
     vLightSpacePos = uLightSpaceMat * vec4(vWorldSpacePos, 1.0);
     gl_Position = uProjView * vec4(vWorldSpacePos, 1.0);
 }
\ No newline at end of file
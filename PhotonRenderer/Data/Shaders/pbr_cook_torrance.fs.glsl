@@ -4,12 +4,19 @@
 */
 #version 450 core
 #extension GL_ARB_bindless_texture: require
+// one multi-draw packs triangles of different draws into a wave, so the material index, flat as
+// it is, is not dynamically uniform and neither are the handles read with it. Bindless sampling
+// with such handles is only defined under NV_gpu_shader5, elsewhere this relies on the driver.
+#ifdef GL_NV_gpu_shader5
+#extension GL_NV_gpu_shader5: enable
+#endif
 out vec4 fColor;
 
 in vec3 vWorldSpacePos;
 in vec4 vLightSpacePos;
 in vec3 vWorldSpaceNormal;
 in vec2 vTexCoords;
+flat in uint vMaterialIndex;
 
 // scene data
 uniform vec3 uLightPos;
@@ -18,26 +25,24 @@ uniform vec3 uLightIntensity;
 uniform int uLightType;
 uniform vec3 uCameraPos;
 
-// pbr textures
-uniform int uAlphaMode;
-uniform float uAlphaCutoff;
-
-uniform bool uHasBaseColorMap;
-uniform bool uHasMetallicRoughnessMap;
-uniform bool uHasEmissiveMap;
-uniform bool uHasOcclusionMap;
-uniform bool uHasNormalMap;
-
-uniform vec4 uBaseColorFactor;
-uniform float uMetallicFactor;
-uniform float uRoughnessFactor;
-uniform vec3 uEmissiveFactor;
-uniform float uOcclusionStrength;
-
-
-// --------- bindless texture ---------------
-layout (binding = 2) uniform PBRSamplers {
-    sampler2D uPBRSamplers[5];
+// MaterialData, indexed by the material of the draw
+struct Material
+{
+    vec4 baseColorFactor;
+    vec3 emissiveFactor;
+    float occlusionStrength;
+    float metallicFactor;
+    float roughnessFactor;
+    float alphaCutoff;
+    int alphaMode;
+    uint textureMask;
+    uint padding;
+    // bindless handles
+    uvec2 textures[5];
+};
+layout(std430, binding = 1) readonly buffer Materials
+{
+    Material uMaterials[];
 };
 
 // IBL
@@ -52,6 +57,14 @@ layout (binding = 6) uniform sampler2D uShadowMap;
 #define TEX_OCCLUSION_INDEX 3
 #define TEX_NORMAL_INDEX 4
 
+bool hasTexture(int index) {
+    return (uMaterials[vMaterialIndex].textureMask & (1u << index)) != 0u;
+}
+
+sampler2D pbrSampler(int index) {
+    return sampler2D(uMaterials[vMaterialIndex].textures[index]);
+}
+
 #define ALPHAMODE_OPAQUE 0
 #define ALPHAMODE_BLEND 1
 #define ALPHAMODE_MASK 2
@@ -62,7 +75,6 @@ layout (binding = 6) uniform sampler2D uShadowMap;
 #define RECIPROCAL_PI 0.3183098861837907
 #define PI 3.1415926535897932384626433832795
 
-const float GAMMA = 2.2;
 const float irradiPerp = 1.0;
 const float reflectance = 0.5;
 
@@ -155,10 +167,6 @@ vec2 directionToSphericalEnvmap(vec3 dir) {
     float t = 1.0 - theta / PI;
     return vec2(s, t);
 }
-vec4 sRGBToLinear(vec4 srgbIn)
-{
-    return vec4(pow(srgbIn.xyz, vec3(GAMMA)), srgbIn.w);
-}
 // from http://www.thetenthplanet.de/archives/1180
 mat3 cotangentFrame(in vec3 N, in vec3 p, in vec2 uv)
 {
@@ -181,8 +189,11 @@ mat3 cotangentFrame(in vec3 N, in vec3 p, in vec2 uv)
 
 vec3 applyNormalMap(in vec3 normal, in vec3 viewVec, in vec2 texcoord)
 {
-    vec3 highResNormal = texture(uPBRSamplers[TEX_NORMAL_INDEX], texcoord).xyz;
-    highResNormal = normalize(highResNormal * 2.0 - 1.0);
+    // only x and y are read, BC5 normal maps store two channels and z is rebuilt from them
+    vec3 highResNormal;
+    highResNormal.xy = texture(pbrSampler(TEX_NORMAL_INDEX), texcoord).xy * 2.0 - 1.0;
+    highResNormal.z = sqrt(max(0.0, 1.0 - dot(highResNormal.xy, highResNormal.xy)));
+    highResNormal = normalize(highResNormal);
     mat3 TBN = cotangentFrame(normal, -viewVec, texcoord);
     return normalize(TBN * highResNormal);
 }
@@ -263,9 +274,10 @@ vec3 specularIBL(vec3 F0, float roughness, vec3 N, vec3 V) {
 }
 
 void main() {
+    Material material = uMaterials[vMaterialIndex];
     vec3 N = normalize(vWorldSpaceNormal);
     vec3 V = normalize(uCameraPos - vWorldSpacePos);
-    if (uHasNormalMap) {
+    if (hasTexture(TEX_NORMAL_INDEX)) {
         N = applyNormalMap(N, V, vTexCoords);
     }
     vec3 L;
@@ -279,26 +291,27 @@ void main() {
 
     vec3 H = normalize(L + V);
 
-    vec4 baseColor = uBaseColorFactor;
-    float roughness = uRoughnessFactor;
-    float metallic = uMetallicFactor;
-    vec3 radiance = uEmissiveFactor;
+    vec4 baseColor = material.baseColorFactor;
+    float roughness = material.roughnessFactor;
+    float metallic = material.metallicFactor;
+    vec3 radiance = material.emissiveFactor;
 
-    if (uHasBaseColorMap) {
-        baseColor *= sRGBToLinear(texture(uPBRSamplers[TEX_BASECOLOR_INDEX], vTexCoords));
+    if (hasTexture(TEX_BASECOLOR_INDEX)) {
+        // sRGB textures, the sampler returns linear values
+        baseColor *= texture(pbrSampler(TEX_BASECOLOR_INDEX), vTexCoords);
     }
 
-    if (uHasMetallicRoughnessMap) {
+    if (hasTexture(TEX_METALLICROUGHNESS_INDEX)) {
         // https://github.com/KhronosGroup/glTF/blob/master/specification/2.0/README.md#pbrmetallicroughnessmetallicroughnesstexture
         // "The metallic-roughness texture.The metalness values are sampled from the B
         // channel.The roughness values are sampled from the G channel."
-        vec4 metallicRougnessFromTexture = texture(uPBRSamplers[TEX_METALLICROUGHNESS_INDEX], vTexCoords);
+        vec4 metallicRougnessFromTexture = texture(pbrSampler(TEX_METALLICROUGHNESS_INDEX), vTexCoords);
         metallic *= metallicRougnessFromTexture.b;
         roughness *= metallicRougnessFromTexture.g;
     }
 
-    if (uHasEmissiveMap) {
-        radiance *= sRGBToLinear(texture(uPBRSamplers[TEX_EMISSIVE_INDEX], vTexCoords)).rgb;
+    if (hasTexture(TEX_EMISSIVE_INDEX)) {
+        radiance *= texture(pbrSampler(TEX_EMISSIVE_INDEX), vTexCoords).rgb;
     }
 
 
@@ -332,15 +345,15 @@ void main() {
     vec3 IBL_Diffuse = rhoD * texture(uEnvDiffuseSampler, N).rgb;
     // IBL Specular
     vec3 IBL_Specular = specularIBL(F0, roughness, N, V);
-    if (uHasOcclusionMap) {
-        float ao = texture(uPBRSamplers[TEX_OCCLUSION_INDEX], vTexCoords).r;
-        radiance = mix(radiance, radiance * ao, uOcclusionStrength);
+    if (hasTexture(TEX_OCCLUSION_INDEX)) {
+        float ao = texture(pbrSampler(TEX_OCCLUSION_INDEX), vTexCoords).r;
+        radiance = mix(radiance, radiance * ao, material.occlusionStrength);
     }
     vec3 finalColor = IBL_Diffuse + IBL_Specular + radiance;
-    if (uAlphaMode == ALPHAMODE_OPAQUE) {
+    if (material.alphaMode == ALPHAMODE_OPAQUE) {
         baseColor.a = 1.0;
-    } else if (uAlphaMode == ALPHAMODE_MASK) {
-        if (baseColor.a < uAlphaCutoff) {
+    } else if (material.alphaMode == ALPHAMODE_MASK) {
+        if (baseColor.a < material.alphaCutoff) {
             discard;
         }
         baseColor.a = 1.0;
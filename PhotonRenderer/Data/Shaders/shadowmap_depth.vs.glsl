@@ -1,10 +1,26 @@
 #version 450 core
+#extension GL_ARB_shader_draw_parameters : require
 layout (location = 0) in vec3 aPos;
 
 uniform mat4 uLightSpaceMat;
-uniform mat4 uModelMat;
+// DrawData, only the transform and the unorm16 position bounds are read here
+struct Draw
+{
+    mat4 model;
+    mat3 normalMatrix;
+    vec4 positionOffset;
+    vec4 positionScale;
+    vec4 texCoordTransform;
+    uint materialIndex;
+};
+layout(std430, binding = 0) readonly buffer Draws
+{
+    Draw uDraws[];
+};
 
 void main()
 {
-    gl_Position = uLightSpaceMat * uModelMat * vec4(aPos, 1.0);
+    Draw draw = uDraws[gl_BaseInstanceARB];
+    vec3 position = draw.positionOffset.xyz + draw.positionScale.xyz * aPos;
+    gl_Position = uLightSpaceMat * draw.model * vec4(position, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "AABBTree.hpp"
+
+namespace photon {
+namespace {
+float SurfaceArea(const glm::vec3& min, const glm::vec3& max) {
+  const auto size = max - min;
+  return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+}  // namespace
+
+uint32_t AABBTree::Insert(const AABB& box, uint32_t userData) {
+  const auto leaf = AllocateNode();
+  auto& node      = m_nodes[leaf];
+  node.min        = box.posMin;
+  node.max        = box.posMax;
+  node.userData   = userData;
+  InsertLeaf(leaf);
+  m_numProxies++;
+  return leaf;
+}
+
+void AABBTree::Remove(uint32_t proxy) {
+  RemoveLeaf(proxy);
+  FreeNode(proxy);
+  m_numProxies--;
+}
+
+void AABBTree::Update(uint32_t proxy, const AABB& box) {
+  const auto parent = m_nodes[proxy].parent;
+  if (parent != Null && glm::all(glm::greaterThanEqual(box.posMin, m_nodes[parent].min)) &&
+      glm::all(glm::lessThanEqual(box.posMax, m_nodes[parent].max))) {
+    m_nodes[proxy].min = box.posMin;
+    m_nodes[proxy].max = box.posMax;
+    // the ancestors can only shrink, up to the first one that does not
+    for (auto index = parent; index != Null; index = m_nodes[index].parent) {
+      const auto min = m_nodes[index].min;
+      const auto max = m_nodes[index].max;
+      Refit(index);
+      if (m_nodes[index].min == min && m_nodes[index].max == max) {
+        break;
+      }
+    }
+    return;
+  }
+  RemoveLeaf(proxy);
+  m_nodes[proxy].min = box.posMin;
+  m_nodes[proxy].max = box.posMax;
+  InsertLeaf(proxy);
+}
+
+void AABBTree::Clear() {
+  m_nodes.clear();
+  m_root       = Null;
+  m_freeList   = Null;
+  m_numProxies = 0;
+}
+
+AABB AABBTree::GetBounds() const {
+  if (m_root == Null) {
+    return {glm::vec3(0.0f), glm::vec3(0.0f)};
+  }
+  return {m_nodes[m_root].min, m_nodes[m_root].max};
+}
+
+AABB AABBTree::GetAABB(uint32_t proxy) const {
+  return {m_nodes[proxy].min, m_nodes[proxy].max};
+}
+
+uint32_t AABBTree::AllocateNode() {
+  if (m_freeList == Null) {
+    m_nodes.emplace_back();
+    return static_cast<uint32_t>(m_nodes.size() - 1);
+  }
+  const auto index = m_freeList;
+  m_freeList       = m_nodes[index].parent;
+  m_nodes[index]   = {};
+  return index;
+}
+
+void AABBTree::FreeNode(uint32_t index) {
+  m_nodes[index].parent = m_freeList;
+  m_nodes[index].height = -1;
+  m_freeList            = index;
+}
+
+void AABBTree::InsertLeaf(uint32_t leaf) {
+  if (m_root == Null) {
+    m_root               = leaf;
+    m_nodes[leaf].parent = Null;
+    return;
+  }
+  const auto leafMin = m_nodes[leaf].min;
+  const auto leafMax = m_nodes[leaf].max;
+  // area a child would add, a leaf becomes a new branch and a branch grows to take the box
+  const auto childCost = [&](uint32_t child) {
+    const auto& node = m_nodes[child];
+    const auto area  = SurfaceArea(glm::min(leafMin, node.min), glm::max(leafMax, node.max));
+    return node.IsLeaf() ? area : area - SurfaceArea(node.min, node.max);
+  };
+  // descend to the sibling with the least area added on the way down
+  auto index = m_root;
+  while (!m_nodes[index].IsLeaf()) {
+    const auto& node         = m_nodes[index];
+    const float area         = SurfaceArea(node.min, node.max);
+    const float combinedArea =
+        SurfaceArea(glm::min(leafMin, node.min), glm::max(leafMax, node.max));
+    // a new parent of this node and the leaf
+    const float cost = 2.0f * combinedArea;
+    // what going further down adds to this node at least
+    const float inheritedCost = 2.0f * (combinedArea - area);
+    const float leftCost      = childCost(node.left) + inheritedCost;
+    const float rightCost     = childCost(node.right) + inheritedCost;
+    if (cost < leftCost && cost < rightCost) {
+      break;
+    }
+    index = leftCost < rightCost ? node.left : node.right;
+  }
+  const auto sibling   = index;
+  const auto oldParent = m_nodes[sibling].parent;
+  const auto newParent = AllocateNode();
+  auto& parent         = m_nodes[newParent];
+  parent.parent        = oldParent;
+  parent.left          = sibling;
+  parent.right         = leaf;
+  if (oldParent == Null) {
+    m_root = newParent;
+  } else if (m_nodes[oldParent].left == sibling) {
+    m_nodes[oldParent].left = newParent;
+  } else {
+    m_nodes[oldParent].right = newParent;
+  }
+  m_nodes[sibling].parent = newParent;
+  m_nodes[leaf].parent    = newParent;
+  RefitToRoot(newParent);
+}
+
+void AABBTree::RemoveLeaf(uint32_t leaf) {
+  if (leaf == m_root) {
+    m_root = Null;
+    return;
+  }
+  const auto parent      = m_nodes[leaf].parent;
+  const auto grandParent = m_nodes[parent].parent;
+  const auto& parentNode = m_nodes[parent];
+  const auto sibling     = parentNode.left == leaf ? parentNode.right : parentNode.left;
+  FreeNode(parent);
+  m_nodes[sibling].parent = grandParent;
+  if (grandParent == Null) {
+    m_root = sibling;
+    return;
+  }
+  if (m_nodes[grandParent].left == parent) {
+    m_nodes[grandParent].left = sibling;
+  } else {
+    m_nodes[grandParent].right = sibling;
+  }
+  RefitToRoot(grandParent);
+}
+
+void AABBTree::Refit(uint32_t index) {
+  auto& node        = m_nodes[index];
+  const auto& left  = m_nodes[node.left];
+  const auto& right = m_nodes[node.right];
+  node.min          = glm::min(left.min, right.min);
+  node.max          = glm::max(left.max, right.max);
+  node.height       = 1 + std::max(left.height, right.height);
+}
+
+void AABBTree::RefitToRoot(uint32_t index) {
+  while (index != Null) {
+    index = Balance(index);
+    Refit(index);
+    index = m_nodes[index].parent;
+  }
+}
+
+uint32_t AABBTree::Balance(uint32_t a) {
+  if (m_nodes[a].IsLeaf() || m_nodes[a].height < 2) {
+    return a;
+  }
+  const auto b       = m_nodes[a].left;
+  const auto c       = m_nodes[a].right;
+  const auto balance = m_nodes[c].height - m_nodes[b].height;
+  if (balance >= -1 && balance <= 1) {
+    return a;
+  }
+  // the taller child takes the place of a, which keeps the shorter child and one grandchild
+  const bool rightTaller = balance > 1;
+  const auto up          = rightTaller ? c : b;
+  const auto kept        = rightTaller ? b : c;
+  auto first             = m_nodes[up].left;
+  auto second            = m_nodes[up].right;
+  // the taller grandchild stays with up
+  if (m_nodes[first].height < m_nodes[second].height) {
+    std::swap(first, second);
+  }
+  const auto parent = m_nodes[a].parent;
+  if (parent == Null) {
+    m_root = up;
+  } else if (m_nodes[parent].left == a) {
+    m_nodes[parent].left = up;
+  } else {
+    m_nodes[parent].right = up;
+  }
+  m_nodes[up].parent     = parent;
+  m_nodes[up].left       = a;
+  m_nodes[up].right      = first;
+  m_nodes[a].parent      = up;
+  m_nodes[first].parent  = up;
+  m_nodes[second].parent = a;
+  m_nodes[a].left        = rightTaller ? kept : second;
+  m_nodes[a].right       = rightTaller ? second : kept;
+  Refit(a);
+  Refit(up);
+  return up;
+}
+}  // namespace photon
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <limits>
+#include <vector>
+#include "Renderer/AABB.hpp"
+#include "Renderer/FrustumCulling.hpp"
+
+namespace photon {
+/**
+ * Distance at which a ray enters a box, 0 from inside it and infinity when it misses the box
+ * within maxDistance. inverseDirection is 1 over the direction of the ray.
+ */
+inline float RayEntryDistance(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin,
+                              const glm::vec3& inverseDirection, float maxDistance) {
+  const auto t0     = (min - origin) * inverseDirection;
+  const auto t1     = (max - origin) * inverseDirection;
+  const auto tNear  = glm::min(t0, t1);
+  const auto tFar   = glm::max(t0, t1);
+  const float enter = std::max({tNear.x, tNear.y, tNear.z, 0.0f});
+  const float exit  = std::min({tFar.x, tFar.y, tFar.z, maxDistance});
+  return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+}
+
+/**
+ * Bounding volume hierarchy over boxes that come, go and move, after the dynamic tree of Box2D.
+ * A box joins next to the node it adds the least surface area to, and branches are rotated to
+ * keep the tree balanced, so inserting, removing and moving walk one path to the root. Leaves
+ * hold the exact boxes, so the root holds the bounds of all of them.
+ */
+class AABBTree {
+public:
+  static constexpr uint32_t Null = ~0u;
+
+  /** Add a box, returns its proxy, which stays the same while the box moves. */
+  uint32_t Insert(const AABB& box, uint32_t userData);
+  void Remove(uint32_t proxy);
+  /**
+   * Give a proxy its new box. Within the box of its parent only the ancestors are refit, a box
+   * that left it is inserted again where it fits best.
+   */
+  void Update(uint32_t proxy, const AABB& box);
+  void Clear();
+
+  [[nodiscard]] bool IsEmpty() const { return m_root == Null; }
+  /** The bounds of all boxes, a zero box when there are none. */
+  [[nodiscard]] AABB GetBounds() const;
+  [[nodiscard]] AABB GetAABB(uint32_t proxy) const;
+  [[nodiscard]] uint32_t GetUserData(uint32_t proxy) const { return m_nodes[proxy].userData; }
+  void SetUserData(uint32_t proxy, uint32_t userData) { m_nodes[proxy].userData = userData; }
+  [[nodiscard]] uint32_t GetNumProxies() const { return m_numProxies; }
+  /** Longest path from the root to a leaf, 0 for a single box. */
+  [[nodiscard]] int32_t GetHeight() const { return m_root == Null ? 0 : m_nodes[m_root].height; }
+
+  /** Call visit(userData) for each box inside or crossing all planes, as CullAABBs decides. */
+  template <typename Visit>
+  void QueryFrustum(const FrustumPlanes& planes, Visit&& visit) const {
+    if (m_root != Null) {
+      QueryFrustum(m_root, planes, visit);
+    }
+  }
+  /** Call visit(userData) for each box overlapping box. */
+  template <typename Visit>
+  void QueryAABB(const AABB& box, Visit&& visit) const {
+    if (m_root != Null) {
+      QueryAABB(m_root, box.posMin, box.posMax, visit);
+    }
+  }
+  /**
+   * Offer the boxes a ray enters within maxDistance to hit, nearer branches first. hit(userData,
+   * distance) gets the distance at which the ray enters the box and returns how far the ray goes
+   * on: the distance it was given to keep going, or that of a hit it found inside the box.
+   */
+  template <typename Hit>
+  void RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+               Hit&& hit) const {
+    if (m_root == Null) {
+      return;
+    }
+    const auto inverse  = 1.0f / direction;
+    const auto distance = EntryDistance(m_nodes[m_root], origin, inverse, maxDistance);
+    if (distance <= maxDistance) {
+      RayCast(m_root, distance, origin, inverse, maxDistance, hit);
+    }
+  }
+
+private:
+  struct Node {
+    glm::vec3 min{0.0f};
+    // the next free node while on the free list
+    uint32_t parent{Null};
+    glm::vec3 max{0.0f};
+    uint32_t userData{Null};
+    uint32_t left{Null};
+    uint32_t right{Null};
+    // 0 for leaves, -1 while free
+    int32_t height{0};
+
+    [[nodiscard]] bool IsLeaf() const { return left == Null; }
+  };
+  enum class Containment { Outside, Crossing, Inside };
+
+  uint32_t AllocateNode();
+  void FreeNode(uint32_t index);
+  void InsertLeaf(uint32_t leaf);
+  void RemoveLeaf(uint32_t leaf);
+  /** Box and height of a branch from its children. */
+  void Refit(uint32_t index);
+  /** Walk up from a node refitting and rotating the branches on the way. */
+  void RefitToRoot(uint32_t index);
+  /** Rotate an unbalanced branch, returns the node now in its place. */
+  uint32_t Balance(uint32_t index);
+
+  static Containment Classify(const FrustumPlanes& planes, const Node& node) {
+    auto containment = Containment::Inside;
+    for (const auto& plane : planes) {
+      // the corners farthest along the normal and against it, as CullAABBs picks them
+      const auto farCorner  = glm::vec3(plane.x >= 0.0f ? node.max.x : node.min.x,
+                                        plane.y >= 0.0f ? node.max.y : node.min.y,
+                                        plane.z >= 0.0f ? node.max.z : node.min.z);
+      const auto nearCorner = node.min + node.max - farCorner;
+      const auto distance   = [&](const glm::vec3& corner) {
+        return plane.w + plane.x * corner.x + plane.y * corner.y + plane.z * corner.z;
+      };
+      if (!(distance(farCorner) >= 0.0f)) {
+        return Containment::Outside;
+      }
+      if (!(distance(nearCorner) >= 0.0f)) {
+        containment = Containment::Crossing;
+      }
+    }
+    return containment;
+  }
+
+  static float EntryDistance(const Node& node, const glm::vec3& origin, const glm::vec3& inverse,
+                             float maxDistance) {
+    return RayEntryDistance(node.min, node.max, origin, inverse, maxDistance);
+  }
+
+  template <typename Visit>
+  void VisitLeaves(uint32_t index, Visit& visit) const {
+    const auto& node = m_nodes[index];
+    if (node.IsLeaf()) {
+      visit(node.userData);
+      return;
+    }
+    VisitLeaves(node.left, visit);
+    VisitLeaves(node.right, visit);
+  }
+
+  template <typename Visit>
+  void QueryFrustum(uint32_t index, const FrustumPlanes& planes, Visit& visit) const {
+    const auto& node = m_nodes[index];
+    switch (Classify(planes, node)) {
+      case Containment::Outside:
+        return;
+      case Containment::Inside:
+        // nothing below needs testing
+        VisitLeaves(index, visit);
+        return;
+      case Containment::Crossing:
+        if (node.IsLeaf()) {
+          visit(node.userData);
+          return;
+        }
+        QueryFrustum(node.left, planes, visit);
+        QueryFrustum(node.right, planes, visit);
+        return;
+    }
+  }
+
+  template <typename Visit>
+  void QueryAABB(uint32_t index, const glm::vec3& min, const glm::vec3& max, Visit& visit) const {
+    const auto& node = m_nodes[index];
+    if (glm::any(glm::lessThan(node.max, min)) || glm::any(glm::greaterThan(node.min, max))) {
+      return;
+    }
+    if (node.IsLeaf()) {
+      visit(node.userData);
+      return;
+    }
+    QueryAABB(node.left, min, max, visit);
+    QueryAABB(node.right, min, max, visit);
+  }
+
+  /** Returns maxDistance as the hits below the node left it. */
+  template <typename Hit>
+  float RayCast(uint32_t index, float distance, const glm::vec3& origin, const glm::vec3& inverse,
+                float maxDistance, Hit& hit) const {
+    const auto& node = m_nodes[index];
+    if (node.IsLeaf()) {
+      return hit(node.userData, distance);
+    }
+    auto nearChild    = node.left;
+    auto farChild     = node.right;
+    auto nearDistance = EntryDistance(m_nodes[nearChild], origin, inverse, maxDistance);
+    auto farDistance  = EntryDistance(m_nodes[farChild], origin, inverse, maxDistance);
+    if (farDistance < nearDistance) {
+      std::swap(nearChild, farChild);
+      std::swap(nearDistance, farDistance);
+    }
+    if (nearDistance <= maxDistance) {
+      maxDistance = RayCast(nearChild, nearDistance, origin, inverse, maxDistance, hit);
+    }
+    // a hit in the nearer branch may have clipped the ray before the farther one
+    if (farDistance <= maxDistance) {
+      maxDistance = RayCast(farChild, farDistance, origin, inverse, maxDistance, hit);
+    }
+    return maxDistance;
+  }
+
+  std::vector<Node> m_nodes;
+  uint32_t m_root{Null};
+  uint32_t m_freeList{Null};
+  uint32_t m_numProxies{0};
+};
+}  // namespace photon
@@ -1,11 +1,15 @@
 // clang-format off
 #include "Engine.hpp"
+#include <algorithm>
 #include "Common/Logging.hpp"
+#include "Graphics/GeometryPool.hpp"
 #include "Platform/NativeWindow.hpp"
 #include "Renderer/BasicRenderer.hpp"
+#include "Renderer/MaterialTable.hpp"
 #include "SimpleScene.hpp"
 #include "Utils/StopWatch.hpp"
 #include "Utils/AssetCache.hpp"
+#include "Utils/TextureResidency.hpp"
 #include "Platform/NativeInput.hpp"  // include glfw after glad
 #include "Systems/GUISystem.hpp"
 using namespace photon::system;
@@ -57,12 +61,31 @@ void Engine::Initialize(const std::string& activeScene) {
   m_stopWatch = CreateRef<util::StopWatch>();
 }
 
+Engine::~Engine() {
+  // the shared pools are statics, destroyed only after the window took the GL context with it
+  m_scene = nullptr;
+  m_sceneCache.clear();
+  m_renderer = nullptr;
+  gl::GeometryPool::GetShared().Shutdown();
+  MaterialTable::GetShared().Shutdown();
+}
+
 void Engine::LoadScene(uint32_t index) {
+  // streamed in, the camera is fitted once the new model shows up
   m_scene->LoadNewModel(index);
-  m_scene->LoadFloor();
-  m_scene->LoadLightModel();
-  auto aabb = m_scene->GetAABB();
-  m_camera  = Camera::Create(aabb.posMin, aabb.posMax, m_window->GetAspect());
+}
+
+void Engine::TrackStreaming(float deltaTime) {
+  const auto& assets = m_scene->GetAssetCache();
+  if (assets.IsStreaming()) {
+    m_streamingFrames++;
+    m_maxStreamingFrameMs = std::max(m_maxStreamingFrameMs, deltaTime * 1000.0f);
+  } else if (m_streamingFrames > 0) {
+    LOGI("Streamed over {} frames, worst frame {:.2f} ms, worst upload stage {:.2f} ms",
+         m_streamingFrames, m_maxStreamingFrameMs, assets.GetStreamingStats().maxUploadMs);
+    m_streamingFrames     = 0;
+    m_maxStreamingFrameMs = 0.0f;
+  }
 }
 
 void Engine::Run() {
@@ -79,12 +102,24 @@ void Engine::Run() {
     float deltaTime = m_stopWatch->TimeStep();
 
     m_scene->Update(m_options, deltaTime);
+    TrackStreaming(deltaTime);
+    if (m_scene->ConsumeBoundsChanged()) {
+      auto aabb = m_scene->GetAABB();
+      m_camera  = Camera::Create(aabb.posMin, aabb.posMax, m_window->GetAspect());
+    }
 
     m_camera->Update(deltaTime, m_options->rotateCamera);
+    if (KeyboardMouseInput::GetInstance().WasKeyPressedOnce(GLFW_KEY_P)) {
+      // pick along the view direction from the camera
+      const auto view  = glm::inverse(m_camera->GetViewMatrix());
+      const auto model = m_scene->PickModel(glm::vec3(view[3]), -glm::vec3(view[2]));
+      LOGI("picked {}", model ? model->GetName() : "nothing");
+    }
 
     m_renderer->RenderFrame(frameInfo);
+    util::TextureResidency::GetShared().EndFrame();
 
-    m_gui->Draw(m_options);
+    m_gui->Draw(m_options, m_renderer->GetStats());
 
     if (m_options->sceneChanged) {
       LoadScene(m_options->selectedModel);
@@ -26,6 +26,8 @@ class BaseScene;
 class Engine {
 public:
   Engine() = default;
+  /** Scenes, renderer and shared GPU pools go first, the window and its context last. */
+  ~Engine();
 
   void Initialize(const std::string& activeScene);
 
@@ -33,6 +35,8 @@ public:
 
 private:
   void LoadScene(uint32_t index);
+  /** Log the worst frame time seen while the scene streamed assets in. */
+  void TrackStreaming(float deltaTime);
 
   Ref<util::StopWatch> m_stopWatch;
   Ref<platform::Window> m_window;
@@ -46,5 +50,8 @@ private:
   Ref<BasicRenderer> m_renderer;
 
   Ref<RenderOptions> m_options;
+
+  uint32_t m_streamingFrames{0};
+  float m_maxStreamingFrameMs{0.0f};
 };
 }  // namespace photon
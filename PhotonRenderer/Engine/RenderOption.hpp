@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 
 namespace photon {
 enum class LightType : decltype(0) { Spot = 0, Directional = 1 };
@@ -20,6 +21,48 @@ struct RenderOptions {
   bool blur{false};
   bool sceneChanged{false};
   bool showDepthDebug{false};
+  bool enableLod{true};
+  // largest error a level of detail may show on screen, in pixels
+  float lodPixelError{1.0f};
+  // draw meshes by their meshlets, skipping those off screen or facing away
+  bool cullClusters{false};
+  // submit each pass with one multi-draw indirect call instead of a call per draw
+  bool indirectDraws{true};
+  // draw in render queue order: state sorted, opaque front to back, skybox after them, blended
+  // back to front; off draws in scene order with the skybox first
+  bool sortDraws{true};
+  // skip mesh instances outside the camera's frustum, and shadow casters outside the light's
+  bool frustumCulling{true};
   LightType lightType{LightType::Directional};
 };
+
+/** What the renderer submitted in the last frame. */
+struct RenderStats {
+  uint64_t numTriangles{0};
+  uint64_t numShadowTriangles{0};
+  // meshes drawn by the main pass, and the draw calls they took
+  uint32_t numDraws{0};
+  uint32_t numDrawCalls{0};
+  // mesh instances the frustum tests passed and dropped, of the main pass and the shadow pass,
+  // not counting those of the models the scene's tree dropped whole
+  uint32_t numInstancesVisible{0};
+  uint32_t numInstancesCulled{0};
+  uint32_t numModelsCulled{0};
+  uint32_t numShadowCastersVisible{0};
+  uint32_t numShadowCastersCulled{0};
+  uint32_t numShadowModelsCulled{0};
+  // meshlets of the meshes drawn with cluster culling, and how many of them were skipped
+  uint32_t numClusters{0};
+  uint32_t numClustersFrustumCulled{0};
+  uint32_t numClustersBackfaceCulled{0};
+  // GL state changes of the frame passed to the driver, and those the state cache dropped
+  uint32_t numStateChanges{0};
+  uint32_t numStateChangesElided{0};
+  // packets of the render queue, and fragments that passed the depth test per pixel of the main
+  // pass, read a few frames late
+  uint32_t numPackets{0};
+  float overdraw{0.0f};
+  // recording and submitting the frame on the CPU, in milliseconds
+  float cpuFrameTime{0.0f};
+};
 }  // namespace photon
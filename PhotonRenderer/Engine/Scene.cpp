@@ -1,4 +1,6 @@
 #include "Scene.hpp"
+#include <algorithm>
+#include <limits>
 #include "Common/Logging.hpp"
 #include "Platform/NativeInput.hpp"
 #include "Utils/AssetCache.hpp"
@@ -10,22 +12,73 @@ BaseScene::BaseScene(std::string_view name) : m_name(name) {
 }
 
 void BaseScene::AddModel(const Ref<asset::Model>& model) {
+  m_modelProxies.push_back(
+      m_modelTree.Insert(model->GetAABB(), static_cast<uint32_t>(m_models.size())));
   m_models.push_back(model);
 }
 
 void BaseScene::AddModel(const std::string& model_path) {
-  m_models.push_back(m_assetCache->RequestModel(model_path));
+  AddModel(m_assetCache->RequestModel(model_path));
+}
+
+void BaseScene::ClearModels() {
+  m_models.clear();
+  m_modelProxies.clear();
+  m_modelTree.Clear();
+}
+
+void BaseScene::RefitModel(uint32_t index) {
+  m_modelTree.Update(m_modelProxies[index], m_models[index]->GetAABB());
+}
+
+void BaseScene::AddModelAsync(const std::string& path,
+                              std::function<void(asset::Model&)> place) {
+  m_streamedModels.push_back({m_assetCache->RequestModelAsync(path), std::move(place)});
+  UpdateStreamedModels();
+}
+
+void BaseScene::UpdateStreamedModels() {
+  if (m_streamedModels.empty()) {
+    return;
+  }
+  // placements may stream more models, so they run after the list is settled
+  std::vector<StreamedModel> ready;
+  std::vector<StreamedModel> waiting;
+  for (auto& streamed : m_streamedModels) {
+    if (streamed.handle->IsFailed()) {
+      continue;
+    }
+    (streamed.handle->Get() != nullptr ? ready : waiting).push_back(std::move(streamed));
+  }
+  m_streamedModels = std::move(waiting);
+  for (const auto& streamed : ready) {
+    const auto& model = streamed.handle->Get();
+    const auto index  = static_cast<uint32_t>(m_models.size());
+    AddModel(model);
+    if (streamed.place) {
+      streamed.place(*model);
+      RefitModel(index);
+    }
+    m_boundsChanged = true;
+  }
+}
+
+const util::AssetCache& BaseScene::GetAssetCache() const {
+  return *m_assetCache;
 }
 
 void BaseScene::Update(const Ref<RenderOptions>& options, float time) {
+  m_assetCache->ProcessUploads();
+  UpdateStreamedModels();
   // turn on/off light
   if (platform::KeyboardMouseInput::GetInstance().WasKeyPressedOnce(GLFW_KEY_L)) {
     SwitchLight();
   }
   float angle = time * 0.5f;
   if (options->rotateModel) {
-    for (auto& model : m_models) {
-      model->Rotate(angle);
+    for (uint32_t i = 0; i < m_models.size(); i++) {
+      m_models[i]->Rotate(angle);
+      RefitModel(i);
     }
   }
   if (options->rotateLight) {
@@ -34,13 +87,38 @@ void BaseScene::Update(const Ref<RenderOptions>& options, float time) {
   }
 }
 
-AABB BaseScene::GetAABB() const {
-  AABB aabb = m_models[0]->GetAABB();
-  for (int i = 1; i < m_models.size(); i++) {
-    aabb.posMax = glm::max(m_models[i]->GetAABB().posMax, aabb.posMax);
-    aabb.posMin = glm::min(m_models[i]->GetAABB().posMin, aabb.posMin);
-  }
-  return aabb;
+void BaseScene::QueryModels(const FrustumPlanes& planes, std::vector<uint32_t>& models) const {
+  models.clear();
+  m_modelTree.QueryFrustum(planes, [&](uint32_t index) { models.push_back(index); });
+  std::sort(models.begin(), models.end());
+}
+
+void BaseScene::QueryModels(const AABB& volume, std::vector<uint32_t>& models) const {
+  models.clear();
+  m_modelTree.QueryAABB(volume, [&](uint32_t index) { models.push_back(index); });
+  std::sort(models.begin(), models.end());
+}
+
+Ref<asset::Model> BaseScene::PickModel(const glm::vec3& origin,
+                                       const glm::vec3& direction) const {
+  constexpr float MaxDistance = std::numeric_limits<float>::max();
+  const auto inverse          = 1.0f / direction;
+  Ref<asset::Model> picked;
+  float nearest = MaxDistance;
+  // the model's box only says the ray may hit one of its instances
+  m_modelTree.RayCast(origin, direction, MaxDistance, [&](uint32_t index, float) {
+    const auto& bounds = m_models[index]->GetInstanceBounds();
+    for (uint32_t i = 0; i < bounds.Size(); i++) {
+      const auto box      = bounds.Get(i);
+      const auto distance = RayEntryDistance(box.posMin, box.posMax, origin, inverse, nearest);
+      if (distance < nearest) {
+        nearest = distance;
+        picked  = m_models[index];
+      }
+    }
+    return nearest;
+  });
+  return picked;
 }
 
 void BaseScene::SwitchLight() {
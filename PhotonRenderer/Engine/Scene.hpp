@@ -1,5 +1,9 @@
 #pragma once
 
+#include <functional>
+#include <utility>
+#include <vector>
+#include "AABBTree.hpp"
 #include "Assets/Model.hpp"
 #include "Common/Base.hpp"
 #include "RenderOption.hpp"
@@ -11,7 +15,9 @@ namespace photon {
 
 namespace util {
 class AssetCache;
-}
+template <typename T>
+class AssetHandle;
+}  // namespace util
 class BaseScene;
 
 class SceneBuilder {
@@ -36,11 +42,27 @@ public:
   virtual void GenerateTerrain(){};
   void AddModel(const std::string& model_name);
   void AddModel(const Ref<asset::Model>& model);
+  /**
+   * Stream a model in without blocking. It joins the scene as a bounding-box proxy once decoded,
+   * which is when place runs; transforms given to the proxy carry over to the real model.
+   */
+  void AddModelAsync(const std::string& path, std::function<void(asset::Model&)> place = {});
   virtual void LoadNewModel(uint32_t index) = 0;
 
   void Update(const Ref<RenderOptions>& options, float time = 0.0f);
 
-  [[nodiscard]] AABB GetAABB() const;
+  /** Bounds of the models, kept at the root of their tree. */
+  [[nodiscard]] AABB GetAABB() const { return m_modelTree.GetBounds(); }
+  /** Indices of the models inside or crossing the planes, in scene order. */
+  void QueryModels(const FrustumPlanes& planes, std::vector<uint32_t>& models) const;
+  /** Indices of the models overlapping a volume, such as the reach of a light, in scene order. */
+  void QueryModels(const AABB& volume, std::vector<uint32_t>& models) const;
+  /** The model with the instance bounds a ray enters first, null when it misses them all. */
+  [[nodiscard]] Ref<asset::Model> PickModel(const glm::vec3& origin,
+                                            const glm::vec3& direction) const;
+  /** True once after models joined the scene, so the camera can be fitted again. */
+  bool ConsumeBoundsChanged() { return std::exchange(m_boundsChanged, false); }
+  [[nodiscard]] const util::AssetCache& GetAssetCache() const;
 
   const auto GetLightPos() const { return m_lightModel->GetAABB().GetCenter(); }
   const auto& GetLightDir() const { return m_lightDir; }
@@ -55,9 +77,23 @@ public:
   virtual const char** GetModelData() = 0;
 
 protected:
+  struct StreamedModel {
+    Ref<util::AssetHandle<asset::Model>> handle;
+    std::function<void(asset::Model&)> place;
+  };
+  void UpdateStreamedModels();
+  void ClearModels();
+  /** Move a model's proxy in the tree to where its bounds are now. */
+  void RefitModel(uint32_t index);
+
   std::string m_name;
   Unique<util::AssetCache> m_assetCache;
   std::vector<Ref<asset::Model>> m_models;
+  // proxies of the models, in their order; each proxy's user data is the model's index
+  AABBTree m_modelTree;
+  std::vector<uint32_t> m_modelProxies;
+  std::vector<StreamedModel> m_streamedModels;
+  bool m_boundsChanged{false};
   Ref<asset::Model> m_floor;
   Ref<asset::Model> m_lightModel;
   Ref<Skybox> m_skybox;
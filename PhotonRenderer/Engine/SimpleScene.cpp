@@ -1,18 +1,28 @@
 #include "SimpleScene.hpp"
 #include <glm/gtx/string_cast.hpp>
+#include "Common/Logging.hpp"
 #include "Renderer/Skybox.hpp"
 #include "Utils/AssetCache.hpp"
+#include "Utils/StopWatch.hpp"
 
 namespace photon {
 void SimpleScene::Init() {
+  util::StopWatch stopWatch;
+  constexpr const char* StarshipPath = "Data/Models/Starship/Starship.obj";
+  constexpr const char* UfoPath      = "Data/Models/ufo/scene.gltf";
+  constexpr const char* RobotPath    = "Data/Models/robot.obj";
+  // the models decode on the shared pool while the skybox and terrain are set up
+  for (const auto* path : {StarshipPath, UfoPath, RobotPath, LightModelPath}) {
+    m_assetCache->PrefetchModel(path);
+  }
   // setup skybox
   m_skybox = Skybox::Create("Data/Textures/sky.hdr", 2048);
   GenerateTerrain();
   //m_center = m_terrain->GetCenter();
 
-  auto starship1 = m_assetCache->RequestModel("Data/Models/Starship/Starship.obj");
-  auto ufo       = m_assetCache->RequestModel("Data/Models/ufo/scene.gltf");
-  auto robot     = m_assetCache->RequestModel("Data/Models/robot.obj");
+  auto starship1 = m_assetCache->RequestModel(StarshipPath);
+  auto ufo       = m_assetCache->RequestModel(UfoPath);
+  auto robot     = m_assetCache->RequestModel(RobotPath);
 
   const auto modelSize = starship1->GetAABB().GetSize();
   //starship1->Translate({m_center.x, m_center.y * 1.1f, m_center.z});
@@ -30,11 +40,17 @@ void SimpleScene::Init() {
   LoadFloor();
   LoadLightModel();
   m_curve = CreateRef<Curve>();
+  LOGI("SimpleScene::Init took {:.2f} ms", stopWatch.TimeStep() * 1000.0f);
 }
 
 void SimpleScene::LoadNewModel(uint32_t index) {
-  m_models.clear();
-  AddModel(ModelPaths[index]);
+  ClearModels();
+  m_streamedModels.clear();
+  // floor and light are fitted around the new model once its bounds are known
+  AddModelAsync(ModelPaths[index], [this](asset::Model&) {
+    LoadFloor();
+    LoadLightModel();
+  });
 }
 
 void SimpleScene::LoadLightModel() {
@@ -6,6 +6,7 @@
 // clang-format on
 #include <string>
 #include "Common/Logging.hpp"
+#include "StateCache.hpp"
 
 namespace photon::gl {
 static const std::unordered_map<GLenum, const char*> SourceEnumToString = {
@@ -52,7 +53,7 @@ Context::Context(GLFWwindow* windowHandle) {
 
 void Context::InitDebug() {
   glDebugMessageCallback((GLDEBUGPROCARB)DebugCallback, nullptr);
-  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  StateCache::GetShared().Enable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
 
   for (const auto& tuple : IgnoreList) {
     glDebugMessageControl(std::get<0>(tuple), std::get<1>(tuple), std::get<2>(tuple), 0, nullptr,
@@ -1,5 +1,6 @@
 #include "framebuffer.hpp"
 #include "Common/Logging.hpp"
+#include "StateCache.hpp"
 
 namespace photon::gl {
 AttachmentInfo AttachmentInfo::Color(std::string name_, AttachmentBinding binding_, int w, int h) {
@@ -82,6 +83,9 @@ Framebuffer::Framebuffer(const FramebufferCreatInfo& info)
 
 Framebuffer::~Framebuffer() {
   glDeleteFramebuffers(1, &m_id);
+  for (const auto id : m_attachmentIds) {
+    StateCache::GetShared().ForgetTexture(id);
+  }
   glDeleteTextures(m_attachmentIds.size(), m_attachmentIds.data());
   m_attachments.clear();
   m_attachmentIds.clear();
@@ -115,6 +119,9 @@ void Framebuffer::SetupAttachments() {
 void Framebuffer::Invalidate() {
   if (m_id != 0) {
     glDeleteFramebuffers(1, &m_id);
+    for (const auto id : m_attachmentIds) {
+      StateCache::GetShared().ForgetTexture(id);
+    }
     glDeleteTextures(m_attachmentIds.size(), m_attachmentIds.data());
     m_attachments.clear();
     m_attachmentIds.clear();
@@ -173,7 +180,7 @@ void Framebuffer::BindForWriting(bool set_view_port) const {
 
 void Framebuffer::BindForReading(const std::string& name, int slot) const {
   const auto& attachment = m_attachments.at(name);
-  glBindTextureUnit(slot, attachment->GetId());
+  StateCache::GetShared().BindTextureUnit(slot, attachment->GetId());
 }
 
 void Framebuffer::Clear() {
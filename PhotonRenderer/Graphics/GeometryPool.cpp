@@ -0,0 +1,242 @@
+#include "GeometryPool.hpp"
+#include <algorithm>
+#include "Common/Logging.hpp"
+#include "VertexArray.hpp"
+
+namespace photon::gl {
+RangeAllocator::RangeAllocator(uint32_t capacity) : m_capacity(capacity) {
+  if (capacity > 0) {
+    m_freeRanges.push_back({0, capacity});
+  }
+}
+
+uint32_t RangeAllocator::Allocate(uint32_t size) {
+  // the smallest range that fits, ties go to the lowest offset
+  auto best = m_freeRanges.end();
+  for (auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it) {
+    if (it->size >= size && (best == m_freeRanges.end() || it->size < best->size)) {
+      best = it;
+      if (it->size == size) {
+        break;
+      }
+    }
+  }
+  if (best == m_freeRanges.end()) {
+    return InvalidOffset;
+  }
+  const auto offset = best->offset;
+  best->offset += size;
+  best->size -= size;
+  if (best->size == 0) {
+    m_freeRanges.erase(best);
+  }
+  m_used += size;
+  return offset;
+}
+
+void RangeAllocator::Free(uint32_t offset, uint32_t size) {
+  if (size == 0) {
+    return;
+  }
+  m_used -= size;
+  auto next = std::lower_bound(m_freeRanges.begin(), m_freeRanges.end(), offset,
+                               [](const Range& range, uint32_t o) { return range.offset < o; });
+  const bool joinsPrev = next != m_freeRanges.begin() &&
+                         std::prev(next)->offset + std::prev(next)->size == offset;
+  const bool joinsNext = next != m_freeRanges.end() && offset + size == next->offset;
+  if (joinsPrev && joinsNext) {
+    std::prev(next)->size += size + next->size;
+    m_freeRanges.erase(next);
+  } else if (joinsPrev) {
+    std::prev(next)->size += size;
+  } else if (joinsNext) {
+    next->offset = offset;
+    next->size += size;
+  } else {
+    m_freeRanges.insert(next, {offset, size});
+  }
+}
+
+void RangeAllocator::Grow(uint32_t capacity) {
+  if (capacity <= m_capacity) {
+    return;
+  }
+  const auto added = capacity - m_capacity;
+  if (!m_freeRanges.empty() &&
+      m_freeRanges.back().offset + m_freeRanges.back().size == m_capacity) {
+    m_freeRanges.back().size += added;
+  } else {
+    m_freeRanges.push_back({m_capacity, added});
+  }
+  m_capacity = capacity;
+}
+
+uint32_t RangeAllocator::GetLargestFree() const {
+  uint32_t largest = 0;
+  for (const auto& range : m_freeRanges) {
+    largest = std::max(largest, range.size);
+  }
+  return largest;
+}
+
+float RangeAllocator::GetFragmentation() const {
+  const auto free = m_capacity - m_used;
+  if (free == 0) {
+    return 0.0f;
+  }
+  return 1.0f - static_cast<float>(GetLargestFree()) / static_cast<float>(free);
+}
+
+GeometryAllocation& GeometryAllocation::operator=(GeometryAllocation&& other) noexcept {
+  if (this != &other) {
+    Release();
+    m_pool        = other.m_pool;
+    m_baseVertex  = other.m_baseVertex;
+    m_numVertices = other.m_numVertices;
+    m_firstIndex  = other.m_firstIndex;
+    m_numIndices  = other.m_numIndices;
+    other.m_pool  = nullptr;
+  }
+  return *this;
+}
+
+void GeometryAllocation::Release() {
+  if (m_pool != nullptr) {
+    m_pool->Free(*this);
+    m_pool = nullptr;
+  }
+}
+
+GeometryPool& GeometryPool::GetShared() {
+  static GeometryPool pool({
+      {"aPos", BufferDataType::Vec4us, true},
+      {"aTexCoords", BufferDataType::Vec2us, true},
+      {"aNormal", BufferDataType::Vec2s, true},
+  });
+  return pool;
+}
+
+GeometryPool::GeometryPool(const BufferView& format)
+    : m_format(format), m_stride(format.get_stride()) {}
+
+GeometryPool::~GeometryPool() = default;
+
+void GeometryPool::Shutdown() {
+  if (m_vao == nullptr) {
+    return;
+  }
+  if (m_numAllocations > 0) {
+    LOGW("Geometry pool shut down with {} live allocations", m_numAllocations);
+  }
+  m_vao = nullptr;
+  glDeleteBuffers(1, &m_vertexBuffer);
+  glDeleteBuffers(1, &m_indexBuffer);
+  m_vertexBuffer   = 0;
+  m_indexBuffer    = 0;
+  m_vertices       = RangeAllocator();
+  m_indices        = RangeAllocator();
+  m_numAllocations = 0;
+}
+
+void GeometryPool::CreateBuffers() {
+  m_vertices = RangeAllocator(InitialVertexCapacity);
+  m_indices  = RangeAllocator(InitialIndexCapacity);
+  GrowBuffer(m_vertexBuffer, 0, InitialVertexCapacity, m_stride);
+  GrowBuffer(m_indexBuffer, 0, InitialIndexCapacity, sizeof(uint32_t));
+  m_vao = VertexArray::Create();
+  m_vao->SetVertexFormat(m_format);
+  m_vao->SetBuffers(m_vertexBuffer, m_stride, m_indexBuffer);
+}
+
+void GeometryPool::GrowBuffer(uint32_t& buffer, uint32_t oldCapacity, uint32_t capacity,
+                              uint32_t elementSize) {
+  uint32_t grown = 0;
+  glCreateBuffers(1, &grown);
+  // written by glNamedBufferSubData and copies from the staging buffer, never mapped
+  glNamedBufferStorage(grown, static_cast<GLsizeiptr>(capacity) * elementSize, nullptr,
+                       GL_DYNAMIC_STORAGE_BIT);
+  if (buffer != 0) {
+    glCopyNamedBufferSubData(buffer, grown, 0, 0,
+                             static_cast<GLsizeiptr>(oldCapacity) * elementSize);
+    glDeleteBuffers(1, &buffer);
+  }
+  buffer = grown;
+}
+
+GeometryAllocation GeometryPool::Allocate(uint32_t numVertices, uint32_t numIndices) {
+  if (m_vao == nullptr) {
+    CreateBuffers();
+  }
+  const auto allocate = [&](RangeAllocator& ranges, uint32_t& buffer, uint32_t size,
+                            uint32_t elementSize) {
+    if (size == 0) {
+      return 0u;
+    }
+    auto offset = ranges.Allocate(size);
+    if (offset == RangeAllocator::InvalidOffset) {
+      const auto oldCapacity = ranges.GetCapacity();
+      const auto capacity    = std::max(oldCapacity * 2, oldCapacity + size);
+      GrowBuffer(buffer, oldCapacity, capacity, elementSize);
+      ranges.Grow(capacity);
+      m_numGrowths++;
+      LOGI("Geometry pool grew to {} units of {} bytes", capacity, elementSize);
+      offset = ranges.Allocate(size);
+    }
+    return offset;
+  };
+  const auto growths    = m_numGrowths;
+  const auto baseVertex = allocate(m_vertices, m_vertexBuffer, numVertices, m_stride);
+  const auto firstIndex = allocate(m_indices, m_indexBuffer, numIndices, sizeof(uint32_t));
+  if (m_numGrowths != growths) {
+    m_vao->SetBuffers(m_vertexBuffer, m_stride, m_indexBuffer);
+  }
+  m_numAllocations++;
+  return {this, baseVertex, numVertices, firstIndex, numIndices};
+}
+
+void GeometryPool::WriteVertices(const GeometryAllocation& allocation, const void* data) {
+  glNamedBufferSubData(m_vertexBuffer,
+                       static_cast<GLintptr>(allocation.GetBaseVertex()) * m_stride,
+                       static_cast<GLsizeiptr>(allocation.GetNumVertices()) * m_stride, data);
+}
+
+void GeometryPool::WriteIndices(const GeometryAllocation& allocation, const uint32_t* indices) {
+  glNamedBufferSubData(m_indexBuffer,
+                       static_cast<GLintptr>(allocation.GetFirstIndex()) * sizeof(uint32_t),
+                       static_cast<GLsizeiptr>(allocation.GetNumIndices()) * sizeof(uint32_t),
+                       indices);
+}
+
+void GeometryPool::Free(const GeometryAllocation& allocation) {
+  if (m_vao == nullptr) {
+    // its range went with the buffers in Shutdown
+    return;
+  }
+  m_vertices.Free(allocation.GetBaseVertex(), allocation.GetNumVertices());
+  m_indices.Free(allocation.GetFirstIndex(), allocation.GetNumIndices());
+  m_numAllocations--;
+}
+
+void GeometryPool::Bind() const {
+  if (m_vao != nullptr) {
+    m_vao->Bind();
+  }
+}
+
+GeometryPoolStats GeometryPool::GetStats() const {
+  GeometryPoolStats stats;
+  stats.numAllocations      = m_numAllocations;
+  stats.vertexCapacity      = m_vertices.GetCapacity();
+  stats.usedVertices        = m_vertices.GetUsed();
+  stats.indexCapacity       = m_indices.GetCapacity();
+  stats.usedIndices         = m_indices.GetUsed();
+  stats.numFreeVertexRanges = m_vertices.GetNumFreeRanges();
+  stats.numFreeIndexRanges  = m_indices.GetNumFreeRanges();
+  stats.vertexFragmentation = m_vertices.GetFragmentation();
+  stats.indexFragmentation  = m_indices.GetFragmentation();
+  stats.numGrowths          = m_numGrowths;
+  stats.vertexBytes         = static_cast<uint64_t>(m_vertices.GetCapacity()) * m_stride;
+  stats.indexBytes          = static_cast<uint64_t>(m_indices.GetCapacity()) * sizeof(uint32_t);
+  return stats;
+}
+}  // namespace photon::gl
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Common/Base.hpp"
+#include "MeshBuffer.hpp"
+
+namespace photon::gl {
+class GeometryPool;
+class VertexArray;
+
+/** Best-fit suballocation of [0, capacity) in whole units, freed neighbours merge back. */
+class RangeAllocator {
+public:
+  static constexpr uint32_t InvalidOffset = ~0u;
+
+  explicit RangeAllocator(uint32_t capacity = 0);
+
+  /** Offset of size free units, InvalidOffset when no free range holds them. */
+  uint32_t Allocate(uint32_t size);
+  void Free(uint32_t offset, uint32_t size);
+  /** Add free units at the end, capacity only grows. */
+  void Grow(uint32_t capacity);
+
+  [[nodiscard]] uint32_t GetCapacity() const { return m_capacity; }
+  [[nodiscard]] uint32_t GetUsed() const { return m_used; }
+  [[nodiscard]] uint32_t GetLargestFree() const;
+  [[nodiscard]] uint32_t GetNumFreeRanges() const {
+    return static_cast<uint32_t>(m_freeRanges.size());
+  }
+  /** 0 when the free units are in one piece, towards 1 the more they are scattered. */
+  [[nodiscard]] float GetFragmentation() const;
+
+private:
+  struct Range {
+    uint32_t offset;
+    uint32_t size;
+  };
+  // sorted by offset, no two touching
+  std::vector<Range> m_freeRanges;
+  uint32_t m_capacity{0};
+  uint32_t m_used{0};
+};
+
+/** Vertices and indices of one mesh inside a GeometryPool, handed back when destroyed. */
+class GeometryAllocation {
+public:
+  GeometryAllocation() = default;
+  GeometryAllocation(GeometryPool* pool, uint32_t baseVertex, uint32_t numVertices,
+                     uint32_t firstIndex, uint32_t numIndices)
+      : m_pool(pool),
+        m_baseVertex(baseVertex),
+        m_numVertices(numVertices),
+        m_firstIndex(firstIndex),
+        m_numIndices(numIndices) {}
+  ~GeometryAllocation() { Release(); }
+
+  GeometryAllocation(const GeometryAllocation&)            = delete;
+  GeometryAllocation& operator=(const GeometryAllocation&) = delete;
+  GeometryAllocation(GeometryAllocation&& other) noexcept { *this = std::move(other); }
+  GeometryAllocation& operator=(GeometryAllocation&& other) noexcept;
+
+  [[nodiscard]] bool IsValid() const { return m_pool != nullptr; }
+  [[nodiscard]] uint32_t GetBaseVertex() const { return m_baseVertex; }
+  [[nodiscard]] uint32_t GetNumVertices() const { return m_numVertices; }
+  [[nodiscard]] uint32_t GetFirstIndex() const { return m_firstIndex; }
+  [[nodiscard]] uint32_t GetNumIndices() const { return m_numIndices; }
+
+private:
+  void Release();
+
+  GeometryPool* m_pool{nullptr};
+  uint32_t m_baseVertex{0};
+  uint32_t m_numVertices{0};
+  uint32_t m_firstIndex{0};
+  uint32_t m_numIndices{0};
+};
+
+struct GeometryPoolStats {
+  uint32_t numAllocations{0};
+  uint32_t vertexCapacity{0};
+  uint32_t usedVertices{0};
+  uint32_t indexCapacity{0};
+  uint32_t usedIndices{0};
+  uint32_t numFreeVertexRanges{0};
+  uint32_t numFreeIndexRanges{0};
+  float vertexFragmentation{0.0f};
+  float indexFragmentation{0.0f};
+  // times the buffers were reallocated to make room
+  uint32_t numGrowths{0};
+  uint64_t vertexBytes{0};
+  uint64_t indexBytes{0};
+};
+
+/**
+ * Static meshes of one vertex format suballocated from a vertex and an index buffer with
+ * immutable storage, behind a single vertex array. A mesh keeps its base vertex and first index;
+ * its indices stay relative to its own vertices, so draws add the base vertex. When a buffer runs
+ * full it is replaced by one twice the size and the contents are copied over on the GPU, which
+ * keeps every allocation where it was. GL thread only.
+ */
+class GeometryPool {
+public:
+  static constexpr uint32_t InitialVertexCapacity = 1u << 20;
+  static constexpr uint32_t InitialIndexCapacity  = 1u << 22;
+
+  /** The pool of PackedVertex meshes. */
+  static GeometryPool& GetShared();
+
+  explicit GeometryPool(const BufferView& format);
+  /** Holds no GL objects by then, Shutdown deletes them while the context is current. */
+  ~GeometryPool();
+
+  GeometryPool(const GeometryPool&)            = delete;
+  GeometryPool& operator=(const GeometryPool&) = delete;
+
+  /** Room for a mesh, the buffers grow when it does not fit. */
+  GeometryAllocation Allocate(uint32_t numVertices, uint32_t numIndices);
+  /** Fill vertices of an allocation, data holds numVertices of them from baseVertex on. */
+  void WriteVertices(const GeometryAllocation& allocation, const void* data);
+  void WriteIndices(const GeometryAllocation& allocation, const uint32_t* indices);
+
+  /** Bind the shared vertex array, every mesh of the pool draws from it. */
+  void Bind() const;
+
+  /** Buffer objects for copies into an allocation, they change when the pool grows. */
+  [[nodiscard]] uint32_t GetVertexBuffer() const { return m_vertexBuffer; }
+  [[nodiscard]] uint32_t GetIndexBuffer() const { return m_indexBuffer; }
+  [[nodiscard]] uint32_t GetVertexStride() const { return m_stride; }
+
+  [[nodiscard]] GeometryPoolStats GetStats() const;
+
+  /**
+   * Delete the buffers and the vertex array, called before the GL context goes away. Allocations
+   * still alive are dropped, the next Allocate creates the buffers again.
+   */
+  void Shutdown();
+
+private:
+  friend class GeometryAllocation;
+  void Free(const GeometryAllocation& allocation);
+  void CreateBuffers();
+  /** Move a buffer into new storage of capacity elements of size bytes. */
+  static void GrowBuffer(uint32_t& buffer, uint32_t oldCapacity, uint32_t capacity,
+                         uint32_t elementSize);
+
+  BufferView m_format;
+  uint32_t m_stride{0};
+  Ref<VertexArray> m_vao;
+  uint32_t m_vertexBuffer{0};
+  uint32_t m_indexBuffer{0};
+  RangeAllocator m_vertices;
+  RangeAllocator m_indices;
+  uint32_t m_numAllocations{0};
+  uint32_t m_numGrowths{0};
+};
+}  // namespace photon::gl
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -19,7 +20,17 @@ enum class BufferDataType {
   Int,
   Vec2i,
   Vec3i,
-  Vec4i
+  Vec4i,
+  // 16-bit floats
+  Vec2h,
+  Vec4h,
+  // 16-bit integers, read as [-1, 1] or [0, 1] floats when the element is normalized
+  Vec2s,
+  Vec4s,
+  Vec2us,
+  Vec4us,
+  // 8-bit unsigned integers
+  Vec4ub
 };
 static size_t data_type_size(BufferDataType type) {
   switch (type) {
@@ -45,6 +56,16 @@ static size_t data_type_size(BufferDataType type) {
       return sizeof(int) * 3;
     case BufferDataType::Vec4i:
       return sizeof(int) * 4;
+    case BufferDataType::Vec2h:
+    case BufferDataType::Vec2s:
+    case BufferDataType::Vec2us:
+      return sizeof(uint16_t) * 2;
+    case BufferDataType::Vec4h:
+    case BufferDataType::Vec4s:
+    case BufferDataType::Vec4us:
+      return sizeof(uint16_t) * 4;
+    case BufferDataType::Vec4ub:
+      return sizeof(uint8_t) * 4;
     default:
       return 0;
   }
@@ -59,12 +80,19 @@ static uint32_t data_type_count(BufferDataType type) {
       return 1;
     case BufferDataType::Vec2f:
     case BufferDataType::Vec2i:
+    case BufferDataType::Vec2h:
+    case BufferDataType::Vec2s:
+    case BufferDataType::Vec2us:
       return 2;
     case BufferDataType::Vec3f:
     case BufferDataType::Vec3i:
       return 3;
     case BufferDataType::Vec4f:
     case BufferDataType::Vec4i:
+    case BufferDataType::Vec4h:
+    case BufferDataType::Vec4s:
+    case BufferDataType::Vec4us:
+    case BufferDataType::Vec4ub:
     case BufferDataType::Mat2f:
       return 4;
     case BufferDataType::Mat3f:
@@ -127,6 +155,7 @@ public:
   void SetData(uint32_t size, const void* data);
 
   [[nodiscard]] const BufferView& GetBufferView() const { return m_bufferView; }
+  [[nodiscard]] uint32_t GetId() const { return m_id; }
 
 private:
   uint32_t m_id{0};
@@ -142,6 +171,7 @@ public:
   ~IndexBuffer();
 
   uint32_t GetCount() const { return m_count; }
+  uint32_t GetId() const { return m_id; }
 
   void Bind() const;
   void Unbind() const;
@@ -1,6 +1,7 @@
 #include "shader.hpp"
 #include <utility>
 #include "Common/Logging.hpp"
+#include "StateCache.hpp"
 #include "Utils/ShaderCache.hpp"
 
 namespace photon::gl {
@@ -100,91 +101,141 @@ Ref<ShaderProgram> ShaderProgramFactory::CreateShaderProgram(const ShaderProgram
 }
 
 ShaderProgram::ShaderProgram(std::string name, GLuint id) : m_id(id), m_name(std::move(name)) {
-  GetUniforms();
+  Reflect();
 }
 
 ShaderProgram::~ShaderProgram() {
   if (m_id != 0) {
+    StateCache::GetShared().ForgetProgram(m_id);
     glDeleteProgram(m_id);
   }
 }
 
 ShaderProgram::ShaderProgram(ShaderProgram&& other) noexcept {
-  m_uniforms = std::move(other.m_uniforms);
-  m_id       = other.m_id;
-  m_name     = std::move(other.m_name);
-  other.m_id = 0;
+  m_uniforms      = std::move(other.m_uniforms);
+  m_uniformBlocks = std::move(other.m_uniformBlocks);
+  m_storageBlocks = std::move(other.m_storageBlocks);
+  m_id            = other.m_id;
+  m_name          = std::move(other.m_name);
+  other.m_id      = 0;
 }
 
 ShaderProgram& ShaderProgram::Use() {
-  glUseProgram(m_id);
+  StateCache::GetShared().UseProgram(m_id);
   return *this;
 }
 
-ShaderProgram& ShaderProgram::SetUniform(const std::string& name, int value) {
-  if (m_uniforms.contains(name)) {
-    glUniform1i(m_uniforms.at(name), value);
-  }
-  return *this;
+void ProgramUniform(GLuint program, GLint location, int value) {
+  glProgramUniform1i(program, location, value);
 }
 
-ShaderProgram& ShaderProgram::SetUniform(const std::string& name, float value) {
-  if (m_uniforms.contains(name)) {
-    glUniform1f(m_uniforms.at(name), value);
-  }
-  return *this;
+void ProgramUniform(GLuint program, GLint location, float value) {
+  glProgramUniform1f(program, location, value);
 }
 
-ShaderProgram& ShaderProgram::SetUniform(const std::string& name, const glm::vec2& value) {
-  if (m_uniforms.contains(name)) {
-    glUniform2fv(m_uniforms.at(name), 1, value_ptr(value));
-  }
-  return *this;
+void ProgramUniform(GLuint program, GLint location, const glm::vec2& value) {
+  glProgramUniform2fv(program, location, 1, value_ptr(value));
 }
 
-ShaderProgram& ShaderProgram::SetUniform(const std::string& name, const glm::vec3& value) {
-  if (m_uniforms.contains(name)) {
-    glUniform3fv(m_uniforms.at(name), 1, value_ptr(value));
-  }
-  return *this;
+void ProgramUniform(GLuint program, GLint location, const glm::vec3& value) {
+  glProgramUniform3fv(program, location, 1, value_ptr(value));
+}
+
+void ProgramUniform(GLuint program, GLint location, const glm::vec4& value) {
+  glProgramUniform4fv(program, location, 1, value_ptr(value));
+}
+
+void ProgramUniform(GLuint program, GLint location, const glm::mat3x3& value) {
+  glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, value_ptr(value));
+}
+
+void ProgramUniform(GLuint program, GLint location, const glm::mat4x4& value) {
+  glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, value_ptr(value));
 }
 
-ShaderProgram& ShaderProgram::SetUniform(const std::string& name, const glm::vec4& value) {
-  if (m_uniforms.contains(name)) {
-    glUniform4fv(m_uniforms.at(name), 1, value_ptr(value));
+template <typename Info>
+void ShaderProgram::Add(InterfaceTable<Info>& table, Info info) {
+  if (const auto* existing = table.Add(info); existing != nullptr) {
+    LOGE("Names {} and {} of program {} hash alike, {} is not reachable by name", existing->name,
+         info.name, m_name, info.name);
   }
-  return *this;
 }
 
-ShaderProgram& ShaderProgram::SetUniform(const std::string& name, const glm::mat3x3& value) {
-  if (m_uniforms.contains(name)) {
-    glUniformMatrix3fv(m_uniforms.at(name), 1, GL_FALSE, value_ptr(value));
+bool ShaderProgram::CheckUniformBlock(UniformId id, GLint binding, size_t size) const {
+  return CheckBlock(FindUniformBlock(id), binding, size);
+}
+
+bool ShaderProgram::CheckStorageBlock(UniformId id, GLint binding, size_t size) const {
+  return CheckBlock(FindStorageBlock(id), binding, size);
+}
+
+bool ShaderProgram::CheckBlock(const BlockInfo* block, GLint binding, size_t size) const {
+  if (block == nullptr) {
+    return true;
   }
-  return *this;
+  if (block->binding != binding || static_cast<size_t>(block->dataSize) != size) {
+    LOGE("Block {} of program {} is {} bytes at binding {}, expected {} bytes at binding {}",
+         block->name, m_name, block->dataSize, block->binding, size, binding);
+    return false;
+  }
+  return true;
 }
 
-ShaderProgram& ShaderProgram::SetUniform(const std::string& name, const glm::mat4x4& value) {
-  if (m_uniforms.contains(name)) {
-    glUniformMatrix4fv(m_uniforms.at(name), 1, GL_FALSE, value_ptr(value));
-  } else {
-    int location = glGetUniformLocation(m_id, name.data());
-    glUniformMatrix4fv(location, 1, GL_FALSE, value_ptr(value));
+void ShaderProgram::CheckType(const UniformInfo& info, GLenum type) const {
+  // bools are set as ints
+  if (info.type != type && !(type == GL_INT && info.type == GL_BOOL)) {
+    LOGW("Uniform {} of program {} has GL type {:#x}, resolved as {:#x}", info.name, m_name,
+         info.type, type);
   }
-  return *this;
 }
 
-void ShaderProgram::GetUniforms() {
-  int num_uniforms = 0;
-  glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &num_uniforms);
-  for (auto i = 0U; i < num_uniforms; i++) {
-    auto name_len = -1, size = -1;
-    GLenum type = GL_ZERO;
-    char name[128];
-    glGetActiveUniform(m_id, i, sizeof(name) - 1, &name_len, &size, &type, name);
-    name[name_len] = 0;
+void ShaderProgram::Reflect() {
+  GLint numUniforms = 0;
+  glGetProgramInterfaceiv(m_id, GL_UNIFORM, GL_ACTIVE_RESOURCES, &numUniforms);
+  const GLenum props[] = {GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE};
+  for (GLint i = 0; i < numUniforms; i++) {
+    GLint values[4]{};
+    glGetProgramResourceiv(m_id, GL_UNIFORM, i, 4, props, 4, nullptr, values);
+    // members of uniform blocks have no location
+    if (values[2] < 0 || values[0] <= 1) {
+      continue;
+    }
+    UniformInfo info;
+    info.name.resize(values[0]);
+    glGetProgramResourceName(m_id, GL_UNIFORM, i, values[0], nullptr, info.name.data());
+    info.name.resize(values[0] - 1);
+    info.type      = static_cast<GLenum>(values[1]);
+    info.location  = values[2];
+    info.arraySize = values[3];
+    // arrays are reported as name[0], they are found by their plain name too
+    if (info.name.ends_with("[0]")) {
+      auto element = info;
+      info.name.resize(info.name.size() - 3);
+      Add(m_uniforms, std::move(element));
+    }
+    Add(m_uniforms, std::move(info));
+  }
+  ReflectBlocks(GL_UNIFORM_BLOCK, m_uniformBlocks);
+  ReflectBlocks(GL_SHADER_STORAGE_BLOCK, m_storageBlocks);
+}
 
-    const auto nameStr = std::string(name);
-    m_uniforms.try_emplace(nameStr, glGetUniformLocation(m_id, name));
+void ShaderProgram::ReflectBlocks(GLenum interface, InterfaceTable<BlockInfo>& blocks) {
+  GLint numBlocks = 0;
+  glGetProgramInterfaceiv(m_id, interface, GL_ACTIVE_RESOURCES, &numBlocks);
+  const GLenum props[] = {GL_NAME_LENGTH, GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE};
+  for (GLint i = 0; i < numBlocks; i++) {
+    GLint values[3]{};
+    glGetProgramResourceiv(m_id, interface, i, 3, props, 3, nullptr, values);
+    if (values[0] <= 1) {
+      continue;
+    }
+    BlockInfo block;
+    block.name.resize(values[0]);
+    glGetProgramResourceName(m_id, interface, i, values[0], nullptr, block.name.data());
+    block.name.resize(values[0] - 1);
+    block.binding  = values[1];
+    block.dataSize = values[2];
+    Add(blocks, std::move(block));
   }
 }
-}  // namespace photon::gl
\ No newline at end of file
+}  // namespace photon::gl
@@ -1,11 +1,17 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/mat4x4.hpp>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <glad/glad.h>
 #include "Common/Base.hpp"
@@ -30,6 +36,134 @@ struct ShaderProgramCreateInfo {
   const std::vector<ShaderStage> stages;
 };
 
+/**
+ * FNV-1a hash of a uniform or block name. Built from a string literal it is computed at compile
+ * time, so looking a name up hashes nothing and allocates nothing at run time.
+ */
+class UniformId {
+public:
+  template <size_t N>
+  consteval UniformId(const char (&name)[N]) : m_hash(Hash({name, N - 1})) {}
+
+  static constexpr UniformId FromName(std::string_view name) { return UniformId(Hash(name)); }
+
+  [[nodiscard]] constexpr uint32_t GetHash() const { return m_hash; }
+
+private:
+  explicit constexpr UniformId(uint32_t hash) : m_hash(hash) {}
+
+  static constexpr uint32_t Hash(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (const char c : name) {
+      hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+  }
+
+  uint32_t m_hash;
+};
+
+/** An active uniform of the default block as the linked program reports it. */
+struct UniformInfo {
+  std::string name;
+  GLint location{-1};
+  GLenum type{GL_NONE};
+  GLint arraySize{0};
+};
+
+/** An active uniform or shader storage block. */
+struct BlockInfo {
+  std::string name;
+  GLint binding{-1};
+  // for a trailing unsized array, the size with one element
+  GLint dataSize{0};
+};
+
+/** Reflected entries of one interface of a program, sorted by the hash of their names. */
+template <typename Info>
+class InterfaceTable {
+public:
+  [[nodiscard]] const Info* Find(UniformId id) const {
+    const auto it = LowerBound(id.GetHash());
+    return it != m_entries.end() && it->first == id.GetHash() ? &it->second : nullptr;
+  }
+
+  /** The entry already there when another name hashes alike, nullptr once added. */
+  const Info* Add(Info info) {
+    const auto hash = UniformId::FromName(info.name).GetHash();
+    const auto it   = LowerBound(hash);
+    if (it != m_entries.end() && it->first == hash) {
+      return &it->second;
+    }
+    m_entries.emplace(it, hash, std::move(info));
+    return nullptr;
+  }
+
+  [[nodiscard]] size_t GetSize() const { return m_entries.size(); }
+
+private:
+  using Entry = std::pair<uint32_t, Info>;
+
+  auto LowerBound(uint32_t hash) const {
+    return std::lower_bound(m_entries.begin(), m_entries.end(), hash,
+                            [](const Entry& entry, uint32_t h) { return entry.first < h; });
+  }
+
+  // a handful of entries per program, a binary search beats hashing the key again
+  std::vector<Entry> m_entries;
+};
+
+/** Location of a uniform of type T, resolved once by ShaderProgram::GetUniform. */
+template <typename T>
+class Uniform {
+public:
+  Uniform() = default;
+  explicit Uniform(GLint location) : m_location(location) {}
+
+  [[nodiscard]] bool IsValid() const { return m_location >= 0; }
+  [[nodiscard]] GLint GetLocation() const { return m_location; }
+
+private:
+  // -1 when the program has no such uniform, setting it does nothing
+  GLint m_location{-1};
+};
+
+void ProgramUniform(GLuint program, GLint location, int value);
+void ProgramUniform(GLuint program, GLint location, float value);
+void ProgramUniform(GLuint program, GLint location, const glm::vec2& value);
+void ProgramUniform(GLuint program, GLint location, const glm::vec3& value);
+void ProgramUniform(GLuint program, GLint location, const glm::vec4& value);
+void ProgramUniform(GLuint program, GLint location, const glm::mat3x3& value);
+void ProgramUniform(GLuint program, GLint location, const glm::mat4x4& value);
+
+/** The GL type a uniform set from T has, GL_NONE when T is not a uniform type. */
+template <typename T>
+constexpr GLenum UniformType() {
+  if constexpr (std::is_same_v<T, int>) {
+    return GL_INT;
+  } else if constexpr (std::is_same_v<T, float>) {
+    return GL_FLOAT;
+  } else if constexpr (std::is_same_v<T, glm::vec2>) {
+    return GL_FLOAT_VEC2;
+  } else if constexpr (std::is_same_v<T, glm::vec3>) {
+    return GL_FLOAT_VEC3;
+  } else if constexpr (std::is_same_v<T, glm::vec4>) {
+    return GL_FLOAT_VEC4;
+  } else if constexpr (std::is_same_v<T, glm::mat3x3>) {
+    return GL_FLOAT_MAT3;
+  } else if constexpr (std::is_same_v<T, glm::mat4x4>) {
+    return GL_FLOAT_MAT4;
+  } else {
+    return GL_NONE;
+  }
+}
+
+/**
+ * A linked program and the interface reflected from it once at link time: its uniforms, uniform
+ * blocks and shader storage blocks, kept by the hash of their names. Uniforms are set with
+ * glProgramUniform, the program need not be in use. Per frame state goes through Uniform handles
+ * resolved up front, cold code may set by name.
+ */
 class ShaderProgram {
 public:
   ShaderProgram(std::string name, GLuint id);
@@ -39,23 +173,67 @@ public:
 
   ShaderProgram& Use();
 
-  ShaderProgram& SetUniform(const std::string& name, int value);
-  ShaderProgram& SetUniform(const std::string& name, float value);
-  ShaderProgram& SetUniform(const std::string& name, const glm::vec2& value);
-  ShaderProgram& SetUniform(const std::string& name, const glm::vec3& value);
-  ShaderProgram& SetUniform(const std::string& name, const glm::vec4& value);
-  ShaderProgram& SetUniform(const std::string& name, const glm::mat3x3& value);
-  ShaderProgram& SetUniform(const std::string& name, const glm::mat4x4& value);
+  /** Resolve a uniform, logs when the program declares it with another type. */
+  template <typename T>
+  Uniform<T> GetUniform(UniformId id) const {
+    static_assert(UniformType<T>() != GL_NONE, "not a uniform type");
+    const auto* info = FindUniform(id);
+    if (info == nullptr) {
+      return {};
+    }
+    CheckType(*info, UniformType<T>());
+    return Uniform<T>(info->location);
+  }
+
+  template <typename T>
+  ShaderProgram& SetUniform(const Uniform<T>& uniform, const T& value) {
+    if (uniform.IsValid()) {
+      ProgramUniform(m_id, uniform.GetLocation(), value);
+    }
+    return *this;
+  }
+
+  /** Set by name, one search of the reflected uniforms. Does nothing for unknown names. */
+  template <typename T>
+  ShaderProgram& SetUniform(UniformId id, const T& value) {
+    if (const auto* info = FindUniform(id); info != nullptr) {
+      ProgramUniform(m_id, info->location, value);
+    }
+    return *this;
+  }
 
   ShaderProgram(const ShaderProgram&)            = delete;
   ShaderProgram& operator=(ShaderProgram&&)      = delete;
   ShaderProgram& operator=(const ShaderProgram&) = delete;
 
-  auto GetLocation(const std::string& name) const { return m_uniforms.at(name); }
+  [[nodiscard]] const UniformInfo* FindUniform(UniformId id) const { return m_uniforms.Find(id); }
+  [[nodiscard]] const BlockInfo* FindUniformBlock(UniformId id) const {
+    return m_uniformBlocks.Find(id);
+  }
+  [[nodiscard]] const BlockInfo* FindStorageBlock(UniformId id) const {
+    return m_storageBlocks.Find(id);
+  }
+
+  /**
+   * Log an error unless an active block sits at binding and is size bytes large, the layout the
+   * C++ side writes. Blocks the compiler dropped pass.
+   */
+  bool CheckUniformBlock(UniformId id, GLint binding, size_t size) const;
+  bool CheckStorageBlock(UniformId id, GLint binding, size_t size) const;
+
+  [[nodiscard]] GLuint GetId() const { return m_id; }
 
 private:
-  void GetUniforms();
-  std::unordered_map<std::string, int> m_uniforms;  // <name, location>
+  template <typename Info>
+  void Add(InterfaceTable<Info>& table, Info info);
+  bool CheckBlock(const BlockInfo* block, GLint binding, size_t size) const;
+  void CheckType(const UniformInfo& info, GLenum type) const;
+
+  void Reflect();
+  void ReflectBlocks(GLenum interface, InterfaceTable<BlockInfo>& blocks);
+  InterfaceTable<UniformInfo> m_uniforms;
+  InterfaceTable<BlockInfo> m_uniformBlocks;
+  InterfaceTable<BlockInfo> m_storageBlocks;
   GLuint m_id{0};
   std::string m_name;
 };
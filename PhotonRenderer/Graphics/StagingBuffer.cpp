@@ -0,0 +1,98 @@
+#include "StagingBuffer.hpp"
+#include <cstring>
+#include "Common/Logging.hpp"
+
+namespace photon::gl {
+namespace {
+inline uint32_t AlignUp(uint32_t value, uint32_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+StagingBuffer::StagingBuffer(uint32_t regionSize) : m_regionSize(regionSize) {
+  constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  const GLsizeiptr size      = static_cast<GLsizeiptr>(regionSize) * NumRegions;
+  glCreateBuffers(1, &m_id);
+  glNamedBufferStorage(m_id, size, nullptr, flags);
+  m_mapped = static_cast<unsigned char*>(glMapNamedBufferRange(m_id, 0, size, flags));
+  if (m_mapped == nullptr) {
+    LOGE("Failed to map staging buffer of {} bytes", size);
+  }
+  // BeginFrame moves on to region 0
+  m_region = NumRegions - 1;
+}
+
+StagingBuffer::~StagingBuffer() {
+  for (auto& fence : m_fences) {
+    if (fence != nullptr) {
+      glDeleteSync(fence);
+    }
+  }
+  if (m_mapped != nullptr) {
+    glUnmapNamedBuffer(m_id);
+  }
+  glDeleteBuffers(1, &m_id);
+}
+
+void StagingBuffer::BeginFrame() {
+  m_region    = (m_region + 1) % NumRegions;
+  m_head      = 0;
+  auto& fence = m_fences[m_region];
+  if (fence == nullptr) {
+    return;
+  }
+  constexpr GLuint64 Timeout = 1'000'000;  // 1 ms
+  GLenum status              = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, Timeout);
+  while (status == GL_TIMEOUT_EXPIRED) {
+    status = glClientWaitSync(fence, 0, Timeout);
+  }
+  glDeleteSync(fence);
+  fence = nullptr;
+}
+
+void StagingBuffer::EndFrame() {
+  if (m_head > 0) {
+    m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+}
+
+uint32_t StagingBuffer::GetAvailable(uint32_t alignment) const {
+  const auto head = AlignUp(m_head, alignment);
+  return m_mapped != nullptr && head < m_regionSize ? m_regionSize - head : 0;
+}
+
+bool StagingBuffer::Write(const void* data, uint32_t size, uint32_t alignment,
+                          uint32_t& offset) {
+  if (size == 0 || size > GetAvailable(alignment)) {
+    return false;
+  }
+  const auto head = AlignUp(m_head, alignment);
+  offset          = m_region * m_regionSize + head;
+  std::memcpy(m_mapped + offset, data, size);
+  m_head = head + size;
+  return true;
+}
+
+void StagingBuffer::CopyToBuffer(uint32_t offset, uint32_t buffer, uint64_t bufferOffset,
+                                 uint32_t size) const {
+  glCopyNamedBufferSubData(m_id, buffer, offset, static_cast<GLintptr>(bufferOffset), size);
+}
+
+void StagingBuffer::CopyToTexture(uint32_t offset, uint32_t texture, int y, int width, int height,
+                                  GLenum format, GLenum type) const {
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_id);
+  glTextureSubImage2D(texture, 0, 0, y, width, height, format, type,
+                      reinterpret_cast<const void*>(static_cast<uintptr_t>(offset)));
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void StagingBuffer::CopyToCompressedTexture(uint32_t offset, uint32_t texture, int level, int y,
+                                            int width, int height, GLenum internalFormat,
+                                            uint32_t size) const {
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_id);
+  glCompressedTextureSubImage2D(texture, level, 0, y, width, height, internalFormat,
+                                static_cast<GLsizei>(size),
+                                reinterpret_cast<const void*>(static_cast<uintptr_t>(offset)));
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+}  // namespace photon::gl
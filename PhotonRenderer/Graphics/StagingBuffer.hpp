@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <array>
+#include "Common/Base.hpp"
+
+namespace photon::gl {
+/**
+ * Persistently mapped upload ring made of one region per frame in flight. Copies recorded from a
+ * region are fenced at the end of its frame, and the region is only rewritten once they are done.
+ */
+class StagingBuffer {
+public:
+  static constexpr uint32_t NumRegions = 3;
+
+  static Ref<StagingBuffer> Create(uint32_t regionSize) {
+    return CreateRef<StagingBuffer>(regionSize);
+  }
+  explicit StagingBuffer(uint32_t regionSize);
+  ~StagingBuffer();
+
+  StagingBuffer(const StagingBuffer&)            = delete;
+  StagingBuffer& operator=(const StagingBuffer&) = delete;
+
+  /** Switch to the next region, waiting for the GPU if it still reads from it. */
+  void BeginFrame();
+  /** Fence the copies recorded since BeginFrame. */
+  void EndFrame();
+
+  /** Bytes still free in this frame's region after aligning to alignment. */
+  [[nodiscard]] uint32_t GetAvailable(uint32_t alignment) const;
+  /** Copy size bytes into this frame's region, returns false when they do not fit. */
+  bool Write(const void* data, uint32_t size, uint32_t alignment, uint32_t& offset);
+
+  /** Copy from staging into a buffer object. */
+  void CopyToBuffer(uint32_t offset, uint32_t buffer, uint64_t bufferOffset, uint32_t size) const;
+  /** Copy rows [y, y + height) of mip 0 from staging into a texture. */
+  void CopyToTexture(uint32_t offset, uint32_t texture, int y, int width, int height,
+                     GLenum format, GLenum type) const;
+  /** Copy size bytes of whole block rows, starting at texel row y, into a level of a texture. */
+  void CopyToCompressedTexture(uint32_t offset, uint32_t texture, int level, int y, int width,
+                               int height, GLenum internalFormat, uint32_t size) const;
+
+  [[nodiscard]] uint32_t GetRegionSize() const { return m_regionSize; }
+
+private:
+  uint32_t m_id{0};
+  uint32_t m_regionSize{0};
+  unsigned char* m_mapped{nullptr};
+  std::array<GLsync, NumRegions> m_fences{};
+  uint32_t m_region{0};
+  // write position inside the current region
+  uint32_t m_head{0};
+};
+}  // namespace photon::gl
@@ -0,0 +1,149 @@
+#include "StateCache.hpp"
+
+namespace photon::gl {
+namespace {
+int CapabilityIndex(GLenum capability) {
+  switch (capability) {
+    case GL_DEPTH_TEST:
+      return 0;
+    case GL_BLEND:
+      return 1;
+    case GL_CULL_FACE:
+      return 2;
+    case GL_FRAMEBUFFER_SRGB:
+      return 3;
+    case GL_TEXTURE_CUBE_MAP_SEAMLESS:
+      return 4;
+    default:
+      return -1;
+  }
+}
+}  // namespace
+
+StateCache& StateCache::GetShared() {
+  // trivially destructible, textures and vertex arrays freed by other statics may still use it
+  static StateCache cache;
+  return cache;
+}
+
+void StateCache::SetEnabled(GLenum capability, bool enabled) {
+  const auto index = CapabilityIndex(capability);
+  if (index < 0) {
+    // not tracked, always issued
+    m_stats.issued++;
+  } else if (!Change(m_capabilities[index], enabled ? Tri::On : Tri::Off)) {
+    return;
+  }
+  if (enabled) {
+    glEnable(capability);
+  } else {
+    glDisable(capability);
+  }
+}
+
+void StateCache::DepthFunc(GLenum func) {
+  if (Change(m_depthFunc, func)) {
+    glDepthFunc(func);
+  }
+}
+
+void StateCache::DepthMask(bool write) {
+  if (Change(m_depthMask, write ? Tri::On : Tri::Off)) {
+    glDepthMask(write ? GL_TRUE : GL_FALSE);
+  }
+}
+
+void StateCache::BlendFunc(GLenum sourceFactor, GLenum destFactor) {
+  if (Change(m_blendFunc, {sourceFactor, destFactor})) {
+    glBlendFunc(sourceFactor, destFactor);
+  }
+}
+
+void StateCache::CullFace(GLenum mode) {
+  if (Change(m_cullFace, mode)) {
+    glCullFace(mode);
+  }
+}
+
+void StateCache::LineWidth(float width) {
+  if (Change(m_lineWidth, width)) {
+    glLineWidth(width);
+  }
+}
+
+void StateCache::ClearColor(const glm::vec4& color) {
+  if (Change(m_clearColor, color)) {
+    glClearColor(color.r, color.g, color.b, color.a);
+  }
+}
+
+void StateCache::UseProgram(GLuint program) {
+  if (Change(m_program, program)) {
+    glUseProgram(program);
+  }
+}
+
+void StateCache::BindVertexArray(GLuint vertexArray) {
+  if (Change(m_vertexArray, vertexArray)) {
+    glBindVertexArray(vertexArray);
+  }
+}
+
+void StateCache::BindTextureUnit(GLuint unit, GLuint texture) {
+  if (unit >= NumTextureUnits) {
+    m_stats.issued++;
+    glBindTextureUnit(unit, texture);
+    return;
+  }
+  if (Change(m_textureUnits[unit], texture)) {
+    glBindTextureUnit(unit, texture);
+  }
+}
+
+void StateCache::BindDrawIndirectBuffer(GLuint buffer) {
+  if (Change(m_drawIndirectBuffer, buffer)) {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+  }
+}
+
+void StateCache::ForgetProgram(GLuint program) {
+  // a deleted program stays in use until another one is, but its name may come back
+  if (m_program == program) {
+    m_program = UnknownName;
+  }
+}
+
+void StateCache::ForgetVertexArray(GLuint vertexArray) {
+  if (m_vertexArray == vertexArray) {
+    m_vertexArray = UnknownName;
+  }
+}
+
+void StateCache::ForgetTexture(GLuint texture) {
+  for (auto& bound : m_textureUnits) {
+    if (bound == texture) {
+      bound = UnknownName;
+    }
+  }
+}
+
+void StateCache::ForgetBuffer(GLuint buffer) {
+  if (m_drawIndirectBuffer == buffer) {
+    m_drawIndirectBuffer = UnknownName;
+  }
+}
+
+void StateCache::Invalidate() {
+  m_capabilities.fill(Tri::Unknown);
+  m_depthFunc          = GL_NONE;
+  m_depthMask          = Tri::Unknown;
+  m_blendFunc          = {GL_NONE, GL_NONE};
+  m_cullFace           = GL_NONE;
+  m_lineWidth          = 0.0f;
+  m_clearColor         = glm::vec4(-1.0f);
+  m_program            = UnknownName;
+  m_vertexArray        = UnknownName;
+  m_drawIndirectBuffer = UnknownName;
+  m_textureUnits.fill(UnknownName);
+}
+}  // namespace photon::gl
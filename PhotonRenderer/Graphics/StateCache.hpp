@@ -0,0 +1,90 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <array>
+#include <cstdint>
+#include <glm/vec4.hpp>
+
+namespace photon::gl {
+/** State changes asked of the cache since the last ResetStats. */
+struct StateCacheStats {
+  // passed on to the driver
+  uint32_t issued{0};
+  // dropped because the state was already set
+  uint32_t elided{0};
+};
+
+/**
+ * Shadow of the GL state the renderer changes between draws. Every change goes through here and
+ * only reaches the driver when it differs from what was last set. State starts out unknown, so
+ * the first change of each is always issued. Code that changes state behind the cache must call
+ * Invalidate, and deleted objects must be forgotten since GL unbinds them and reuses their names.
+ * Capabilities other than the tracked ones pass through. GL thread only.
+ */
+class StateCache {
+public:
+  static constexpr uint32_t NumTextureUnits = 32;
+
+  static StateCache& GetShared();
+
+  void Enable(GLenum capability) { SetEnabled(capability, true); }
+  void Disable(GLenum capability) { SetEnabled(capability, false); }
+  void SetEnabled(GLenum capability, bool enabled);
+
+  void DepthFunc(GLenum func);
+  void DepthMask(bool write);
+  void BlendFunc(GLenum sourceFactor, GLenum destFactor);
+  void CullFace(GLenum mode);
+  void LineWidth(float width);
+  void ClearColor(const glm::vec4& color);
+
+  void UseProgram(GLuint program);
+  void BindVertexArray(GLuint vertexArray);
+  void BindTextureUnit(GLuint unit, GLuint texture);
+  void BindDrawIndirectBuffer(GLuint buffer);
+
+  /** Drop deleted objects from the shadow, a new object may get the same name. */
+  void ForgetProgram(GLuint program);
+  void ForgetVertexArray(GLuint vertexArray);
+  void ForgetTexture(GLuint texture);
+  void ForgetBuffer(GLuint buffer);
+
+  /** Forget all state, the next change of each is issued. */
+  void Invalidate();
+
+  void ResetStats() { m_stats = {}; }
+  [[nodiscard]] const StateCacheStats& GetStats() const { return m_stats; }
+
+private:
+  StateCache() { Invalidate(); }
+
+  enum class Tri : uint8_t { Unknown, Off, On };
+  static constexpr GLuint UnknownName = ~0u;
+
+  /** Whether to issue a change from current to value, current takes the value when it is. */
+  template <typename T>
+  bool Change(T& current, const T& value) {
+    if (current == value) {
+      m_stats.elided++;
+      return false;
+    }
+    current = value;
+    m_stats.issued++;
+    return true;
+  }
+
+  // the capabilities the renderer toggles, indexed by CapabilityIndex
+  std::array<Tri, 5> m_capabilities{};
+  GLenum m_depthFunc{GL_NONE};
+  Tri m_depthMask{Tri::Unknown};
+  std::array<GLenum, 2> m_blendFunc{};
+  GLenum m_cullFace{GL_NONE};
+  float m_lineWidth{0.0f};
+  glm::vec4 m_clearColor{-1.0f};
+  GLuint m_program{UnknownName};
+  GLuint m_vertexArray{UnknownName};
+  GLuint m_drawIndirectBuffer{UnknownName};
+  std::array<GLuint, NumTextureUnits> m_textureUnits{};
+  StateCacheStats m_stats;
+};
+}  // namespace photon::gl
@@ -0,0 +1,30 @@
+#include "StorageBuffer.hpp"
+#include <glad/glad.h>
+#include "StateCache.hpp"
+
+namespace photon::gl {
+StorageBuffer::StorageBuffer() {
+  glCreateBuffers(1, &m_id);
+}
+
+StorageBuffer::~StorageBuffer() {
+  StateCache::GetShared().ForgetBuffer(m_id);
+  glDeleteBuffers(1, &m_id);
+}
+
+void StorageBuffer::SetData(const void* data, uint64_t size) {
+  glNamedBufferData(m_id, static_cast<GLsizeiptr>(size), data, GL_STREAM_DRAW);
+}
+
+void StorageBuffer::SetSubData(const void* data, uint64_t size, uint64_t offset) {
+  glNamedBufferSubData(m_id, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+}
+
+void StorageBuffer::BindBase(uint32_t binding) const {
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_id);
+}
+
+void StorageBuffer::BindIndirect() const {
+  StateCache::GetShared().BindDrawIndirectBuffer(m_id);
+}
+}  // namespace photon::gl
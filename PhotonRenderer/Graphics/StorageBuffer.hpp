@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include "Common/Base.hpp"
+
+namespace photon::gl {
+/**
+ * Buffer for shader storage blocks and indirect draw commands. SetData replaces the contents as a
+ * whole and orphans the old storage, so draws still reading it are not waited on; SetSubData
+ * patches a part of it in place.
+ */
+class StorageBuffer {
+public:
+  static Ref<StorageBuffer> Create() { return CreateRef<StorageBuffer>(); }
+  StorageBuffer();
+  ~StorageBuffer();
+
+  StorageBuffer(const StorageBuffer&)            = delete;
+  StorageBuffer& operator=(const StorageBuffer&) = delete;
+
+  void SetData(const void* data, uint64_t size);
+  void SetSubData(const void* data, uint64_t size, uint64_t offset);
+  /** Bind to a shader storage block binding. */
+  void BindBase(uint32_t binding) const;
+  /** Bind as GL_DRAW_INDIRECT_BUFFER, commands are then read from offsets into it. */
+  void BindIndirect() const;
+
+  [[nodiscard]] uint32_t GetId() const { return m_id; }
+
+private:
+  uint32_t m_id{0};
+};
+}  // namespace photon::gl
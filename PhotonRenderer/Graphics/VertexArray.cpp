@@ -1,42 +1,97 @@
 #include "VertexArray.hpp"
 #include "Common/Logging.hpp"
+#include "StateCache.hpp"
 
 namespace photon::gl {
+namespace {
+GLenum GetComponentType(BufferDataType type) {
+  switch (type) {
+    case BufferDataType::Int:
+    case BufferDataType::Vec2i:
+    case BufferDataType::Vec3i:
+    case BufferDataType::Vec4i:
+      return GL_INT;
+    case BufferDataType::Vec2h:
+    case BufferDataType::Vec4h:
+      return GL_HALF_FLOAT;
+    case BufferDataType::Vec2s:
+    case BufferDataType::Vec4s:
+      return GL_SHORT;
+    case BufferDataType::Vec2us:
+    case BufferDataType::Vec4us:
+      return GL_UNSIGNED_SHORT;
+    case BufferDataType::Vec4ub:
+      return GL_UNSIGNED_BYTE;
+    default:
+      return GL_FLOAT;
+  }
+}
+}  // namespace
 
 VertexArray::VertexArray() {
   glCreateVertexArrays(1, &m_id);
 }
 
 VertexArray::~VertexArray() {
+  StateCache::GetShared().ForgetVertexArray(m_id);
   glDeleteVertexArrays(1, &m_id);
 }
 
 void VertexArray::Bind() const {
-  glBindVertexArray(m_id);
+  StateCache::GetShared().BindVertexArray(m_id);
 }
 
 void VertexArray::Unbind() const {
-  glBindVertexArray(0);
+  StateCache::GetShared().BindVertexArray(0);
 }
 
 void VertexArray::AttachVertexBuffer(const Ref<VertexBuffer>& vertexBuffer) {
   assert(!vertexBuffer->GetBufferView().get_elements().empty());
-  glBindVertexArray(m_id);
+  Bind();
   vertexBuffer->Bind();
   const auto& view     = vertexBuffer->GetBufferView();
   const auto& elements = view.get_elements();
   for (int i = 0; i < elements.size(); ++i) {
+    const auto& element = elements[i];
+    const auto type     = GetComponentType(element.type);
+    const auto* offset  = reinterpret_cast<void*>(element.offset);
     glEnableVertexAttribArray(i);
-    // only support floats/vecNf for now
-    glVertexAttribPointer(i, elements[i].count, GL_FLOAT, GL_FALSE, view.get_stride(),
-                          reinterpret_cast<void*>(elements[i].offset));
+    if (type == GL_FLOAT || type == GL_HALF_FLOAT || element.normalized) {
+      glVertexAttribPointer(i, element.count, type, element.normalized ? GL_TRUE : GL_FALSE,
+                            view.get_stride(), offset);
+    } else {
+      // integers stay integers, the shader reads them as ivecN/uvecN
+      glVertexAttribIPointer(i, element.count, type, view.get_stride(), offset);
+    }
   }
   m_vertexBuffers.push_back(vertexBuffer);
 }
 
 void VertexArray::AttachIndexBuffer(const Ref<IndexBuffer>& indexBuffer) {
-  glBindVertexArray(m_id);
+  Bind();
   indexBuffer->Bind();
   m_indexBuffer = indexBuffer;
 }
+
+void VertexArray::SetVertexFormat(const BufferView& view) {
+  const auto& elements = view.get_elements();
+  for (GLuint i = 0; i < elements.size(); ++i) {
+    const auto& element = elements[i];
+    const auto type     = GetComponentType(element.type);
+    const auto offset   = static_cast<GLuint>(element.offset);
+    glEnableVertexArrayAttrib(m_id, i);
+    if (type == GL_FLOAT || type == GL_HALF_FLOAT || element.normalized) {
+      glVertexArrayAttribFormat(m_id, i, element.count, type,
+                                element.normalized ? GL_TRUE : GL_FALSE, offset);
+    } else {
+      glVertexArrayAttribIFormat(m_id, i, element.count, type, offset);
+    }
+    glVertexArrayAttribBinding(m_id, i, 0);
+  }
+}
+
+void VertexArray::SetBuffers(uint32_t vertexBuffer, uint32_t stride, uint32_t indexBuffer) {
+  glVertexArrayVertexBuffer(m_id, 0, vertexBuffer, 0, stride);
+  glVertexArrayElementBuffer(m_id, indexBuffer);
+}
 }  // namespace photon::gl
\ No newline at end of file
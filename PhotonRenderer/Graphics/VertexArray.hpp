@@ -19,8 +19,13 @@ public:
 
   void AttachVertexBuffer(const Ref<VertexBuffer>& vertexBuffer);
   void AttachIndexBuffer(const Ref<IndexBuffer>& indexBuffer);
+  /** Describe the attributes of binding 0 for buffers owned elsewhere, see SetBuffers. */
+  void SetVertexFormat(const BufferView& view);
+  /** Point binding 0 and the element array at raw buffer objects, which the caller keeps. */
+  void SetBuffers(uint32_t vertexBuffer, uint32_t stride, uint32_t indexBuffer);
 
   const Ref<IndexBuffer>& GetIndexBuffer() const { return m_indexBuffer; }
+  const std::vector<Ref<VertexBuffer>>& GetVertexBuffers() const { return m_vertexBuffers; }
 
 private:
   uint32_t m_id{0};
@@ -34,6 +34,15 @@ glm::vec3 AABB::GetCenter() const {
   return (posMin + posMax) * 0.5f;
 }
 
+AABB AABB::Transform(const glm::mat4& matrix) const {
+  const auto center = glm::vec3(matrix * glm::vec4(GetCenter(), 1.0f));
+  // every axis of the box adds the absolute length it projects onto each world axis
+  const auto extent = glm::mat3(glm::abs(glm::vec3(matrix[0])), glm::abs(glm::vec3(matrix[1])),
+                                glm::abs(glm::vec3(matrix[2]))) *
+                      ((posMax - posMin) * 0.5f);
+  return {center - extent, center + extent};
+}
+
 void AABB::FillLinesData(Ref<Line>& data) const {
   glm::vec3 i = glm::vec3(1.0f, 0.0f, 0.0f);
   glm::vec3 j = glm::vec3(0.0f, 1.0f, 0.0f);
@@ -1,5 +1,8 @@
 #pragma once
+#include <array>
+#include <cstdint>
 #include <glm/glm.hpp>
+#include <vector>
 #include "Common/Base.hpp"
 
 namespace photon {
@@ -9,6 +12,8 @@ struct AABB {
   AABB(const glm::vec3& _min, const glm::vec3& _max);
 
   glm::vec3 GetCenter() const;
+  /** The box around this one after an affine transform (Arvo 1990), exact for translations. */
+  AABB Transform(const glm::mat4& matrix) const;
 
   // translate the center of the bbx to target_pos
   void Translate(const glm::vec3& pos);
@@ -25,4 +30,37 @@ struct AABB {
   glm::vec3 posMax;
   glm::vec3 diag;
 };
+
+/**
+ * Boxes stored one array per coordinate, so that a SIMD register loads the same coordinate of
+ * neighbouring boxes. min[axis][i] and max[axis][i] are the corners of box i.
+ */
+struct AABBArray {
+  void Clear() {
+    for (int axis = 0; axis < 3; axis++) {
+      min[axis].clear();
+      max[axis].clear();
+    }
+  }
+  void Add(const AABB& box) {
+    for (int axis = 0; axis < 3; axis++) {
+      min[axis].push_back(box.posMin[axis]);
+      max[axis].push_back(box.posMax[axis]);
+    }
+  }
+  void Set(uint32_t index, const AABB& box) {
+    for (int axis = 0; axis < 3; axis++) {
+      min[axis][index] = box.posMin[axis];
+      max[axis][index] = box.posMax[axis];
+    }
+  }
+  [[nodiscard]] AABB Get(uint32_t index) const {
+    return {{min[0][index], min[1][index], min[2][index]},
+            {max[0][index], max[1][index], max[2][index]}};
+  }
+  [[nodiscard]] uint32_t Size() const { return static_cast<uint32_t>(min[0].size()); }
+
+  std::array<std::vector<float>, 3> min;
+  std::array<std::vector<float>, 3> max;
+};
 }  // namespace photon
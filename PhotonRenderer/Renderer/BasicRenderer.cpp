@@ -1,10 +1,15 @@
 #include "BasicRenderer.hpp"
 
+#include <glm/gtc/matrix_inverse.hpp>
 #include <memory>
+#include <numeric>
 #include "Graphics/Framebuffer.hpp"
 #include "Graphics/Shader.hpp"
+#include "Graphics/StateCache.hpp"
 #include "Line.hpp"
+#include "MaterialTable.hpp"
 #include "RenderAPI.hpp"
+#include "Utils/StopWatch.hpp"
 
 namespace photon {
 
@@ -27,12 +32,19 @@ BasicRenderer::BasicRenderer(const RendererConfig& config)
                                 }};
   m_shaderCache.try_emplace(info3.name, ShaderProgramFactory::CreateShaderProgram(info3));
   CompileShaders({info1, info2, info3});
+  ResolveUniforms();
   SetupUbos();
   SetupScreenQuad();
   SetupFramebuffers(m_width, m_height);
   SetupCoordinateAxis();
   m_aabbLine  = CreateRef<Line>();
   m_shadowMap = CreateRef<ShadowMap>(1024, 1024);
+  glCreateQueries(GL_SAMPLES_PASSED, static_cast<GLsizei>(m_sampleQueries.size()),
+                  m_sampleQueries.data());
+}
+
+BasicRenderer::~BasicRenderer() {
+  glDeleteQueries(static_cast<GLsizei>(m_sampleQueries.size()), m_sampleQueries.data());
 }
 
 void BasicRenderer::CompileShaders(
@@ -44,10 +56,24 @@ void BasicRenderer::CompileShaders(
   }
 }
 
+void BasicRenderer::ResolveUniforms() {
+  m_pbrShader = m_shaderCache.at("pbr");
+  if (m_pbrShader == nullptr) {
+    return;
+  }
+  m_pbrUniforms.lightIntensity = m_pbrShader->GetUniform<glm::vec3>("uLightIntensity");
+  m_pbrUniforms.lightPos       = m_pbrShader->GetUniform<glm::vec3>("uLightPos");
+  m_pbrUniforms.lightDir       = m_pbrShader->GetUniform<glm::vec3>("uLightDir");
+  m_pbrUniforms.lightType      = m_pbrShader->GetUniform<int>("uLightType");
+  m_pbrUniforms.cameraPos      = m_pbrShader->GetUniform<glm::vec3>("uCameraPos");
+  m_pbrUniforms.lightSpaceMat  = m_pbrShader->GetUniform<glm::mat4>("uLightSpaceMat");
+  m_pbrShader->CheckUniformBlock("Camera", CameraBinding, sizeof(CameraData));
+  m_pbrShader->CheckStorageBlock("Draws", DrawList::DrawDataBinding, sizeof(DrawData));
+  m_pbrShader->CheckStorageBlock("Materials", MaterialTable::Binding, sizeof(MaterialData));
+}
+
 void BasicRenderer::SetupUbos() {
-  m_cameraUBO     = gl::UniformBuffer::Create(sizeof(CameraData), 0);
-  m_modelUBO      = gl::UniformBuffer::Create(sizeof(ModelData), 1);
-  m_pbrSamplerUBO = gl::UniformBuffer::Create(sizeof(ModelData), 2);
+  m_cameraUBO = gl::UniformBuffer::Create(sizeof(CameraData), CameraBinding);
 }
 
 void BasicRenderer::SetupScreenQuad() {
@@ -107,14 +133,49 @@ void BasicRenderer::SetupCoordinateAxis() {
   m_axisLine->vao->AttachVertexBuffer(vbo);
 }
 
-void BasicRenderer::RenderModel(const Ref<asset::Model>& model) {
-  RenderMeshes(model->GetMeshes());
+void BasicRenderer::QueueModel(const Ref<asset::Model>& model) {
+  const auto& meshes   = model->GetMeshes();
+  const auto instances = model->GetInstances();
+  const auto& bounds   = model->GetInstanceBounds();
+  auto& materials      = MaterialTable::GetShared();
+  if (m_frustumCulling) {
+    const auto numVisible = CullAABBs(bounds, m_frustumPlanes, m_visible);
+    m_stats.numInstancesVisible += numVisible;
+    m_stats.numInstancesCulled += bounds.Size() - numVisible;
+  } else {
+    m_visible.assign(bounds.Size(), 1);
+    m_stats.numInstancesVisible += bounds.Size();
+  }
+  for (const auto& batch : model->GetBatches()) {
+    const auto& mesh = meshes[batch.mesh];
+    // shared by every instance of the mesh
+    const auto materialIndex = materials.Use(mesh.material);
+    RenderPass pass          = RenderPass::Opaque;
+    if (mesh.material.alphaMode == 1) {
+      pass = RenderPass::Transparent;
+    } else if (mesh.material.alphaMode == 2) {
+      pass = RenderPass::Masked;
+    }
+    for (uint32_t i = batch.firstInstance; i < batch.firstInstance + batch.numInstances; i++) {
+      if (m_visible[i] == 0) {
+        continue;
+      }
+      auto& instance    = instances[i];
+      const auto center = m_cameraData.viewMatrix * glm::vec4(instance.aabb.GetCenter(), 1.0f);
+      // materials are rows of one bindless table and meshes share the geometry pool, so all
+      // instances have the same state and only depth orders them
+      const auto key = RenderQueue::MakeKey(pass, PbrProgram, 0, 0, -center.z / m_farPlane);
+      m_queue.Add(key, static_cast<uint32_t>(m_queueItems.size()));
+      m_queueItems.push_back({&mesh, &instance, materialIndex});
+    }
+  }
 }
 
 void BasicRenderer::SetDefaultState() {
-  glEnable(GL_DEPTH_TEST);
-  glDepthFunc(GL_LEQUAL);
-  glEnable(GL_FRAMEBUFFER_SRGB);
+  auto& state = StateCache::GetShared();
+  state.Enable(GL_DEPTH_TEST);
+  state.DepthFunc(GL_LEQUAL);
+  state.Enable(GL_FRAMEBUFFER_SRGB);
   RenderAPI::SetClearColor({0.1f, 0.1f, 0.1f, 1.0f});
   RenderAPI::EnableBlending(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
@@ -125,36 +186,119 @@ void BasicRenderer::UpdateUbo(const FrameInfo& info) {
   m_cameraData.projMatrix     = info.camera->GetProjectionMatrix();
   m_cameraData.projViewMatrix = m_cameraData.projMatrix * m_cameraData.viewMatrix;
   m_cameraUBO->SetData(&m_cameraData, sizeof(CameraData));
-  // scene ubo
-  auto& shader = m_shaderCache.at("pbr");
-  shader->Use();
-  shader->SetUniform("uLightIntensity", info.scene->GetLightIntensity());
-  shader->SetUniform("uLightPos", info.scene->GetLightPos());
-  shader->SetUniform("uLightDir", info.scene->GetLightDir());
-  shader->SetUniform("uLightType", static_cast<int>(info.options->lightType));
-  shader->SetUniform("uCameraPos", info.camera->GetPos());
-  shader->SetUniform("uLightSpaceMat", m_shadowMap->GetLightSpaceMatrix());
-}
-
-void BasicRenderer::RenderMeshes(const std::vector<Mesh>& meshes) {
-  for (const auto& mesh : meshes) {
-    m_samplerData = {};
-    // model ubo
-    m_modelData.modelMatrix = mesh.modelMatrix;
-    m_modelUBO->SetData(&m_modelData, sizeof(ModelData));
-    // bindless textures
-    mesh.material.BindTextures(m_shaderCache.at("pbr"), m_samplerData);
-    m_pbrSamplerUBO->SetData(m_samplerData.samplers, sizeof(PBRSamplerData));
-    // draw mesh
-    RenderAPI::DrawMesh(mesh);
+  // scene uniforms, set on the program without making it current
+  m_pbrShader->SetUniform(m_pbrUniforms.lightIntensity, info.scene->GetLightIntensity())
+      .SetUniform(m_pbrUniforms.lightPos, info.scene->GetLightPos())
+      .SetUniform(m_pbrUniforms.lightDir, info.scene->GetLightDir())
+      .SetUniform(m_pbrUniforms.lightType, static_cast<int>(info.options->lightType))
+      .SetUniform(m_pbrUniforms.cameraPos, info.camera->GetPos())
+      .SetUniform(m_pbrUniforms.lightSpaceMat, m_shadowMap->GetLightSpaceMatrix());
+}
+
+void BasicRenderer::AddInstance(const Mesh& mesh, MeshInstance& instance,
+                                uint32_t materialIndex) {
+  const auto& quantization = mesh.quantization;
+  DrawData draw{};
+  draw.modelMatrix = instance.modelMatrix;
+  // once per draw here rather than once per vertex in the shader
+  draw.normalMatrix    = glm::mat3x4(glm::inverseTranspose(glm::mat3(instance.modelMatrix)));
+  draw.positionOffset  = glm::vec4(quantization.positionOffset, 0.0f);
+  draw.positionScale   = glm::vec4(quantization.positionScale, 0.0f);
+  draw.uvTransform     = glm::vec4(quantization.uvOffset, quantization.uvScale);
+  draw.materialIndex   = materialIndex;
+  const auto drawIndex = m_drawList.AddDraw(draw);
+
+  auto& lod = instance.selectedLods[static_cast<size_t>(LodView::Camera)];
+  lod       = mesh.SelectLod(instance.modelMatrix, m_cameraData.viewMatrix,
+                             m_cameraData.projMatrix, static_cast<float>(m_height), m_lodPixelError,
+                             lod);
+  if (m_cullClusters && lod == 0 && !mesh.meshlets.empty()) {
+    // cull in model space, the planes and camera are brought to the meshlets
+    const auto planes    = ExtractFrustumPlanes(m_cameraData.projViewMatrix * instance.modelMatrix);
+    const auto cameraPos = glm::inverse(instance.modelMatrix) * glm::vec4(m_cameraPos, 1.0f);
+    // blended and masked surfaces tend to show their back faces
+    const bool cullBackfaces = mesh.material.alphaMode == 0;
+    const auto numIndices    = CullMeshlets(
+        mesh.meshlets, planes, glm::vec3(cameraPos), cullBackfaces, mesh.geometry.GetFirstIndex(),
+        static_cast<int32_t>(mesh.geometry.GetBaseVertex()), drawIndex, m_drawList, m_stats);
+    m_stats.numTriangles += numIndices / 3;
+    return;
+  }
+  m_stats.numTriangles += m_drawList.AddMesh(drawIndex, mesh, lod);
+}
+
+void BasicRenderer::DrawQueue(const FrameInfo& info) {
+  auto& state      = StateCache::GetShared();
+  bool transparent = false;
+  m_drawList.Clear();
+  for (const auto& packet : m_queue.GetPackets()) {
+    // blended draws go last when sorted, drawn in order without writing depth
+    if (m_sortDraws && !transparent &&
+        RenderQueue::GetPass(packet.key) == RenderPass::Transparent) {
+      SubmitModels();
+      state.DepthMask(false);
+      transparent = true;
+    }
+    const auto program = RenderQueue::GetProgram(packet.key);
+    if (program == PbrProgram) {
+      const auto& item = m_queueItems[packet.item];
+      AddInstance(*item.mesh, *item.instance, item.materialIndex);
+      continue;
+    }
+    SubmitModels();
+    switch (program) {
+      case TerrainProgram:
+        RenderAPI::EnableCullFace();
+        info.scene->m_terrain->Draw(info.camera,
+                                    info.scene->GetLightPos() - info.scene->GetCenter());
+        RenderAPI::DisableCullFace();
+        break;
+      case CurveProgram:
+        info.scene->m_curve->Draw(info.camera);
+        break;
+      case SkyboxProgram:
+        info.scene->m_skybox->Draw(info.camera, info.options->blur);
+        break;
+      default:
+        break;
+    }
   }
+  SubmitModels();
+  state.DepthMask(true);
+}
+
+void BasicRenderer::SubmitModels() {
+  if (m_drawList.GetNumDraws() == 0) {
+    return;
+  }
+  m_pbrShader->Use();
+  m_stats.numDraws += m_drawList.GetNumDraws();
+  m_stats.numDrawCalls += m_drawList.Submit(m_indirectDraws);
+  m_drawList.Clear();
+}
+
+void BasicRenderer::BeginOverdrawQuery() {
+  const auto query = m_sampleQueries[m_frameIndex % m_sampleQueries.size()];
+  // the query was last used as many frames ago as there are queries
+  if (m_frameIndex >= m_sampleQueries.size()) {
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == GL_TRUE) {
+      GLuint64 samples = 0;
+      glGetQueryObjectui64v(query, GL_QUERY_RESULT, &samples);
+      m_overdraw = static_cast<float>(samples) / static_cast<float>(m_width * m_height);
+    }
+  }
+  glBeginQuery(GL_SAMPLES_PASSED, query);
+}
+
+void BasicRenderer::EndOverdrawQuery() {
+  glEndQuery(GL_SAMPLES_PASSED);
+  m_frameIndex++;
+  m_stats.overdraw = m_overdraw;
 }
 
 void BasicRenderer::RenderScene(const FrameInfo& info) {
-  RenderAPI::EnableCullFace();
-  info.scene->m_terrain->Draw(info.camera, info.scene->GetLightPos() - info.scene->GetCenter());
-  RenderAPI::DisableCullFace();
-  info.scene->m_curve->Draw(info.camera);
   m_shadowMap->BindForRead(6);
   if (info.scene->HasSkybox()) {
     // bind Prefiltered IBL texture
@@ -163,24 +307,48 @@ void BasicRenderer::RenderScene(const FrameInfo& info) {
     } else {
       info.scene->m_skybox->UnbindPrefilterData();
     }
-    if (info.options->showBackground) {
-      info.scene->m_skybox->Draw(info.camera, info.options->blur);
-    }
   }
-  // render models
-  for (const auto& model : info.scene->m_models) {
-    RenderModel(model);
-    if (info.options->showAABB) {
-      model->GetAABB().FillLinesData(m_aabbLine);
-      m_shaderCache.at("lines")->Use();
-      RenderAPI::DrawLine(m_aabbLine->vao, m_aabbLine->lineVertices.size());
-    }
+  m_frustumPlanes = ExtractFrustumPlanes(m_cameraData.projViewMatrix);
+  // queued in scene order, which is the draw order when not sorted
+  m_queue.Clear();
+  m_queueItems.clear();
+  m_queue.Add(RenderQueue::MakeKey(RenderPass::Opaque, TerrainProgram, 0, 0, 0.0f), 0);
+  m_queue.Add(RenderQueue::MakeKey(RenderPass::Opaque, CurveProgram, 0, 0, 0.0f), 0);
+  if (info.scene->HasSkybox() && info.options->showBackground) {
+    // drawn at the far plane, after the opaque passes only the uncovered pixels are shaded
+    m_queue.Add(RenderQueue::MakeKey(RenderPass::Skybox, SkyboxProgram, 0, 0, 1.0f), 0);
+  }
+  const auto& models = info.scene->m_models;
+  if (m_frustumCulling) {
+    info.scene->QueryModels(m_frustumPlanes, m_visibleModels);
+    m_stats.numModelsCulled = static_cast<uint32_t>(models.size() - m_visibleModels.size());
+  } else {
+    m_visibleModels.resize(models.size());
+    std::iota(m_visibleModels.begin(), m_visibleModels.end(), 0);
+  }
+  for (const auto index : m_visibleModels) {
+    QueueModel(models[index]);
   }
   if (info.options->showLightModel) {
-    RenderModel(info.scene->m_lightModel);
+    QueueModel(info.scene->m_lightModel);
   }
   if (info.options->showFloor) {
-    RenderModel(info.scene->m_floor);
+    QueueModel(info.scene->m_floor);
+  }
+  MaterialTable::GetShared().Upload();
+  if (m_sortDraws) {
+    m_queue.Sort();
+  }
+  m_stats.numPackets = static_cast<uint32_t>(m_queue.GetPackets().size());
+  BeginOverdrawQuery();
+  DrawQueue(info);
+  EndOverdrawQuery();
+  if (info.options->showAABB) {
+    m_shaderCache.at("lines")->Use();
+    for (const auto& model : info.scene->m_models) {
+      model->GetAABB().FillLinesData(m_aabbLine);
+      RenderAPI::DrawLine(m_aabbLine->vao, m_aabbLine->lineVertices.size());
+    }
   }
   if (info.options->showAxis) {
     m_shaderCache.at("lines")->Use();
@@ -189,7 +357,19 @@ void BasicRenderer::RenderScene(const FrameInfo& info) {
 }
 
 void BasicRenderer::RenderFrame(const FrameInfo& info) {
-  m_shadowMap->RunDepthPass(info.scene, info.options->lightType);
+  util::StopWatch stopWatch;
+  auto& state = StateCache::GetShared();
+  state.ResetStats();
+  m_stats          = {};
+  m_lodPixelError  = info.options->enableLod ? info.options->lodPixelError : 0.0f;
+  m_cullClusters   = info.options->cullClusters;
+  m_indirectDraws  = info.options->indirectDraws;
+  m_sortDraws      = info.options->sortDraws;
+  m_frustumCulling = info.options->frustumCulling;
+  m_cameraPos      = info.camera->GetPos();
+  m_farPlane       = info.camera->GetFar();
+  m_shadowMap->RunDepthPass(info.scene, info.options->lightType, m_lodPixelError,
+                            m_indirectDraws, m_frustumCulling, m_stats);
   SetDefaultState();
   m_pbuffer->BindForWriting();
   m_pbuffer->Clear();
@@ -212,6 +392,9 @@ void BasicRenderer::RenderFrame(const FrameInfo& info) {
   }
 
   RenderAPI::DrawVertices(m_quadVAO, 6);
+  m_stats.numStateChanges       = state.GetStats().issued;
+  m_stats.numStateChangesElided = state.GetStats().elided;
+  m_stats.cpuFrameTime          = stopWatch.TimeStep() * 1000.0f;
 }
 
 void BasicRenderer::ResizeFbos(int width, int height) {
@@ -1,9 +1,16 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include "Common/Base.hpp"
+#include "DrawList.hpp"
 #include "FrameInfo.hpp"
+#include "FrustumCulling.hpp"
+#include "Graphics/Shader.hpp"
+#include "MeshInstance.hpp"
+#include "Meshlet.hpp"
 #include "RenderData.hpp"
+#include "RenderQueue.hpp"
 #include "ShadowMap.hpp"
 
 namespace photon {
@@ -23,21 +30,34 @@ struct RendererConfig {
 class BasicRenderer {
 public:
   explicit BasicRenderer(const RendererConfig& config);
+  ~BasicRenderer();
 
   void RenderFrame(const FrameInfo& info);
 
   void ResizeFbos(int width, int height);
 
+  [[nodiscard]] const RenderStats& GetStats() const { return m_stats; }
+
 private:
   void CompileShaders(const std::vector<gl::ShaderProgramCreateInfo>& shader_program_infos);
   void SetupUbos();
   void SetupScreenQuad();
   void SetupFramebuffers(uint32_t width, uint32_t height);
   void SetupCoordinateAxis();
-
-  void RenderModel(const Ref<asset::Model>& model);
-  void RenderMeshes(const std::vector<asset::Mesh>& meshes);
+  /** Look up the per frame uniforms of the pbr program, check its blocks match RenderData. */
+  void ResolveUniforms();
+
+  /** Queue the instances of a model in the frustum, their materials go to the material table. */
+  void QueueModel(const Ref<asset::Model>& model);
+  void AddInstance(const asset::Mesh& mesh, MeshInstance& instance, uint32_t materialIndex);
+  /** Draw the queue in order, models gathered into the draw list until another program. */
+  void DrawQueue(const FrameInfo& info);
+  /** Submit the models gathered so far. */
+  void SubmitModels();
   void RenderScene(const FrameInfo& info);
+  /** Count the fragments of the main pass, read back a few frames later to not stall. */
+  void BeginOverdrawQuery();
+  void EndOverdrawQuery();
 
   void UpdateUbo(const FrameInfo& info);
 
@@ -46,18 +66,56 @@ private:
   uint32_t m_width{0};
   uint32_t m_height{0};
 
-  ModelData m_modelData{};
   CameraData m_cameraData{};
-  PBRSamplerData m_samplerData{};
-
-  Ref<gl::UniformBuffer> m_modelUBO;
+  RenderStats m_stats{};
+  // 0 while LOD selection is off
+  float m_lodPixelError{0.0f};
+  bool m_cullClusters{false};
+  bool m_indirectDraws{true};
+  bool m_sortDraws{true};
+  bool m_frustumCulling{true};
+  FrustumPlanes m_frustumPlanes{};
+  // models of the scene in the frustum, and which instances of the one being queued are
+  std::vector<uint32_t> m_visibleModels;
+  std::vector<uint8_t> m_visible;
+  glm::vec3 m_cameraPos{0.0f};
+  float m_farPlane{1.0f};
+  // the models of the frame, kept to reuse the allocations
+  DrawList m_drawList;
+
+  /**
+   * Programs of the render queue keys, in the order they draw within a pass. Pbr goes last so the
+   * masked pass that follows continues its draw list.
+   */
+  enum QueueProgram : uint32_t { TerrainProgram, CurveProgram, PbrProgram, SkyboxProgram };
+  /** A mesh instance a queue packet points to, the other programs draw one item of their own. */
+  struct QueueItem {
+    const asset::Mesh* mesh;
+    MeshInstance* instance;
+    uint32_t materialIndex;
+  };
+  RenderQueue m_queue;
+  std::vector<QueueItem> m_queueItems;
+  // samples passed queries of the last frames, used in turn
+  std::array<uint32_t, 3> m_sampleQueries{};
+  uint64_t m_frameIndex{0};
+  float m_overdraw{0.0f};
   Ref<gl::UniformBuffer> m_cameraUBO;
-  Ref<gl::UniformBuffer> m_pbrSamplerUBO;
 
   Ref<gl::Framebuffer> m_pbuffer;
 
   Ref<gl::VertexArray> m_quadVAO;
   std::unordered_map<std::string, Ref<gl::ShaderProgram>> m_shaderCache;
+  static constexpr uint32_t CameraBinding = 0;
+  Ref<gl::ShaderProgram> m_pbrShader;
+  struct PbrUniforms {
+    gl::Uniform<glm::vec3> lightIntensity;
+    gl::Uniform<glm::vec3> lightPos;
+    gl::Uniform<glm::vec3> lightDir;
+    gl::Uniform<int> lightType;
+    gl::Uniform<glm::vec3> cameraPos;
+    gl::Uniform<glm::mat4> lightSpaceMat;
+  } m_pbrUniforms;
 
   Ref<Line> m_axisLine;
   Ref<Line> m_aabbLine;
@@ -1,4 +1,5 @@
 #include "Curve.hpp"
+#include "Graphics/StateCache.hpp"
 #include "RenderAPI.hpp"
 #include "Systems/CameraSystem.hpp"
 #include "Vertex.hpp"
@@ -43,7 +44,7 @@ void Curve::Draw(const Ref<system::Camera>& camara) {
   m_shader->Use();
   m_shader->SetUniform("uProjView", camara->GetProjectionMatrix() * camara->GetViewMatrix());
   m_vao->Bind();
-  glLineWidth(2.0f);
+  gl::StateCache::GetShared().LineWidth(2.0f);
   glDrawArrays(GL_LINES, 0, m_numPoints);
 }
 
@@ -0,0 +1,94 @@
+#include "DrawList.hpp"
+#include "Assets/Mesh.hpp"
+#include "Graphics/GeometryPool.hpp"
+#include "Graphics/StorageBuffer.hpp"
+
+namespace photon {
+DrawList::DrawList()  = default;
+DrawList::~DrawList() = default;
+
+void DrawList::Clear() {
+  m_draws.clear();
+  m_elements.clear();
+  m_arrays.clear();
+}
+
+uint32_t DrawList::AddDraw(const DrawData& draw) {
+  m_draws.push_back(draw);
+  return static_cast<uint32_t>(m_draws.size() - 1);
+}
+
+void DrawList::AddElements(uint32_t drawIndex, uint32_t count, uint32_t firstIndex,
+                           int32_t baseVertex) {
+  if (!m_elements.empty()) {
+    auto& last = m_elements.back();
+    if (last.baseInstance == drawIndex && last.baseVertex == baseVertex &&
+        last.firstIndex + last.count == firstIndex) {
+      last.count += count;
+      return;
+    }
+  }
+  m_elements.push_back({count, 1, firstIndex, baseVertex, drawIndex});
+}
+
+uint32_t DrawList::AddMesh(uint32_t drawIndex, const asset::Mesh& mesh, uint32_t lod) {
+  const auto& geometry = mesh.geometry;
+  if (lod < mesh.lods.size()) {
+    const auto& level = mesh.lods[lod];
+    AddElements(drawIndex, level.numIndices, geometry.GetFirstIndex() + level.firstIndex,
+                static_cast<int32_t>(geometry.GetBaseVertex()));
+    return level.numIndices / 3;
+  }
+  if (mesh.numIndices != 0) {
+    AddElements(drawIndex, static_cast<uint32_t>(mesh.numIndices), geometry.GetFirstIndex(),
+                static_cast<int32_t>(geometry.GetBaseVertex()));
+    return static_cast<uint32_t>(mesh.numIndices) / 3;
+  }
+  m_arrays.push_back(
+      {static_cast<uint32_t>(mesh.numVertices), 1, geometry.GetBaseVertex(), drawIndex});
+  return static_cast<uint32_t>(mesh.numVertices) / 3;
+}
+
+uint32_t DrawList::Submit(bool indirect) {
+  if (m_draws.empty()) {
+    return 0;
+  }
+  if (m_drawBuffer == nullptr) {
+    m_drawBuffer    = gl::StorageBuffer::Create();
+    m_elementBuffer = gl::StorageBuffer::Create();
+    m_arrayBuffer   = gl::StorageBuffer::Create();
+  }
+  m_drawBuffer->SetData(m_draws.data(), m_draws.size() * sizeof(DrawData));
+  m_drawBuffer->BindBase(DrawDataBinding);
+  gl::GeometryPool::GetShared().Bind();
+  if (!indirect) {
+    for (const auto& command : m_elements) {
+      glDrawElementsInstancedBaseVertexBaseInstance(
+          GL_TRIANGLES, static_cast<GLsizei>(command.count), GL_UNSIGNED_INT,
+          reinterpret_cast<const void*>(command.firstIndex * sizeof(uint32_t)), 1,
+          command.baseVertex, command.baseInstance);
+    }
+    for (const auto& command : m_arrays) {
+      glDrawArraysInstancedBaseInstance(GL_TRIANGLES, static_cast<GLint>(command.first),
+                                        static_cast<GLsizei>(command.count), 1,
+                                        command.baseInstance);
+    }
+    return GetNumCommands();
+  }
+  uint32_t numCalls = 0;
+  if (!m_elements.empty()) {
+    m_elementBuffer->SetData(m_elements.data(), m_elements.size() * sizeof(DrawElementsCommand));
+    m_elementBuffer->BindIndirect();
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr,
+                                static_cast<GLsizei>(m_elements.size()), 0);
+    numCalls++;
+  }
+  if (!m_arrays.empty()) {
+    m_arrayBuffer->SetData(m_arrays.data(), m_arrays.size() * sizeof(DrawArraysCommand));
+    m_arrayBuffer->BindIndirect();
+    glMultiDrawArraysIndirect(GL_TRIANGLES, nullptr, static_cast<GLsizei>(m_arrays.size()), 0);
+    numCalls++;
+  }
+  return numCalls;
+}
+}  // namespace photon
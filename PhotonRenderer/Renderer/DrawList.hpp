@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Common/Base.hpp"
+#include "RenderData.hpp"
+
+namespace photon {
+namespace asset {
+struct Mesh;
+}
+namespace gl {
+class StorageBuffer;
+}
+
+/** Layout of glMultiDrawElementsIndirect. */
+struct DrawElementsCommand {
+  uint32_t count;
+  uint32_t instanceCount;
+  uint32_t firstIndex;
+  int32_t baseVertex;
+  // index of the DrawData, the shaders find it at gl_BaseInstance
+  uint32_t baseInstance;
+};
+
+/** Layout of glMultiDrawArraysIndirect. */
+struct DrawArraysCommand {
+  uint32_t count;
+  uint32_t instanceCount;
+  uint32_t first;
+  uint32_t baseInstance;
+};
+
+/**
+ * The draws of one pass over meshes of the geometry pool, gathered on the CPU and submitted with
+ * one glMultiDrawElementsIndirect, plus one glMultiDrawArraysIndirect for meshes without indices.
+ * Each draw has a DrawData in a shader storage block, which its commands point to.
+ */
+class DrawList {
+public:
+  static constexpr uint32_t DrawDataBinding = 0;
+
+  DrawList();
+  ~DrawList();
+
+  void Clear();
+  /** Store the data of a draw, returns the index its commands refer to. */
+  uint32_t AddDraw(const DrawData& draw);
+  /** Draw count indices from firstIndex, continuing the previous command when they follow it. */
+  void AddElements(uint32_t drawIndex, uint32_t count, uint32_t firstIndex, int32_t baseVertex);
+  /** Draw one level of detail of a mesh, the full mesh by default. Returns its triangles. */
+  uint32_t AddMesh(uint32_t drawIndex, const asset::Mesh& mesh, uint32_t lod = 0);
+
+  /**
+   * Upload the draws and commands and draw them with the geometry pool bound. Without indirect
+   * every command is its own draw call, which costs one call per command on the CPU.
+   * Returns the draw calls made.
+   */
+  uint32_t Submit(bool indirect);
+
+  [[nodiscard]] uint32_t GetNumDraws() const { return static_cast<uint32_t>(m_draws.size()); }
+  [[nodiscard]] uint32_t GetNumCommands() const {
+    return static_cast<uint32_t>(m_elements.size() + m_arrays.size());
+  }
+
+private:
+  std::vector<DrawData> m_draws;
+  std::vector<DrawElementsCommand> m_elements;
+  std::vector<DrawArraysCommand> m_arrays;
+  // created on the first submit
+  Ref<gl::StorageBuffer> m_drawBuffer;
+  Ref<gl::StorageBuffer> m_elementBuffer;
+  Ref<gl::StorageBuffer> m_arrayBuffer;
+};
+}  // namespace photon
@@ -0,0 +1,155 @@
+#include "FrustumCulling.hpp"
+#include <bit>
+#include <cstring>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace photon {
+namespace {
+/** Coordinates of the corner of each box farthest along the normal of a plane. */
+struct FarCorners {
+  const float* x;
+  const float* y;
+  const float* z;
+};
+
+std::array<FarCorners, 6> GetFarCorners(const AABBArray& boxes, const FrustumPlanes& planes) {
+  std::array<FarCorners, 6> corners{};
+  for (size_t i = 0; i < planes.size(); i++) {
+    const auto& plane = planes[i];
+    corners[i]        = {(plane.x >= 0.0f ? boxes.max : boxes.min)[0].data(),
+                         (plane.y >= 0.0f ? boxes.max : boxes.min)[1].data(),
+                         (plane.z >= 0.0f ? boxes.max : boxes.min)[2].data()};
+  }
+  return corners;
+}
+
+uint32_t CullRange(const std::array<FarCorners, 6>& corners, const FrustumPlanes& planes,
+                   uint32_t begin, uint32_t end, uint8_t* visible) {
+  uint32_t numVisible = 0;
+  for (uint32_t i = begin; i < end; i++) {
+    bool inside = true;
+    for (size_t p = 0; p < planes.size(); p++) {
+      const auto& plane = planes[p];
+      const auto& c     = corners[p];
+      inside &= plane.w + plane.x * c.x[i] + plane.y * c.y[i] + plane.z * c.z[i] >= 0.0f;
+    }
+    visible[i] = inside ? 1 : 0;
+    numVisible += inside ? 1 : 0;
+  }
+  return numVisible;
+}
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+// four lanes of a movemask as one visible byte each
+constexpr std::array<uint32_t, 16> LaneBytes = {
+    0x00000000, 0x00000001, 0x00000100, 0x00000101, 0x00010000, 0x00010001, 0x00010100, 0x00010101,
+    0x01000000, 0x01000001, 0x01000100, 0x01000101, 0x01010000, 0x01010001, 0x01010100, 0x01010101,
+};
+
+void StoreLanes(uint32_t mask, uint8_t* visible) {
+  std::memcpy(visible, &LaneBytes[mask & 0xf], sizeof(uint32_t));
+}
+#endif
+
+#if defined(__AVX__)
+constexpr uint32_t NumLanes = 8;
+
+uint32_t CullWide(const std::array<FarCorners, 6>& corners, const FrustumPlanes& planes,
+                  uint32_t numBoxes, uint8_t* visible) {
+  __m256 broadcast[6][4];
+  for (size_t p = 0; p < planes.size(); p++) {
+    for (int i = 0; i < 4; i++) {
+      broadcast[p][i] = _mm256_set1_ps(planes[p][i]);
+    }
+  }
+  const auto zero     = _mm256_setzero_ps();
+  uint32_t numVisible = 0;
+  uint32_t i          = 0;
+  for (; i + NumLanes <= numBoxes; i += NumLanes) {
+    auto outside = zero;
+    for (size_t p = 0; p < planes.size(); p++) {
+      const auto& c = corners[p];
+      const auto& n = broadcast[p];
+      auto distance = _mm256_add_ps(n[3], _mm256_mul_ps(n[0], _mm256_loadu_ps(c.x + i)));
+      distance      = _mm256_add_ps(distance, _mm256_mul_ps(n[1], _mm256_loadu_ps(c.y + i)));
+      distance      = _mm256_add_ps(distance, _mm256_mul_ps(n[2], _mm256_loadu_ps(c.z + i)));
+      outside       = _mm256_or_ps(outside, _mm256_cmp_ps(distance, zero, _CMP_NGE_UQ));
+    }
+    const auto mask = ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xff;
+    StoreLanes(mask, visible + i);
+    StoreLanes(mask >> 4, visible + i + 4);
+    numVisible += std::popcount(mask);
+  }
+  return numVisible;
+}
+#elif defined(__SSE2__) || defined(_M_X64)
+constexpr uint32_t NumLanes = 4;
+
+uint32_t CullWide(const std::array<FarCorners, 6>& corners, const FrustumPlanes& planes,
+                  uint32_t numBoxes, uint8_t* visible) {
+  __m128 broadcast[6][4];
+  for (size_t p = 0; p < planes.size(); p++) {
+    for (int i = 0; i < 4; i++) {
+      broadcast[p][i] = _mm_set1_ps(planes[p][i]);
+    }
+  }
+  const auto zero     = _mm_setzero_ps();
+  uint32_t numVisible = 0;
+  uint32_t i          = 0;
+  for (; i + NumLanes <= numBoxes; i += NumLanes) {
+    auto outside = zero;
+    for (size_t p = 0; p < planes.size(); p++) {
+      const auto& c = corners[p];
+      const auto& n = broadcast[p];
+      auto distance = _mm_add_ps(n[3], _mm_mul_ps(n[0], _mm_loadu_ps(c.x + i)));
+      distance      = _mm_add_ps(distance, _mm_mul_ps(n[1], _mm_loadu_ps(c.y + i)));
+      distance      = _mm_add_ps(distance, _mm_mul_ps(n[2], _mm_loadu_ps(c.z + i)));
+      outside       = _mm_or_ps(outside, _mm_cmpnge_ps(distance, zero));
+    }
+    const auto mask = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xf;
+    StoreLanes(mask, visible + i);
+    numVisible += std::popcount(mask);
+  }
+  return numVisible;
+}
+#endif
+}  // namespace
+
+FrustumPlanes ExtractFrustumPlanes(const glm::mat4& clipMatrix) {
+  // Gribb and Hartmann: each plane is the w row plus or minus the x, y or z row
+  const auto row = [&](int i) {
+    return glm::vec4(clipMatrix[0][i], clipMatrix[1][i], clipMatrix[2][i], clipMatrix[3][i]);
+  };
+  FrustumPlanes planes{row(3) + row(0), row(3) - row(0), row(3) + row(1),
+                       row(3) - row(1), row(3) + row(2), row(3) - row(2)};
+  for (auto& plane : planes) {
+    plane /= glm::length(glm::vec3(plane));
+  }
+  return planes;
+}
+
+uint32_t CullAABBs(const AABBArray& boxes, const FrustumPlanes& planes,
+                   std::vector<uint8_t>& visible) {
+  const auto numBoxes = boxes.Size();
+  visible.resize(numBoxes);
+  const auto corners = GetFarCorners(boxes, planes);
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+  const auto numVisible = CullWide(corners, planes, numBoxes, visible.data());
+  // the boxes left over from the last full register
+  const auto begin = numBoxes / NumLanes * NumLanes;
+  return numVisible + CullRange(corners, planes, begin, numBoxes, visible.data());
+#else
+  return CullRange(corners, planes, 0, numBoxes, visible.data());
+#endif
+}
+
+uint32_t CullAABBsScalar(const AABBArray& boxes, const FrustumPlanes& planes,
+                         std::vector<uint8_t>& visible) {
+  visible.resize(boxes.Size());
+  return CullRange(GetFarCorners(boxes, planes), planes, 0, boxes.Size(), visible.data());
+}
+}  // namespace photon
@@ -0,0 +1,24 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+#include "AABB.hpp"
+
+namespace photon {
+using FrustumPlanes = std::array<glm::vec4, 6>;
+
+/** Normalized planes of the clip volume of a transform, pointing inwards, in its source space. */
+FrustumPlanes ExtractFrustumPlanes(const glm::mat4& clipMatrix);
+
+/**
+ * Set visible[i] to 1 for the boxes inside or crossing every plane and to 0 for the others,
+ * returns how many are visible. A box is outside when the corner farthest along a plane's normal
+ * is behind it. Tests 8 boxes at a time with AVX, 4 with SSE.
+ */
+uint32_t CullAABBs(const AABBArray& boxes, const FrustumPlanes& planes,
+                   std::vector<uint8_t>& visible);
+/** CullAABBs one box at a time, the result the SIMD paths must match. */
+uint32_t CullAABBsScalar(const AABBArray& boxes, const FrustumPlanes& planes,
+                         std::vector<uint8_t>& visible);
+}  // namespace photon
@@ -0,0 +1,160 @@
+#include "MaterialTable.hpp"
+#include <algorithm>
+#include "Assets/Material.hpp"
+#include "Graphics/StorageBuffer.hpp"
+#include "Utils/TextureResidency.hpp"
+
+namespace photon {
+MaterialSlot& MaterialSlot::operator=(MaterialSlot&& other) noexcept {
+  if (this != &other) {
+    Release();
+    m_row       = other.m_row;
+    other.m_row = InvalidRow;
+  }
+  return *this;
+}
+
+void MaterialSlot::MarkChanged() const {
+  if (m_row != InvalidRow) {
+    MaterialTable::GetShared().MarkChanged(m_row);
+  }
+}
+
+void MaterialSlot::Release() {
+  if (m_row != InvalidRow) {
+    MaterialTable::GetShared().Release(m_row);
+    m_row = InvalidRow;
+  }
+}
+
+MaterialTable& MaterialTable::GetShared() {
+  static MaterialTable table;
+  return table;
+}
+
+MaterialTable::MaterialTable()  = default;
+MaterialTable::~MaterialTable() = default;
+
+uint32_t MaterialTable::Use(const asset::PBRMaterial& material) {
+  auto row = material.slot.GetRow();
+  if (row == MaterialSlot::InvalidRow) {
+    if (m_freeRows.empty()) {
+      row = static_cast<uint32_t>(m_rows.size());
+      m_rows.emplace_back();
+      m_data.emplace_back();
+    } else {
+      row = m_freeRows.back();
+      m_freeRows.pop_back();
+    }
+    m_numMaterials++;
+    material.slot = MaterialSlot(row);
+  }
+  auto& entry = m_rows[row];
+  if (entry.changed) {
+    Compile(material, row);
+    entry.changed = false;
+    QueueUpload(row);
+  }
+  // stamping a texture as used reloads it when it was evicted, under a new handle
+  auto& residency = util::TextureResidency::GetShared();
+  auto& data      = m_data[row];
+  for (size_t i = 0; i < entry.textures.size(); i++) {
+    if (entry.textures[i] == nullptr) {
+      continue;
+    }
+    const auto handle = residency.Use(*entry.textures[i]);
+    if (handle != data.textures[i]) {
+      data.textures[i] = handle;
+      QueueUpload(row);
+    }
+  }
+  return row;
+}
+
+void MaterialTable::Compile(const asset::PBRMaterial& material, uint32_t row) {
+  auto& data             = m_data[row];
+  auto& entry            = m_rows[row];
+  data                   = {};
+  data.baseColorFactor   = material.baseColorFactor;
+  data.emissiveFactor    = material.emissiveFactor;
+  data.occlusionStrength = static_cast<float>(material.occlusionStrength);
+  data.metallicFactor    = static_cast<float>(material.metallicFactor);
+  data.roughnessFactor   = static_cast<float>(material.roughnessFactor);
+  data.alphaCutoff       = material.alphaCutoff;
+  data.alphaMode         = material.alphaMode;
+  entry.textures         = {};
+  for (const auto& [component, texture] : material.textures) {
+    const auto index      = static_cast<uint32_t>(component);
+    entry.textures[index] = texture.get();
+    data.textureMask |= 1u << index;
+  }
+}
+
+void MaterialTable::QueueUpload(uint32_t row) {
+  if (!m_rows[row].queued) {
+    m_rows[row].queued = true;
+    m_uploads.push_back(row);
+  }
+}
+
+void MaterialTable::Release(uint32_t row) {
+  // the row keeps its old contents on the GPU until it is handed out and compiled again
+  m_rows[row].changed = true;
+  m_freeRows.push_back(row);
+  m_numMaterials--;
+}
+
+void MaterialTable::MarkChanged(uint32_t row) {
+  m_rows[row].changed = true;
+}
+
+void MaterialTable::Upload() {
+  if (m_buffer == nullptr) {
+    m_buffer = gl::StorageBuffer::Create();
+  }
+  m_lastUpload = {};
+  const auto numRows = static_cast<uint32_t>(m_data.size());
+  if (numRows > m_capacity) {
+    // new storage, which takes every row
+    m_capacity = std::max(numRows, m_capacity * 2);
+    m_buffer->SetData(nullptr, uint64_t{m_capacity} * sizeof(MaterialData));
+    m_buffer->SetSubData(m_data.data(), uint64_t{numRows} * sizeof(MaterialData), 0);
+    m_lastUpload.uploadedRows = numRows;
+    m_lastUpload.uploadCalls  = 1;
+  } else {
+    // neighbouring rows go in one call
+    std::sort(m_uploads.begin(), m_uploads.end());
+    for (size_t i = 0; i < m_uploads.size();) {
+      size_t end = i + 1;
+      while (end < m_uploads.size() && m_uploads[end] == m_uploads[end - 1] + 1) {
+        end++;
+      }
+      const auto first = m_uploads[i];
+      const auto count = static_cast<uint32_t>(end - i);
+      m_buffer->SetSubData(&m_data[first], uint64_t{count} * sizeof(MaterialData),
+                           uint64_t{first} * sizeof(MaterialData));
+      m_lastUpload.uploadedRows += count;
+      m_lastUpload.uploadCalls++;
+      i = end;
+    }
+  }
+  for (const auto row : m_uploads) {
+    m_rows[row].queued = false;
+  }
+  m_uploads.clear();
+  if (m_capacity > 0) {
+    m_buffer->BindBase(Binding);
+  }
+}
+
+void MaterialTable::Shutdown() {
+  m_buffer   = nullptr;
+  m_capacity = 0;
+}
+
+MaterialTableStats MaterialTable::GetStats() const {
+  auto stats         = m_lastUpload;
+  stats.numMaterials = m_numMaterials;
+  return stats;
+}
+}  // namespace photon
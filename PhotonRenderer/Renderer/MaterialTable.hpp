@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Common/Base.hpp"
+#include "RenderData.hpp"
+
+namespace photon {
+namespace asset {
+struct PBRMaterial;
+class Texture2D;
+}  // namespace asset
+namespace gl {
+class StorageBuffer;
+}
+
+/**
+ * The row of a material in the MaterialTable, handed back when the material is destroyed. Moves
+ * with the material; a copy starts without a row, and assigning over a material marks its row to
+ * be compiled again.
+ */
+class MaterialSlot {
+public:
+  static constexpr uint32_t InvalidRow = ~0u;
+
+  MaterialSlot() = default;
+  ~MaterialSlot() { Release(); }
+  MaterialSlot(const MaterialSlot&) {}
+  MaterialSlot& operator=(const MaterialSlot&) {
+    MarkChanged();
+    return *this;
+  }
+  MaterialSlot(MaterialSlot&& other) noexcept { *this = std::move(other); }
+  MaterialSlot& operator=(MaterialSlot&& other) noexcept;
+
+  [[nodiscard]] uint32_t GetRow() const { return m_row; }
+  /** Compile the material again before its next draw, after its fields were changed. */
+  void MarkChanged() const;
+
+private:
+  friend class MaterialTable;
+  explicit MaterialSlot(uint32_t row) : m_row(row) {}
+  void Release();
+
+  uint32_t m_row{InvalidRow};
+};
+
+struct MaterialTableStats {
+  uint32_t numMaterials{0};
+  // rows sent to the GPU by the last Upload, and the calls it took
+  uint32_t uploadedRows{0};
+  uint32_t uploadCalls{0};
+};
+
+/**
+ * Every drawn PBRMaterial compiled once into a MaterialData row of a shader storage buffer, which
+ * draws index with DrawData::materialIndex. A row is compiled again only when its material is
+ * marked changed, and sent again only then or when the residency of one of its textures changed
+ * the bindless handle. GL thread only.
+ */
+class MaterialTable {
+public:
+  static constexpr uint32_t Binding = 1;
+
+  static MaterialTable& GetShared();
+
+  MaterialTable();
+  /** Holds no GL objects by then, Shutdown deletes them while the context is current. */
+  ~MaterialTable();
+
+  /**
+   * Row of a material for this frame, compiled on its first use. Stamps its textures as used,
+   * which reloads evicted ones.
+   */
+  uint32_t Use(const asset::PBRMaterial& material);
+  /** Send the rows changed since the last upload and bind the table for the shaders. */
+  void Upload();
+
+  [[nodiscard]] MaterialTableStats GetStats() const;
+
+  /**
+   * Delete the storage buffer, called before the GL context goes away. Rows stay compiled, the
+   * next Upload sends all of them to new storage.
+   */
+  void Shutdown();
+
+private:
+  friend class MaterialSlot;
+  void Release(uint32_t row);
+  void MarkChanged(uint32_t row);
+  void Compile(const asset::PBRMaterial& material, uint32_t row);
+  void QueueUpload(uint32_t row);
+
+  struct Row {
+    // of the textures map of the material, looked up once when compiled
+    std::array<const asset::Texture2D*, 5> textures{};
+    bool changed{true};
+    bool queued{false};
+  };
+  // what the GPU holds, and how to keep it current
+  std::vector<MaterialData> m_data;
+  std::vector<Row> m_rows;
+  std::vector<uint32_t> m_freeRows;
+  std::vector<uint32_t> m_uploads;
+  uint32_t m_numMaterials{0};
+  uint32_t m_capacity{0};
+  Ref<gl::StorageBuffer> m_buffer;
+  MaterialTableStats m_lastUpload{};
+};
+}  // namespace photon
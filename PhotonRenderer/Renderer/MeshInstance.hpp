@@ -0,0 +1,26 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "AABB.hpp"
+#include "MeshLod.hpp"
+
+namespace photon {
+/** One placement of a mesh in its model. Meshes placed by several nodes are uploaded once. */
+struct MeshInstance {
+  // index into the meshes of the model
+  uint32_t mesh{0};
+  glm::mat4 modelMatrix{1.0f};
+  // bounds of the mesh under modelMatrix
+  AABB aabb{glm::vec3(0.0f), glm::vec3(0.0f)};
+  // level each view picked last frame, for the hysteresis of Mesh::SelectLod
+  std::array<uint32_t, NumLodViews> selectedLods{};
+};
+
+/** Consecutive instances of one mesh, drawn with its buffers and material bound once. */
+struct InstanceBatch {
+  uint32_t mesh{0};
+  uint32_t firstInstance{0};
+  uint32_t numInstances{0};
+};
+}  // namespace photon
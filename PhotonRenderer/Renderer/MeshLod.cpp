@@ -0,0 +1,38 @@
+#include "MeshLod.hpp"
+#include <limits>
+
+namespace photon {
+namespace {
+// fraction of the pixel error a coarser level has to stay under before it replaces a finer one
+constexpr float LodHysteresis = 0.25f;
+}  // namespace
+
+float GetPixelsPerUnit(const glm::mat4& viewMatrix, const glm::mat4& projMatrix,
+                       float viewportHeight, const glm::vec3& center, float radius) {
+  // projMatrix[1][1] maps a unit at distance one to half the viewport height
+  const float scale = projMatrix[1][1] * viewportHeight * 0.5f;
+  if (projMatrix[3][3] == 1.0f) {
+    return scale;
+  }
+  const float distance = -(viewMatrix * glm::vec4(center, 1.0f)).z - radius;
+  // inside the sphere it covers the screen, draw it at full detail
+  if (distance <= 0.0f) {
+    return std::numeric_limits<float>::max();
+  }
+  return scale / distance;
+}
+
+uint32_t SelectLod(std::span<const MeshLod> lods, float pixelsPerUnit, float maxPixelError,
+                   uint32_t current) {
+  uint32_t selected = 0;
+  for (uint32_t i = 1; i < lods.size(); i++) {
+    const float limit = i > current ? maxPixelError * (1.0f - LodHysteresis) : maxPixelError;
+    // errors only grow along the chain, so the first level that is too coarse ends the search
+    if (lods[i].error * pixelsPerUnit > limit) {
+      break;
+    }
+    selected = i;
+  }
+  return selected;
+}
+}  // namespace photon
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <glm/glm.hpp>
+
+namespace photon {
+/** One level of detail of a mesh, a range of its index buffer. Levels run finest to coarsest. */
+struct MeshLod {
+  uint32_t firstIndex{0};
+  uint32_t numIndices{0};
+  // farthest the simplified surface strays from the full one, in model units
+  float error{0.0f};
+};
+
+// full resolution plus up to three simplified levels
+constexpr uint32_t MaxMeshLods = 4;
+
+/** Views that pick levels independently, each one remembers its last pick for the hysteresis. */
+enum class LodView { Camera, Shadow };
+constexpr size_t NumLodViews = 2;
+
+/**
+ * Pixels covered by one world unit on the near side of a bounding sphere, from the projected
+ * size of the sphere. Orthographic projections scale the same at any distance.
+ */
+float GetPixelsPerUnit(const glm::mat4& viewMatrix, const glm::mat4& projMatrix,
+                       float viewportHeight, const glm::vec3& center, float radius);
+
+/**
+ * Pick the coarsest level whose error projects to at most maxPixelError pixels. Switching to a
+ * coarser level than current needs a margin below that, so meshes near a threshold do not flicker.
+ */
+uint32_t SelectLod(std::span<const MeshLod> lods, float pixelsPerUnit, float maxPixelError,
+                   uint32_t current);
+}  // namespace photon
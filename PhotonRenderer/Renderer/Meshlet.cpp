@@ -0,0 +1,32 @@
+#include "Meshlet.hpp"
+#include "DrawList.hpp"
+
+namespace photon {
+uint64_t CullMeshlets(std::span<const Meshlet> meshlets, const FrustumPlanes& planes,
+                      const glm::vec3& cameraPos, bool cullBackfaces, uint32_t firstIndex,
+                      int32_t baseVertex, uint32_t drawIndex, DrawList& list, RenderStats& stats) {
+  stats.numClusters += static_cast<uint32_t>(meshlets.size());
+  uint64_t numIndices = 0;
+  for (const auto& meshlet : meshlets) {
+    const auto center = glm::vec4(meshlet.center, 1.0f);
+    bool inside       = true;
+    for (const auto& plane : planes) {
+      inside &= glm::dot(plane, center) >= -meshlet.radius;
+    }
+    if (!inside) {
+      stats.numClustersFrustumCulled++;
+      continue;
+    }
+    const auto toCenter = meshlet.center - cameraPos;
+    if (cullBackfaces && glm::dot(toCenter, meshlet.coneAxis) >=
+                             meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius) {
+      stats.numClustersBackfaceCulled++;
+      continue;
+    }
+    // meshlets are stored in index order, so a survivor right after the last one extends it
+    list.AddElements(drawIndex, meshlet.numIndices, firstIndex + meshlet.firstIndex, baseVertex);
+    numIndices += meshlet.numIndices;
+  }
+  return numIndices;
+}
+}  // namespace photon
@@ -0,0 +1,39 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Engine/RenderOption.hpp"
+#include "FrustumCulling.hpp"
+
+namespace photon {
+class DrawList;
+
+constexpr uint32_t MaxMeshletVertices  = 64;
+constexpr uint32_t MaxMeshletTriangles = 124;
+
+/** A cluster of nearby triangles, one contiguous range of its mesh's index buffer. */
+struct Meshlet {
+  // bounding sphere, in model space
+  glm::vec3 center{0.0f};
+  float radius{0.0f};
+  // normal cone: every triangle faces away from a viewer when dot(center - viewer, coneAxis)
+  // exceeds coneCutoff * distance + radius, a cutoff of 1 never culls
+  glm::vec3 coneAxis{0.0f, 0.0f, 1.0f};
+  float coneCutoff{1.0f};
+  uint32_t firstIndex{0};
+  uint32_t numIndices{0};
+};
+static_assert(sizeof(Meshlet) == 40, "Meshlet is stored as-is in mesh caches");
+
+/**
+ * Add the meshlets inside the frustum, and when cullBackfaces also facing the camera, to list as
+ * commands of drawIndex, neighbours merged. planes and cameraPos are in the model space of the
+ * meshlets, whose indices start at firstIndex of the index buffer and refer to vertices from
+ * baseVertex on. Returns the indices added.
+ */
+uint64_t CullMeshlets(std::span<const Meshlet> meshlets, const FrustumPlanes& planes,
+                      const glm::vec3& cameraPos, bool cullBackfaces, uint32_t firstIndex,
+                      int32_t baseVertex, uint32_t drawIndex, DrawList& list, RenderStats& stats);
+}  // namespace photon
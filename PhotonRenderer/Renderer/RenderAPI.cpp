@@ -1,27 +1,28 @@
 #include "RenderAPI.hpp"
-#include "Assets/Mesh.hpp"
-#include "Assets/Model.hpp"
+#include "Graphics/StateCache.hpp"
 #include "Graphics/VertexArray.hpp"
 
 namespace photon {
 
 void RenderAPI::EnableBlending(int sfactor, int dfactor) {
-  glEnable(GL_BLEND);
-  glBlendFunc(sfactor, dfactor);
+  auto& state = StateCache::GetShared();
+  state.Enable(GL_BLEND);
+  state.BlendFunc(sfactor, dfactor);
 }
 
 void RenderAPI::EnableCullFace() {
   // Enable face culling
-  glEnable(GL_CULL_FACE);
-  glCullFace(GL_BACK);  // Specify to cull the back faces
+  auto& state = StateCache::GetShared();
+  state.Enable(GL_CULL_FACE);
+  state.CullFace(GL_BACK);  // Specify to cull the back faces
 }
 
 void RenderAPI::DisableCullFace() {
-  glDisable(GL_CULL_FACE);
+  StateCache::GetShared().Disable(GL_CULL_FACE);
 }
 
 void RenderAPI::SetClearColor(const glm::vec4& color) {
-  glClearColor(color.r, color.g, color.b, color.a);
+  StateCache::GetShared().ClearColor(color);
 }
 
 void RenderAPI::ClearColorAndDepthBuffer() {
@@ -33,16 +34,16 @@ void RenderAPI::ClearColorBuffer() {
 }
 
 void RenderAPI::EnableDepthTesting() {
-  glEnable(GL_DEPTH_TEST);
+  StateCache::GetShared().Enable(GL_DEPTH_TEST);
 }
 
 void RenderAPI::DisableDepthTesting() {
-  glDisable(GL_DEPTH_TEST);
+  StateCache::GetShared().Disable(GL_DEPTH_TEST);
 }
 
 void RenderAPI::DrawLine(const std::shared_ptr<VertexArray>& vao, uint32_t num_vertices) {
   vao->Bind();
-  glLineWidth(2.0f);
+  StateCache::GetShared().LineWidth(2.0f);
   glDrawArrays(GL_LINES, 0, num_vertices);
 }
 
@@ -54,20 +55,4 @@ void RenderAPI::DrawIndices(const std::shared_ptr<VertexArray>& vao) {
   vao->Bind();
   glDrawElements(GL_TRIANGLES, vao->GetIndexBuffer()->GetCount(), GL_UNSIGNED_INT, nullptr);
 }
-
-void RenderAPI::DrawMeshes(const std::vector<Mesh>& meshes) {
-  for (const auto& mesh : meshes) {
-    mesh.vao->Bind();
-    glDrawElements(GL_TRIANGLES, mesh.numIndices, GL_UNSIGNED_INT, nullptr);
-  }
-}
-
-void RenderAPI::DrawMesh(const Mesh& mesh) {
-  mesh.vao->Bind();
-  if (mesh.numIndices != 0) {
-    glDrawElements(GL_TRIANGLES, mesh.numIndices, GL_UNSIGNED_INT, nullptr);
-  } else {
-    glDrawArrays(GL_TRIANGLES, 0, mesh.numVertices);
-  }
-}
-}  // namespace photon
\ No newline at end of file
+}  // namespace photon
@@ -29,9 +29,6 @@ public:
   static void DrawLine(const std::shared_ptr<gl::VertexArray>& vao, uint32_t num_vertices);
   static void DrawVertices(const std::shared_ptr<VertexArray>& vao, uint32_t num_vertices);
   static void DrawIndices(const std::shared_ptr<VertexArray>& vao);
-
-  static void DrawMeshes(const std::vector<Mesh>& meshes);
-  static void DrawMesh(const Mesh& mesh);
 };
 
 }  // namespace photon
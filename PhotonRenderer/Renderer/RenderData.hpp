@@ -1,19 +1,47 @@
 #pragma once
 
+#include <glad/glad.h>
+#include <cstdint>
+#include <glm/mat3x4.hpp>
 #include <glm/mat4x4.hpp>
 
 namespace photon {
-struct ModelData {
+/** One draw of a DrawList, std430, read by the vertex shader at gl_BaseInstance. */
+struct DrawData {
   glm::mat4 modelMatrix;
+  // inverse transpose of the upper 3x3, columns padded to vec4 like a std430 mat3
+  glm::mat3x4 normalMatrix;
+  // VertexQuantization of the mesh, padded to vec4
+  glm::vec4 positionOffset;
+  glm::vec4 positionScale;
+  // uv offset in xy, scale in zw
+  glm::vec4 uvTransform;
+  uint32_t materialIndex;
+  uint32_t padding[3];
 };
+static_assert(sizeof(DrawData) == 176, "DrawData must match the std430 layout of the shaders");
+
+/** A PBRMaterial as the pbr shader reads it, std430, indexed by DrawData::materialIndex. */
+struct MaterialData {
+  glm::vec4 baseColorFactor;
+  glm::vec3 emissiveFactor;
+  float occlusionStrength;
+  float metallicFactor;
+  float roughnessFactor;
+  float alphaCutoff;
+  // 0: opaque  1: blend  2: mask
+  int32_t alphaMode;
+  // bit i is set when textures[i] holds the handle of PBRComponent i
+  uint32_t textureMask;
+  uint32_t padding;
+  GLuint64 textures[5];
+};
+static_assert(sizeof(MaterialData) == 96,
+              "MaterialData must match the std430 layout of the shaders");
 
 struct CameraData {
   glm::mat4 projViewMatrix;
   glm::mat4 viewMatrix;
   glm::mat4 projMatrix;
 };
-
-struct PBRSamplerData {
-  GLuint64 samplers[5];
-};
 }  // namespace photon
@@ -0,0 +1,69 @@
+#include "RenderQueue.hpp"
+#include <algorithm>
+#include <array>
+
+namespace photon {
+namespace {
+constexpr uint64_t Mask(uint32_t bits) {
+  return (uint64_t{1} << bits) - 1;
+}
+}  // namespace
+
+uint64_t RenderQueue::MakeKey(RenderPass pass, uint32_t program, uint32_t material,
+                              uint32_t vertexArray, float depth) {
+  const auto maxDepth = static_cast<float>(Mask(DepthBits));
+  auto quantized      = static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * maxDepth);
+  // state below the pass, it changes least between neighbours
+  const uint64_t state = (uint64_t{program} & Mask(ProgramBits)) << (2 * StateBits) |
+                         (uint64_t{material} & Mask(StateBits)) << StateBits |
+                         (uint64_t{vertexArray} & Mask(StateBits));
+  const uint64_t passBits = uint64_t{static_cast<uint8_t>(pass)} << 62;
+  if (pass == RenderPass::Transparent) {
+    quantized = Mask(DepthBits) - quantized;
+    return passBits | quantized << (ProgramBits + 2 * StateBits) | state;
+  }
+  return passBits | state << DepthBits | quantized;
+}
+
+uint32_t RenderQueue::GetProgram(uint64_t key) {
+  const auto shift = GetPass(key) == RenderPass::Transparent ? 2 * StateBits
+                                                             : 2 * StateBits + DepthBits;
+  return static_cast<uint32_t>(key >> shift & Mask(ProgramBits));
+}
+
+void RenderQueue::Sort() {
+  RadixSort(m_packets, m_sorted);
+}
+
+void RadixSort(std::vector<RenderPacket>& packets, std::vector<RenderPacket>& scratch) {
+  if (packets.size() < 2) {
+    return;
+  }
+  // all eight histograms in one read of the keys
+  std::array<std::array<uint32_t, 256>, 8> counts{};
+  for (const auto& packet : packets) {
+    for (uint32_t byte = 0; byte < 8; byte++) {
+      counts[byte][packet.key >> (8 * byte) & 0xff]++;
+    }
+  }
+  scratch.resize(packets.size());
+  const auto numPackets = static_cast<uint32_t>(packets.size());
+  for (uint32_t byte = 0; byte < 8; byte++) {
+    auto& count = counts[byte];
+    // a byte all keys share leaves the order as it is
+    if (count[packets.front().key >> (8 * byte) & 0xff] == numPackets) {
+      continue;
+    }
+    uint32_t offset = 0;
+    for (auto& c : count) {
+      const auto n = c;
+      c            = offset;
+      offset += n;
+    }
+    for (const auto& packet : packets) {
+      scratch[count[packet.key >> (8 * byte) & 0xff]++] = packet;
+    }
+    packets.swap(scratch);
+  }
+}
+}  // namespace photon
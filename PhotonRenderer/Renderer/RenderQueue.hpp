@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace photon {
+/** Passes of the main view in the order they are drawn, the top bits of a sort key. */
+enum class RenderPass : uint8_t { Opaque = 0, Masked = 1, Skybox = 2, Transparent = 3 };
+
+struct RenderPacket {
+  uint64_t key;
+  // what to draw, an index into items the renderer keeps
+  uint32_t item;
+};
+
+/**
+ * The draws of one view as packets with 64-bit keys, sorted by an LSD radix sort so that walking
+ * them draws each pass in turn with the fewest state changes. Key bits, most significant first:
+ *
+ *   opaque, masked, skybox  pass:2 program:6 material:16 vertexArray:16 depth:24, near first
+ *   transparent             pass:2 depth:24 program:6 material:16 vertexArray:16, far first
+ *
+ * Depth is the view distance over the far plane. Transparent draws give up batching to blend in
+ * order. Equal keys keep the order they were added in.
+ */
+class RenderQueue {
+public:
+  static constexpr uint32_t DepthBits   = 24;
+  static constexpr uint32_t ProgramBits = 6;
+  static constexpr uint32_t StateBits   = 16;
+
+  /** Program, material and vertex array are ids of the caller, cut to their bits. */
+  static uint64_t MakeKey(RenderPass pass, uint32_t program, uint32_t material,
+                          uint32_t vertexArray, float depth);
+  static RenderPass GetPass(uint64_t key) { return static_cast<RenderPass>(key >> 62); }
+  static uint32_t GetProgram(uint64_t key);
+
+  void Clear() { m_packets.clear(); }
+  void Add(uint64_t key, uint32_t item) { m_packets.push_back({key, item}); }
+  void Sort();
+
+  [[nodiscard]] const std::vector<RenderPacket>& GetPackets() const { return m_packets; }
+
+private:
+  std::vector<RenderPacket> m_packets;
+  // the other buffer of the sort, kept to reuse its memory
+  std::vector<RenderPacket> m_sorted;
+};
+
+/** Sort packets by key, one counting pass per byte that differs between them. Stable. */
+void RadixSort(std::vector<RenderPacket>& packets, std::vector<RenderPacket>& scratch);
+}  // namespace photon
@@ -1,7 +1,10 @@
 #include "ShadowMap.hpp"
+#include <numeric>
 #include "Common/Logging.hpp"
 #include "Engine/Scene.hpp"
 #include "Graphics/Framebuffer.hpp"
+#include "FrustumCulling.hpp"
+#include "Graphics/StateCache.hpp"
 #include "RenderAPI.hpp"
 
 namespace photon {
@@ -18,12 +21,17 @@ ShadowMap::ShadowMap(uint32_t width, uint32_t height) : m_width(width), m_height
            {"Data/Shaders/debug_quad_depth.vs.glsl", "vertex"},
            {"Data/Shaders/debug_quad_depth.fs.glsl", "fragment"},
        }});
+  if (m_depthShader != nullptr) {
+    m_lightSpaceUniform = m_depthShader->GetUniform<glm::mat4>("uLightSpaceMat");
+    m_depthShader->CheckStorageBlock("Draws", DrawList::DrawDataBinding, sizeof(DrawData));
+  }
   SetupFramebuffer();
 }
 
-void ShadowMap::RunDepthPass(const Ref<BaseScene>& scene, const LightType& type) {
-  const auto& aabb = scene->GetAABB();
-  auto aabb_len    = glm::length(aabb.diag);
+void ShadowMap::RunDepthPass(const Ref<BaseScene>& scene, const LightType& type,
+                             float lodPixelError, bool indirect, bool cull, RenderStats& stats) {
+  const auto aabb = scene->GetAABB();
+  auto aabb_len   = glm::length(aabb.diag);
   // set near far plane
   m_near             = 0.01f * aabb_len;
   m_far              = 10.0f * aabb_len;
@@ -35,7 +43,7 @@ void ShadowMap::RunDepthPass(const Ref<BaseScene>& scene, const LightType& type)
     lightProjMatrix = glm::ortho(-box_len, box_len, -box_len, box_len, m_near, m_far);
     // for directional light, fix the light position
     lightViewMatrix =
-        glm::lookAt(scene->GetAABB().posMax * 5.0f, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::lookAt(aabb.posMax * 5.0f, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
   } else {
     lightProjMatrix = glm::perspective(glm::radians(45.0f), 1.0f, m_near, m_far);
     lightViewMatrix =
@@ -43,20 +51,58 @@ void ShadowMap::RunDepthPass(const Ref<BaseScene>& scene, const LightType& type)
   }
   m_lightSpaceMatrix = lightProjMatrix * lightViewMatrix;
 
-  glEnable(GL_DEPTH_TEST);
-  glDepthFunc(GL_LESS);
+  auto& state = StateCache::GetShared();
+  state.Enable(GL_DEPTH_TEST);
+  state.DepthFunc(GL_LESS);
   glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
   glViewport(0, 0, m_width, m_height);
   // Clear the depth buffer of the shadow map
   glClearNamedFramebufferfv(m_fbo, GL_DEPTH, 0, &ClearDepth);
   m_depthShader->Use();
-  m_depthShader->SetUniform("uLightSpaceMat", m_lightSpaceMatrix);
-  for (const auto& model : scene->m_models) {
-    for (const auto& mesh : model->GetMeshes()) {
-      m_depthShader->SetUniform("uModelMat", mesh.modelMatrix);
-      RenderAPI::DrawMesh(mesh);
+  m_depthShader->SetUniform(m_lightSpaceUniform, m_lightSpaceMatrix);
+  m_drawList.Clear();
+  const auto planes  = ExtractFrustumPlanes(m_lightSpaceMatrix);
+  const auto& models = scene->m_models;
+  if (cull) {
+    scene->QueryModels(planes, m_visibleModels);
+    stats.numShadowModelsCulled = static_cast<uint32_t>(models.size() - m_visibleModels.size());
+  } else {
+    m_visibleModels.resize(models.size());
+    std::iota(m_visibleModels.begin(), m_visibleModels.end(), 0);
+  }
+  for (const auto index : m_visibleModels) {
+    const auto& model    = models[index];
+    const auto& meshes   = model->GetMeshes();
+    const auto instances = model->GetInstances();
+    const auto& bounds   = model->GetInstanceBounds();
+    if (cull) {
+      const auto numVisible = CullAABBs(bounds, planes, m_visible);
+      stats.numShadowCastersVisible += numVisible;
+      stats.numShadowCastersCulled += bounds.Size() - numVisible;
+    } else {
+      m_visible.assign(bounds.Size(), 1);
+      stats.numShadowCastersVisible += bounds.Size();
+    }
+    for (const auto& batch : model->GetBatches()) {
+      const auto& mesh = meshes[batch.mesh];
+      // depth only, the normal matrix and material are not read
+      DrawData draw{};
+      draw.positionOffset = glm::vec4(mesh.quantization.positionOffset, 0.0f);
+      draw.positionScale  = glm::vec4(mesh.quantization.positionScale, 0.0f);
+      for (uint32_t i = batch.firstInstance; i < batch.firstInstance + batch.numInstances; i++) {
+        if (m_visible[i] == 0) {
+          continue;
+        }
+        auto& instance   = instances[i];
+        draw.modelMatrix = instance.modelMatrix;
+        auto& lod        = instance.selectedLods[static_cast<size_t>(LodView::Shadow)];
+        lod              = mesh.SelectLod(instance.modelMatrix, lightViewMatrix, lightProjMatrix,
+                                          static_cast<float>(m_height), lodPixelError, lod);
+        stats.numShadowTriangles += m_drawList.AddMesh(m_drawList.AddDraw(draw), mesh, lod);
+      }
     }
   }
+  m_drawList.Submit(indirect);
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
@@ -81,7 +127,7 @@ void ShadowMap::SetupFramebuffer() {
 }
 
 void ShadowMap::BindForRead(int slot) {
-  glBindTextureUnit(slot, m_depthTexture);
+  StateCache::GetShared().BindTextureUnit(slot, m_depthTexture);
   //  m_fbo->bind_for_reading("depth", slot);
 }
 
@@ -90,6 +136,6 @@ void ShadowMap::BindDebugTexture(const LightType& type) {
   m_debugShader->SetUniform("uNear", m_near);
   m_debugShader->SetUniform("uFar", m_far);
   m_debugShader->SetUniform("uLightType", static_cast<int>(type));
-  glBindTextureUnit(0, m_depthTexture);
+  StateCache::GetShared().BindTextureUnit(0, m_depthTexture);
 }
 }  // namespace photon
\ No newline at end of file
@@ -1,20 +1,28 @@
 #pragma once
 
 #include <glm/mat4x4.hpp>
+#include <vector>
 #include "Common/Base.hpp"
+#include "DrawList.hpp"
 #include "Engine/RenderOption.hpp"
+#include "Graphics/Shader.hpp"
 
 namespace photon {
 namespace gl {
 class Framebuffer;
-class ShaderProgram;
 }  // namespace gl
 class BaseScene;
 
 class ShadowMap {
 public:
   ShadowMap(uint32_t width, uint32_t height);
-  void RunDepthPass(const Ref<BaseScene>& scene, const LightType& type);
+  /**
+   * Draw the depth of the scene's models, at levels of detail picked from the light's view, with
+   * one multi-draw indirect call unless indirect is off. With cull, instances outside the light's
+   * frustum are skipped, they cannot cast into the map.
+   */
+  void RunDepthPass(const Ref<BaseScene>& scene, const LightType& type, float lodPixelError,
+                    bool indirect, bool cull, RenderStats& stats);
   void BindForRead(int slot);
   void BindDebugTexture(const LightType& type);
   auto GetLightSpaceMatrix() const { return m_lightSpaceMatrix; }
@@ -30,6 +38,10 @@ private:
   glm::mat4 m_lightSpaceMatrix;
   Ref<gl::ShaderProgram> m_depthShader;
   Ref<gl::ShaderProgram> m_debugShader;
+  gl::Uniform<glm::mat4> m_lightSpaceUniform;
+  DrawList m_drawList;
+  std::vector<uint32_t> m_visibleModels;
+  std::vector<uint8_t> m_visible;
   const float ClearDepth = 1.0f;
 };
 }  // namespace photon
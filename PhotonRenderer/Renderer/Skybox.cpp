@@ -1,4 +1,5 @@
 #include "Skybox.hpp"
+#include "Graphics/StateCache.hpp"
 #include "Graphics/framebuffer.hpp"
 #include "Renderer/RenderAPI.hpp"
 #include "Utils/AssetCache.hpp"
@@ -128,18 +129,20 @@ Skybox::Skybox(const std::vector<std::string>& face_paths) {
   m_type = SkyboxType::Cubemap;
   SetupShaders();
   setup_cube_quads();
-  glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+  gl::StateCache::GetShared().Enable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
   //m_cube_texture = m_assetCache->RequestTexture("skybox1", face_paths);
 }
 
 Skybox::Skybox(const std::string& hdrPath, int resolution) : m_resolution(resolution) {
   // init asset cache
   m_assetCache = CreateUnique<util::AssetCache>();
+  // decoded on the shared pool while the shaders compile
+  m_assetCache->PrefetchTexture(hdrPath);
 
   m_type = SkyboxType::Equirectangular;
   SetupShaders();
   setup_cube_quads();
-  glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+  gl::StateCache::GetShared().Enable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
   AttachmentInfo baseColor{.width   = resolution,
                            .height  = resolution,
                            .type    = AttachmentType::TEXTURE_CUBEMAP,
@@ -264,9 +267,10 @@ void Skybox::BindPrefilterData() {
 }
 
 void Skybox::UnbindPrefilterData() {
-  glBindTextureUnit(3, 0);
-  glBindTextureUnit(4, 0);
-  glBindTextureUnit(5, 0);
+  auto& state = gl::StateCache::GetShared();
+  state.BindTextureUnit(3, 0);
+  state.BindTextureUnit(4, 0);
+  state.BindTextureUnit(5, 0);
 }
 
 void Skybox::Draw(const Ref<system::Camera>& camera, bool blur) {
@@ -1,5 +1,6 @@
 #include "GeoMipGrid.hpp"
 #include "Common/Math.hpp"
+#include "Graphics/StateCache.hpp"
 #include "Terrain.hpp"
 
 int gShowPoints = 0;
@@ -12,6 +13,7 @@ GeomipGrid::~GeomipGrid() {
 
 void GeomipGrid::Destroy() {
   if (m_vao > 0) {
+    gl::StateCache::GetShared().ForgetVertexArray(m_vao);
     glDeleteVertexArrays(1, &m_vao);
   }
 
@@ -64,7 +66,7 @@ void GeomipGrid::CreateGeomipGrid(int Width, int Depth, int PatchSize, const Ter
 
   PopulateBuffers(pTerrain);
 
-  glBindVertexArray(0);
+  gl::StateCache::GetShared().BindVertexArray(0);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
@@ -72,7 +74,7 @@ void GeomipGrid::CreateGeomipGrid(int Width, int Depth, int PatchSize, const Ter
 void GeomipGrid::CreateGLState() {
   glGenVertexArrays(1, &m_vao);
 
-  glBindVertexArray(m_vao);
+  gl::StateCache::GetShared().BindVertexArray(m_vao);
 
   glGenBuffers(1, &m_vb);
 
@@ -337,7 +339,7 @@ void GeomipGrid::CalcNormals(std::vector<Vertex>& Vertices, std::vector<uint32_t
 void GeomipGrid::Render(const glm::vec3& CameraPos) {
   m_lodManager.Update(CameraPos);
 
-  glBindVertexArray(m_vao);
+  gl::StateCache::GetShared().BindVertexArray(m_vao);
 
   if (gShowPoints > 0) {
     glDrawElementsBaseVertex(GL_POINTS, m_lodInfo[0].info[0][0][0][0].Count, GL_UNSIGNED_INT,
@@ -366,7 +368,5 @@ void GeomipGrid::Render(const glm::vec3& CameraPos) {
       }
     }
   }
-
-  glBindVertexArray(0);
 }
 }  // namespace photon
\ No newline at end of file
@@ -3,6 +3,12 @@
 #include "Common/Math.hpp"
 #include "Graphics/Shader.hpp"
 #include "Systems/CameraSystem.hpp"
+#include "Utils/AssetLoader.hpp"
+#include "Utils/ModelSource.hpp"
+#include "Utils/TextureBaker.hpp"
+#include "Utils/TextureRegistry.hpp"
+#include "Utils/TextureResidency.hpp"
+#include "Utils/ThreadPool.hpp"
 
 namespace photon {
 Terrain::Terrain(const TerrainCreateInfo& info) {
@@ -18,14 +24,32 @@ Terrain::Terrain(const TerrainCreateInfo& info) {
     LOGE("Number of terrain textures is not equal to {}", m_textures.size());
     exit(0);
   }
-  for (auto i = 0u; i < m_textures.size(); i++) {
-    m_textures[i] = CreateRef<Texture2D>(info.textureFiles[i]);
+  // decoded on the shared pool while the shader compiles, uploaded here on the GL thread
+  auto& pool = util::ThreadPool::GetShared();
+  std::vector<std::future<util::TextureSource>> decoded;
+  for (const auto& path : info.textureFiles) {
+    decoded.push_back(pool.Async([path] {
+      util::TextureSource texture{.path = path};
+      util::AssetLoader::DecodeBakedImage(texture, util::TextureUsage::Color);
+      return texture;
+    }));
   }
   // init shader program
   gl::ShaderProgramCreateInfo shaderInfo = {
       "TerrainShader",
       {{"Data/Shaders/terrain.vs.glsl", "vertex"}, {"Data/Shaders/terrain.fs.glsl", "fragment"}}};
   m_shader = gl::ShaderProgramFactory::CreateShaderProgram(shaderInfo);
+  if (m_shader != nullptr) {
+    m_viewProjUniform  = m_shader->GetUniform<glm::mat4>("gVP");
+    m_lightDirUniform  = m_shader->GetUniform<glm::vec3>("gReversedLightDir");
+    m_minHeightUniform = m_shader->GetUniform<float>("gMinHeight");
+    m_maxHeightUniform = m_shader->GetUniform<float>("gMaxHeight");
+  }
+
+  for (auto i = 0u; i < m_textures.size(); i++) {
+    const auto texture = pool.Wait(decoded[i]);
+    m_textures[i] = util::TextureRegistry::GetShared().Acquire(texture);
+  }
 }
 
 Terrain::~Terrain() {
@@ -136,19 +160,20 @@ void Terrain::Draw(const Ref<system::Camera>& camera, const glm::vec3& lightDir)
   auto VP = camera->GetProjectionMatrix() * camera->GetViewMatrix();
 
   m_shader->Use();
-  m_shader->SetUniform("gVP", VP);
+  m_shader->SetUniform(m_viewProjUniform, VP);
 
   for (int i = 0; i < m_textures.size(); i++) {
     if (m_textures[i]) {
+      util::TextureResidency::GetShared().Use(*m_textures[i]);
       m_textures[i]->Bind(i);
     }
   }
   double range = m_maxHeigt - m_minHeight;
   double step  = range / 4.0;
 
-  m_shader->SetUniform("gReversedLightDir", {1.0, 1.0f, 1.0f});
-  m_shader->SetUniform("gMinHeight", m_minHeight);
-  m_shader->SetUniform("gMaxHeight", m_maxHeigt);
+  m_shader->SetUniform(m_lightDirUniform, {1.0, 1.0f, 1.0f});
+  m_shader->SetUniform(m_minHeightUniform, m_minHeight);
+  m_shader->SetUniform(m_maxHeightUniform, m_maxHeigt);
   m_geomipGrid.Render(camera->GetPos());
 }
 
@@ -5,6 +5,7 @@
 #include "Assets/Texture.hpp"
 #include "Common/Array2D.hpp"
 #include "Common/Base.hpp"
+#include "Graphics/Shader.hpp"
 #include "GeoMipGrid.hpp"
 // Reference:https://github.com/emeiri/ogldev/tree/master/Terrain7
 namespace photon {
@@ -12,10 +13,6 @@ using asset::Texture2D;
 namespace system {
 class Camera;
 }
-namespace gl {
-class ShaderProgram;
-}
-
 struct TerrainCreateInfo {
   int terrainSize;
   int patchSize;
@@ -59,6 +56,11 @@ private:
   Array2D<float> m_heightMap;
   GeomipGrid m_geomipGrid;
   Ref<gl::ShaderProgram> m_shader;
+  // resolved when the shader is built, set every draw
+  gl::Uniform<glm::mat4> m_viewProjUniform;
+  gl::Uniform<glm::vec3> m_lightDirUniform;
+  gl::Uniform<float> m_minHeightUniform;
+  gl::Uniform<float> m_maxHeightUniform;
 };
 
 }  // namespace photon
\ No newline at end of file
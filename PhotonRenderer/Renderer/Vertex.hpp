@@ -1,6 +1,8 @@
 #pragma once
+#include <cstdint>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 namespace photon {
 struct LineVertex {
   glm::vec3 position;
@@ -25,4 +27,23 @@ struct Vertex {
   vec3 normal;
   //  vec3 tangent;
 };
+
+/** Vertex as uploaded, 16 bytes in the attribute order of Vertex. */
+struct PackedVertex {
+  // unorm16 within the position bounds of the mesh, w is padding
+  uint16_t position[4];
+  // unorm16 within the uv bounds of the mesh
+  uint16_t uv[2];
+  // octahedral unit vector, snorm16
+  int16_t normal[2];
+};
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay 16 bytes");
+
+/** Turns the unorm16 attributes of PackedVertex back into values: offset + scale * unorm. */
+struct VertexQuantization {
+  glm::vec3 positionOffset{0.0f};
+  glm::vec3 positionScale{1.0f};
+  glm::vec2 uvOffset{0.0f};
+  glm::vec2 uvScale{1.0f};
+};
 }  // namespace photon
\ No newline at end of file
@@ -15,6 +15,7 @@ public:
   glm::mat4 GetViewMatrix() const;
   glm::mat4 GetProjectionMatrix() const;
   const auto GetPos() const { return m_position; }
+  float GetFar() const { return m_far; }
 
   void SetSpeed(float speed) { m_speed = speed; }
   void Update(float deltaTime, bool rotate = false);
@@ -1,5 +1,7 @@
 #include "GUISystem.hpp"
 #include "Common/Logging.hpp"
+#include "Graphics/GeometryPool.hpp"
+#include "Renderer/MaterialTable.hpp"
 
 namespace photon::system {
 static const char* glsl_version = "#version 450";
@@ -24,7 +26,7 @@ GUISystem::GUISystem(GLFWwindow* glfw_window) {
   ImGui_ImplOpenGL3_Init(glsl_version);
 }
 
-void GUISystem::Draw(Ref<RenderOptions> options) {
+void GUISystem::Draw(Ref<RenderOptions> options, const RenderStats& stats) {
   BeginFrame();
   {
     ImGui::SetNextWindowSize(ImVec2(300, 300));
@@ -34,6 +36,34 @@ void GUISystem::Draw(Ref<RenderOptions> options) {
     ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 1.0f, 0.0f, 1.0f));
     ImGui::Text("Frame time: %.3f ms", 1000.0f / ImGui::GetIO().Framerate);
     ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+    ImGui::Text("CPU frame time: %.3f ms", stats.cpuFrameTime);
+    ImGui::Text("Triangles: %llu in %u draws, %u calls",
+                static_cast<unsigned long long>(stats.numTriangles), stats.numDraws,
+                stats.numDrawCalls);
+    ImGui::Text("Shadow triangles: %llu",
+                static_cast<unsigned long long>(stats.numShadowTriangles));
+    ImGui::Text("Instances: %u visible, %u culled, %u models culled", stats.numInstancesVisible,
+                stats.numInstancesCulled, stats.numModelsCulled);
+    ImGui::Text("Shadow casters: %u visible, %u culled, %u models culled",
+                stats.numShadowCastersVisible, stats.numShadowCastersCulled,
+                stats.numShadowModelsCulled);
+    ImGui::Text("State changes: %u issued, %u elided", stats.numStateChanges,
+                stats.numStateChangesElided);
+    ImGui::Text("Render queue: %u packets, overdraw %.2f", stats.numPackets, stats.overdraw);
+    if (options->cullClusters) {
+      ImGui::Text("Clusters: %u, culled %u by frustum, %u by cone", stats.numClusters,
+                  stats.numClustersFrustumCulled, stats.numClustersBackfaceCulled);
+    }
+    const auto pool = gl::GeometryPool::GetShared().GetStats();
+    ImGui::Text("Geometry pool: %u meshes, %u grown", pool.numAllocations, pool.numGrowths);
+    ImGui::Text("  vertices %u / %u, %u holes, %.0f%% fragmented", pool.usedVertices,
+                pool.vertexCapacity, pool.numFreeVertexRanges,
+                pool.vertexFragmentation * 100.0f);
+    ImGui::Text("  indices %u / %u, %u holes, %.0f%% fragmented", pool.usedIndices,
+                pool.indexCapacity, pool.numFreeIndexRanges, pool.indexFragmentation * 100.0f);
+    const auto materials = MaterialTable::GetShared().GetStats();
+    ImGui::Text("Materials: %u, %u rows sent in %u calls", materials.numMaterials,
+                materials.uploadedRows, materials.uploadCalls);
     ImGui::PopStyleColor();
 
     ImGui::Checkbox("Show Axis", &options->showAxis);
@@ -60,6 +90,16 @@ void GUISystem::Draw(Ref<RenderOptions> options) {
     }
     if (ImGui::CollapsingHeader("Scene Settings")) {
       ImGui::Checkbox("Show Floor", &options->showFloor);
+      ImGui::Checkbox("Mesh LOD", &options->enableLod);
+      ImGui::SameLine();
+      ImGui::Checkbox("Cluster Culling", &options->cullClusters);
+      ImGui::Checkbox("Indirect Draws", &options->indirectDraws);
+      ImGui::SameLine();
+      ImGui::Checkbox("Sort Draws", &options->sortDraws);
+      ImGui::Checkbox("Frustum Culling", &options->frustumCulling);
+      if (options->enableLod) {
+        ImGui::SliderFloat("LOD Pixel Error", &options->lodPixelError, 0.25f, 8.0f);
+      }
       ImGui::Text("Light Type:");
       ImGui::RadioButton("Directional", reinterpret_cast<int*>(&options->lightType), 1);
       ImGui::RadioButton("Spot", reinterpret_cast<int*>(&options->lightType), 0);
@@ -16,7 +16,7 @@ public:
   GUISystem(GLFWwindow* glfw_window);
   ~GUISystem();
 
-  void Draw(Ref<RenderOptions> options);
+  void Draw(Ref<RenderOptions> options, const RenderStats& stats);
 
 private:
   void BeginFrame();
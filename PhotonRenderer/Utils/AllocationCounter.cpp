@@ -0,0 +1,55 @@
+#include "AllocationCounter.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace photon::util {
+namespace {
+// relaxed, a reading only has to add up once the threads it counts are done
+std::atomic<uint64_t> NumAllocations{0};
+std::atomic<uint64_t> NumAllocatedBytes{0};
+}  // namespace
+
+AllocationStats GetAllocationStats() {
+  return {NumAllocations.load(std::memory_order_relaxed),
+          NumAllocatedBytes.load(std::memory_order_relaxed)};
+}
+}  // namespace photon::util
+
+#if defined(PHOTON_COUNT_ALLOCATIONS)
+// the nothrow forms fall back to these, so every allocation is counted once
+void* operator new(std::size_t size) {
+  photon::util::NumAllocations.fetch_add(1, std::memory_order_relaxed);
+  photon::util::NumAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  while (true) {
+    if (void* pointer = std::malloc(size != 0 ? size : 1)) {
+      return pointer;
+    }
+    const auto handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+  std::free(pointer);
+}
+#endif
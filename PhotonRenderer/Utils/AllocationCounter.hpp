@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+namespace photon::util {
+/** Heap allocations made through operator new, counted over every thread. */
+struct AllocationStats {
+  uint64_t allocations{0};
+  uint64_t bytes{0};
+
+  AllocationStats operator-(const AllocationStats& other) const {
+    return {allocations - other.allocations, bytes - other.bytes};
+  }
+};
+
+/**
+ * Whether allocations are counted at all. Counting replaces the global operator new with one that
+ * adds an atomic update to every allocation, so only builds defining PHOTON_COUNT_ALLOCATIONS do.
+ */
+#if defined(PHOTON_COUNT_ALLOCATIONS)
+constexpr bool CountsAllocations = true;
+#else
+constexpr bool CountsAllocations = false;
+#endif
+
+/**
+ * Allocations since the program started, subtract two readings for what happened in between.
+ * The counters sit in the global operator new, which AllocationCounter.cpp replaces; the
+ * over-aligned forms do not go through it and are not counted. Always zero without counting.
+ */
+AllocationStats GetAllocationStats();
+}  // namespace photon::util
@@ -1,31 +1,518 @@
 #include "AssetCache.hpp"
+#include <algorithm>
+#include <span>
 #include "Common/Logging.hpp"
+#include "Graphics/GeometryPool.hpp"
+#include "Graphics/StagingBuffer.hpp"
+#include "MeshCache.hpp"
+#include "MeshUtils.hpp"
+#include "ModelSource.hpp"
 #include "Renderer/Vertex.hpp"
+#include "StopWatch.hpp"
+#include "TextureRegistry.hpp"
+#include "ThreadPool.hpp"
 
 namespace photon::util {
+namespace {
+// offsets inside the staging buffer, enough for every pixel and vertex format
+constexpr uint32_t StagingAlignment = 16;
+// copies are issued in slices of at most this size, so the time budget is checked in between
+constexpr uint64_t MaxChunkSize = 1u << 20;
+
+// bytes GL reads per row of pixels with the default unpack alignment of 4
+uint64_t GetRowSize(const asset::TextureInfo& info) {
+  uint64_t rowSize = static_cast<uint64_t>(info.width);
+  if (info.dataType == GL_UNSIGNED_INT_5_9_9_9_REV ||
+      info.dataType == GL_UNSIGNED_INT_10F_11F_11F_REV) {
+    // every channel packed into a single 32-bit value
+    return rowSize * 4;
+  }
+  switch (info.dataFormat) {
+    case GL_RED:
+      break;
+    case GL_RG:
+      rowSize *= 2;
+      break;
+    case GL_RGB:
+      rowSize *= 3;
+      break;
+    default:
+      rowSize *= 4;
+      break;
+  }
+  switch (info.dataType) {
+    case GL_FLOAT:
+      rowSize *= 4;
+      break;
+    case GL_HALF_FLOAT:
+      rowSize *= 2;
+      break;
+    default:
+      break;
+  }
+  return (rowSize + 3) & ~uint64_t{3};
+}
+}  // namespace
+
+struct AssetCache::PendingAsset {
+  std::string path;
+  // exactly one of the two is set
+  Ref<ModelHandle> model;
+  Ref<TextureHandle> texture;
+  ModelSource source;
+  bool failed{false};
+  float decodeMs{0.0f};
+  // GL objects being filled, their contents are only complete once the upload is finished
+  std::vector<asset::Mesh> meshes;
+  std::vector<Ref<Texture2D>> textures;
+  // already resident through the texture registry, nothing to upload
+  std::vector<bool> sharedTextures;
+  // upload cursor: all textures row by row, then the vertices and indices of each mesh
+  size_t item{0};
+  uint64_t itemOffset{0};
+  uint32_t numFrames{0};
+
+  [[nodiscard]] size_t GetNumItems() const { return textures.size() + meshes.size() * 2; }
+};
+
 Ref<Model> AssetCache::RequestModel(const std::string& path) {
   if (m_modelCache.find(path) == m_modelCache.end()) {
-    m_modelCache.try_emplace(path, m_loader->LoadModel(path));
+    m_modelCache.try_emplace(path, LoadModel(path));
   }
   return m_modelCache.at(path);
 }
 
+bool AssetCache::LoadModelSource(const std::string& path, ModelSource& source) {
+  StopWatch stopWatch;
+  uint64_t sourceHash = 0;
+  if (!HashModelFiles(path, sourceHash)) {
+    return false;
+  }
+  const auto cachePath = path + ".pmesh";
+  if (ReadMeshCache(cachePath, sourceHash, source)) {
+    LOGI("Loaded {} from {} in {:.2f} ms", path, cachePath, stopWatch.TimeStep() * 1000.0f);
+    return true;
+  }
+  if (!AssetLoader::DecodeModel(path, source)) {
+    return false;
+  }
+  const auto loadSeconds = stopWatch.TimeStep();
+  if (WriteMeshCache(cachePath, sourceHash, source)) {
+    LOGI("Loaded {} in {:.2f} ms, baked {} in {:.2f} ms", path, loadSeconds * 1000.0f, cachePath,
+         stopWatch.TimeStep() * 1000.0f);
+  }
+  return true;
+}
+
+Ref<Model> AssetCache::LoadModel(const std::string& path) {
+  Unique<ModelSource> source;
+  if (const auto it = m_prefetchedModels.find(path); it != m_prefetchedModels.end()) {
+    source = ThreadPool::GetShared().Wait(it->second);
+    m_prefetchedModels.erase(it);
+  } else {
+    source = CreateUnique<ModelSource>();
+    if (!LoadModelSource(path, *source)) {
+      return nullptr;
+    }
+    // a missing image leaves its texture empty, like in CreateModel
+    AssetLoader::DecodeModelImages(*source);
+  }
+  return source != nullptr ? m_loader->CreateModel(std::move(*source)) : nullptr;
+}
+
+void AssetCache::PrefetchModel(const std::string& path) {
+  if (m_modelCache.contains(path) || m_prefetchedModels.contains(path)) {
+    return;
+  }
+  m_prefetchedModels.try_emplace(path, ThreadPool::GetShared().Async([path] {
+    auto source = CreateUnique<ModelSource>();
+    if (!LoadModelSource(path, *source)) {
+      return Unique<ModelSource>();
+    }
+    AssetLoader::DecodeModelImages(*source);
+    return source;
+  }));
+}
+
 Ref<Texture2D> AssetCache::RequestTexture(const std::string& path) {
   if (m_textureCache.find(path) == m_textureCache.end()) {
-    m_textureCache.try_emplace(path, m_loader->LoadTexture(path));
+    Ref<Texture2D> texture;
+    if (const auto it = m_prefetchedTextures.find(path); it != m_prefetchedTextures.end()) {
+      const auto source = ThreadPool::GetShared().Wait(it->second);
+      m_prefetchedTextures.erase(it);
+      if (source != nullptr) {
+        texture = TextureRegistry::GetShared().Acquire(*source);
+      }
+    } else {
+      texture = m_loader->LoadTexture(path);
+    }
+    m_textureCache.try_emplace(path, texture);
   }
   return m_textureCache.at(path);
 }
 
-AssetCache::AssetCache() {
-  m_whiteTexture = Texture2D::CreateDefaultWhite();
+void AssetCache::PrefetchTexture(const std::string& path) {
+  if (m_textureCache.contains(path) || m_prefetchedTextures.contains(path)) {
+    return;
+  }
+  m_prefetchedTextures.try_emplace(path, ThreadPool::GetShared().Async([path] {
+    auto source = CreateUnique<TextureSource>();
+    if (!AssetLoader::DecodeTexture(path, *source)) {
+      return Unique<TextureSource>();
+    }
+    return source;
+  }));
+}
+
+Ref<ModelHandle> AssetCache::RequestModelAsync(const std::string& path) {
+  if (const auto it = m_modelHandles.find(path); it != m_modelHandles.end()) {
+    return it->second;
+  }
+  auto handle = CreateRef<ModelHandle>();
+  if (const auto it = m_modelCache.find(path); it != m_modelCache.end() && it->second) {
+    handle->m_asset = it->second;
+    handle->m_state = AssetState::Resident;
+  } else {
+    auto pending   = CreateRef<PendingAsset>();
+    pending->path  = path;
+    pending->model = handle;
+    Submit(pending);
+  }
+  m_modelHandles.try_emplace(path, handle);
+  return handle;
+}
+
+Ref<TextureHandle> AssetCache::RequestTextureAsync(const std::string& path) {
+  if (const auto it = m_textureHandles.find(path); it != m_textureHandles.end()) {
+    return it->second;
+  }
+  auto handle  = CreateRef<TextureHandle>();
+  auto texture = TextureRegistry::GetShared().Find(AssetLoader::DescribeTexture(path));
+  if (const auto it = m_textureCache.find(path); it != m_textureCache.end() && it->second) {
+    texture = it->second;
+  }
+  if (texture != nullptr) {
+    handle->m_asset = texture;
+    handle->m_state = AssetState::Resident;
+    m_textureCache.try_emplace(path, texture);
+  } else {
+    handle->m_asset  = m_whiteTexture;
+    auto pending     = CreateRef<PendingAsset>();
+    pending->path    = path;
+    pending->texture = handle;
+    Submit(pending);
+  }
+  m_textureHandles.try_emplace(path, handle);
+  return handle;
+}
+
+void AssetCache::Submit(const Ref<PendingAsset>& pending) {
+  m_stats.pendingAssets++;
+  // finished jobs are dropped here rather than every frame
+  std::erase_if(m_decodeJobs, [](const std::future<void>& job) {
+    return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  });
+  m_decodeJobs.push_back(ThreadPool::GetShared().Async([this, pending] {
+    StopWatch stopWatch;
+    auto& source = pending->source;
+    if (pending->model != nullptr) {
+      pending->failed = !LoadModelSource(pending->path, source);
+      // images with a file of their own are decoded here too, rather than on the GL thread
+      if (!pending->failed) {
+        AssetLoader::DecodeModelImages(source);
+      }
+    } else {
+      auto& texture       = source.textures.emplace_back();
+      pending->failed     = !AssetLoader::DecodeTexture(pending->path, texture);
+      texture.contentHash = TextureRegistry::ComputeContentHash(texture);
+    }
+    pending->decodeMs = stopWatch.TimeStep() * 1000.0f;
+    std::lock_guard lock(m_decodedMutex);
+    m_decoded.push_back(pending);
+  }));
+}
+
+void AssetCache::ProcessUploads() {
+  StopWatch stopWatch;
+  const float budgetSeconds = m_budget.millisecondsPerFrame / 1000.0f;
+  std::vector<Ref<PendingAsset>> decoded;
+  {
+    // allocating GL storage is not free either, start as many as the time budget allows
+    std::lock_guard lock(m_decodedMutex);
+    decoded.swap(m_decoded);
+  }
+  for (size_t i = 0; i < decoded.size(); i++) {
+    const auto& pending = decoded[i];
+    if (i > 0 && stopWatch.TimeStepSinceInitialisation() >= budgetSeconds) {
+      std::lock_guard lock(m_decodedMutex);
+      m_decoded.insert(m_decoded.begin(), decoded.begin() + i, decoded.end());
+      break;
+    }
+    if (pending->failed) {
+      LOGE("Failed to stream {}", pending->path);
+      if (pending->model != nullptr) {
+        pending->model->m_state = AssetState::Failed;
+      } else {
+        pending->texture->m_state = AssetState::Failed;
+      }
+      m_stats.pendingAssets--;
+      continue;
+    }
+    BeginUpload(*pending);
+    m_uploads.push_back(pending);
+  }
+
+  m_stats.uploadedBytes = 0;
+  if (!m_uploads.empty()) {
+    if (m_staging == nullptr) {
+      m_staging = gl::StagingBuffer::Create(m_budget.bytesPerFrame);
+    }
+    for (const auto& pending : m_uploads) {
+      pending->numFrames++;
+    }
+    m_staging->BeginFrame();
+    while (!m_uploads.empty() && m_stats.uploadedBytes < m_budget.bytesPerFrame &&
+           stopWatch.TimeStepSinceInitialisation() < budgetSeconds) {
+      auto& pending = *m_uploads.front();
+      if (pending.item < pending.GetNumItems() &&
+          !UploadChunk(pending, m_budget.bytesPerFrame - m_stats.uploadedBytes,
+                       m_stats.uploadedBytes)) {
+        break;
+      }
+      if (pending.item == pending.GetNumItems()) {
+        FinishUpload(pending);
+        m_uploads.pop_front();
+      }
+    }
+    m_staging->EndFrame();
+  }
+  m_stats.uploadMs    = stopWatch.TimeStepSinceInitialisation() * 1000.0f;
+  m_stats.maxUploadMs = std::max(m_stats.maxUploadMs, m_stats.uploadMs);
+}
+
+void AssetCache::BeginUpload(PendingAsset& pending) {
+  const auto& source = pending.source;
+  // storage only, filled chunk by chunk through the staging buffer
+  auto& registry = TextureRegistry::GetShared();
+  for (const auto& texture : source.textures) {
+    const bool hasPixels = !texture.GetPixels().empty() && texture.info.height > 0;
+    auto shared          = registry.Find(texture);
+    // without pixels the file was shared when decoded and may have gone since, or could not be
+    // read
+    if (shared == nullptr && !hasPixels && !texture.path.empty()) {
+      TextureSource reloaded{.path = texture.path, .info = texture.info};
+      if (AssetLoader::DecodeBakedImage(reloaded, texture.usage)) {
+        shared = registry.Acquire(reloaded);
+      }
+    }
+    pending.sharedTextures.push_back(shared != nullptr);
+    if (shared != nullptr) {
+      pending.textures.push_back(std::move(shared));
+    } else if (!hasPixels) {
+      pending.textures.push_back(nullptr);
+    } else if (!texture.levels.empty()) {
+      pending.textures.push_back(Texture2D::Create(texture.info, texture.levels, nullptr));
+    } else {
+      pending.textures.push_back(Texture2D::Create(texture.info, nullptr));
+    }
+  }
+  if (pending.model == nullptr) {
+    return;
+  }
+  pending.meshes.reserve(source.meshes.size());
+  for (const auto& mesh : source.meshes) {
+    pending.meshes.emplace_back(static_cast<GLsizei>(mesh.GetVertices().size()),
+                                static_cast<GLsizei>(mesh.GetIndices().size()));
+  }
+
+  // the bounding box stands in for the model until every buffer and texture is filled
+  std::vector<Vertex> vertices;
+  std::vector<uint32_t> indices;
+  BuildBoxMesh(source.aabb.posMin, source.aabb.posMax, vertices, indices);
+  asset::Mesh proxy{vertices, indices};
+  proxy.material.textures[asset::PBRComponent::BaseColor] = m_whiteTexture;
+  auto model = Model::Create(source.name);
+  model->AttachMesh(std::move(proxy));
+  model->SetAABB(source.aabb);
+  pending.model->m_asset = model;
+  pending.model->m_state = AssetState::Decoded;
+}
+
+bool AssetCache::UploadChunk(PendingAsset& pending, uint64_t maxBytes, uint64_t& uploadedBytes) {
+  const auto available =
+      std::min({maxBytes, MaxChunkSize, uint64_t{m_staging->GetAvailable(StagingAlignment)}});
+  const auto next_item = [&] {
+    pending.item++;
+    pending.itemOffset = 0;
+  };
+  uint32_t offset = 0;
+
+  const auto numTextures = pending.textures.size();
+  if (pending.item < numTextures && pending.sharedTextures[pending.item]) {
+    next_item();
+    return true;
+  }
+  if (pending.item < numTextures) {
+    const auto& texture = pending.textures[pending.item];
+    const auto& source  = pending.source.textures[pending.item];
+    const auto pixels   = source.GetPixels();
+    if (texture != nullptr && !source.levels.empty()) {
+      return UploadCompressedChunk(pending, available, uploadedBytes);
+    }
+    const auto height   = static_cast<uint64_t>(source.info.height);
+    const auto rowSize  = GetRowSize(source.info);
+    const auto maxRow   = std::min<uint64_t>(MaxChunkSize, m_staging->GetRegionSize());
+    if (texture == nullptr || rowSize > maxRow || pixels.size() < rowSize * height) {
+      if (texture != nullptr) {
+        LOGW("Skipping a texture of {} that does not fit a staging chunk", pending.path);
+      }
+      next_item();
+      return true;
+    }
+    // whole rows only, a texture larger than the budget is spread over several frames
+    const auto rows = std::min(available / rowSize, height - pending.itemOffset);
+    if (rows == 0) {
+      return false;
+    }
+    m_staging->Write(pixels.data() + pending.itemOffset * rowSize,
+                     static_cast<uint32_t>(rows * rowSize), StagingAlignment, offset);
+    m_staging->CopyToTexture(offset, texture->GetId(), static_cast<int>(pending.itemOffset),
+                             source.info.width, static_cast<int>(rows), source.info.dataFormat,
+                             source.info.dataType);
+    uploadedBytes += rows * rowSize;
+    pending.itemOffset += rows;
+    if (pending.itemOffset == height) {
+      if (source.info.generateMipmap) {
+        texture->GenerateMipmap();
+      }
+      next_item();
+    }
+    return true;
+  }
+
+  const auto meshIndex   = (pending.item - numTextures) / 2;
+  const bool isIndices   = (pending.item - numTextures) % 2 == 1;
+  const auto& meshSource = pending.source.meshes[meshIndex];
+  const auto& geometry   = pending.meshes[meshIndex].geometry;
+  const auto bytes       = isIndices ? std::as_bytes(meshSource.GetIndices())
+                                     : std::as_bytes(meshSource.GetVertices());
+  const auto size        = std::min<uint64_t>(available, bytes.size() - pending.itemOffset);
+  if (size > 0) {
+    // looked up per chunk, the pool swaps its buffers when it grows
+    const auto& pool    = gl::GeometryPool::GetShared();
+    const auto buffer   = isIndices ? pool.GetIndexBuffer() : pool.GetVertexBuffer();
+    const auto dstStart = isIndices ? uint64_t{geometry.GetFirstIndex()} * sizeof(uint32_t)
+                                    : uint64_t{geometry.GetBaseVertex()} * pool.GetVertexStride();
+    m_staging->Write(bytes.data() + pending.itemOffset, static_cast<uint32_t>(size),
+                     StagingAlignment, offset);
+    m_staging->CopyToBuffer(offset, buffer, dstStart + pending.itemOffset,
+                            static_cast<uint32_t>(size));
+    uploadedBytes += size;
+    pending.itemOffset += size;
+  } else if (pending.itemOffset < bytes.size()) {
+    return false;
+  }
+  if (pending.itemOffset == bytes.size()) {
+    next_item();
+  }
+  return true;
+}
+
+bool AssetCache::UploadCompressedChunk(PendingAsset& pending, uint64_t available,
+                                       uint64_t& uploadedBytes) {
+  const auto& texture = pending.textures[pending.item];
+  const auto& source  = pending.source.textures[pending.item];
+  const auto pixels   = source.GetPixels();
+  // itemOffset counts rows of 4x4 blocks across the whole mip chain
+  uint64_t firstRow = 0;
+  for (size_t level = 0; level < source.levels.size(); level++) {
+    const auto& info   = source.levels[level];
+    const auto numRows = static_cast<uint64_t>((info.height + 3) / 4);
+    if (pending.itemOffset >= firstRow + numRows) {
+      firstRow += numRows;
+      continue;
+    }
+    const auto rowSize = info.size / numRows;
+    const auto maxRow  = std::min<uint64_t>(MaxChunkSize, m_staging->GetRegionSize());
+    if (rowSize > maxRow || info.offset + info.size > pixels.size()) {
+      LOGW("Skipping a texture of {} that does not fit a staging chunk", pending.path);
+      break;
+    }
+    const auto row  = pending.itemOffset - firstRow;
+    const auto rows = std::min(available / rowSize, numRows - row);
+    if (rows == 0) {
+      return false;
+    }
+    const auto y      = static_cast<int>(row * 4);
+    const auto height = std::min(static_cast<int>(rows * 4), info.height - y);
+    const auto size   = static_cast<uint32_t>(rows * rowSize);
+    uint32_t offset   = 0;
+    m_staging->Write(pixels.data() + info.offset + row * rowSize, size, StagingAlignment, offset);
+    m_staging->CopyToCompressedTexture(offset, texture->GetId(), static_cast<int>(level), y,
+                                       info.width, height, source.info.internalFormat, size);
+    uploadedBytes += size;
+    pending.itemOffset += rows;
+    if (level + 1 < source.levels.size() || row + rows < numRows) {
+      return true;
+    }
+    break;
+  }
+  pending.item++;
+  pending.itemOffset = 0;
+  return true;
+}
+
+void AssetCache::FinishUpload(PendingAsset& pending) {
+  m_stats.pendingAssets--;
+  LOGI("Streamed {}: decoded in {:.2f} ms, uploaded over {} frames", pending.path,
+       pending.decodeMs, pending.numFrames);
+  // filled now, so other models may share them
+  auto& registry = TextureRegistry::GetShared();
+  for (size_t i = 0; i < pending.textures.size(); i++) {
+    if (pending.textures[i] != nullptr && !pending.sharedTextures[i]) {
+      registry.Register(pending.source.textures[i], pending.textures[i]);
+    }
+  }
+  if (pending.texture != nullptr) {
+    const auto& texture = pending.textures.front();
+    if (texture == nullptr) {
+      pending.texture->m_state = AssetState::Failed;
+      return;
+    }
+    pending.texture->m_asset = texture;
+    pending.texture->m_state = AssetState::Resident;
+    m_textureCache.try_emplace(pending.path, texture);
+    return;
+  }
+  for (size_t i = 0; i < pending.meshes.size(); i++) {
+    auto& source                   = pending.source.meshes[i];
+    pending.meshes[i].quantization = source.quantization;
+    pending.meshes[i].lods         = std::move(source.lods);
+    pending.meshes[i].meshlets     = std::move(source.meshlets);
+    pending.meshes[i].material     = std::move(source.material);
+    source.BindTextures(pending.textures, pending.meshes[i].material);
+  }
+  const auto& model = pending.model->m_asset;
+  model->ReplaceProxy(std::move(pending.meshes), std::move(pending.source.instances));
+  pending.model->m_state = AssetState::Resident;
+  m_modelCache.try_emplace(pending.path, model);
+}
+
+AssetCache::AssetCache(const UploadBudget& budget) : m_budget(budget) {
+  m_whiteTexture = TextureRegistry::GetShared().GetDefaultWhite();
   m_loader       = CreateUnique<AssetLoader>();
 }
 
+AssetCache::~AssetCache() {
+  for (auto& job : m_decodeJobs) {
+    ThreadPool::GetShared().Wait(job);
+  }
+}
+
 void AssetCache::RemoveModel(const std::string& path) {
   if (m_modelCache.contains(path)) {
     m_modelCache.erase(path);
   }
 }
 
-}  // namespace photon::util
\ No newline at end of file
+}  // namespace photon::util
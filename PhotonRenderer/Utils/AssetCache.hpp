@@ -1,23 +1,117 @@
 #pragma once
+#include <deque>
+#include <future>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "AssetLoader.hpp"
 #include "Assets/Model.hpp"
 #include "Assets/Texture.hpp"
 using photon::asset::Model;
 using photon::asset::Texture2D;
+namespace photon::gl {
+class StagingBuffer;
+}
 namespace photon::util {
+
+enum class AssetState { Queued, Decoded, Resident, Failed };
+
+/**
+ * An asset streamed in the background. Get() returns a placeholder until the asset is resident:
+ * nothing for a model that is still being decoded, then its bounding-box proxy, which becomes the
+ * real model in place. Only read and updated on the GL thread.
+ */
+template <typename T>
+class AssetHandle {
+public:
+  [[nodiscard]] const Ref<T>& Get() const { return m_asset; }
+  [[nodiscard]] AssetState GetState() const { return m_state; }
+  [[nodiscard]] bool IsResident() const { return m_state == AssetState::Resident; }
+  [[nodiscard]] bool IsFailed() const { return m_state == AssetState::Failed; }
+
+private:
+  friend class AssetCache;
+  Ref<T> m_asset;
+  AssetState m_state{AssetState::Queued};
+};
+using ModelHandle   = AssetHandle<Model>;
+using TextureHandle = AssetHandle<Texture2D>;
+
+/** Upper bounds on the work ProcessUploads does in one frame. */
+struct UploadBudget {
+  uint32_t bytesPerFrame{8u << 20};
+  float millisecondsPerFrame{2.0f};
+};
+
+struct StreamingStats {
+  uint32_t pendingAssets{0};
+  // last frame's upload stage
+  uint64_t uploadedBytes{0};
+  float uploadMs{0.0f};
+  // worst upload stage since the cache was created
+  float maxUploadMs{0.0f};
+};
+
 class AssetCache {
 public:
-  AssetCache();
+  explicit AssetCache(const UploadBudget& budget = {});
+  ~AssetCache();
   Ref<Model> RequestModel(const std::string& path);
   void RemoveModel(const std::string& path);
   Ref<Texture2D> RequestTexture(const std::string& path);
 
+  /**
+   * Start decoding on the shared pool, so several loads overlap each other and the caller's own
+   * setup. The following RequestModel or RequestTexture then only waits for it and uploads.
+   */
+  void PrefetchModel(const std::string& path);
+  void PrefetchTexture(const std::string& path);
+
+  /** Decode on a worker thread, the GL objects are filled in by ProcessUploads. */
+  Ref<ModelHandle> RequestModelAsync(const std::string& path);
+  Ref<TextureHandle> RequestTextureAsync(const std::string& path);
+
+  /** Upload stage, once per frame on the GL thread: copies decoded data within the budget. */
+  void ProcessUploads();
+
+  [[nodiscard]] bool IsStreaming() const { return m_stats.pendingAssets > 0; }
+  [[nodiscard]] const StreamingStats& GetStreamingStats() const { return m_stats; }
+
 private:
+  struct PendingAsset;
+
+  /** Load from the baked .pmesh next to the source, baking it first when missing or stale. */
+  Ref<Model> LoadModel(const std::string& path);
+  /** Fill source from the baked cache or the model file, thread safe. */
+  static bool LoadModelSource(const std::string& path, ModelSource& source);
+  void Submit(const Ref<PendingAsset>& pending);
+  void BeginUpload(PendingAsset& pending);
+  /** Stage the next piece of pending within maxBytes, returns false when staging is full. */
+  bool UploadChunk(PendingAsset& pending, uint64_t maxBytes, uint64_t& uploadedBytes);
+  /** UploadChunk for a compressed texture, whole block rows of one level at a time. */
+  bool UploadCompressedChunk(PendingAsset& pending, uint64_t available, uint64_t& uploadedBytes);
+  void FinishUpload(PendingAsset& pending);
+
   std::unordered_map<std::string, Ref<Model>> m_modelCache;
   std::unordered_map<std::string, Ref<Texture2D>> m_textureCache;
+  // decoding on the shared pool, empty results mark failed loads
+  std::unordered_map<std::string, std::future<Unique<ModelSource>>> m_prefetchedModels;
+  std::unordered_map<std::string, std::future<Unique<TextureSource>>> m_prefetchedTextures;
   Ref<Texture2D> m_whiteTexture;
   Unique<AssetLoader> m_loader;
+
+  std::unordered_map<std::string, Ref<ModelHandle>> m_modelHandles;
+  std::unordered_map<std::string, Ref<TextureHandle>> m_textureHandles;
+  UploadBudget m_budget;
+  StreamingStats m_stats;
+  Ref<gl::StagingBuffer> m_staging;
+  // decoded by the workers, waiting to be picked up by the GL thread
+  std::mutex m_decodedMutex;
+  std::vector<Ref<PendingAsset>> m_decoded;
+  // being uploaded, in the order they finished decoding
+  std::deque<Ref<PendingAsset>> m_uploads;
+  // decode jobs on the shared pool, waited for before anything they touch goes away
+  std::vector<std::future<void>> m_decodeJobs;
 };
-}  // namespace photon::util
\ No newline at end of file
+}  // namespace photon::util
@@ -1,91 +1,197 @@
 #include "AssetLoader.hpp"
 #include <stb_image.h>
 #include <tiny_gltf.h>
-#include <fstream>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <numeric>
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include "Assets/Model.hpp"
 #include "Assets/Texture.hpp"
 #include "Common/Logging.hpp"
 #include "GltfUtils.hpp"
+#include "Ktx2.hpp"
+#include "MappedFile.hpp"
+#include "MeshCache.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshletBuilder.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshUtils.hpp"
+#include "ModelSource.hpp"
+#include "ObjUtils.hpp"
 #include "Renderer/AABB.hpp"
+#include "StopWatch.hpp"
+#include "TextureBaker.hpp"
+#include "TextureRegistry.hpp"
+#include "ThreadPool.hpp"
 
 namespace photon::util {
+namespace {
 
-Ref<Model> AssetLoader::LoadModelOBJ(const std::string& path) {
-  LOGI("Loading Model: {}", path);
-  std::ifstream file(path);
-  if (!file.is_open()) {
-    LOGE("Failed to open {}", path);
-    return nullptr;
+// keeps the encoded bytes while parsing, they are decoded together on the shared pool afterwards
+bool StoreEncodedImage(tinygltf::Image* image, const int, std::string*, std::string*, int, int,
+                       const unsigned char* bytes, int size, void*) {
+  image->image.assign(bytes, bytes + size);
+  image->as_is = true;
+  return true;
+}
+
+AABB ComputeBounds(const std::vector<Vertex>& vertices) {
+  glm::vec3 posMin(std::numeric_limits<float>::max());
+  glm::vec3 posMax(std::numeric_limits<float>::lowest());
+  for (const auto& vertex : vertices) {
+    posMin = glm::min(posMin, vertex.position);
+    posMax = glm::max(posMax, vertex.position);
   }
-  std::vector<unsigned int> positionIndices, uvIndices, normalIndices;
-  std::vector<glm::vec3> positions;
-  std::vector<glm::vec2> uvs;
-  std::vector<glm::vec3> normals;
-
-  std::string currLine;
-  while (std::getline(file, currLine)) {
-    std::istringstream iss(currLine);
-    std::string firstToken;
-    iss >> firstToken;
-    if (firstToken == "v") {
-      glm::vec3 position;
-      iss >> position.x >> position.y >> position.z;
-      positions.push_back(position);
-    } else if (firstToken == "vt") {
-      glm::vec2 uv;
-      iss >> uv.x >> uv.y;
-      uvs.push_back(uv);
-    } else if (firstToken == "vn") {
-      glm::vec3 normal;
-      iss >> normal.x >> normal.y >> normal.z;
-      normals.push_back(normal);
-    } else if (firstToken == "f") {
-      char slash;
-      uint32_t positionIndex, uvIndex, normalIndex;
-      while (iss >> positionIndex >> slash >> uvIndex >> slash >> normalIndex) {
-        positionIndices.push_back(positionIndex);
-        uvIndices.push_back(uvIndex);
-        normalIndices.push_back(normalIndex);
-      }
+  return vertices.empty() ? AABB{glm::vec3(0.0f), glm::vec3(0.0f)} : AABB{posMin, posMax};
+}
+
+void LogMeshOptimization(size_t numTriangles, float seconds) {
+  LOGI("Optimized {} triangles in {:.2f} ms", numTriangles, seconds * 1000.0f);
+}
+
+void LogMeshLods(const std::vector<MeshSource>& meshes, float seconds) {
+  std::array<uint64_t, MaxMeshLods> numTriangles{};
+  float maxError = 0.0f;
+  for (const auto& mesh : meshes) {
+    for (size_t i = 0; i < mesh.lods.size(); i++) {
+      numTriangles[i] += mesh.lods[i].numIndices / 3;
+      maxError = std::max(maxError, mesh.lods[i].error);
     }
   }
+  LOGI("Built LODs in {:.2f} ms: {} / {} / {} / {} triangles, largest error {:.4f}",
+       seconds * 1000.0f, numTriangles[0], numTriangles[1], numTriangles[2], numTriangles[3],
+       maxError);
+}
+
+void LogMeshlets(const std::vector<MeshSource>& meshes, float seconds) {
+  size_t numMeshlets    = 0;
+  size_t numCones       = 0;
+  uint64_t numTriangles = 0;
+  for (const auto& mesh : meshes) {
+    numMeshlets += mesh.meshlets.size();
+    for (const auto& meshlet : mesh.meshlets) {
+      numTriangles += meshlet.numIndices / 3;
+      numCones += meshlet.coneCutoff < 1.0f;
+    }
+  }
+  LOGI("Built {} meshlets in {:.2f} ms, {:.1f} triangles each, {} can be backface culled",
+       numMeshlets, seconds * 1000.0f,
+       static_cast<float>(numTriangles) / static_cast<float>(std::max<size_t>(numMeshlets, 1)),
+       numCones);
+}
+
+// one bake per use of an image, sampled as color and as data it compresses differently
+std::string GetBakedPath(const std::string& path, TextureUsage usage) {
+  switch (usage) {
+    case TextureUsage::Data:
+      return path + ".data.ktx2";
+    case TextureUsage::Normal:
+      return path + ".normal.ktx2";
+    case TextureUsage::Occlusion:
+      return path + ".occlusion.ktx2";
+    default:
+      return path + ".ktx2";
+  }
+}
+
+// percent-encoded and data URIs are not plain file names, only their pixels are kept
+bool IsImageFile(const tinygltf::Image& image) {
+  return !image.uri.empty() && !image.uri.starts_with("data:") &&
+         image.uri.find('%') == std::string::npos;
+}
+
+/**
+ * Decode the images embedded in the model. Image files are left to DecodeModelImages, which bakes
+ * them and shares them through the registry by path, so they are only dropped here.
+ */
+bool DecodeGltfImages(tinygltf::Model& model) {
+  std::vector<int> encoded;
+  for (size_t i = 0; i < model.images.size(); i++) {
+    auto& image = model.images[i];
+    if (IsImageFile(image)) {
+      image.image = {};
+      image.as_is = false;
+    } else if (image.as_is) {
+      encoded.push_back(static_cast<int>(i));
+    }
+  }
+  std::vector<std::string> errors(encoded.size());
+  ThreadPool::GetShared().ParallelFor(encoded.size(), [&](size_t i) {
+    auto& image      = model.images[encoded[i]];
+    const auto bytes = std::move(image.image);
+    image.as_is      = false;
+    std::string warning;
+    // the loader tinygltf would have run while parsing, so the pixels are the same
+    tinygltf::LoadImageData(&image, encoded[i], &errors[i], &warning, 0, 0, bytes.data(),
+                            static_cast<int>(bytes.size()), nullptr);
+  });
+  bool decoded = true;
+  for (const auto& error : errors) {
+    if (!error.empty()) {
+      LOGE("gltf loader error: {}", error);
+      decoded = false;
+    }
+  }
+  return decoded;
+}
+}  // namespace
+
+bool AssetLoader::DecodeModelOBJ(const std::string& path, ModelSource& source) {
+  LOGI("Loading Model: {}", path);
+  StopWatch stopWatch;
+  MappedFile file(path);
+  if (!file.IsOpen()) {
+    return false;
+  }
   std::vector<Vertex> vertices;
+  glm::vec3 bboxMin, bboxMax;
+  if (!ParseObjBuffer(file.GetData(), file.GetSize(), vertices, bboxMin, bboxMax)) {
+    LOGE("Failed to parse {}", path);
+    return false;
+  }
+  const auto seconds   = stopWatch.TimeStep();
+  const auto megabytes = static_cast<float>(file.GetSize()) / (1024.0f * 1024.0f);
+  LOGI("Parsed {:.2f} MB in {:.2f} ms ({:.1f} MB/s)", megabytes, seconds * 1000.0f,
+       megabytes / seconds);
+
+  const auto numCorners = vertices.size();
   std::vector<uint32_t> indices;
-  auto bboxMin = glm::vec3(std::numeric_limits<float>::max());
-  auto bboxMax = glm::vec3(std::numeric_limits<float>::lowest());
-  // For each vertex of each triangle
-  for (unsigned int i = 0; i < positionIndices.size(); i++) {
-
-    // Get the indices of its attributes
-    unsigned int vertexIndex = positionIndices[i];
-    unsigned int uvIndex     = uvIndices[i];
-    unsigned int normalIndex = normalIndices[i];
-
-    // Get the attributes thanks to the index
-    glm::vec3 position = positions[vertexIndex - 1];
-    glm::vec2 uv       = uvs[uvIndex - 1];
-    glm::vec3 normal   = normals[normalIndex - 1];
-
-    bboxMin = glm::min(bboxMin, position);
-    bboxMax = glm::max(bboxMax, position);
-    indices.emplace_back(vertices.size());
-    vertices.emplace_back(position, uv, normal);
-  }
-  auto model = CreateRef<Model>(ExtractName(path), vertices);
-  model->GetSingleMeshMaterial().textures[asset::PBRComponent::BaseColor] =
-      LoadTexture("Data/Textures/white.png");
-  model->SetAABB({bboxMin, bboxMax});
-  return model;
+  // one index per corner, plus the levels of detail appended later
+  indices.reserve(GetMeshLodIndexCapacity(numCorners));
+  WeldVertices(vertices, indices);
+  LOGI("Welded {} corners into {} vertices ({:.2f}x) in {:.2f} ms", numCorners, vertices.size(),
+       static_cast<float>(numCorners) / static_cast<float>(std::max<size_t>(vertices.size(), 1)),
+       stopWatch.TimeStep() * 1000.0f);
+  OptimizeMesh(vertices, indices);
+  LogMeshOptimization(indices.size() / 3, stopWatch.TimeStep());
+  source.name = ExtractName(path);
+  source.aabb = {bboxMin, bboxMax};
+  source.textures.push_back({.path = TextureRegistry::DefaultWhitePath});
+  source.instances.push_back({0, glm::mat4(1.0f), source.aabb});
+  auto& mesh    = source.meshes.emplace_back();
+  mesh.vertices = std::move(vertices);
+  mesh.indices  = std::move(indices);
+  BuildMeshlets(mesh.vertices, mesh.indices, mesh.indices.size(), mesh.meshlets);
+  LogMeshlets(source.meshes, stopWatch.TimeStep());
+  BuildMeshLods(mesh.vertices, mesh.indices, mesh.lods);
+  LogMeshLods(source.meshes, stopWatch.TimeStep());
+
+  mesh.textures[static_cast<int>(asset::PBRComponent::BaseColor)] = 0;
+  return true;
 }
 
-Ref<Model> AssetLoader::LoadModelGLTF(const std::string& path) {
+bool AssetLoader::DecodeModelGLTF(const std::string& path, ModelSource& source) {
   LOGI("Loading Model: {}", path);
   tinygltf::Model gltf_model;
   tinygltf::TinyGLTF loader;
   std::string error;
   std::string warning;
-  bool ret = loader.LoadASCIIFromFile(&gltf_model, &error, &warning, path.c_str());
+  StopWatch stopWatch;
+  loader.SetImageLoader(StoreEncodedImage, nullptr);
+  const bool ret = LoadGltfModel(loader, path, gltf_model, error, warning);
   if (!warning.empty()) {
     LOGW(warning);
   }
@@ -94,18 +200,37 @@ Ref<Model> AssetLoader::LoadModelGLTF(const std::string& path) {
   }
   if (!ret) {
     LOGE("Failed to parse glTF");
-    return nullptr;
+    return false;
   }
-  const auto load_textures = [&](const tinygltf::Model& model) {
+  const auto parseSeconds = stopWatch.TimeStep();
+  if (!DecodeGltfMeshopt(gltf_model)) {
+    LOGE("Failed to decode compressed glTF buffers");
+    return false;
+  }
+  const auto bufferSeconds = stopWatch.TimeStep();
+  if (!DecodeGltfImages(gltf_model)) {
+    LOGE("Failed to decode glTF images");
+    return false;
+  }
+  LOGI("Parsed glTF in {:.2f} ms, decoded buffers in {:.2f} ms and {} images in {:.2f} ms",
+       parseSeconds * 1000.0f, bufferSeconds * 1000.0f, gltf_model.images.size(),
+       stopWatch.TimeStep() * 1000.0f);
+  const auto directory     = path.substr(0, path.find_last_of('/') + 1);
+  const auto load_textures = [&](tinygltf::Model& model) {
     tinygltf::Sampler defaultSampler;
     defaultSampler.minFilter = GL_LINEAR;
     defaultSampler.magFilter = GL_LINEAR;
     defaultSampler.wrapS     = GL_REPEAT;
     defaultSampler.wrapT     = GL_REPEAT;
     defaultSampler.wrapR     = GL_REPEAT;
+    // the last texture using an image takes its pixels instead of copying them
+    std::vector<int> imageUses(model.images.size(), 0);
+    for (const auto& texture : model.textures) {
+      imageUses[texture.source]++;
+    }
     for (size_t i = 0; i < model.textures.size(); i++) {
       const auto& texture = model.textures[i];
-      const auto& image   = model.images[texture.source];
+      auto& image         = model.images[texture.source];
       const auto& sampler = texture.sampler >= 0 ? model.samplers[texture.sampler] : defaultSampler;
       asset::TextureInfo info{};
       info.minFilter = sampler.minFilter != -1 ? sampler.minFilter : GL_LINEAR;
@@ -122,7 +247,16 @@ Ref<Model> AssetLoader::LoadModelGLTF(const std::string& path) {
           sampler.minFilter == GL_LINEAR_MIPMAP_LINEAR) {
         info.generateMipmap = true;
       }
-      m_textureCache.emplace_back(asset::Texture2D::Create(info, image.image.data()));
+      TextureSource& decoded = source.textures.emplace_back();
+      decoded.info           = info;
+      if (IsImageFile(image)) {
+        // decoded later from the file, the same way a model from the mesh cache does
+        decoded.path = directory + image.uri;
+      } else if (--imageUses[texture.source] == 0) {
+        decoded.pixels = std::move(image.image);
+      } else {
+        decoded.pixels = image.image;
+      }
     }
   };
   static const std::unordered_map<std::string, int> c_AlphaModeValue = {
@@ -131,8 +265,12 @@ Ref<Model> AssetLoader::LoadModelGLTF(const std::string& path) {
       {"MASK", 2},
   };
 
-  const auto bind_material = [&](const auto materialIndex, asset::Mesh& mesh) {
-    asset::PBRMaterial mesh_material{};
+  int defaultWhite         = -1;
+  const auto bind_material = [&](const auto materialIndex, MeshSource& mesh) {
+    asset::PBRMaterial& mesh_material = mesh.material;
+    const auto set_texture            = [&](asset::PBRComponent component, int textureIndex) {
+      mesh.textures[static_cast<int>(component)] = textureIndex;
+    };
     if (materialIndex >= 0) {
       const tinygltf::Material& material = gltf_model.materials[materialIndex];
       mesh_material.name                 = material.name;
@@ -144,38 +282,23 @@ Ref<Model> AssetLoader::LoadModelGLTF(const std::string& path) {
                                             (float)pbrMetallicRoughness.baseColorFactor[2],
                                             (float)pbrMetallicRoughness.baseColorFactor[3]};
 
-      const auto baseColorTextureId = pbrMetallicRoughness.baseColorTexture.index;
-      if (baseColorTextureId >= 0) {
-        mesh_material.textures[asset::PBRComponent::BaseColor] = m_textureCache[baseColorTextureId];
-      }
-
-      const auto metallicRoughnessTextureId = pbrMetallicRoughness.metallicRoughnessTexture.index;
-      if (metallicRoughnessTextureId >= 0) {
-        mesh_material.textures[asset::PBRComponent::MetallicRoughness] =
-            m_textureCache[metallicRoughnessTextureId];
-      }
+      // glTF texture indices double as indices into source.textures
+      set_texture(asset::PBRComponent::BaseColor, pbrMetallicRoughness.baseColorTexture.index);
+      set_texture(asset::PBRComponent::MetallicRoughness,
+                  pbrMetallicRoughness.metallicRoughnessTexture.index);
       mesh_material.metallicFactor  = pbrMetallicRoughness.metallicFactor;
       mesh_material.roughnessFactor = pbrMetallicRoughness.roughnessFactor;
 
-      const auto normalTextureId = material.normalTexture.index;
-      if (normalTextureId >= 0) {
-        mesh_material.textures[asset::PBRComponent::Normal] = m_textureCache[normalTextureId];
-      }
+      set_texture(asset::PBRComponent::Normal, material.normalTexture.index);
 
-      const auto emissiveTextureId = material.emissiveTexture.index;
-      if (emissiveTextureId >= 0) {
-        mesh_material.textures[asset::PBRComponent::Emissive] = m_textureCache[emissiveTextureId];
-      }
+      set_texture(asset::PBRComponent::Emissive, material.emissiveTexture.index);
       mesh_material.emissiveFactor = {
           (float)material.emissiveFactor[0],
           (float)material.emissiveFactor[1],
           (float)material.emissiveFactor[2],
       };
 
-      const auto occlusionTextureId = material.occlusionTexture.index;
-      if (occlusionTextureId >= 0) {
-        mesh_material.textures[asset::PBRComponent::Occlusion] = m_textureCache[occlusionTextureId];
-      }
+      set_texture(asset::PBRComponent::Occlusion, material.occlusionTexture.index);
       mesh_material.occlusionStrength = material.occlusionTexture.strength;
     } else {
       // Apply default material
@@ -183,99 +306,434 @@ Ref<Model> AssetLoader::LoadModelGLTF(const std::string& path) {
       // https://github.com/KhronosGroup/glTF/blob/master/specification/2.0/README.md#reference-material
       // https://github.com/KhronosGroup/glTF/blob/master/specification/2.0/README.md#reference-pbrmetallicroughness3
       LOGI("Using default white texture");
-      mesh_material.textures[asset::PBRComponent::BaseColor] = Texture2D::CreateDefaultWhite();
+      if (defaultWhite < 0) {
+        defaultWhite = static_cast<int>(source.textures.size());
+        source.textures.push_back({.path = TextureRegistry::DefaultWhitePath});
+      }
+      set_texture(asset::PBRComponent::BaseColor, defaultWhite);
     }
-    mesh.material = std::move(mesh_material);
   };
   load_textures(gltf_model);
-  std::unordered_map<int, glm::mat4> mesh_matrices;
-  const std::function<void(int, const glm::mat4&)> extract_node_matrices =
-      [&](int node_idx, const glm::mat4& parent_matrix) {
-        const auto& node = gltf_model.nodes[node_idx];
-        // get world matrix
-        const glm::mat4 model_matrix = util::GetLocalToWorldMatrix(node, parent_matrix);
-        if (node.mesh >= 0) {
-          mesh_matrices[node.mesh] = model_matrix;
-        }
-        for (const auto child : node.children) {
-          extract_node_matrices(child, model_matrix);
-        }
-      };
-  if (gltf_model.defaultScene >= 0) {
-    for (const auto node_idx : gltf_model.scenes[gltf_model.defaultScene].nodes) {
-      extract_node_matrices(node_idx, glm::mat4(1.0f));
+  StopWatch sceneWatch;
+  std::vector<GltfNodeInstance> nodeInstances;
+  FlattenGltfScene(gltf_model, nodeInstances);
+  if (gltf_model.scenes.empty()) {
+    // without a scene every mesh stands where its vertices are
+    for (int i = 0; i < static_cast<int>(gltf_model.meshes.size()); i++) {
+      nodeInstances.push_back({i, glm::mat4(1.0f)});
     }
   }
-  const auto name = ExtractName(path);
-  auto model      = asset::Model::Create(name);
+  // the matrices of the nodes placing each mesh, in compressed rows
+  std::vector<uint32_t> nodeOffsets(gltf_model.meshes.size() + 1, 0);
+  for (const auto& instance : nodeInstances) {
+    nodeOffsets[instance.mesh + 1]++;
+  }
+  std::partial_sum(nodeOffsets.begin(), nodeOffsets.end(), nodeOffsets.begin());
+  std::vector<glm::mat4> nodeMatrices(nodeInstances.size());
+  std::vector<uint32_t> cursor(nodeOffsets.begin(), nodeOffsets.end() - 1);
+  for (const auto& instance : nodeInstances) {
+    nodeMatrices[cursor[instance.mesh]++] = instance.worldMatrix;
+  }
+  const auto sceneSeconds = sceneWatch.TimeStep();
+  source.name              = ExtractName(path);
+  float extractSeconds     = 0.0f;
+  float weldSeconds        = 0.0f;
+  float optimizeSeconds    = 0.0f;
+  float meshletSeconds     = 0.0f;
+  float lodSeconds         = 0.0f;
+  size_t numSourceVertices = 0, numWeldedVertices = 0;
+  // of the first level of detail, the others are appended after optimization
+  size_t numTriangles  = 0;
+  size_t numPrimitives = 0, numInstances = 0;
+  for (size_t i = 0; i < gltf_model.meshes.size(); i++) {
+    const auto count = gltf_model.meshes[i].primitives.size();
+    numPrimitives += nodeOffsets[i + 1] > nodeOffsets[i] ? count : 0;
+    numInstances += count * (nodeOffsets[i + 1] - nodeOffsets[i]);
+  }
+  source.meshes.reserve(numPrimitives);
+  source.instances.reserve(numInstances);
   for (auto mesh_idx = 0; mesh_idx < gltf_model.meshes.size(); mesh_idx++) {
+    // meshes no node places are never drawn, so they are not decoded either
+    const auto firstNode = nodeOffsets[mesh_idx];
+    const auto lastNode  = nodeOffsets[mesh_idx + 1];
+    if (firstNode == lastNode) {
+      continue;
+    }
     auto& gl_mesh = gltf_model.meshes[mesh_idx];
-    std::vector<Vertex> vertices;
-    std::vector<uint32_t> indices;
     for (auto primitive_index = 0; primitive_index < gl_mesh.primitives.size(); primitive_index++) {
-      vertices.clear();
-      indices.clear();
       auto& primitive = gl_mesh.primitives[primitive_index];
-      util::ExtractGltfVertices(primitive, gltf_model, vertices);
-      util::ExtractGltfIndices(primitive, gltf_model, indices);
-      asset::Mesh mesh{vertices, indices};
-      if (mesh_matrices.find(mesh_idx) != mesh_matrices.end()) {
-        mesh.modelMatrix = mesh_matrices[mesh_idx];
+      auto& mesh      = source.meshes.emplace_back();
+      StopWatch stepWatch;
+      // room for the levels of detail appended later, so the list is allocated once
+      mesh.indices.reserve(GetMeshLodIndexCapacity(GetGltfIndexCount(primitive, gltf_model)));
+      if (!util::ExtractGltfVertices(primitive, gltf_model, mesh.vertices) ||
+          !util::ExtractGltfIndices(primitive, gltf_model, mesh.indices)) {
+        LOGW("Skipping primitive {} of mesh {}, its geometry cannot be read", primitive_index,
+             mesh_idx);
+        source.meshes.pop_back();
+        continue;
+      }
+      // welding and everything after it index the vertices unchecked
+      const auto numVertices = mesh.vertices.size();
+      if (std::any_of(mesh.indices.begin(), mesh.indices.end(),
+                      [numVertices](uint32_t index) { return index >= numVertices; })) {
+        LOGW("Skipping primitive {} of mesh {}, an index is past its {} vertices", primitive_index,
+             mesh_idx, numVertices);
+        source.meshes.pop_back();
+        continue;
       }
+      numSourceVertices += numVertices;
+      extractSeconds += stepWatch.TimeStep();
+      WeldVertices(mesh.vertices, mesh.indices);
+      weldSeconds += stepWatch.TimeStep();
+      numWeldedVertices += mesh.vertices.size();
+      OptimizeMesh(mesh.vertices, mesh.indices);
+      numTriangles += mesh.indices.size() / 3;
+      optimizeSeconds += stepWatch.TimeStep();
+      BuildMeshlets(mesh.vertices, mesh.indices, mesh.indices.size(), mesh.meshlets);
+      meshletSeconds += stepWatch.TimeStep();
+      BuildMeshLods(mesh.vertices, mesh.indices, mesh.lods);
+      lodSeconds += stepWatch.TimeStep();
       bind_material(primitive.material, mesh);
-      model->AttachMesh(mesh);
+      const auto bounds = ComputeBounds(mesh.vertices);
+      for (auto node = firstNode; node < lastNode; node++) {
+        auto& instance       = source.instances.emplace_back();
+        instance.mesh        = static_cast<uint32_t>(source.meshes.size() - 1);
+        instance.modelMatrix = nodeMatrices[node];
+        instance.aabb        = bounds.Transform(instance.modelMatrix);
+      }
     }
   }
+  LOGI("Extracted {} vertices in {:.2f} ms", numSourceVertices, extractSeconds * 1000.0f);
+  LOGI("Welded {} vertices into {} ({:.2f}x) in {:.2f} ms", numSourceVertices, numWeldedVertices,
+       static_cast<float>(numSourceVertices) /
+           static_cast<float>(std::max<size_t>(numWeldedVertices, 1)),
+       weldSeconds * 1000.0f);
+  LogMeshOptimization(numTriangles, optimizeSeconds);
+  LogMeshlets(source.meshes, meshletSeconds);
+  LogMeshLods(source.meshes, lodSeconds);
 
-  glm::vec3 bbox_min, bbox_max;
-  // compute boundary
-  util::ComputeSceneBounds(gltf_model, bbox_min, bbox_max);
-  AABB aabb{bbox_min, bbox_max};
-  model->SetAABB(aabb);
+  // bounds of the instance bounds, so no vertex is transformed
+  glm::vec3 bboxMin(std::numeric_limits<float>::max());
+  glm::vec3 bboxMax(std::numeric_limits<float>::lowest());
+  for (const auto& instance : source.instances) {
+    bboxMin = glm::min(bboxMin, instance.aabb.posMin);
+    bboxMax = glm::max(bboxMax, instance.aabb.posMax);
+  }
+  source.aabb = source.instances.empty() ? AABB{glm::vec3(0.0f), glm::vec3(0.0f)}
+                                         : AABB{bboxMin, bboxMax};
 
-  model->Translate(glm::vec3{0.0f, 0.0f, 0.0f});
-  m_textureCache.clear();
-  return model;
+  // center the model on the origin
+  const auto translation = glm::translate(glm::mat4(1.0f), -source.aabb.GetCenter());
+  for (auto& instance : source.instances) {
+    instance.modelMatrix = translation * instance.modelMatrix;
+    instance.aabb        = instance.aabb.Transform(translation);
+  }
+  source.aabb.Translate(glm::vec3{0.0f, 0.0f, 0.0f});
+  LOGI("Flattened {} nodes into {} instances of {} meshes in {:.2f} ms", gltf_model.nodes.size(),
+       source.instances.size(), source.meshes.size(), sceneSeconds * 1000.0f);
+  return true;
 }
 
-Ref<Texture2D> AssetLoader::LoadTexture(const std::string& path) {
-  bool isHDR = ExtractExtension(path) == "hdr";
+TextureSource AssetLoader::DescribeTexture(const std::string& path) {
+  TextureSource texture;
+  texture.path = path;
+  if (stbi_is_hdr(path.c_str())) {
+    texture.info.wrapS = GL_CLAMP_TO_EDGE;
+    texture.info.wrapT = GL_CLAMP_TO_EDGE;
+  }
+  return texture;
+}
+
+bool AssetLoader::DecodeTexture(const std::string& path, TextureSource& texture) {
+  texture.path  = path;
+  texture.info  = {};
+  texture.usage = TextureUsage::Color;
+  if (!stbi_is_hdr(path.c_str())) {
+    // 8 bits per channel are all the file holds, as floats they would take 4x the memory
+    if (!DecodeImage(texture)) {
+      return false;
+    }
+    texture.info.internalFormat = GetUncompressedFormat(TextureUsage::Color);
+    return true;
+  }
   int width, height, channels;
-  stbi_set_flip_vertically_on_load(true);
   LOGT("Loading texture at path {}", path);
-  auto* data = stbi_loadf(path.c_str(), &width, &height, &channels, 0);
-  stbi_set_flip_vertically_on_load(false);
-
+  auto* data = stbi_loadf(path.c_str(), &width, &height, &channels, 3);
   if (!data) {
     LOGE("Failed to load texture {}", path);
-    return nullptr;
+    return false;
   }
-  asset::TextureInfo info{};
-  info.width  = width;
-  info.height = height;
-  if (isHDR) {
-    info.dataFormat     = GL_RGB;
-    info.internalFormat = GL_RGB16F;
-    info.dataType       = GL_FLOAT;
-    info.wrapS          = GL_CLAMP_TO_EDGE;
-    info.wrapT          = GL_CLAMP_TO_EDGE;
-    info.minFilter      = GL_LINEAR;
-    info.magFilter      = GL_LINEAR;
+  auto& info          = texture.info;
+  info.width          = width;
+  info.height         = height;
+  info.internalFormat = GL_RGB9_E5;
+  info.dataFormat     = GL_RGB;
+  info.dataType       = GL_UNSIGNED_INT_5_9_9_9_REV;
+  info.wrapS          = GL_CLAMP_TO_EDGE;
+  info.wrapT          = GL_CLAMP_TO_EDGE;
+  info.minFilter      = GL_LINEAR;
+  info.magFilter      = GL_LINEAR;
+  // packed a row at a time and flipped by hand, stbi_set_flip_vertically_on_load is global state
+  // shared by all threads
+  const size_t rowSize = static_cast<size_t>(width) * sizeof(uint32_t);
+  texture.pixels.resize(rowSize * height);
+  for (int y = 0; y < height; y++) {
+    PackRGB9E5(data + static_cast<size_t>(height - 1 - y) * width * 3, width,
+               reinterpret_cast<uint32_t*>(texture.pixels.data() + rowSize * y));
   }
+  stbi_image_free(data);
+  return true;
+}
 
-  return Texture2D::Create(info, data);
+bool AssetLoader::DecodeImage(TextureSource& texture, int channels) {
+  if (ExtractExtension(texture.path) == "ktx2") {
+    if (!ReadKtx2(texture.path, 0, texture)) {
+      LOGE("Failed to load texture {}", texture.path);
+      return false;
+    }
+    return true;
+  }
+  int width, height, fileChannels;
+  LOGT("Loading texture at path {}", texture.path);
+  auto* data = stbi_load(texture.path.c_str(), &width, &height, &fileChannels, channels);
+  if (!data) {
+    LOGE("Failed to load texture {}", texture.path);
+    return false;
+  }
+  if (channels == 0) {
+    channels = fileChannels;
+  }
+  texture.info.width    = width;
+  texture.info.height   = height;
+  texture.info.dataType = GL_UNSIGNED_BYTE;
+  switch (channels) {
+    case 1:
+      texture.info.internalFormat = GL_R8;
+      texture.info.dataFormat     = GL_RED;
+      break;
+    case 2:
+      texture.info.internalFormat = GL_RG8;
+      texture.info.dataFormat     = GL_RG;
+      break;
+    case 3:
+      texture.info.internalFormat = GL_RGB8;
+      texture.info.dataFormat     = GL_RGB;
+      break;
+    default:
+      texture.info.internalFormat = GL_RGBA8;
+      texture.info.dataFormat     = GL_RGBA;
+      break;
+  }
+  texture.pixels.assign(data, data + static_cast<size_t>(width) * height * channels);
+  stbi_image_free(data);
+  return true;
 }
 
-Ref<Model> AssetLoader::LoadModel(const std::string& path) {
+bool AssetLoader::DecodeBakedImage(TextureSource& texture, TextureUsage usage) {
+  texture.usage = usage;
+  if (ExtractExtension(texture.path) == "ktx2") {
+    return DecodeImage(texture);
+  }
+  uint64_t sourceHash = 0;
+  const auto bakedPath = GetBakedPath(texture.path, usage);
+  if (HashFile(texture.path, sourceHash) && ReadKtx2(bakedPath, sourceHash, texture)) {
+    return true;
+  }
+  TextureSource image{.path = texture.path, .info = texture.info};
+  if (!DecodeImage(image)) {
+    return false;
+  }
+  StopWatch stopWatch;
+  if (!BakeTexture(image, usage, texture)) {
+    // not something the baker understands, upload it as it is
+    texture                     = std::move(image);
+    texture.usage               = usage;
+    texture.info.internalFormat = GetUncompressedFormat(usage);
+    return true;
+  }
+  const auto bakeSeconds = stopWatch.TimeStep();
+  if (sourceHash != 0 && WriteKtx2(bakedPath, sourceHash, texture)) {
+    LOGI("Baked {} into {} levels in {:.2f} ms, {:.2f} MB to {:.2f} MB", bakedPath,
+         texture.levels.size(), bakeSeconds * 1000.0f,
+         static_cast<float>(image.pixels.size()) / (1024.0f * 1024.0f),
+         static_cast<float>(texture.pixels.size()) / (1024.0f * 1024.0f));
+  }
+  return true;
+}
+
+bool AssetLoader::DecodeModelImages(ModelSource& source) {
+  // what each texture is sampled as, one shared by different kinds of maps keeps every channel
+  std::vector<int> usages(source.textures.size(), -1);
+  const auto use_as = [&](int32_t index, TextureUsage usage) {
+    if (index < 0 || index >= static_cast<int32_t>(usages.size())) {
+      return;
+    }
+    const auto value = static_cast<int>(usage);
+    usages[index]    = usages[index] < 0 || usages[index] == value
+                           ? value
+                           : static_cast<int>(TextureUsage::Data);
+  };
+  for (const auto& mesh : source.meshes) {
+    const auto texture_of = [&](asset::PBRComponent component) {
+      return mesh.textures[static_cast<int>(component)];
+    };
+    use_as(texture_of(asset::PBRComponent::BaseColor), TextureUsage::Color);
+    use_as(texture_of(asset::PBRComponent::Emissive), TextureUsage::Color);
+    use_as(texture_of(asset::PBRComponent::MetallicRoughness), TextureUsage::Data);
+    use_as(texture_of(asset::PBRComponent::Occlusion), TextureUsage::Occlusion);
+    use_as(texture_of(asset::PBRComponent::Normal), TextureUsage::Normal);
+  }
+  // files some other model already uploaded for the same use are not decoded again, CreateModel
+  // shares them
+  auto& registry = TextureRegistry::GetShared();
+  std::vector<char> missing(source.textures.size(), 0);
+  for (size_t i = 0; i < source.textures.size(); i++) {
+    auto& texture     = source.textures[i];
+    texture.usage     = usages[i] < 0 ? TextureUsage::Color : static_cast<TextureUsage>(usages[i]);
+    const bool isFile = texture.GetPixels().empty() && !texture.path.empty();
+    missing[i]        = isFile && registry.Find(texture) == nullptr;
+  }
+  std::vector<char> decoded(source.textures.size(), 1);
+  ThreadPool::GetShared().ParallelFor(source.textures.size(), [&](size_t i) {
+    auto& texture = source.textures[i];
+    if (missing[i]) {
+      decoded[i] = DecodeBakedImage(texture, texture.usage);
+    } else if (texture.levels.empty() && !texture.GetPixels().empty()) {
+      // embedded images are decoded as 8-bit RGBA along with the model
+      texture.info.internalFormat = GetUncompressedFormat(texture.usage);
+    }
+    // identical images under different files, or embedded twice, are uploaded once
+    texture.contentHash = TextureRegistry::ComputeContentHash(texture);
+  });
+  return std::find(decoded.begin(), decoded.end(), 0) == decoded.end();
+}
+
+bool AssetLoader::RedecodeImage(TextureSource& texture) {
+  if (texture.path.empty()) {
+    return false;
+  }
+  if (!texture.levels.empty() && ExtractExtension(texture.path) != "ktx2") {
+    // baked on the first load, whatever the file holds now
+    return ReadKtx2(GetBakedPath(texture.path, texture.usage), 0, texture);
+  }
+  if (texture.info.dataType != GL_UNSIGNED_BYTE) {
+    return DecodeTexture(texture.path, texture);
+  }
+  // the channels say how it was decoded, the internal format what it was used as
+  const auto internalFormat = texture.info.internalFormat;
+  int channels              = 4;
+  switch (texture.info.dataFormat) {
+    case GL_RED:
+      channels = 1;
+      break;
+    case GL_RG:
+      channels = 2;
+      break;
+    case GL_RGB:
+      channels = 3;
+      break;
+    default:
+      break;
+  }
+  if (!DecodeImage(texture, channels)) {
+    return false;
+  }
+  texture.info.internalFormat = internalFormat;
+  return true;
+}
+
+Ref<Texture2D> AssetLoader::CreateTexture(const TextureSource& texture) {
+  const auto pixels = texture.GetPixels();
+  if (pixels.empty()) {
+    return nullptr;
+  }
+  return texture.levels.empty() ? Texture2D::Create(texture.info, pixels.data())
+                                : Texture2D::Create(texture.info, texture.levels, pixels.data());
+}
+
+Ref<Texture2D> AssetLoader::LoadTexture(const std::string& path) {
+  auto& registry = TextureRegistry::GetShared();
+  auto texture   = DescribeTexture(path);
+  if (auto shared = registry.Acquire(texture)) {
+    return shared;
+  }
+  if (!DecodeTexture(path, texture)) {
+    return nullptr;
+  }
+  return registry.Acquire(texture);
+}
+
+bool AssetLoader::DecodeModel(const std::string& path, ModelSource& source) {
   auto modelFormat = ExtractExtension(path);
+  bool decoded     = false;
   if (modelFormat == "obj") {
-    return LoadModelOBJ(path);
-  } else if (modelFormat == "gltf") {
-    return LoadModelGLTF(path);
+    decoded = DecodeModelOBJ(path, source);
+  } else if (modelFormat == "gltf" || modelFormat == "glb") {
+    decoded = DecodeModelGLTF(path, source);
   } else {
     LOGE("Model format {} not supported, sorry about that", modelFormat);
+    return false;
+  }
+  if (!decoded) {
+    return false;
+  }
+  // packed once here, so mesh caches hold and uploads read the 16-byte form
+  for (auto& mesh : source.meshes) {
+    mesh.quantization = PackVertices(mesh.vertices, mesh.packedVertices);
+    mesh.vertices     = {};
+  }
+  return true;
+}
+
+Ref<Model> AssetLoader::CreateModel(ModelSource&& source) {
+  StopWatch stopWatch;
+  auto& registry    = TextureRegistry::GetShared();
+  const auto before = registry.GetStats();
+  std::vector<Ref<Texture2D>> textures;
+  textures.reserve(source.textures.size());
+  for (const auto& texture : source.textures) {
+    auto& created = textures.emplace_back(registry.Acquire(texture));
+    // without pixels the file was either shared when decoded and may have gone since, or could
+    // not be read
+    if (created == nullptr && texture.GetPixels().empty() && !texture.path.empty()) {
+      TextureSource reloaded{.path = texture.path, .info = texture.info};
+      if (DecodeBakedImage(reloaded, texture.usage)) {
+        created = registry.Acquire(reloaded);
+      }
+    }
+  }
+  const auto after = registry.GetStats();
+  LOGI("Uploaded {} of {} textures of {} in {:.2f} ms, {:.2f} MB of video memory, {:.2f} MB shared",
+       after.uploads - before.uploads, textures.size(), source.name,
+       stopWatch.TimeStep() * 1000.0f,
+       static_cast<float>(after.uploadedBytes - before.uploadedBytes) / (1024.0f * 1024.0f),
+       static_cast<float>(after.sharedBytes - before.sharedBytes) / (1024.0f * 1024.0f));
+  auto model = Model::Create(source.name);
+  std::vector<asset::Mesh> meshes;
+  meshes.reserve(source.meshes.size());
+  for (auto& meshSource : source.meshes) {
+    const auto vertices = meshSource.GetVertices();
+    const auto indices  = meshSource.GetIndices();
+
+    auto& mesh    = meshes.emplace_back(vertices, meshSource.quantization, indices);
+    mesh.material = std::move(meshSource.material);
+    mesh.lods     = std::move(meshSource.lods);
+    mesh.meshlets = std::move(meshSource.meshlets);
+    meshSource.BindTextures(textures, mesh.material);
+  }
+  model->SetMeshes(std::move(meshes), std::move(source.instances));
+  model->SetAABB(source.aabb);
+  return model;
+}
+
+Ref<Model> AssetLoader::LoadModel(const std::string& path) {
+  ModelSource source;
+  if (!DecodeModel(path, source)) {
     return nullptr;
   }
+  DecodeModelImages(source);
+  return CreateModel(std::move(source));
 }
 
 std::string AssetLoader::ExtractName(const std::string& path) {
@@ -5,10 +5,14 @@
 namespace photon::asset {
 class Model;
 class Texture2D;
+struct TextureInfo;
 }  // namespace photon::asset
 using photon::asset::Model;
 using photon::asset::Texture2D;
 namespace photon::util {
+struct ModelSource;
+struct TextureSource;
+enum class TextureUsage;
 
 class AssetLoader {
 public:
@@ -16,9 +20,43 @@ public:
   Ref<Model> LoadModel(const std::string& path);
   Ref<Texture2D> LoadTexture(const std::string& path);
 
+  /** Parse a model into its CPU-side description. Touches no GL state, safe on any thread. */
+  static bool DecodeModel(const std::string& path, ModelSource& source);
+  /**
+   * Decode texture.path as 8-bit pixels into texture.pixels, keeping its sampler state. With 0
+   * channels the ones stored in the file are kept, the way Texture2D(path) loads an image.
+   */
+  static bool DecodeImage(TextureSource& texture, int channels = 4);
+  /**
+   * Load texture.path as a compressed mip chain from the .ktx2 baked next to it for usage, baking
+   * it first when missing or stale. Files that already are .ktx2 are read as they are.
+   */
+  static bool DecodeBakedImage(TextureSource& texture, TextureUsage usage);
+  /** Bake and load the textures of source that have a file but no pixels, on the shared pool. */
+  static bool DecodeModelImages(ModelSource& source);
+  /**
+   * Decode texture.path again into the form it was first loaded in, told apart by its levels and
+   * format. Used to refill evicted textures, images without a file of their own cannot be.
+   */
+  static bool RedecodeImage(TextureSource& texture);
+  /** Upload decoded pixels or a compressed mip chain. */
+  static Ref<Texture2D> CreateTexture(const TextureSource& texture);
+  /**
+   * Decode a standalone texture the way LoadTexture(path) uploads it, safe on any thread. Images
+   * are 8-bit sRGB color, HDR images are flipped and packed into GL_RGB9_E5.
+   */
+  static bool DecodeTexture(const std::string& path, TextureSource& texture);
+  /** The path, usage and sampler state DecodeTexture gives an image, to look it up undecoded. */
+  static TextureSource DescribeTexture(const std::string& path);
+  /**
+   * Create the GL objects of a decoded model, textures without pixels are read from disk. The
+   * materials, levels and meshlets are moved out of source, which is left for destruction.
+   */
+  Ref<Model> CreateModel(ModelSource&& source);
+
 private:
-  Ref<Model> LoadModelOBJ(const std::string& path);
-  Ref<Model> LoadModelGLTF(const std::string& path);
+  static bool DecodeModelOBJ(const std::string& path, ModelSource& source);
+  static bool DecodeModelGLTF(const std::string& path, ModelSource& source);
   static std::string ExtractName(const std::string& path);
   static std::string ExtractExtension(const std::string& path);
   inline std::string FirstToken(const std::string& in) {
@@ -33,7 +71,6 @@ private:
     }
     return "";
   }
-  std::vector<Ref<Texture2D>> m_textureCache;
 };
 
-}  // namespace photon::util
\ No newline at end of file
+}  // namespace photon::util
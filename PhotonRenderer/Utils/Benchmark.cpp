@@ -0,0 +1,774 @@
+#include "Benchmark.hpp"
+#include <stb_image.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AllocationCounter.hpp"
+#include "AssetLoader.hpp"
+#include "Common/Logging.hpp"
+#include "Engine/AABBTree.hpp"
+#include "GltfUtils.hpp"
+#include "MappedFile.hpp"
+#include "MeshCache.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshUtils.hpp"
+#include "Graphics/Shader.hpp"
+#include "ModelSource.hpp"
+#include "ObjUtils.hpp"
+#include "Renderer/DrawList.hpp"
+#include "Renderer/FrustumCulling.hpp"
+#include "Renderer/RenderQueue.hpp"
+#include "StopWatch.hpp"
+#include "TextureBaker.hpp"
+
+namespace photon::util {
+namespace {
+// the fastest of a few runs, the first one also pays for reading the file from disk
+constexpr int NumRuns = 5;
+
+template <typename Function>
+float MeasureMilliseconds(Function&& function) {
+  float best = 0.0f;
+  for (int run = 0; run < NumRuns; run++) {
+    StopWatch stopWatch;
+    function();
+    const float milliseconds = stopWatch.TimeStep() * 1000.0f;
+    best                     = run == 0 ? milliseconds : std::min(best, milliseconds);
+  }
+  return best;
+}
+
+void ReportDecode(const char* format, float milliseconds, size_t bytes, size_t numTexels) {
+  LOGI("  {:<24} {:>8.2f} ms {:>8.2f} MB {:>5.1f} B/texel", format, milliseconds,
+       static_cast<float>(bytes) / (1024.0f * 1024.0f),
+       static_cast<float>(bytes) / static_cast<float>(std::max<size_t>(numTexels, 1)));
+}
+
+// mean relative error of the texels bright enough for it to mean something
+template <typename Unpack>
+float MeasurePackingError(const std::vector<float>& rgb, const std::vector<uint32_t>& packed,
+                          Unpack&& unpack) {
+  double error     = 0.0;
+  size_t numValues = 0;
+  for (size_t i = 0; i < packed.size(); i++) {
+    const auto value = unpack(packed[i]);
+    for (int c = 0; c < 3; c++) {
+      const float expected = rgb[i * 3 + c];
+      if (expected > 1e-3f) {
+        error += std::abs(value[c] - expected) / expected;
+        numValues++;
+      }
+    }
+  }
+  return numValues > 0 ? static_cast<float>(error / static_cast<double>(numValues)) : 0.0f;
+}
+
+void BenchmarkTextureDecode() {
+  // one of each kind of file the engine loads
+  const std::array<std::string, 4> paths = {
+      "Data/Textures/ground1.jpg",
+      "Data/Textures/grass.png",
+      "Data/Models/ufo/textures/material_normal.png",
+      "Data/Textures/sky.hdr",
+  };
+  LOGI("Texture decode, best of {} runs", NumRuns);
+  for (const auto& path : paths) {
+    if (!std::filesystem::exists(path)) {
+      LOGW("Skipping {}, the file is missing", path);
+      continue;
+    }
+    int width = 0, height = 0, channels = 0;
+    if (stbi_info(path.c_str(), &width, &height, &channels) == 0) {
+      LOGW("Skipping {}, stb_image cannot read it", path);
+      continue;
+    }
+    const auto numTexels = static_cast<size_t>(width) * height;
+    LOGI("{} ({}x{}, {} channels)", path, width, height, channels);
+
+    // what every standalone texture went through before, whatever the file held
+    const float floatMs = MeasureMilliseconds([&] {
+      int w, h, c;
+      stbi_image_free(stbi_loadf(path.c_str(), &w, &h, &c, 0));
+    });
+    ReportDecode("32-bit float", floatMs, numTexels * channels * sizeof(float), numTexels);
+
+    TextureSource texture;
+    const float decodeMs = MeasureMilliseconds([&] { AssetLoader::DecodeTexture(path, texture); });
+    if (!stbi_is_hdr(path.c_str())) {
+      ReportDecode("8-bit RGBA", decodeMs, texture.pixels.size(), numTexels);
+      continue;
+    }
+    ReportDecode("RGB9E5 (decode and pack)", decodeMs, texture.pixels.size(), numTexels);
+
+    int w, h, c;
+    auto* data = stbi_loadf(path.c_str(), &w, &h, &c, 3);
+    if (data == nullptr) {
+      continue;
+    }
+    const std::vector<float> rgb(data, data + numTexels * 3);
+    stbi_image_free(data);
+    std::vector<uint32_t> packed(numTexels);
+    const float rgb9e5Ms =
+        MeasureMilliseconds([&] { PackRGB9E5(rgb.data(), numTexels, packed.data()); });
+    const float rgb9e5Error = MeasurePackingError(rgb, packed, glm::unpackF3x9_E1x5);
+    const float r11g11b10Ms =
+        MeasureMilliseconds([&] { PackR11G11B10F(rgb.data(), numTexels, packed.data()); });
+    const float r11g11b10Error = MeasurePackingError(rgb, packed, glm::unpackF2x11_1x10);
+    LOGI("  {:<24} {:>8.2f} ms, {:.4f}% mean relative error", "RGB9E5 pack", rgb9e5Ms,
+         rgb9e5Error * 100.0f);
+    LOGI("  {:<24} {:>8.2f} ms, {:.4f}% mean relative error", "R11G11B10F pack", r11g11b10Ms,
+         r11g11b10Error * 100.0f);
+  }
+}
+// a grid of GridSide x GridSide vertices, about a million, the size of a detailed scanned asset
+constexpr int GridSide = 1024;
+
+int AddBufferView(tinygltf::Model& model, const std::vector<uint8_t>& bytes, size_t stride) {
+  if (model.buffers.empty()) {
+    model.buffers.emplace_back();
+  }
+  auto& buffer = model.buffers[0].data;
+  auto& view   = model.bufferViews.emplace_back();
+  view.buffer     = 0;
+  view.byteOffset = buffer.size();
+  view.byteLength = bytes.size();
+  view.byteStride = stride;
+  buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+  return static_cast<int>(model.bufferViews.size() - 1);
+}
+
+int AddAccessor(tinygltf::Model& model, int bufferView, size_t byteOffset, size_t count,
+                int componentType, int type, bool normalized = false) {
+  auto& accessor         = model.accessors.emplace_back();
+  accessor.bufferView    = bufferView;
+  accessor.byteOffset    = byteOffset;
+  accessor.count         = count;
+  accessor.componentType = componentType;
+  accessor.type          = type;
+  accessor.normalized    = normalized;
+  return static_cast<int>(model.accessors.size() - 1);
+}
+
+template <typename T>
+std::vector<uint8_t> ToBytes(const std::vector<T>& values) {
+  std::vector<uint8_t> bytes(values.size() * sizeof(T));
+  std::memcpy(bytes.data(), values.data(), bytes.size());
+  return bytes;
+}
+
+/**
+ * The grid as one primitive of interleaved attributes, either floats as exporters write them or
+ * quantized as KHR_mesh_quantization allows: unsigned short positions, normalized byte normals and
+ * normalized unsigned short uvs, with 16 bit indices that wrap.
+ */
+tinygltf::Model CreateGridModel(bool quantized) {
+  tinygltf::Model model;
+  const size_t numVertices = static_cast<size_t>(GridSide) * GridSide;
+  std::vector<uint32_t> indices;
+  indices.reserve(static_cast<size_t>(GridSide - 1) * (GridSide - 1) * 6);
+  for (uint32_t y = 0; y + 1 < GridSide; y++) {
+    for (uint32_t x = 0; x + 1 < GridSide; x++) {
+      const auto corner = y * GridSide + x;
+      for (const auto index : {corner, corner + GridSide, corner + 1, corner + 1, corner + GridSide,
+                               corner + GridSide + 1}) {
+        indices.push_back(index);
+      }
+    }
+  }
+  tinygltf::Primitive primitive;
+  if (quantized) {
+    struct QuantizedVertex {
+      uint16_t position[4];
+      int8_t normal[4];
+      uint16_t uv[2];
+    };
+    std::vector<QuantizedVertex> vertices(numVertices);
+    for (size_t i = 0; i < numVertices; i++) {
+      const auto x = static_cast<uint16_t>(i % GridSide);
+      const auto y = static_cast<uint16_t>(i / GridSide);
+      vertices[i]  = {{x, 0, y, 0},
+                      {0, 127, 0, 0},
+                      {static_cast<uint16_t>(x * 64), static_cast<uint16_t>(y * 64)}};
+    }
+    const int view = AddBufferView(model, ToBytes(vertices), sizeof(QuantizedVertex));
+    primitive.attributes["POSITION"] = AddAccessor(
+        model, view, 0, numVertices, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, TINYGLTF_TYPE_VEC3);
+    primitive.attributes["NORMAL"] =
+        AddAccessor(model, view, offsetof(QuantizedVertex, normal), numVertices,
+                    TINYGLTF_COMPONENT_TYPE_BYTE, TINYGLTF_TYPE_VEC3, true);
+    primitive.attributes["TEXCOORD_0"] =
+        AddAccessor(model, view, offsetof(QuantizedVertex, uv), numVertices,
+                    TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, TINYGLTF_TYPE_VEC2, true);
+    std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+    primitive.indices =
+        AddAccessor(model, AddBufferView(model, ToBytes(shortIndices), 0), 0, shortIndices.size(),
+                    TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, TINYGLTF_TYPE_SCALAR);
+  } else {
+    std::vector<Vertex> vertices(numVertices);
+    for (size_t i = 0; i < numVertices; i++) {
+      const auto x = static_cast<float>(i % GridSide), y = static_cast<float>(i / GridSide);
+      vertices[i]  = Vertex({x, 0.0f, y}, {x / GridSide, y / GridSide}, {0.0f, 1.0f, 0.0f});
+    }
+    const int view = AddBufferView(model, ToBytes(vertices), sizeof(Vertex));
+    primitive.attributes["POSITION"] =
+        AddAccessor(model, view, offsetof(Vertex, position), numVertices,
+                    TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3);
+    primitive.attributes["NORMAL"] = AddAccessor(model, view, offsetof(Vertex, normal), numVertices,
+                                                 TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3);
+    primitive.attributes["TEXCOORD_0"] = AddAccessor(
+        model, view, offsetof(Vertex, uv), numVertices, TINYGLTF_COMPONENT_TYPE_FLOAT,
+        TINYGLTF_TYPE_VEC2);
+    primitive.indices =
+        AddAccessor(model, AddBufferView(model, ToBytes(indices), 0), 0, indices.size(),
+                    TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, TINYGLTF_TYPE_SCALAR);
+  }
+  model.meshes.emplace_back().primitives.push_back(primitive);
+  return model;
+}
+
+// what extraction did before: every accessor copied out element by element, then read with a
+// type check per vertex, indices appended one at a time and flipped in a second pass
+bool ExtractLegacy(const tinygltf::Model& model, const tinygltf::Primitive& primitive,
+                   std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+  const auto unpack = [&](const tinygltf::Accessor& accessor, std::vector<uint8_t>& out) {
+    const auto& view = model.bufferViews[accessor.bufferView];
+    const uint8_t* data =
+        model.buffers[view.buffer].data.data() + accessor.byteOffset + view.byteOffset;
+    const size_t elementSize = tinygltf::GetComponentSizeInBytes(accessor.componentType) *
+                               tinygltf::GetNumComponentsInType(accessor.type);
+    const size_t stride = view.byteStride != 0 ? view.byteStride : elementSize;
+    out.resize(accessor.count * elementSize);
+    for (size_t i = 0; i < accessor.count; i++) {
+      std::memcpy(out.data() + elementSize * i, data + stride * i, elementSize);
+    }
+  };
+  const auto read = [&](const char* name, int numComponents, auto&& store) {
+    const auto& accessor = model.accessors[primitive.attributes.at(name)];
+    std::vector<uint8_t> data;
+    unpack(accessor, data);
+    for (size_t i = 0; i < vertices.size(); i++) {
+      if (tinygltf::GetNumComponentsInType(accessor.type) != numComponents ||
+          accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT) {
+        return false;
+      }
+      store(i, reinterpret_cast<const float*>(data.data()) + i * numComponents);
+    }
+    return true;
+  };
+  vertices.resize(model.accessors[primitive.attributes.at("POSITION")].count);
+  if (!read("POSITION", 3, [&](size_t i, const float* v) {
+        vertices[i].position = {v[0], v[1], v[2]};
+      }) ||
+      !read("TEXCOORD_0", 2, [&](size_t i, const float* v) { vertices[i].uv = {v[0], v[1]}; }) ||
+      !read("NORMAL", 3, [&](size_t i, const float* v) {
+        vertices[i].normal = {v[0], v[1], v[2]};
+      })) {
+    return false;
+  }
+  const auto& accessor = model.accessors[primitive.indices];
+  std::vector<uint8_t> data;
+  unpack(accessor, data);
+  for (size_t i = 0; i < accessor.count; i++) {
+    switch (accessor.componentType) {
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+        indices.push_back(reinterpret_cast<const uint16_t*>(data.data())[i]);
+        break;
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+        indices.push_back(reinterpret_cast<const uint32_t*>(data.data())[i]);
+        break;
+      default:
+        return false;
+    }
+  }
+  for (size_t i = 0; i < indices.size() / 3; i++) {
+    std::swap(indices[i * 3 + 1], indices[i * 3 + 2]);
+  }
+  return true;
+}
+
+void BenchmarkGltfExtraction() {
+  LOGI("glTF geometry extraction, {}x{} vertex grid, best of {} runs", GridSide, GridSide,
+       NumRuns);
+  for (const bool quantized : {false, true}) {
+    const auto model      = CreateGridModel(quantized);
+    const auto& primitive = model.meshes[0].primitives[0];
+    const auto numIndices = model.accessors[primitive.indices].count;
+    LOGI("{} ({} vertices, {} indices)",
+         quantized ? "Quantized, 16 bit indices" : "Float, 32 bit indices",
+         model.accessors[primitive.attributes.at("POSITION")].count, numIndices);
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    const float bulkMs = MeasureMilliseconds([&] {
+      std::vector<Vertex> runVertices;
+      std::vector<uint32_t> runIndices;
+      ExtractGltfVertices(primitive, model, runVertices);
+      ExtractGltfIndices(primitive, model, runIndices);
+      vertices = std::move(runVertices);
+      indices  = std::move(runIndices);
+    });
+    const float bulkIndexMs = MeasureMilliseconds([&] {
+      std::vector<uint32_t> runIndices;
+      ExtractGltfIndices(primitive, model, runIndices);
+    });
+    LOGI("  {:<24} {:>8.2f} ms, indices alone {:.2f} ms", "bulk", bulkMs, bulkIndexMs);
+    if (quantized) {
+      // the copy and branch path asserted on anything but float attributes
+      continue;
+    }
+    std::vector<Vertex> legacyVertices;
+    std::vector<uint32_t> legacyIndices;
+    const float legacyMs = MeasureMilliseconds([&] {
+      std::vector<Vertex> runVertices;
+      std::vector<uint32_t> runIndices;
+      ExtractLegacy(model, primitive, runVertices, runIndices);
+      legacyVertices = std::move(runVertices);
+      legacyIndices  = std::move(runIndices);
+    });
+    const bool same = legacyIndices == indices && legacyVertices.size() == vertices.size() &&
+                      std::memcmp(legacyVertices.data(), vertices.data(),
+                                  vertices.size() * sizeof(Vertex)) == 0;
+    LOGI("  {:<24} {:>8.2f} ms, {:.2f}x slower, output {}", "copy and branch", legacyMs,
+         legacyMs / std::max(bulkMs, 1e-3f), same ? "identical" : "DIFFERS");
+  }
+}
+
+void ReportAllocations(const char* run, float milliseconds, const AllocationStats& stats) {
+  LOGI("  {:<24} {:>8.2f} ms {:>8} allocations {:>8.2f} MB", run, milliseconds, stats.allocations,
+       static_cast<float>(stats.bytes) / (1024.0f * 1024.0f));
+}
+
+// the getline and istringstream loop ParseObjBuffer replaced, kept as the reference to beat
+void ParseObjStream(const std::string& text, std::vector<Vertex>& vertices) {
+  std::istringstream file(text);
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec2> uvs;
+  std::vector<glm::vec3> normals;
+  vertices.clear();
+  std::string currLine;
+  while (std::getline(file, currLine)) {
+    std::istringstream iss(currLine);
+    std::string firstToken;
+    iss >> firstToken;
+    if (firstToken == "v") {
+      glm::vec3 position;
+      iss >> position.x >> position.y >> position.z;
+      positions.push_back(position);
+    } else if (firstToken == "vt") {
+      glm::vec2 uv;
+      iss >> uv.x >> uv.y;
+      uvs.push_back(uv);
+    } else if (firstToken == "vn") {
+      glm::vec3 normal;
+      iss >> normal.x >> normal.y >> normal.z;
+      normals.push_back(normal);
+    } else if (firstToken == "f") {
+      char slash;
+      uint32_t position, uv, normal;
+      while (iss >> position >> slash >> uv >> slash >> normal) {
+        vertices.emplace_back(positions[position - 1], uvs[uv - 1], normals[normal - 1]);
+      }
+    }
+  }
+}
+
+void BenchmarkObjParsing() {
+  // a grid of quads split into triangles, in the v/vt/vn layout both parsers read
+  constexpr int Size = 256;
+  std::ostringstream obj;
+  for (int y = 0; y <= Size; y++) {
+    for (int x = 0; x <= Size; x++) {
+      const float u = static_cast<float>(x) / Size;
+      const float v = static_cast<float>(y) / Size;
+      obj << "v " << u * 100.0f << ' ' << std::sin(u * 20.0f) * std::cos(v * 20.0f) << ' '
+          << v * 100.0f << "\nvt " << u << ' ' << v << "\nvn 0 1 0\n";
+    }
+  }
+  for (int y = 0; y < Size; y++) {
+    for (int x = 0; x < Size; x++) {
+      const int a = y * (Size + 1) + x + 1;
+      const int b = a + Size + 1;
+      for (const auto& [i, j, k] : {std::array{a, b, a + 1}, std::array{a + 1, b, b + 1}}) {
+        obj << "f " << i << '/' << i << '/' << i << ' ' << j << '/' << j << '/' << j << ' ' << k
+            << '/' << k << '/' << k << '\n';
+      }
+    }
+  }
+  const auto text      = obj.str();
+  const auto megabytes = static_cast<float>(text.size()) / (1024.0f * 1024.0f);
+
+  std::vector<Vertex> streamed;
+  std::vector<Vertex> chunked;
+  glm::vec3 bboxMin, bboxMax;
+  const float streamMs = MeasureMilliseconds([&] { ParseObjStream(text, streamed); });
+  const float chunkMs  = MeasureMilliseconds(
+      [&] { ParseObjBuffer(text.data(), text.size(), chunked, bboxMin, bboxMax); });
+  const bool identical = streamed.size() == chunked.size() &&
+                         std::memcmp(streamed.data(), chunked.data(),
+                                     streamed.size() * sizeof(Vertex)) == 0;
+  LOGI("OBJ parsing of {:.2f} MB, best of {} runs", megabytes, NumRuns);
+  LOGI("  {:<24} {:>8.2f} ms {:>8.1f} MB/s", "getline", streamMs, megabytes * 1000.0f / streamMs);
+  LOGI("  {:<24} {:>8.2f} ms {:>8.1f} MB/s {}", "chunked", chunkMs, megabytes * 1000.0f / chunkMs,
+       identical ? "same vertices" : "DIFFERENT VERTICES");
+}
+
+void BenchmarkMeshOptimization() {
+  // what the import passes gain, the analyses are too slow to run on every load
+  const std::array<std::string, 2> paths = {
+      "Data/Models/robot.obj",
+      "Data/Models/Starship/Starship.obj",
+  };
+  LOGI("Mesh optimization, best of {} runs", NumRuns);
+  for (const auto& path : paths) {
+    MappedFile file(path);
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    glm::vec3 bboxMin, bboxMax;
+    if (!file.IsOpen() ||
+        !ParseObjBuffer(file.GetData(), file.GetSize(), vertices, bboxMin, bboxMax)) {
+      LOGW("Skipping {}, it cannot be parsed", path);
+      continue;
+    }
+    WeldVertices(vertices, indices);
+    const auto cacheBefore    = AnalyzeVertexCache(indices, vertices.size());
+    const auto overdrawBefore = AnalyzeOverdraw(vertices, indices);
+    auto optimizedVertices    = vertices;
+    auto optimizedIndices     = indices;
+    const float milliseconds  = MeasureMilliseconds([&] {
+      optimizedVertices = vertices;
+      optimizedIndices  = indices;
+      OptimizeMesh(optimizedVertices, optimizedIndices);
+    });
+    const auto cacheAfter    = AnalyzeVertexCache(optimizedIndices, optimizedVertices.size());
+    const auto overdrawAfter = AnalyzeOverdraw(optimizedVertices, optimizedIndices);
+    LOGI("  {:<36} {:>8} triangles {:>8.2f} ms", path, cacheAfter.numTriangles, milliseconds);
+    LOGI("    ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, overdraw {:.3f} -> {:.3f}",
+         cacheBefore.GetACMR(), cacheAfter.GetACMR(), cacheBefore.GetATVR(), cacheAfter.GetATVR(),
+         overdrawBefore.GetOverdraw(), overdrawAfter.GetOverdraw());
+  }
+}
+
+void BenchmarkModelDecode() {
+  // the first decode also fills the scratch arenas of this thread, later ones reuse them
+  const std::array<std::string, 4> paths = {
+      "Data/Models/robot.obj",
+      "Data/Models/Starship/Starship.obj",
+      "Data/Models/sun/scene.gltf",
+      "Data/Models/ufo/scene.gltf",
+  };
+  LOGI("Model decode heap allocations, first run and best of {} more", NumRuns);
+  for (const auto& path : paths) {
+    if (!std::filesystem::exists(path)) {
+      LOGW("Skipping {}, the file is missing", path);
+      continue;
+    }
+    const auto decode = [&](AllocationStats& stats) {
+      const auto before = GetAllocationStats();
+      ModelSource source;
+      if (!AssetLoader::DecodeModel(path, source)) {
+        return false;
+      }
+      // destroying the source frees memory but allocates nothing
+      stats = GetAllocationStats() - before;
+      return true;
+    };
+    AllocationStats first;
+    StopWatch stopWatch;
+    if (!decode(first)) {
+      LOGW("Skipping {}, it cannot be decoded", path);
+      continue;
+    }
+    const float firstMs = stopWatch.TimeStep() * 1000.0f;
+    AllocationStats again;
+    const float againMs = MeasureMilliseconds([&] { decode(again); });
+    LOGI("{}", path);
+    ReportAllocations("first", firstMs, first);
+    ReportAllocations("again", againMs, again);
+  }
+}
+
+void CheckMeshCacheDependencies() {
+  // a model and the files it references in a scratch directory, each edited in turn
+  const auto directory = std::filesystem::temp_directory_path() / "photon_mesh_cache_check";
+  std::filesystem::create_directories(directory);
+  const auto write = [&](const char* name, const std::string& contents) {
+    std::ofstream(directory / name, std::ios::binary) << contents;
+  };
+  write("model.gltf", R"({"asset": {"version": "2.0"},
+      "buffers": [{"uri": "model%20data.bin", "byteLength": 4}],
+      "images": [{"uri": "color.png"}, {"uri": "data:image/png;base64,AA=="}]})");
+  write("model.obj", "mtllib model.mtl\nv 0 0 0\n");
+  write("model data.bin", "abcd");
+  write("color.png", "png");
+  write("model.mtl", "newmtl a\n");
+  LOGI("Mesh cache invalidation");
+  for (const auto& [model, dependency] : {std::pair{"model.gltf", "model data.bin"},
+                                          std::pair{"model.gltf", "color.png"},
+                                          std::pair{"model.obj", "model.mtl"}}) {
+    const auto path = (directory / model).string();
+    uint64_t before = 0;
+    uint64_t after  = 0;
+    HashModelFiles(path, before);
+    write(dependency, "edited");
+    HashModelFiles(path, after);
+    LOGI("  editing {:<16} makes the cache of {} {}", dependency, model,
+         before != after ? "stale" : "STILL VALID");
+  }
+  std::error_code ec;
+  std::filesystem::remove_all(directory, ec);
+}
+
+void BenchmarkDrawRecording() {
+  // the CPU side of the indirect path, which grows with the draws while its GL calls do not; the
+  // call per draw of the direct path needs a context and is compared in the app with Indirect Draws
+  LOGI("Draw list recording, best of {} runs", NumRuns);
+  DrawList list;
+  for (const uint32_t numDraws : {1000u, 10000u, 100000u}) {
+    const float milliseconds = MeasureMilliseconds([&] {
+      list.Clear();
+      for (uint32_t i = 0; i < numDraws; i++) {
+        const auto position = glm::vec3(i % 100, i / 100 % 100, i / 10000);
+        const auto model    = glm::rotate(glm::translate(glm::mat4(1.0f), position),
+                                          static_cast<float>(i), glm::vec3(0.0f, 1.0f, 0.0f));
+        DrawData draw{};
+        draw.modelMatrix   = model;
+        draw.normalMatrix  = glm::mat3x4(glm::inverseTranspose(glm::mat3(model)));
+        draw.materialIndex = i % 64;
+        list.AddElements(list.AddDraw(draw), 3 * 1024, i % 64 * 3 * 1024, 0);
+      }
+    });
+    LOGI("  {:>8} draws {:>8.2f} ms {:>8.1f} ns per draw", numDraws, milliseconds,
+         milliseconds * 1e6f / static_cast<float>(numDraws));
+  }
+}
+
+void BenchmarkUniformUpdates() {
+  // what a uniform update costs in front of its glProgramUniform call, which needs a context and
+  // is the same on every path: a string keyed map as uniforms were once found, the hashed ids of
+  // ShaderProgram::SetUniform by name, and the handles the per frame paths resolve once
+  constexpr std::array<const char*, 10> Names = {
+      "uLightIntensity", "uLightPos", "uLightDir",  "uLightType",        "uCameraPos",
+      "uLightSpaceMat",  "gVP",       "gMinHeight", "gReversedLightDir", "gMaxHeight",
+  };
+  constexpr std::array<gl::UniformId, 10> Ids = {
+      "uLightIntensity", "uLightPos", "uLightDir",  "uLightType",        "uCameraPos",
+      "uLightSpaceMat",  "gVP",       "gMinHeight", "gReversedLightDir", "gMaxHeight",
+  };
+  std::unordered_map<std::string, int> byName;
+  gl::InterfaceTable<gl::UniformInfo> byId;
+  std::array<gl::Uniform<float>, Names.size()> handles;
+  for (int i = 0; i < static_cast<int>(Names.size()); i++) {
+    byName.try_emplace(Names[i], i);
+    gl::UniformInfo info;
+    info.name     = Names[i];
+    info.location = i;
+    byId.Add(info);
+    handles[i] = gl::Uniform<float>(byId.Find(Ids[i])->location);
+  }
+  constexpr int NumFrames  = 100000;
+  constexpr int NumUpdates = NumFrames * static_cast<int>(Names.size());
+  // locations go here so the lookups are not optimized away
+  volatile int sink = 0;
+  const auto report = [&](const char* run, const auto& update) {
+    const auto before        = GetAllocationStats();
+    const float milliseconds = MeasureMilliseconds([&] {
+      int sum = 0;
+      for (int frame = 0; frame < NumFrames; frame++) {
+        for (size_t i = 0; i < Names.size(); i++) {
+          sum += update(i);
+        }
+      }
+      sink = sum;
+    });
+    const auto stats = GetAllocationStats() - before;
+    LOGI("  {:<12} {:>8.2f} ns per update {:>6.2f} allocations per update", run,
+         milliseconds * 1e6f / static_cast<float>(NumUpdates),
+         static_cast<float>(stats.allocations) / static_cast<float>(NumRuns * NumUpdates));
+  };
+  LOGI("Uniform lookup of {} updates, best of {} runs", NumUpdates, NumRuns);
+  report("string map", [&](size_t i) {
+    const std::string name = Names[i];
+    return byName.contains(name) ? byName.at(name) : -1;
+  });
+  report("hashed id", [&](size_t i) {
+    const auto* info = byId.Find(Ids[i]);
+    return info != nullptr ? info->location : -1;
+  });
+  report("handle", [&](size_t i) { return handles[i].IsValid() ? handles[i].GetLocation() : -1; });
+}
+
+void BenchmarkRenderQueueSort() {
+  // keys of a scene with a few programs, many materials and one blended draw in eight, sorted by
+  // the radix sort of the render queue and by the comparison sort it replaces
+  LOGI("Render queue sort, best of {} runs", NumRuns);
+  std::mt19937 random(1);
+  std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+  std::vector<RenderPacket> packets;
+  std::vector<RenderPacket> sorted;
+  std::vector<RenderPacket> scratch;
+  for (const uint32_t numPackets : {1000u, 10000u, 100000u}) {
+    packets.clear();
+    for (uint32_t i = 0; i < numPackets; i++) {
+      const auto pass = i % 8 == 0 ? RenderPass::Transparent : RenderPass::Opaque;
+      packets.push_back(
+          {RenderQueue::MakeKey(pass, random() % 4, random() % 256, random() % 16, depth(random)),
+           i});
+    }
+    const float radix = MeasureMilliseconds([&] {
+      sorted = packets;
+      RadixSort(sorted, scratch);
+    });
+    const float comparison = MeasureMilliseconds([&] {
+      sorted = packets;
+      std::stable_sort(sorted.begin(), sorted.end(),
+                       [](const auto& a, const auto& b) { return a.key < b.key; });
+    });
+    LOGI("  {:>8} packets radix {:>7.3f} ms std::stable_sort {:>7.3f} ms", numPackets, radix,
+         comparison);
+  }
+}
+
+void BenchmarkFrustumCulling() {
+  // boxes scattered around a camera looking down -z, about a tenth of them in its frustum
+  LOGI("Frustum culling, best of {} runs", NumRuns);
+  const auto planes = ExtractFrustumPlanes(
+      glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f) *
+      glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+  std::mt19937 random(1);
+  std::uniform_real_distribution<float> position(-250.0f, 250.0f);
+  std::uniform_real_distribution<float> size(0.5f, 4.0f);
+  AABBArray boxes;
+  std::vector<uint8_t> visible;
+  for (const uint32_t numBoxes : {1000u, 10000u, 100000u}) {
+    boxes.Clear();
+    for (uint32_t i = 0; i < numBoxes; i++) {
+      const auto min = glm::vec3(position(random), position(random), position(random));
+      boxes.Add({min, min + glm::vec3(size(random), size(random), size(random))});
+    }
+    uint32_t numVisible      = 0;
+    const float scalar       = MeasureMilliseconds([&] {
+      numVisible = CullAABBsScalar(boxes, planes, visible);
+    });
+    const float milliseconds = MeasureMilliseconds([&] {
+      numVisible = CullAABBs(boxes, planes, visible);
+    });
+    LOGI("  {:>8} boxes {:>7} visible scalar {:>7.3f} ms simd {:>7.3f} ms {:>6.2f} ns per box",
+         numBoxes, numVisible, scalar, milliseconds,
+         milliseconds * 1e6f / static_cast<float>(numBoxes));
+  }
+}
+
+void BenchmarkAABBTree() {
+  // boxes scattered over a fixed world, the frustum sees a small part of it, as in a large scene
+  LOGI("Bounding volume tree, best of {} runs", NumRuns);
+  const auto planes = ExtractFrustumPlanes(
+      glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f) *
+      glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+  std::mt19937 random(1);
+  std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+  std::uniform_real_distribution<float> size(0.5f, 4.0f);
+  std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+  std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+  AABBArray boxes;
+  std::vector<uint8_t> visible;
+  std::vector<uint32_t> found;
+  for (const uint32_t numBoxes : {10000u, 100000u, 1000000u}) {
+    boxes.Clear();
+    for (uint32_t i = 0; i < numBoxes; i++) {
+      const auto min = glm::vec3(position(random), position(random), position(random));
+      boxes.Add({min, min + glm::vec3(size(random), size(random), size(random))});
+    }
+    AABBTree tree;
+    std::vector<uint32_t> proxies(numBoxes);
+    const float build = MeasureMilliseconds([&] {
+      tree.Clear();
+      for (uint32_t i = 0; i < numBoxes; i++) {
+        proxies[i] = tree.Insert(boxes.Get(i), i);
+      }
+    });
+    uint32_t numVisible = 0;
+    const float linear  = MeasureMilliseconds([&] {
+      numVisible = CullAABBs(boxes, planes, visible);
+    });
+    const float frustum = MeasureMilliseconds([&] {
+      found.clear();
+      tree.QueryFrustum(planes, [&](uint32_t index) { found.push_back(index); });
+    });
+    if (found.size() != numVisible) {
+      LOGE("  tree found {} boxes, the linear cull {}", found.size(), numVisible);
+    }
+    // a tenth of the boxes take a small step, most stay within their parent's box
+    const uint32_t numMoved = numBoxes / 10;
+    const float update      = MeasureMilliseconds([&] {
+      for (uint32_t i = 0; i < numMoved; i++) {
+        const auto index = i * 10;
+        auto box         = boxes.Get(index);
+        const auto delta = glm::vec3(step(random), step(random), step(random)) * 0.1f;
+        box.posMin += delta;
+        box.posMax += delta;
+        boxes.Set(index, box);
+        tree.Update(proxies[index], box);
+      }
+    });
+    // rays from the centre in random directions, and boxes the size of a room
+    constexpr uint32_t NumQueries = 1000;
+    uint32_t numHits              = 0;
+    const float ray               = MeasureMilliseconds([&] {
+      numHits = 0;
+      for (uint32_t i = 0; i < NumQueries; i++) {
+        const float yaw       = angle(random);
+        const auto direction  = glm::vec3(std::cos(yaw), step(random), std::sin(yaw));
+        bool hit              = false;
+        tree.RayCast(glm::vec3(0.0f), direction, 1000.0f, [&](uint32_t, float distance) {
+          hit = true;
+          return distance;
+        });
+        numHits += hit ? 1 : 0;
+      }
+    });
+    uint32_t numOverlaps = 0;
+    const float overlap  = MeasureMilliseconds([&] {
+      numOverlaps = 0;
+      for (uint32_t i = 0; i < NumQueries; i++) {
+        const auto min = glm::vec3(position(random), position(random), position(random));
+        tree.QueryAABB({min, min + glm::vec3(10.0f)}, [&](uint32_t) { numOverlaps++; });
+      }
+    });
+    LOGI("  {:>8} boxes height {:>2} build {:>8.2f} ms move {:>6} {:>7.3f} ms", numBoxes,
+         tree.GetHeight(), build, numMoved, update);
+    LOGI("    frustum {:>6} visible tree {:>7.3f} ms linear simd {:>7.3f} ms", numVisible, frustum,
+         linear);
+    LOGI("    ray {:>6.2f} us {:>4} of {} hit, box {:>6.2f} us {:>6} overlaps",
+         ray * 1e3f / NumQueries, numHits, NumQueries, overlap * 1e3f / NumQueries, numOverlaps);
+  }
+}
+}  // namespace
+
+void RunBenchmarks() {
+  if (!CountsAllocations) {
+    LOGW("Allocations are not counted, build with PHOTON_COUNT_ALLOCATIONS to count them");
+  }
+  BenchmarkTextureDecode();
+  BenchmarkGltfExtraction();
+  BenchmarkObjParsing();
+  BenchmarkMeshOptimization();
+  BenchmarkModelDecode();
+  CheckMeshCacheDependencies();
+  BenchmarkDrawRecording();
+  BenchmarkUniformUpdates();
+  BenchmarkRenderQueueSort();
+  BenchmarkFrustumCulling();
+  BenchmarkAABBTree();
+}
+}  // namespace photon::util
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace photon::util {
+/**
+ * Microbenchmarks of the asset pipeline, draw recording, uniform lookup, draw sorting, frustum
+ * culling and the scene's bounding volume tree, run with `PhotonRenderer --benchmark` and
+ * reported to the log, along with a check that mesh caches go stale when the files a model
+ * references change. They need no window or GL context, files missing from Data are skipped.
+ */
+void RunBenchmarks();
+}  // namespace photon::util
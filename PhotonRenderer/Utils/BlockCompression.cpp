@@ -0,0 +1,421 @@
+#include "BlockCompression.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace photon::util {
+namespace {
+constexpr int BlockTexels = 16;
+// BC7 weights of the 4-bit indices, out of 64
+constexpr int Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+struct Texels {
+  float values[BlockTexels][4];
+};
+
+Texels ToFloat(const uint8_t* texels) {
+  Texels result{};
+  for (int i = 0; i < BlockTexels; i++) {
+    for (int c = 0; c < 4; c++) {
+      result.values[i][c] = texels[i * 4 + c];
+    }
+  }
+  return result;
+}
+
+// mean of the first numChannels channels and the direction they vary most along
+void FitLine(const Texels& texels, int numChannels, float mean[4], float axis[4]) {
+  for (int c = 0; c < 4; c++) {
+    mean[c] = 0.0f;
+    axis[c] = 0.0f;
+  }
+  for (const auto& texel : texels.values) {
+    for (int c = 0; c < numChannels; c++) {
+      mean[c] += texel[c] / BlockTexels;
+    }
+  }
+  float covariance[4][4]{};
+  for (const auto& texel : texels.values) {
+    for (int i = 0; i < numChannels; i++) {
+      for (int j = 0; j < numChannels; j++) {
+        covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+      }
+    }
+  }
+  // power iteration, a handful of steps is plenty for a 4x4 block
+  float direction[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+  for (int iteration = 0; iteration < 8; iteration++) {
+    float next[4]{};
+    float largest = 0.0f;
+    for (int i = 0; i < numChannels; i++) {
+      for (int j = 0; j < numChannels; j++) {
+        next[i] += covariance[i][j] * direction[j];
+      }
+      largest = std::max(largest, std::abs(next[i]));
+    }
+    if (largest == 0.0f) {
+      return;
+    }
+    for (int i = 0; i < numChannels; i++) {
+      direction[i] = next[i] / largest;
+    }
+  }
+  for (int c = 0; c < numChannels; c++) {
+    axis[c] = direction[c];
+  }
+}
+
+// ends of the line through the texels, inset so that the extremes fall between palette entries
+void FindEndpoints(const Texels& texels, int numChannels, float inset, float low[4],
+                   float high[4]) {
+  float mean[4], axis[4];
+  FitLine(texels, numChannels, mean, axis);
+  float minT = 0.0f, maxT = 0.0f;
+  for (const auto& texel : texels.values) {
+    float t = 0.0f;
+    for (int c = 0; c < numChannels; c++) {
+      t += (texel[c] - mean[c]) * axis[c];
+    }
+    minT = std::min(minT, t);
+    maxT = std::max(maxT, t);
+  }
+  const float margin = (maxT - minT) * inset;
+  for (int c = 0; c < 4; c++) {
+    low[c]  = std::clamp(mean[c] + axis[c] * (minT + margin), 0.0f, 255.0f);
+    high[c] = std::clamp(mean[c] + axis[c] * (maxT - margin), 0.0f, 255.0f);
+  }
+}
+
+// least squares endpoints for the given interpolation weights, false when they are degenerate
+bool SolveEndpoints(const Texels& texels, int numChannels, const float weights[BlockTexels],
+                    float low[4], float high[4]) {
+  float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+  float ax[4]{}, bx[4]{};
+  for (int i = 0; i < BlockTexels; i++) {
+    const float b = weights[i];
+    const float a = 1.0f - b;
+    aa += a * a;
+    ab += a * b;
+    bb += b * b;
+    for (int c = 0; c < numChannels; c++) {
+      ax[c] += a * texels.values[i][c];
+      bx[c] += b * texels.values[i][c];
+    }
+  }
+  const float determinant = aa * bb - ab * ab;
+  if (std::abs(determinant) < 1e-6f) {
+    return false;
+  }
+  for (int c = 0; c < numChannels; c++) {
+    low[c]  = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+    high[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+  }
+  return true;
+}
+
+uint16_t PackColor565(const float color[4]) {
+  const auto quantize = [](float value, int maxValue) {
+    return static_cast<uint16_t>(std::clamp(
+        static_cast<int>(std::lround(value * maxValue / 255.0f)), 0, maxValue));
+  };
+  return static_cast<uint16_t>(quantize(color[0], 31) << 11 | quantize(color[1], 63) << 5 |
+                               quantize(color[2], 31));
+}
+
+void UnpackColor565(uint16_t packed, float color[3]) {
+  const int r = packed >> 11;
+  const int g = (packed >> 5) & 63;
+  const int b = packed & 31;
+  color[0]    = static_cast<float>(r << 3 | r >> 2);
+  color[1]    = static_cast<float>(g << 2 | g >> 4);
+  color[2]    = static_cast<float>(b << 3 | b >> 2);
+}
+
+// 2-bit indices of the four color palette between color0 and color1, returns the squared error
+float FitColorIndices(const Texels& texels, uint16_t color0, uint16_t color1,
+                      uint8_t indices[BlockTexels]) {
+  float palette[4][3];
+  UnpackColor565(color0, palette[0]);
+  UnpackColor565(color1, palette[1]);
+  for (int c = 0; c < 3; c++) {
+    palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+    palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+  }
+  float error = 0.0f;
+  for (int i = 0; i < BlockTexels; i++) {
+    float best = INFINITY;
+    for (int p = 0; p < 4; p++) {
+      float distance = 0.0f;
+      for (int c = 0; c < 3; c++) {
+        const float d = texels.values[i][c] - palette[p][c];
+        distance += d * d;
+      }
+      if (distance < best) {
+        best       = distance;
+        indices[i] = static_cast<uint8_t>(p);
+      }
+    }
+    error += best;
+  }
+  return error;
+}
+
+void EncodeColorBlock(const Texels& texels, uint8_t* block) {
+  float low[4], high[4];
+  FindEndpoints(texels, 3, 1.0f / 16.0f, low, high);
+  uint16_t color0 = PackColor565(high);
+  uint16_t color1 = PackColor565(low);
+  uint8_t indices[BlockTexels];
+  float error = FitColorIndices(texels, color0, color1, indices);
+
+  // refit the endpoints to the chosen indices once
+  constexpr float IndexWeights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+  float weights[BlockTexels];
+  for (int i = 0; i < BlockTexels; i++) {
+    weights[i] = IndexWeights[indices[i]];
+  }
+  if (SolveEndpoints(texels, 3, weights, high, low)) {
+    const uint16_t refined0 = PackColor565(high);
+    const uint16_t refined1 = PackColor565(low);
+    uint8_t refinedIndices[BlockTexels];
+    if (FitColorIndices(texels, refined0, refined1, refinedIndices) < error) {
+      color0 = refined0;
+      color1 = refined1;
+      std::memcpy(indices, refinedIndices, sizeof(indices));
+    }
+  }
+
+  // color0 > color1 selects the four color mode, equal endpoints only need index 0
+  if (color0 < color1) {
+    std::swap(color0, color1);
+    for (auto& index : indices) {
+      index ^= 1;
+    }
+  }
+  uint32_t packed = 0;
+  if (color0 != color1) {
+    for (int i = 0; i < BlockTexels; i++) {
+      packed |= static_cast<uint32_t>(indices[i]) << (i * 2);
+    }
+  }
+  block[0] = static_cast<uint8_t>(color0);
+  block[1] = static_cast<uint8_t>(color0 >> 8);
+  block[2] = static_cast<uint8_t>(color1);
+  block[3] = static_cast<uint8_t>(color1 >> 8);
+  std::memcpy(block + 4, &packed, sizeof(packed));
+}
+
+void EncodeChannelBlock(const Texels& texels, int channel, uint8_t* block) {
+  float low = 255.0f, high = 0.0f;
+  for (const auto& texel : texels.values) {
+    low  = std::min(low, texel[channel]);
+    high = std::max(high, texel[channel]);
+  }
+  // value0 > value1 selects the eight value mode, equal ends leave every index at 0
+  const auto value0 = static_cast<int>(std::lround(high));
+  const auto value1 = static_cast<int>(std::lround(low));
+  block[0]          = static_cast<uint8_t>(value0);
+  block[1]          = static_cast<uint8_t>(value1);
+  uint64_t packed   = 0;
+  if (value0 > value1) {
+    float palette[8];
+    palette[0] = static_cast<float>(value0);
+    palette[1] = static_cast<float>(value1);
+    for (int p = 2; p < 8; p++) {
+      palette[p] = static_cast<float>((8 - p) * value0 + (p - 1) * value1) / 7.0f;
+    }
+    for (int i = 0; i < BlockTexels; i++) {
+      uint64_t index = 0;
+      float best     = INFINITY;
+      for (int p = 0; p < 8; p++) {
+        const float distance = std::abs(texels.values[i][channel] - palette[p]);
+        if (distance < best) {
+          best  = distance;
+          index = p;
+        }
+      }
+      packed |= index << (i * 3);
+    }
+  }
+  for (int b = 0; b < 6; b++) {
+    block[2 + b] = static_cast<uint8_t>(packed >> (b * 8));
+  }
+}
+
+class BitWriter {
+public:
+  explicit BitWriter(uint8_t* data) : m_data(data) { std::memset(m_data, 0, 16); }
+
+  void Write(uint32_t value, int numBits) {
+    for (int b = 0; b < numBits; b++, m_position++) {
+      if ((value >> b) & 1) {
+        m_data[m_position >> 3] |= static_cast<uint8_t>(1 << (m_position & 7));
+      }
+    }
+  }
+
+private:
+  uint8_t* m_data;
+  int m_position{0};
+};
+
+struct Mode6Block {
+  int endpoints[2][4];
+  int pbits[2];
+  uint8_t indices[BlockTexels];
+  float error{INFINITY};
+};
+
+// quantize low/high to 7 bits plus the given p-bits and pick the index of every texel
+void FitMode6(const Texels& texels, const float low[4], const float high[4], int pbit0, int pbit1,
+              Mode6Block& result) {
+  Mode6Block candidate;
+  candidate.pbits[0] = pbit0;
+  candidate.pbits[1] = pbit1;
+  int expanded[2][4];
+  for (int c = 0; c < 4; c++) {
+    candidate.endpoints[0][c] =
+        std::clamp(static_cast<int>(std::lround((low[c] - pbit0) / 2.0f)), 0, 127);
+    candidate.endpoints[1][c] =
+        std::clamp(static_cast<int>(std::lround((high[c] - pbit1) / 2.0f)), 0, 127);
+    expanded[0][c] = candidate.endpoints[0][c] << 1 | pbit0;
+    expanded[1][c] = candidate.endpoints[1][c] << 1 | pbit1;
+  }
+  float palette[16][4];
+  for (int p = 0; p < 16; p++) {
+    for (int c = 0; c < 4; c++) {
+      palette[p][c] = static_cast<float>(
+          ((64 - Weights4[p]) * expanded[0][c] + Weights4[p] * expanded[1][c] + 32) >> 6);
+    }
+  }
+  candidate.error = 0.0f;
+  for (int i = 0; i < BlockTexels; i++) {
+    float best = INFINITY;
+    for (int p = 0; p < 16; p++) {
+      float distance = 0.0f;
+      for (int c = 0; c < 4; c++) {
+        const float d = texels.values[i][c] - palette[p][c];
+        distance += d * d;
+      }
+      if (distance < best) {
+        best                 = distance;
+        candidate.indices[i] = static_cast<uint8_t>(p);
+      }
+    }
+    candidate.error += best;
+  }
+  if (candidate.error < result.error) {
+    result = candidate;
+  }
+}
+
+void FitMode6AllPBits(const Texels& texels, const float low[4], const float high[4],
+                      Mode6Block& result) {
+  for (int pbits = 0; pbits < 4; pbits++) {
+    FitMode6(texels, low, high, pbits & 1, pbits >> 1, result);
+  }
+}
+}  // namespace
+
+uint32_t GetBlockSize(BlockFormat format) {
+  return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+size_t GetCompressedSize(BlockFormat format, int width, int height) {
+  const auto blocksX = static_cast<size_t>((width + 3) / 4);
+  const auto blocksY = static_cast<size_t>((height + 3) / 4);
+  return blocksX * blocksY * GetBlockSize(format);
+}
+
+void EncodeBC1(const uint8_t* texels, uint8_t* block) {
+  EncodeColorBlock(ToFloat(texels), block);
+}
+
+void EncodeBC3(const uint8_t* texels, uint8_t* block) {
+  const auto values = ToFloat(texels);
+  EncodeChannelBlock(values, 3, block);
+  EncodeColorBlock(values, block + 8);
+}
+
+void EncodeBC4(const uint8_t* texels, uint8_t* block, int channel) {
+  EncodeChannelBlock(ToFloat(texels), channel, block);
+}
+
+void EncodeBC5(const uint8_t* texels, uint8_t* block) {
+  const auto values = ToFloat(texels);
+  EncodeChannelBlock(values, 0, block);
+  EncodeChannelBlock(values, 1, block + 8);
+}
+
+void EncodeBC7(const uint8_t* texels, uint8_t* block) {
+  const auto values = ToFloat(texels);
+  float low[4], high[4];
+  FindEndpoints(values, 4, 0.0f, low, high);
+  Mode6Block best;
+  FitMode6AllPBits(values, low, high, best);
+
+  // refit the endpoints to the chosen indices once
+  float weights[BlockTexels];
+  for (int i = 0; i < BlockTexels; i++) {
+    weights[i] = Weights4[best.indices[i]] / 64.0f;
+  }
+  if (SolveEndpoints(values, 4, weights, low, high)) {
+    FitMode6AllPBits(values, low, high, best);
+  }
+
+  // the anchor index is stored without its top bit, so it has to be below 8
+  if (best.indices[0] >= 8) {
+    std::swap(best.endpoints[0], best.endpoints[1]);
+    std::swap(best.pbits[0], best.pbits[1]);
+    for (auto& index : best.indices) {
+      index = static_cast<uint8_t>(15 - index);
+    }
+  }
+  BitWriter writer(block);
+  writer.Write(1 << 6, 7);
+  for (int c = 0; c < 4; c++) {
+    writer.Write(best.endpoints[0][c], 7);
+    writer.Write(best.endpoints[1][c], 7);
+  }
+  writer.Write(best.pbits[0], 1);
+  writer.Write(best.pbits[1], 1);
+  writer.Write(best.indices[0], 3);
+  for (int i = 1; i < BlockTexels; i++) {
+    writer.Write(best.indices[i], 4);
+  }
+}
+
+void CompressImage(BlockFormat format, const uint8_t* rgba, int width, int height, uint8_t* out) {
+  const auto blockSize = GetBlockSize(format);
+  uint8_t texels[BlockTexels * 4];
+  for (int blockY = 0; blockY < height; blockY += 4) {
+    for (int blockX = 0; blockX < width; blockX += 4) {
+      for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+          const auto sourceX = static_cast<size_t>(std::min(blockX + x, width - 1));
+          const auto sourceY = static_cast<size_t>(std::min(blockY + y, height - 1));
+          std::memcpy(texels + (y * 4 + x) * 4, rgba + (sourceY * width + sourceX) * 4, 4);
+        }
+      }
+      switch (format) {
+        case BlockFormat::BC1:
+          EncodeBC1(texels, out);
+          break;
+        case BlockFormat::BC3:
+          EncodeBC3(texels, out);
+          break;
+        case BlockFormat::BC4:
+          EncodeBC4(texels, out);
+          break;
+        case BlockFormat::BC5:
+          EncodeBC5(texels, out);
+          break;
+        case BlockFormat::BC7:
+          EncodeBC7(texels, out);
+          break;
+      }
+      out += blockSize;
+    }
+  }
+}
+}  // namespace photon::util
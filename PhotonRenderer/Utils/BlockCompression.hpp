@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace photon::util {
+/**
+ * CPU encoders for the BCn block formats. The block encoders take 16 texels of 8-bit RGBA, four
+ * rows of four; images come out as one block after another in row order, the way
+ * glCompressedTextureSubImage2D expects them.
+ * Reference: https://learn.microsoft.com/en-us/windows/win32/direct3d11/texture-block-compression-in-direct3d-11
+ */
+enum class BlockFormat { BC1, BC3, BC4, BC5, BC7 };
+
+/** Bytes per 4x4 block: 8 for BC1 and BC4, 16 for the others. */
+uint32_t GetBlockSize(BlockFormat format);
+
+size_t GetCompressedSize(BlockFormat format, int width, int height);
+
+/** BC1: RGB in the four color mode, alpha is dropped. */
+void EncodeBC1(const uint8_t* texels, uint8_t* block);
+
+/** BC3: alpha coded like BC4, followed by a BC1 color block. */
+void EncodeBC3(const uint8_t* texels, uint8_t* block);
+
+/** BC4: a single channel of the texels with eight interpolated values. */
+void EncodeBC4(const uint8_t* texels, uint8_t* block, int channel = 0);
+
+/** BC5: red and green as two BC4 blocks. */
+void EncodeBC5(const uint8_t* texels, uint8_t* block);
+
+/** BC7 in mode 6: one RGBA line with per-endpoint p-bits and 4-bit indices. */
+void EncodeBC7(const uint8_t* texels, uint8_t* block);
+
+/** Compress a whole image, partial blocks at the right and bottom edges repeat the last texel. */
+void CompressImage(BlockFormat format, const uint8_t* rgba, int width, int height, uint8_t* out);
+}  // namespace photon::util
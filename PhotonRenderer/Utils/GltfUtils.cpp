@@ -1,176 +1,433 @@
 #include "Utils/GltfUtils.hpp"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
-#include <iostream>
+#include <json.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include "Assets/Mesh.hpp"
 #include "Common/Logging.hpp"
+#include "MeshoptDecoder.hpp"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 /**
  * Reference: https://gitlab.com/gltf-viewer-tutorial/gltf-viewer
  */
 
 namespace photon::util {
-void ExtractGltfVertices(tinygltf::Primitive& primitive, tinygltf::Model& model,
-                         std::vector<Vertex>& vertices) {
-  tinygltf::Accessor& pos_accessor = model.accessors[primitive.attributes["POSITION"]];
-
-  vertices.resize(pos_accessor.count);
+namespace {
+// "glTF" and "JSON" read as little endian words
+constexpr uint32_t GlbMagic     = 0x46546C67;
+constexpr uint32_t GlbJsonChunk = 0x4E4F534A;
+// what a fallback buffer is loaded as, it decodes to PlaceholderLength bytes
+constexpr const char* PlaceholderUri = "data:application/octet-stream;base64,AAAA";
+constexpr size_t PlaceholderLength   = 3;
 
-  std::vector<uint8_t> pos_data;
-  UnpackGltfBuffer(model, pos_accessor, pos_data);
+template <typename T>
+T LoadComponent(const uint8_t* source) {
+  T value;
+  std::memcpy(&value, source, sizeof(T));
+  return value;
+}
 
-  for (int i = 0; i < vertices.size(); i++) {
-    if (pos_accessor.type == TINYGLTF_TYPE_VEC3) {
-      if (pos_accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT) {
-        float* dtf = (float*)pos_data.data();
+template <typename T, bool Normalized>
+float ToFloat(T value) {
+  if constexpr (!Normalized || std::is_floating_point_v<T>) {
+    return static_cast<float>(value);
+  } else if constexpr (std::is_signed_v<T>) {
+    // both the minimum and the one above it are -1
+    return std::max(static_cast<float>(value) / std::numeric_limits<T>::max(), -1.0f);
+  } else {
+    return static_cast<float>(value) / std::numeric_limits<T>::max();
+  }
+}
 
-        //vec3f
-        vertices[i].position[0] = *(dtf + (i * 3) + 0);
-        vertices[i].position[1] = *(dtf + (i * 3) + 1);
-        vertices[i].position[2] = *(dtf + (i * 3) + 2);
-      } else {
-        assert(false);
-      }
-    } else {
-      assert(false);
+// the component type is settled before the loop, not branched on per element
+template <typename T, bool Normalized, int N, typename Store>
+void ReadElements(const GltfAccessorView& view, Store&& store) {
+  for (size_t i = 0; i < view.count; i++) {
+    const uint8_t* element = view.data + view.stride * i;
+    glm::vec<N, float> value;
+    for (int c = 0; c < N; c++) {
+      value[c] = ToFloat<T, Normalized>(LoadComponent<T>(element + sizeof(T) * c));
     }
+    store(i, value);
   }
+}
 
-  const auto iterator = primitive.attributes.find("TEXCOORD_0");
-  if (iterator != primitive.attributes.end()) {
-    tinygltf::Accessor& uv_accessor = model.accessors[iterator->second];
+template <typename T, int N, typename Store>
+void ReadComponents(const GltfAccessorView& view, Store&& store) {
+  if (view.normalized) {
+    ReadElements<T, true, N>(view, store);
+  } else {
+    ReadElements<T, false, N>(view, store);
+  }
+}
 
-    std::vector<uint8_t> uv_data;
-    UnpackGltfBuffer(model, uv_accessor, uv_data);
+template <int N, typename Store>
+bool ReadAttribute(const GltfAccessorView& view, Store&& store) {
+  if (view.numComponents != N) {
+    return false;
+  }
+  switch (view.componentType) {
+    case TINYGLTF_COMPONENT_TYPE_FLOAT:
+      ReadComponents<float, N>(view, store);
+      return true;
+    case TINYGLTF_COMPONENT_TYPE_BYTE:
+      ReadComponents<int8_t, N>(view, store);
+      return true;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+      ReadComponents<uint8_t, N>(view, store);
+      return true;
+    case TINYGLTF_COMPONENT_TYPE_SHORT:
+      ReadComponents<int16_t, N>(view, store);
+      return true;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+      ReadComponents<uint16_t, N>(view, store);
+      return true;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+      ReadComponents<uint32_t, N>(view, store);
+      return true;
+    default:
+      return false;
+  }
+}
 
-    for (int i = 0; i < vertices.size(); i++) {
-      if (uv_accessor.type == TINYGLTF_TYPE_VEC2) {
-        if (uv_accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT) {
-          float* dtf = (float*)uv_data.data();
+#if defined(__SSE2__) || defined(_M_X64)
+// four triangles widened to a0 a1 a2 b0 | b1 b2 c0 c1 | c2 d0 d1 d2, stored as
+// a0 a2 a1 b0 | b2 b1 c0 c2 | c1 d0 d2 d1
+void StoreFlippedTriangles(__m128i v0, __m128i v1, __m128i v2, uint32_t* out) {
+  const auto f1     = _mm_castsi128_ps(v1);
+  const auto f2     = _mm_castsi128_ps(v2);
+  const auto middle = _mm_shuffle_ps(f1, f2, _MM_SHUFFLE(1, 0, 3, 2));
+  const auto r0     = _mm_shuffle_epi32(v0, _MM_SHUFFLE(3, 1, 2, 0));
+  const auto r1     = _mm_shuffle_ps(f1, middle, _MM_SHUFFLE(2, 0, 0, 1));
+  const auto r2     = _mm_shuffle_ps(middle, f2, _MM_SHUFFLE(2, 3, 3, 1));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), r0);
+  _mm_storeu_ps(reinterpret_cast<float*>(out + 4), r1);
+  _mm_storeu_ps(reinterpret_cast<float*>(out + 8), r2);
+}
 
-          //vec3f
-          vertices[i].uv[0] = *(dtf + (i * 2) + 0);
-          vertices[i].uv[1] = *(dtf + (i * 2) + 1);
-        } else {
-          assert(false);
-        }
+// widens four tightly packed triangles per step, returns how many indices it wrote
+template <typename T>
+size_t ReadPackedTriangles(const uint8_t* source, size_t numTriangles, uint32_t* out) {
+  const auto zero = _mm_setzero_si128();
+  size_t i        = 0;
+  for (; i + 4 <= numTriangles; i += 4, source += 12 * sizeof(T), out += 12) {
+    if constexpr (sizeof(T) == 4) {
+      StoreFlippedTriangles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source)),
+                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 16)),
+                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 32)), out);
+    } else {
+      __m128i low, high;
+      if constexpr (sizeof(T) == 2) {
+        low  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+        high = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + 16));
       } else {
-        assert(false);
+        low  = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source)), zero);
+        high = _mm_unpacklo_epi8(_mm_cvtsi32_si128(LoadComponent<int32_t>(source + 8)), zero);
       }
+      StoreFlippedTriangles(_mm_unpacklo_epi16(low, zero), _mm_unpackhi_epi16(low, zero),
+                            _mm_unpacklo_epi16(high, zero), out);
     }
   }
+  return i * 3;
+}
+#endif
 
-  tinygltf::Accessor& normal_accessor = model.accessors[primitive.attributes["NORMAL"]];
-
-  std::vector<uint8_t> normal_data;
-  UnpackGltfBuffer(model, normal_accessor, normal_data);
-
-  for (int i = 0; i < vertices.size(); i++) {
-    if (normal_accessor.type == TINYGLTF_TYPE_VEC3) {
-      if (normal_accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT) {
-        float* dtf = (float*)normal_data.data();
-        //vec3f
-        vertices[i].normal[0] = *(dtf + (i * 3) + 0);
-        vertices[i].normal[1] = *(dtf + (i * 3) + 1);
-        vertices[i].normal[2] = *(dtf + (i * 3) + 2);
-
-        //        _vertices[i].color[0] = *(dtf + (i * 3) + 0);
-        //        _vertices[i].color[1] = *(dtf + (i * 3) + 1);
-        //        _vertices[i].color[2] = *(dtf + (i * 3) + 2);
-      } else {
-        assert(false);
-      }
-    } else {
-      assert(false);
-    }
+template <typename T>
+void ReadIndices(const GltfAccessorView& view, uint32_t* out) {
+  const size_t numTriangles = view.count / 3;
+  size_t i                  = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+  if (view.stride == sizeof(T)) {
+    i = ReadPackedTriangles<T>(view.data, numTriangles, out);
+  }
+#endif
+  const auto load = [&](size_t index) {
+    return static_cast<uint32_t>(LoadComponent<T>(view.data + view.stride * index));
+  };
+  for (; i < numTriangles * 3; i += 3) {
+    out[i]     = load(i);
+    out[i + 1] = load(i + 2);
+    out[i + 2] = load(i + 1);
+  }
+  for (; i < view.count; i++) {
+    out[i] = load(i);
   }
+}
+}  // namespace
 
-  tinygltf::Accessor& tangent_accessor = model.accessors[primitive.attributes["TANGENT"]];
+bool GetGltfAccessorView(const tinygltf::Model& model, int accessorIndex, GltfAccessorView& view) {
+  view = {};
+  if (accessorIndex < 0 || accessorIndex >= static_cast<int>(model.accessors.size())) {
+    return false;
+  }
+  const auto& accessor = model.accessors[accessorIndex];
+  if (accessor.sparse.isSparse || accessor.bufferView < 0 ||
+      accessor.bufferView >= static_cast<int>(model.bufferViews.size())) {
+    LOGE("Accessor {} is sparse or has no bufferView", accessorIndex);
+    return false;
+  }
+  const auto& bufferView = model.bufferViews[accessor.bufferView];
+  if (bufferView.buffer < 0 || bufferView.buffer >= static_cast<int>(model.buffers.size())) {
+    LOGE("Accessor {} has a bufferView without a buffer", accessorIndex);
+    return false;
+  }
+  const auto& buffer = model.buffers[bufferView.buffer];
+  view.componentType = accessor.componentType;
+  view.numComponents = tinygltf::GetNumComponentsInType(accessor.type);
+  view.normalized    = accessor.normalized;
+  view.count         = accessor.count;
+  const int elementSize =
+      tinygltf::GetComponentSizeInBytes(accessor.componentType) * view.numComponents;
+  view.stride         = bufferView.byteStride != 0 ? bufferView.byteStride : elementSize;
+  const size_t offset = bufferView.byteOffset + accessor.byteOffset;
+  const size_t end    = view.count > 0 ? offset + view.stride * (view.count - 1) + elementSize : 0;
+  if (elementSize <= 0 || end > buffer.data.size()) {
+    LOGE("Accessor {} is out of range of its buffer", accessorIndex);
+    view = {};
+    return false;
+  }
+  view.data = buffer.data.data() + offset;
+  return true;
+}
 
-  std::vector<uint8_t> tangent_data;
-  UnpackGltfBuffer(model, tangent_accessor, tangent_data);
+bool ExtractGltfVertices(const tinygltf::Primitive& primitive, const tinygltf::Model& model,
+                         std::vector<Vertex>& vertices) {
+  const auto find_view = [&](const char* name, GltfAccessorView& view) {
+    const auto iterator = primitive.attributes.find(name);
+    return iterator != primitive.attributes.end() &&
+           GetGltfAccessorView(model, iterator->second, view);
+  };
+  GltfAccessorView view;
+  if (!find_view("POSITION", view)) {
+    LOGE("Primitive has no readable POSITION");
+    return false;
+  }
+  vertices.assign(view.count, Vertex(glm::vec3(0.0f), glm::vec2(0.0f), glm::vec3(0.0f)));
+  bool read = ReadAttribute<3>(view, [&](size_t i, const glm::vec3& value) {
+    vertices[i].position = value;
+  });
+  if (read && find_view("NORMAL", view)) {
+    read = view.count == vertices.size() &&
+           ReadAttribute<3>(view, [&](size_t i, const glm::vec3& value) {
+             vertices[i].normal = value;
+           });
+  }
+  if (read && find_view("TEXCOORD_0", view)) {
+    read = view.count == vertices.size() &&
+           ReadAttribute<2>(view, [&](size_t i, const glm::vec2& value) {
+             vertices[i].uv = value;
+           });
+  }
+  if (!read) {
+    LOGE("Primitive has a vertex attribute of unsupported type or count");
+    vertices.clear();
+  }
+  return read;
+}
 
-  //  for (int i = 0; i < vertices.size(); i++) {
-  //    if (tangent_accessor.type == TINYGLTF_TYPE_VEC3) {
-  //      if (tangent_accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT) {
-  //        float* dtf = (float*)tangent_data.data();
-  //        //vec3f
-  //        vertices[i].tangent[0] = *(dtf + (i * 3) + 0);
-  //        vertices[i].tangent[1] = *(dtf + (i * 3) + 1);
-  //        vertices[i].tangent[2] = *(dtf + (i * 3) + 2);
-  //      } else {
-  //        assert(false);
-  //      }
-  //    } else {
-  //      assert(false);
-  //    }
-  //  }
+size_t GetGltfIndexCount(const tinygltf::Primitive& primitive, const tinygltf::Model& model) {
+  const auto count_of = [&](int accessor) {
+    return accessor >= 0 && accessor < static_cast<int>(model.accessors.size())
+               ? model.accessors[accessor].count
+               : size_t(0);
+  };
+  if (primitive.indices >= 0) {
+    return count_of(primitive.indices);
+  }
+  const auto iterator = primitive.attributes.find("POSITION");
+  return iterator != primitive.attributes.end() ? count_of(iterator->second) : 0;
 }
 
-void ExtractGltfIndices(tinygltf::Primitive& primitive, tinygltf::Model& model,
+bool ExtractGltfIndices(const tinygltf::Primitive& primitive, const tinygltf::Model& model,
                         std::vector<uint32_t>& indices) {
-  int accessor_index      = primitive.indices;
-  const auto& accessor    = model.accessors[accessor_index];
-  const int componentType = accessor.componentType;
-  std::vector<uint8_t> unpackedIndices;
-  UnpackGltfBuffer(model, accessor, unpackedIndices);
-  for (int i = 0; i < accessor.count; i++) {
-    uint32_t index;
-    switch (componentType) {
-      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
-        auto* buf = reinterpret_cast<uint16_t*>(unpackedIndices.data());
-        index     = *(buf + i);
-        break;
-      }
-      case TINYGLTF_COMPONENT_TYPE_SHORT: {
-        auto* buf = reinterpret_cast<int16_t*>(unpackedIndices.data());
-        index     = *(buf + i);
-        break;
-      }
-      case TINYGLTF_COMPONENT_TYPE_INT: {
-        auto* buf = reinterpret_cast<int32_t*>(unpackedIndices.data());
-        index     = *(buf + i);
-        break;
-      }
-      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: {
-        auto* buf = reinterpret_cast<uint32_t*>(unpackedIndices.data());
-        index     = *(buf + i);
-        break;
-      }
-      default: {
-        LOGE("Invalid component type for indices");
-        assert(false);
-      }
+  if (primitive.indices < 0) {
+    const auto iterator = primitive.attributes.find("POSITION");
+    if (iterator == primitive.attributes.end()) {
+      return false;
+    }
+    const auto count = model.accessors[iterator->second].count;
+    indices.resize(count);
+    std::iota(indices.begin(), indices.end(), 0u);
+    for (size_t i = 0; i + 2 < count; i += 3) {
+      std::swap(indices[i + 1], indices[i + 2]);
     }
-    indices.push_back(index);
+    return true;
   }
-  // flip the triangle
-  for (int i = 0; i < indices.size() / 3; ++i) {
-    std::swap(indices[i * 3 + 1], indices[i * 3 + 2]);
+  GltfAccessorView view;
+  if (!GetGltfAccessorView(model, primitive.indices, view) || view.numComponents != 1) {
+    return false;
   }
+  indices.resize(view.count);
+  switch (view.componentType) {
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+      ReadIndices<uint8_t>(view, indices.data());
+      break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+      ReadIndices<uint16_t>(view, indices.data());
+      break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+      ReadIndices<uint32_t>(view, indices.data());
+      break;
+    default:
+      LOGE("Invalid component type for indices");
+      indices.clear();
+      return false;
+  }
+  return true;
 }
 
-void UnpackGltfBuffer(tinygltf::Model& model, const tinygltf::Accessor& accessor,
-                      std::vector<uint8_t>& outBuffer) {
-  tinygltf::BufferView& buffer_view = model.bufferViews[accessor.bufferView];
-  tinygltf::Buffer& buffer          = model.buffers[buffer_view.buffer];
+bool LoadGltfModel(tinygltf::TinyGLTF& loader, const std::string& path, tinygltf::Model& model,
+                   std::string& error, std::string& warning) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    error = "Failed to open " + path;
+    return false;
+  }
+  std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)),
+                                   std::istreambuf_iterator<char>());
+  // magic, version, length, then the length and type of the JSON chunk
+  uint32_t header[5]{};
+  if (bytes.size() >= sizeof(header)) {
+    std::memcpy(header, bytes.data(), sizeof(header));
+  }
+  const bool isBinary = header[0] == GlbMagic;
+  size_t jsonOffset = 0;
+  size_t jsonSize   = bytes.size();
+  if (isBinary) {
+    if (header[4] != GlbJsonChunk || header[3] > bytes.size() - sizeof(header)) {
+      error = "Invalid GLB header in " + path;
+      return false;
+    }
+    jsonOffset = sizeof(header);
+    jsonSize   = header[3];
+  }
 
-  uint8_t* dataPtr = buffer.data.data() + accessor.byteOffset + buffer_view.byteOffset;
+  // only files with fallback buffers are rewritten, the rest are loaded as they are
+  std::vector<std::pair<size_t, size_t>> fallbacks;
+  const std::string_view text(reinterpret_cast<const char*>(bytes.data()) + jsonOffset, jsonSize);
+  if (text.find("EXT_meshopt_compression") != std::string_view::npos) {
+    auto json = nlohmann::json::parse(text, nullptr, false);
+    if (!json.is_discarded() && json.contains("buffers") && json["buffers"].is_array()) {
+      auto& buffers = json["buffers"];
+      for (size_t i = 0; i < buffers.size(); i++) {
+        auto& buffer = buffers[i];
+        if (!buffer.is_object() || buffer.contains("uri") || !buffer.contains("extensions") ||
+            !buffer["extensions"].contains("EXT_meshopt_compression")) {
+          continue;
+        }
+        fallbacks.emplace_back(i, buffer.value("byteLength", size_t{0}));
+        buffer["uri"]        = PlaceholderUri;
+        buffer["byteLength"] = PlaceholderLength;
+      }
+    }
+    if (!fallbacks.empty()) {
+      auto rewritten = json.dump();
+      if (!isBinary) {
+        bytes.assign(rewritten.begin(), rewritten.end());
+      } else {
+        // chunks stay 4-byte aligned, JSON is padded with spaces
+        rewritten.resize((rewritten.size() + 3) & ~size_t{3}, ' ');
+        std::vector<unsigned char> glb(sizeof(header));
+        glb.insert(glb.end(), rewritten.begin(), rewritten.end());
+        glb.insert(glb.end(), bytes.begin() + static_cast<ptrdiff_t>(jsonOffset + jsonSize),
+                   bytes.end());
+        header[2] = static_cast<uint32_t>(glb.size());
+        header[3] = static_cast<uint32_t>(rewritten.size());
+        std::memcpy(glb.data(), header, sizeof(header));
+        bytes = std::move(glb);
+      }
+    }
+  }
 
-  size_t elementSize = tinygltf::GetComponentSizeInBytes(accessor.componentType) *
-                       tinygltf::GetNumComponentsInType(accessor.type);
-  size_t stride = buffer_view.byteStride;
-  if (stride == 0) {
-    stride = elementSize;
+  const auto baseDir = std::filesystem::path(path).parent_path().string();
+  const auto length  = static_cast<unsigned int>(bytes.size());
+  const bool loaded =
+      isBinary
+          ? loader.LoadBinaryFromMemory(&model, &error, &warning, bytes.data(), length, baseDir)
+          : loader.LoadASCIIFromString(&model, &error, &warning,
+                                       reinterpret_cast<const char*>(bytes.data()), length, baseDir);
+  if (!loaded) {
+    return false;
+  }
+  for (const auto& [index, byteLength] : fallbacks) {
+    auto& buffer = model.buffers[index];
+    buffer.uri.clear();
+    buffer.data.assign(byteLength, 0);
   }
-  outBuffer.resize(accessor.count * elementSize);
+  return true;
+}
 
-  for (int i = 0; i < accessor.count; i++) {
-    uint8_t* src = dataPtr + stride * i;
-    uint8_t* dst = outBuffer.data() + elementSize * i;
-    memcpy(dst, src, elementSize);
+bool DecodeGltfMeshopt(tinygltf::Model& model) {
+  const auto get_size = [](const tinygltf::Value& object, const char* key) {
+    const auto& value = object.Get(key);
+    return value.IsNumber() ? static_cast<size_t>(value.GetNumberAsDouble()) : size_t(0);
+  };
+  const auto get_string = [](const tinygltf::Value& object, const char* key, const char* fallback) {
+    const auto& value = object.Get(key);
+    return value.IsString() ? value.Get<std::string>() : std::string(fallback);
+  };
+  for (size_t i = 0; i < model.bufferViews.size(); i++) {
+    auto& bufferView     = model.bufferViews[i];
+    const auto extension = bufferView.extensions.find("EXT_meshopt_compression");
+    if (extension == bufferView.extensions.end()) {
+      continue;
+    }
+    const auto& ext     = extension->second;
+    const int source    = ext.Get("buffer").IsNumber() ? ext.Get("buffer").GetNumberAsInt() : -1;
+    const size_t offset = get_size(ext, "byteOffset");
+    const size_t length = get_size(ext, "byteLength");
+    const size_t stride = get_size(ext, "byteStride");
+    const size_t count  = get_size(ext, "count");
+    const auto mode     = get_string(ext, "mode", "");
+    const auto filter   = get_string(ext, "filter", "NONE");
+    if (source < 0 || source >= static_cast<int>(model.buffers.size()) || bufferView.buffer < 0 ||
+        bufferView.buffer >= static_cast<int>(model.buffers.size())) {
+      LOGE("Invalid buffer in compressed bufferView {}", i);
+      return false;
+    }
+    const auto& src = model.buffers[source].data;
+    auto& dst       = model.buffers[bufferView.buffer].data;
+    if (offset + length > src.size() || bufferView.byteOffset + count * stride > dst.size()) {
+      LOGE("Compressed bufferView {} is out of range", i);
+      return false;
+    }
+    uint8_t* destination = dst.data() + bufferView.byteOffset;
+    bool decoded         = false;
+    if (mode == "ATTRIBUTES") {
+      decoded = DecodeMeshoptVertexBuffer(destination, count, stride, src.data() + offset, length);
+    } else if (mode == "TRIANGLES") {
+      decoded = DecodeMeshoptIndexBuffer(destination, count, stride, src.data() + offset, length);
+    } else if (mode == "INDICES") {
+      decoded = DecodeMeshoptIndexSequence(destination, count, stride, src.data() + offset, length);
+    }
+    if (!decoded) {
+      LOGE("Failed to decode bufferView {} ({} mode)", i, mode);
+      return false;
+    }
+    if (filter == "OCTAHEDRAL" && (stride == 4 || stride == 8)) {
+      DecodeMeshoptFilterOct(destination, count, stride);
+    } else if (filter == "QUATERNION" && stride == 8) {
+      DecodeMeshoptFilterQuat(destination, count);
+    } else if (filter == "EXPONENTIAL" && stride % 4 == 0) {
+      DecodeMeshoptFilterExp(destination, count, stride);
+    } else if (filter != "NONE") {
+      LOGE("Unsupported filter {} on bufferView {}", filter, i);
+      return false;
+    }
   }
+  return true;
 }
 
 glm::mat4 GetLocalToWorldMatrix(const tinygltf::Node& node, const glm::mat4& parentMatrix) {
@@ -199,101 +456,34 @@ glm::mat4 GetLocalToWorldMatrix(const tinygltf::Node& node, const glm::mat4& par
              : glm::scale(TR, glm::vec3(node.scale[0], node.scale[1], node.scale[2]));
 };
 
-void ComputeSceneBounds(const tinygltf::Model& model, glm::vec3& bboxMin, glm::vec3& bboxMax) {
-  // Compute scene bounding box
-  // todo refactor with scene drawing
-  // todo need a visitScene generic function that takes a accept() functor
-  bboxMin = glm::vec3(std::numeric_limits<float>::max());
-  bboxMax = glm::vec3(std::numeric_limits<float>::lowest());
-  if (model.defaultScene >= 0) {
-    const std::function<void(int, const glm::mat4&)> updateBounds = [&](int nodeIdx,
-                                                                        const glm::mat4&
-                                                                            parentMatrix) {
-      const auto& node = model.nodes[nodeIdx];
-      // model matrix
-      const glm::mat4 modelMatrix = GetLocalToWorldMatrix(node, parentMatrix);
-      if (node.mesh >= 0) {
-        const auto& mesh = model.meshes[node.mesh];
-        for (size_t pIdx = 0; pIdx < mesh.primitives.size(); ++pIdx) {
-          const auto& primitive        = mesh.primitives[pIdx];
-          const auto positionAttrIdxIt = primitive.attributes.find("POSITION");
-          if (positionAttrIdxIt == end(primitive.attributes)) {
-            continue;
-          }
-          const auto& positionAccessor = model.accessors[(*positionAttrIdxIt).second];
-          if (positionAccessor.type != 3) {
-            std::cerr << "Position accessor with type != VEC3, skipping" << std::endl;
-            continue;
-          }
-          const auto& positionBufferView = model.bufferViews[positionAccessor.bufferView];
-          const auto byteOffset      = positionAccessor.byteOffset + positionBufferView.byteOffset;
-          const auto& positionBuffer = model.buffers[positionBufferView.buffer];
-          const auto positionByteStride =
-              positionBufferView.byteStride ? positionBufferView.byteStride : 3 * sizeof(float);
-
-          if (primitive.indices >= 0) {
-            const auto& indexAccessor   = model.accessors[primitive.indices];
-            const auto& indexBufferView = model.bufferViews[indexAccessor.bufferView];
-            const auto indexByteOffset  = indexAccessor.byteOffset + indexBufferView.byteOffset;
-            const auto& indexBuffer     = model.buffers[indexBufferView.buffer];
-            auto indexByteStride        = indexBufferView.byteStride;
-
-            switch (indexAccessor.componentType) {
-              default:
-                std::cerr << "Primitive index accessor with bad componentType "
-                          << indexAccessor.componentType << ", skipping it." << std::endl;
-                continue;
-              case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-                indexByteStride = indexByteStride ? indexByteStride : sizeof(uint8_t);
-                break;
-              case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-                indexByteStride = indexByteStride ? indexByteStride : sizeof(uint16_t);
-                break;
-              case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-                indexByteStride = indexByteStride ? indexByteStride : sizeof(uint32_t);
-                break;
-            }
-
-            for (size_t i = 0; i < indexAccessor.count; ++i) {
-              uint32_t index = 0;
-              switch (indexAccessor.componentType) {
-                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-                  index =
-                      *((const uint8_t*)&indexBuffer.data[indexByteOffset + indexByteStride * i]);
-                  break;
-                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-                  index =
-                      *((const uint16_t*)&indexBuffer.data[indexByteOffset + indexByteStride * i]);
-                  break;
-                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-                  index =
-                      *((const uint32_t*)&indexBuffer.data[indexByteOffset + indexByteStride * i]);
-                  break;
-              }
-              const auto& localPosition = *(
-                  (const glm::vec3*)&positionBuffer.data[byteOffset + positionByteStride * index]);
-              const auto worldPosition = glm::vec3(modelMatrix * glm::vec4(localPosition, 1.f));
-              bboxMin                  = glm::min(bboxMin, worldPosition);
-              bboxMax                  = glm::max(bboxMax, worldPosition);
-            }
-          } else {
-            for (size_t i = 0; i < positionAccessor.count; ++i) {
-              const auto& localPosition =
-                  *((const glm::vec3*)&positionBuffer.data[byteOffset + positionByteStride * i]);
-              const auto worldPosition = glm::vec3(modelMatrix * glm::vec4(localPosition, 1.f));
-              bboxMin                  = glm::min(bboxMin, worldPosition);
-              bboxMax                  = glm::max(bboxMax, worldPosition);
-            }
-          }
-        }
-      }
-      for (const auto childNodeIdx : node.children) {
-        updateBounds(childNodeIdx, modelMatrix);
-      }
-    };
-    for (const auto nodeIdx : model.scenes[model.defaultScene].nodes) {
-      updateBounds(nodeIdx, glm::mat4(1));
+void FlattenGltfScene(const tinygltf::Model& model, std::vector<GltfNodeInstance>& instances) {
+  instances.clear();
+  const int scene = model.defaultScene >= 0 ? model.defaultScene : 0;
+  if (scene >= static_cast<int>(model.scenes.size())) {
+    return;
+  }
+  const auto& roots = model.scenes[scene].nodes;
+  std::vector<std::pair<int, glm::mat4>> stack;
+  // reversed, so nodes come out in the order of the file
+  for (auto root = roots.rbegin(); root != roots.rend(); ++root) {
+    stack.emplace_back(*root, glm::mat4(1.0f));
+  }
+  std::vector<char> visited(model.nodes.size(), 0);
+  while (!stack.empty()) {
+    const auto [nodeIndex, parentMatrix] = stack.back();
+    stack.pop_back();
+    if (nodeIndex < 0 || nodeIndex >= static_cast<int>(model.nodes.size()) || visited[nodeIndex]) {
+      continue;
+    }
+    visited[nodeIndex]     = 1;
+    const auto& node       = model.nodes[nodeIndex];
+    const auto worldMatrix = GetLocalToWorldMatrix(node, parentMatrix);
+    if (node.mesh >= 0 && node.mesh < static_cast<int>(model.meshes.size())) {
+      instances.push_back({node.mesh, worldMatrix});
+    }
+    for (auto child = node.children.rbegin(); child != node.children.rend(); ++child) {
+      stack.emplace_back(*child, worldMatrix);
     }
   }
 }
-}  // namespace photon::util
\ No newline at end of file
+}  // namespace photon::util
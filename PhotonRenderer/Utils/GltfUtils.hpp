@@ -6,29 +6,69 @@
 
 namespace photon::util {
 
+/** An accessor's elements where they lie in their buffer, read in place rather than copied out. */
+struct GltfAccessorView {
+  const uint8_t* data{nullptr};
+  size_t count{0};
+  // bytes from one element to the next, the element size when tightly packed
+  size_t stride{0};
+  int componentType{0};
+  int numComponents{0};
+  bool normalized{false};
+};
+
+/**
+ * Fails on accessors without a bufferView or buffer, sparse ones, or ones reaching past their
+ * buffer, leaving view empty.
+ */
+bool GetGltfAccessorView(const tinygltf::Model& model, int accessorIndex, GltfAccessorView& view);
+
+/** Indices ExtractGltfIndices yields for a primitive, without reading them. */
+size_t GetGltfIndexCount(const tinygltf::Primitive& primitive, const tinygltf::Model& model);
+
 /**
- * Reference: https://github.com/vblanco20-1/vulkan-guide/blob/engine/asset-baker/asset_main.cpp
+ * Read a primitive's triangle list in one pass, widening 8 and 16 bit indices and swapping the
+ * last two corners of every triangle on the way. Primitives without indices get 0..n-1.
  */
-void ExtractGltfIndices(tinygltf::Primitive& primitive, tinygltf::Model& model,
+bool ExtractGltfIndices(const tinygltf::Primitive& primitive, const tinygltf::Model& model,
                         std::vector<uint32_t>& indices);
 /**
- * Reference: https://github.com/vblanco20-1/vulkan-guide/blob/engine/asset-baker/asset_main.cpp
+ * Read POSITION, NORMAL and TEXCOORD_0 straight from their buffers into vertices, one pass per
+ * attribute. Normalized and plain integer components (KHR_mesh_quantization) are converted to
+ * float; a missing NORMAL or TEXCOORD_0 is left zero.
  */
-void ExtractGltfVertices(tinygltf::Primitive& primitive, tinygltf::Model& model,
+bool ExtractGltfVertices(const tinygltf::Primitive& primitive, const tinygltf::Model& model,
                          std::vector<Vertex>& vertices);
+
 /**
- * Reference: https://github.com/vblanco20-1/vulkan-guide/blob/engine/asset-baker/asset_main.cpp
+ * Load a .gltf or .glb file, told apart by the GLB header. Fallback buffers of
+ * EXT_meshopt_compression carry no uri and no data, which tinygltf refuses; they are handed to it
+ * as a placeholder and come back zeroed at their full length, ready for DecodeGltfMeshopt.
  */
-void UnpackGltfBuffer(tinygltf::Model& model, const tinygltf::Accessor& accessor,
-                      std::vector<uint8_t>& outBuffer);
+bool LoadGltfModel(tinygltf::TinyGLTF& loader, const std::string& path, tinygltf::Model& model,
+                   std::string& error, std::string& warning);
+
+/**
+ * Decode every EXT_meshopt_compression bufferView in place into its (fallback) buffer, so the
+ * accessors can be read as if the data had never been compressed.
+ */
+bool DecodeGltfMeshopt(tinygltf::Model& model);
 
 /**
  * Reference: https://gitlab.com/gltf-viewer-tutorial/gltf-viewer/-/blob/tutorial-v1/src/utils/gltf.cpp
  */
 glm::mat4 GetLocalToWorldMatrix(const tinygltf::Node& node, const glm::mat4& parentMatrix);
 
+/** A node of the scene that places a mesh, with the matrix of its whole chain of parents. */
+struct GltfNodeInstance {
+  int mesh;
+  glm::mat4 worldMatrix;
+};
+
 /**
- * Reference: https://gitlab.com/gltf-viewer-tutorial/gltf-viewer/-/blob/tutorial-v1/src/utils/gltf.cpp
+ * Walk the node hierarchy of the default scene, or the first one, depth first with an explicit
+ * stack and collect every node that places a mesh. Linear in the number of nodes; nodes reached a
+ * second time, which only malformed files allow, are skipped.
  */
-void ComputeSceneBounds(const tinygltf::Model& model, glm::vec3& bboxMin, glm::vec3& bboxMax);
+void FlattenGltfScene(const tinygltf::Model& model, std::vector<GltfNodeInstance>& instances);
 }  // namespace photon::util
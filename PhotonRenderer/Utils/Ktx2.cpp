@@ -0,0 +1,307 @@
+#include "Ktx2.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "Common/Logging.hpp"
+#include "MappedFile.hpp"
+#include "ModelSource.hpp"
+#include "TextureBaker.hpp"
+
+namespace photon::util {
+namespace {
+constexpr uint8_t Ktx2Identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A,
+                                        '\n'};
+constexpr const char* WriterKey     = "KTXwriter";
+constexpr const char* SourceHashKey = "PhotonSourceHash";
+// a multiple of every block size and of 4, as the level offsets require
+constexpr uint64_t LevelAlignment = 16;
+
+struct Ktx2Header {
+  uint8_t identifier[12];
+  uint32_t vkFormat;
+  uint32_t typeSize;
+  uint32_t pixelWidth;
+  uint32_t pixelHeight;
+  uint32_t pixelDepth;
+  uint32_t layerCount;
+  uint32_t faceCount;
+  uint32_t levelCount;
+  uint32_t supercompressionScheme;
+  uint32_t dfdByteOffset;
+  uint32_t dfdByteLength;
+  uint32_t kvdByteOffset;
+  uint32_t kvdByteLength;
+  uint64_t sgdByteOffset;
+  uint64_t sgdByteLength;
+};
+static_assert(sizeof(Ktx2Header) == 80);
+
+struct Ktx2Level {
+  uint64_t byteOffset;
+  uint64_t byteLength;
+  uint64_t uncompressedByteLength;
+};
+static_assert(sizeof(Ktx2Level) == 24);
+
+struct Ktx2Sample {
+  uint32_t channel;
+  uint32_t bitOffset;
+  uint32_t bitLength;
+};
+
+struct Ktx2Format {
+  BlockFormat format;
+  uint32_t vkFormat;
+  // 0 when the format has no sRGB variant
+  uint32_t vkFormatSRGB;
+  // KHR_DF_MODEL_BC*
+  uint32_t colorModel;
+  std::vector<Ktx2Sample> samples;
+};
+
+const std::vector<Ktx2Format>& GetFormats() {
+  // VK_FORMAT_BC*_BLOCK values and the channels of their data format descriptors
+  static const std::vector<Ktx2Format> formats = {
+      {BlockFormat::BC1, 131, 132, 128, {{0, 0, 64}}},
+      {BlockFormat::BC3, 137, 138, 130, {{15, 0, 64}, {0, 64, 64}}},
+      {BlockFormat::BC4, 139, 0, 131, {{0, 0, 64}}},
+      {BlockFormat::BC5, 141, 0, 132, {{0, 0, 64}, {1, 64, 64}}},
+      {BlockFormat::BC7, 145, 146, 134, {{0, 0, 128}}},
+  };
+  return formats;
+}
+
+inline uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+std::vector<uint32_t> BuildDataFormatDescriptor(const Ktx2Format& format, bool srgb) {
+  constexpr uint32_t LinearSample = 1u << 4;
+  const auto numSamples           = static_cast<uint32_t>(format.samples.size());
+  const uint32_t blockSize        = 24 + 16 * numSamples;
+  // Khronos vendor and basic descriptor block version 1.3, BT.709 primaries, 4x4 texel blocks
+  std::vector<uint32_t> words = {4 + blockSize,
+                                 0,
+                                 2 | blockSize << 16,
+                                 format.colorModel | 1u << 8 | (srgb ? 2u : 1u) << 16,
+                                 3 | 3 << 8,
+                                 GetBlockSize(format.format),
+                                 0};
+  for (const auto& sample : format.samples) {
+    // alpha stays linear in an sRGB texture
+    const uint32_t channel = srgb && sample.channel == 15 ? sample.channel | LinearSample
+                                                          : sample.channel;
+    words.push_back(sample.bitOffset | (sample.bitLength - 1) << 16 | channel << 24);
+    words.push_back(0);
+    words.push_back(0);
+    words.push_back(0xFFFFFFFF);
+  }
+  return words;
+}
+
+std::vector<char> BuildKeyValueData(uint64_t sourceHash) {
+  std::vector<char> data;
+  const auto add_entry = [&](const std::string& key, const std::string& value) {
+    const auto length = static_cast<uint32_t>(key.size() + 1 + value.size() + 1);
+    const auto* bytes = reinterpret_cast<const char*>(&length);
+    data.insert(data.end(), bytes, bytes + sizeof(length));
+    data.insert(data.end(), key.c_str(), key.c_str() + key.size() + 1);
+    data.insert(data.end(), value.c_str(), value.c_str() + value.size() + 1);
+    data.resize(AlignUp(data.size(), 4));
+  };
+  // sorted by key
+  add_entry(WriterKey, "PhotonRenderer");
+  if (sourceHash != 0) {
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(sourceHash));
+    add_entry(SourceHashKey, hash);
+  }
+  return data;
+}
+
+uint64_t FindSourceHash(std::span<const char> keyValueData) {
+  size_t offset = 0;
+  while (offset + sizeof(uint32_t) <= keyValueData.size()) {
+    uint32_t length;
+    std::memcpy(&length, keyValueData.data() + offset, sizeof(length));
+    offset += sizeof(length);
+    if (length > keyValueData.size() - offset) {
+      break;
+    }
+    const std::string_view entry(keyValueData.data() + offset, length);
+    const auto keyEnd = entry.find('\0');
+    if (keyEnd != std::string_view::npos && entry.substr(0, keyEnd) == SourceHashKey) {
+      return std::strtoull(std::string(entry.substr(keyEnd + 1)).c_str(), nullptr, 16);
+    }
+    offset = AlignUp(offset + length, 4);
+  }
+  return 0;
+}
+}  // namespace
+
+bool WriteKtx2(const std::string& path, uint64_t sourceHash, const TextureSource& texture) {
+  const Ktx2Format* format = nullptr;
+  bool srgb                = false;
+  for (const auto& candidate : GetFormats()) {
+    const auto linearFormat = GetCompressedFormat(candidate.format, false);
+    const auto srgbFormat   = GetCompressedFormat(candidate.format, true);
+    if (texture.info.internalFormat == linearFormat || texture.info.internalFormat == srgbFormat) {
+      format = &candidate;
+      srgb   = texture.info.internalFormat != linearFormat;
+    }
+  }
+  const auto pixels = texture.GetPixels();
+  if (format == nullptr || texture.levels.empty()) {
+    LOGE("Cannot write {}, only block-compressed mip chains are supported", path);
+    return false;
+  }
+  const auto numLevels    = static_cast<uint32_t>(texture.levels.size());
+  const auto descriptor   = BuildDataFormatDescriptor(*format, srgb);
+  const auto keyValueData = BuildKeyValueData(sourceHash);
+  Ktx2Header header{};
+  std::memcpy(header.identifier, Ktx2Identifier, sizeof(Ktx2Identifier));
+  header.vkFormat    = srgb ? format->vkFormatSRGB : format->vkFormat;
+  header.typeSize    = 1;
+  header.pixelWidth  = static_cast<uint32_t>(texture.info.width);
+  header.pixelHeight = static_cast<uint32_t>(texture.info.height);
+  header.faceCount   = 1;
+  header.levelCount  = numLevels;
+
+  // header | level index | descriptor | key/value data | levels from the smallest up
+  header.dfdByteOffset =
+      static_cast<uint32_t>(sizeof(Ktx2Header) + numLevels * sizeof(Ktx2Level));
+  header.dfdByteLength = static_cast<uint32_t>(descriptor.size() * sizeof(uint32_t));
+  header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+  header.kvdByteLength = static_cast<uint32_t>(keyValueData.size());
+  std::vector<Ktx2Level> levelIndex(numLevels);
+  uint64_t offset = header.kvdByteOffset + header.kvdByteLength;
+  for (uint32_t i = numLevels; i-- > 0;) {
+    const auto& level = texture.levels[i];
+    if (level.offset + level.size > pixels.size()) {
+      LOGE("Cannot write {}, level {} lies outside the pixels", path, i);
+      return false;
+    }
+    levelIndex[i].byteOffset             = AlignUp(offset, LevelAlignment);
+    levelIndex[i].byteLength             = level.size;
+    levelIndex[i].uncompressedByteLength = level.size;
+    offset                               = levelIndex[i].byteOffset + level.size;
+  }
+
+  // write next to the target and rename, so a crash never leaves a truncated file behind
+  const auto tempPath = path + ".tmp";
+  {
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      LOGE("Failed to create {}", tempPath);
+      return false;
+    }
+    uint64_t written = 0;
+    const auto write = [&](const void* data, uint64_t size) {
+      out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+      written += size;
+    };
+    write(&header, sizeof(header));
+    write(levelIndex.data(), levelIndex.size() * sizeof(Ktx2Level));
+    write(descriptor.data(), header.dfdByteLength);
+    write(keyValueData.data(), keyValueData.size());
+    for (uint32_t i = numLevels; i-- > 0;) {
+      static constexpr char Zeros[LevelAlignment]{};
+      write(Zeros, levelIndex[i].byteOffset - written);
+      write(pixels.data() + texture.levels[i].offset, texture.levels[i].size);
+    }
+    if (!out) {
+      LOGE("Failed to write {}", tempPath);
+      return false;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tempPath, path, ec);
+  if (ec) {
+    LOGE("Failed to move {} into place: {}", path, ec.message());
+    std::filesystem::remove(tempPath, ec);
+    return false;
+  }
+  return true;
+}
+
+bool ReadKtx2(const std::string& path, uint64_t sourceHash, TextureSource& texture) {
+  if (!std::filesystem::exists(path)) {
+    return false;
+  }
+  MappedFile file(path);
+  if (!file.IsOpen() || file.GetSize() < sizeof(Ktx2Header)) {
+    return false;
+  }
+  const char* data    = file.GetData();
+  const uint64_t size = file.GetSize();
+  Ktx2Header header;
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.identifier, Ktx2Identifier, sizeof(Ktx2Identifier)) != 0) {
+    LOGW("{} is not a KTX2 file", path);
+    return false;
+  }
+  const Ktx2Format* format = nullptr;
+  for (const auto& candidate : GetFormats()) {
+    if (header.vkFormat == candidate.vkFormat || header.vkFormat == candidate.vkFormatSRGB) {
+      format = &candidate;
+    }
+  }
+  if (format == nullptr || header.supercompressionScheme != 0 || header.pixelDepth > 1 ||
+      header.layerCount > 1 || header.faceCount != 1 || header.pixelWidth == 0 ||
+      header.pixelHeight == 0) {
+    LOGE("{}: only single 2D BC1/BC3/BC4/BC5/BC7 images without supercompression are supported",
+         path);
+    return false;
+  }
+  if (sourceHash != 0) {
+    if (static_cast<uint64_t>(header.kvdByteOffset) + header.kvdByteLength > size ||
+        FindSourceHash({data + header.kvdByteOffset, header.kvdByteLength}) != sourceHash) {
+      LOGI("Baked texture {} is stale", path);
+      return false;
+    }
+  }
+  // a level count of 0 asks for the mip chain to be generated, only the base level is stored
+  const uint32_t numLevels = std::max(header.levelCount, 1u);
+  if (sizeof(Ktx2Header) + static_cast<uint64_t>(numLevels) * sizeof(Ktx2Level) > size) {
+    LOGW("Ignoring truncated KTX2 file {}", path);
+    return false;
+  }
+  std::vector<Ktx2Level> levelIndex(numLevels);
+  std::memcpy(levelIndex.data(), data + sizeof(Ktx2Header), numLevels * sizeof(Ktx2Level));
+
+  std::vector<unsigned char> pixels;
+  std::vector<asset::TextureLevel> levels;
+  for (uint32_t i = 0; i < numLevels; i++) {
+    const int width     = std::max(static_cast<int>(header.pixelWidth >> i), 1);
+    const int height    = std::max(static_cast<int>(header.pixelHeight >> i), 1);
+    const auto expected = GetCompressedSize(format->format, width, height);
+    const auto& level   = levelIndex[i];
+    if (level.byteLength != expected || level.byteOffset > size ||
+        level.byteLength > size - level.byteOffset) {
+      LOGW("Ignoring KTX2 file {} with a malformed level {}", path, i);
+      return false;
+    }
+    levels.push_back({width, height, pixels.size(), expected});
+    pixels.insert(pixels.end(), data + level.byteOffset, data + level.byteOffset + expected);
+  }
+  texture.pixels              = std::move(pixels);
+  texture.mappedPixels        = {};
+  texture.levels              = std::move(levels);
+  texture.info.width          = static_cast<int>(header.pixelWidth);
+  texture.info.height         = static_cast<int>(header.pixelHeight);
+  texture.info.internalFormat =
+      GetCompressedFormat(format->format, header.vkFormat == format->vkFormatSRGB);
+  texture.info.dataFormat     = GL_RGBA;
+  texture.info.dataType       = GL_UNSIGNED_BYTE;
+  texture.info.generateMipmap = false;
+  if (numLevels > 1) {
+    texture.info.minFilter = GetMipmapFilter(texture.info.minFilter);
+  }
+  return true;
+}
+}  // namespace photon::util
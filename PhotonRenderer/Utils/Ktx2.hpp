@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace photon::util {
+struct TextureSource;
+/**
+ * KTX2 container for block-compressed mip chains, without supercompression.
+ * Reference: https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+ */
+
+/**
+ * Write the levels of a baked texture, labelled sRGB when its internal format is. A non-zero
+ * sourceHash is kept as metadata, to tell whether a baked file is stale.
+ */
+bool WriteKtx2(const std::string& path, uint64_t sourceHash, const TextureSource& texture);
+
+/**
+ * Read every level of a BC1/BC3/BC4/BC5/BC7 file into texture, keeping its sampler state. With a
+ * non-zero sourceHash, files baked from anything else are rejected.
+ */
+bool ReadKtx2(const std::string& path, uint64_t sourceHash, TextureSource& texture);
+}  // namespace photon::util
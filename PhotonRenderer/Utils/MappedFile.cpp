@@ -0,0 +1,96 @@
+#include "MappedFile.hpp"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "Common/Logging.hpp"
+
+namespace photon::util {
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& path) {
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    LOGE("Failed to open {}", path);
+    return;
+  }
+  m_fileHandle = file;
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    LOGE("Failed to query size of {}", path);
+    return;
+  }
+  m_size = static_cast<size_t>(size.QuadPart);
+  if (m_size == 0) {
+    // empty files can not be mapped, but they are still valid
+    m_isOpen = true;
+    return;
+  }
+  m_mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (m_mappingHandle == nullptr) {
+    LOGE("Failed to map {}", path);
+    return;
+  }
+  m_data = static_cast<const char*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+  if (m_data == nullptr) {
+    LOGE("Failed to map view of {}", path);
+    return;
+  }
+  m_isOpen = true;
+}
+
+MappedFile::~MappedFile() {
+  if (m_data != nullptr) {
+    UnmapViewOfFile(m_data);
+  }
+  if (m_mappingHandle != nullptr) {
+    CloseHandle(m_mappingHandle);
+  }
+  if (m_fileHandle != nullptr) {
+    CloseHandle(m_fileHandle);
+  }
+}
+#else
+MappedFile::MappedFile(const std::string& path) {
+  m_fd = open(path.c_str(), O_RDONLY);
+  if (m_fd < 0) {
+    LOGE("Failed to open {}", path);
+    return;
+  }
+  struct stat st {};
+  if (fstat(m_fd, &st) != 0) {
+    LOGE("Failed to query size of {}", path);
+    return;
+  }
+  m_size = static_cast<size_t>(st.st_size);
+  if (m_size == 0) {
+    // empty files can not be mapped, but they are still valid
+    m_isOpen = true;
+    return;
+  }
+  void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+  if (data == MAP_FAILED) {
+    LOGE("Failed to map {}", path);
+    return;
+  }
+  madvise(data, m_size, MADV_SEQUENTIAL);
+  m_data   = static_cast<const char*>(data);
+  m_isOpen = true;
+}
+
+MappedFile::~MappedFile() {
+  if (m_data != nullptr) {
+    munmap(const_cast<char*>(m_data), m_size);
+  }
+  if (m_fd >= 0) {
+    close(m_fd);
+  }
+}
+#endif
+}  // namespace photon::util
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace photon::util {
+/**
+ * Read-only memory mapping of a whole file, unmapped on destruction.
+ */
+class MappedFile {
+public:
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&)            = delete;
+  MappedFile(MappedFile&&)                 = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile& operator=(MappedFile&&)      = delete;
+
+  [[nodiscard]] bool IsOpen() const { return m_isOpen; }
+  [[nodiscard]] const char* GetData() const { return m_data; }
+  [[nodiscard]] size_t GetSize() const { return m_size; }
+
+private:
+  const char* m_data{nullptr};
+  size_t m_size{0};
+  bool m_isOpen{false};
+#ifdef _WIN32
+  void* m_fileHandle{nullptr};
+  void* m_mappingHandle{nullptr};
+#else
+  int m_fd{-1};
+#endif
+};
+}  // namespace photon::util
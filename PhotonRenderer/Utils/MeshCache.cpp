@@ -0,0 +1,509 @@
+#include "MeshCache.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <json.hpp>
+#include <span>
+#include <string_view>
+#include "Common/Logging.hpp"
+#include "MappedFile.hpp"
+
+namespace photon::util {
+namespace {
+constexpr uint32_t MeshCacheMagic   = 0x48534d50;  // "PMSH"
+constexpr uint32_t MeshCacheVersion = 7;
+// blobs are aligned so vertices and indices can be read in place
+constexpr uint64_t BlobAlignment = 16;
+
+// all records are laid out without padding so they can be written and mapped as-is
+struct StringRef {
+  uint32_t offset;
+  uint32_t length;
+};
+
+struct MeshCacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t sourceHash;
+  uint32_t numMeshes;
+  uint32_t numTextures;
+  glm::vec3 aabbMin;
+  glm::vec3 aabbMax;
+  StringRef name;
+  uint64_t fileSize;
+  uint32_t numInstances;
+  uint32_t padding;
+};
+static_assert(sizeof(MeshCacheHeader) == 72);
+
+struct MeshRecord {
+  glm::vec4 baseColorFactor;
+  glm::vec3 emissiveFactor;
+  float alphaCutoff;
+  double metallicFactor;
+  double roughnessFactor;
+  double occlusionStrength;
+  int32_t alphaMode;
+  // index into the texture records per PBRComponent, -1 if unused
+  int32_t textures[NumPBRComponents];
+  StringRef name;
+  uint64_t vertexOffset;
+  uint64_t indexOffset;
+  uint32_t numVertices;
+  uint32_t numIndices;
+  // ranges of the index blob, the first numLods are used
+  uint32_t numLods;
+  MeshLod lods[MaxMeshLods];
+  uint32_t numMeshlets;
+  uint64_t meshletOffset;
+  // turns the packed vertices back into positions and uvs
+  VertexQuantization quantization;
+};
+static_assert(sizeof(MeshRecord) == 216);
+
+struct InstanceRecord {
+  glm::mat4 modelMatrix;
+  glm::vec3 aabbMin;
+  uint32_t mesh;
+  glm::vec3 aabbMax;
+  uint32_t padding;
+};
+static_assert(sizeof(InstanceRecord) == 96);
+
+struct TextureRecord {
+  int32_t width;
+  int32_t height;
+  int32_t minFilter;
+  int32_t magFilter;
+  int32_t wrapS;
+  int32_t wrapT;
+  int32_t wrapR;
+  uint32_t generateMipmap;
+  // image file, empty when the pixels are embedded in the cache
+  StringRef path;
+  uint64_t pixelOffset;
+  uint64_t pixelSize;
+};
+static_assert(sizeof(TextureRecord) == 56);
+
+inline uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+class StringTable {
+public:
+  StringRef Add(const std::string& str) {
+    StringRef ref{static_cast<uint32_t>(m_data.size()), static_cast<uint32_t>(str.size())};
+    m_data += str;
+    return ref;
+  }
+  [[nodiscard]] const std::string& GetData() const { return m_data; }
+
+private:
+  std::string m_data;
+};
+
+template <typename T>
+bool InRange(uint64_t offset, uint64_t count, uint64_t size) {
+  return offset <= size && count <= (size - offset) / sizeof(T);
+}
+
+// undo the percent-encoding of a relative URI, as tinygltf does before opening it
+std::string DecodeUri(std::string_view uri) {
+  std::string path;
+  path.reserve(uri.size());
+  for (size_t i = 0; i < uri.size(); i++) {
+    if (uri[i] == '%' && i + 2 < uri.size() &&
+        std::isxdigit(static_cast<unsigned char>(uri[i + 1])) &&
+        std::isxdigit(static_cast<unsigned char>(uri[i + 2]))) {
+      path += static_cast<char>(std::stoi(std::string(uri.substr(i + 1, 2)), nullptr, 16));
+      i += 2;
+    } else {
+      path += uri[i];
+    }
+  }
+  return path;
+}
+
+/** The external buffers and images a glTF references, data URIs are part of its own bytes. */
+void FindGltfFiles(const char* data, size_t size, bool isBinary, std::vector<std::string>& uris) {
+  if (isBinary) {
+    // header, then the JSON chunk with its length and type
+    uint32_t jsonLength = 0;
+    if (size < 20) {
+      return;
+    }
+    std::memcpy(&jsonLength, data + 12, sizeof(jsonLength));
+    if (!InRange<char>(20, jsonLength, size)) {
+      return;
+    }
+    data += 20;
+    size = jsonLength;
+  }
+  const auto json = nlohmann::json::parse(data, data + size, nullptr, false);
+  if (json.is_discarded()) {
+    return;
+  }
+  for (const auto* array : {"buffers", "images"}) {
+    const auto it = json.find(array);
+    if (it == json.end() || !it->is_array()) {
+      continue;
+    }
+    for (const auto& entry : *it) {
+      const auto uri = entry.find("uri");
+      if (uri != entry.end() && uri->is_string() &&
+          !uri->get_ref<const std::string&>().starts_with("data:")) {
+        uris.push_back(DecodeUri(uri->get_ref<const std::string&>()));
+      }
+    }
+  }
+}
+
+/** The material libraries an OBJ references. */
+void FindObjFiles(const char* data, size_t size, std::vector<std::string>& uris) {
+  constexpr std::string_view Keyword = "mtllib";
+  const std::string_view text(data, size);
+  for (size_t line = 0; line < text.size();) {
+    auto end   = text.find('\n', line);
+    end        = end == std::string_view::npos ? text.size() : end;
+    auto entry = text.substr(line, end - line);
+    if (entry.starts_with(Keyword) && entry.size() > Keyword.size() &&
+        std::isspace(static_cast<unsigned char>(entry[Keyword.size()]))) {
+      entry.remove_prefix(Keyword.size());
+      const auto first = entry.find_first_not_of(" \t");
+      const auto last  = entry.find_last_not_of(" \t\r");
+      if (first != std::string_view::npos) {
+        uris.emplace_back(entry.substr(first, last - first + 1));
+      }
+    }
+    line = end + 1;
+  }
+}
+}  // namespace
+
+uint64_t HashBytes(const void* bytes, size_t size) {
+  const auto* data              = static_cast<const char*>(bytes);
+  constexpr uint64_t Multiplier = 0x9e3779b97f4a7c15ull;
+  uint64_t hash                 = 0xcbf29ce484222325ull ^ size;
+  size_t i                      = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * Multiplier;
+    hash ^= hash >> 32;
+  }
+  for (; i < size; i++) {
+    hash = (hash ^ static_cast<unsigned char>(data[i])) * Multiplier;
+  }
+  return hash ^ (hash >> 29);
+}
+
+bool HashFile(const std::string& path, uint64_t& hash) {
+  MappedFile file(path);
+  if (!file.IsOpen()) {
+    return false;
+  }
+  hash = HashBytes(file.GetData(), file.GetSize());
+  return true;
+}
+
+bool HashModelFiles(const std::string& path, uint64_t& hash) {
+  MappedFile file(path);
+  if (!file.IsOpen()) {
+    return false;
+  }
+  hash = HashBytes(file.GetData(), file.GetSize());
+  std::vector<std::string> uris;
+  const auto extension = std::filesystem::path(path).extension();
+  if (extension == ".gltf" || extension == ".glb") {
+    FindGltfFiles(file.GetData(), file.GetSize(), extension == ".glb", uris);
+  } else if (extension == ".obj") {
+    FindObjFiles(file.GetData(), file.GetSize(), uris);
+  }
+  // the size and write time of each stand in for its contents, reading them would cost as much
+  // as loading without the cache
+  const auto directory = std::filesystem::path(path).parent_path();
+  for (const auto& uri : uris) {
+    std::error_code ec;
+    const auto dependency = directory / uri;
+    const auto size       = std::filesystem::file_size(dependency, ec);
+    const auto time       = std::filesystem::last_write_time(dependency, ec);
+    // a missing file still changes the hash, it may show up later
+    const uint64_t stamp[3] = {hash, ec ? ~0ull : static_cast<uint64_t>(size),
+                               ec ? 0ull : static_cast<uint64_t>(time.time_since_epoch().count())};
+    hash = HashBytes(stamp, sizeof(stamp));
+  }
+  return true;
+}
+
+bool WriteMeshCache(const std::string& path, uint64_t sourceHash, const ModelSource& source) {
+  const auto& meshes   = source.meshes;
+  const auto& textures = source.textures;
+  StringTable strings;
+  MeshCacheHeader header{};
+  header.magic        = MeshCacheMagic;
+  header.version      = MeshCacheVersion;
+  header.sourceHash   = sourceHash;
+  header.numMeshes    = static_cast<uint32_t>(meshes.size());
+  header.numTextures  = static_cast<uint32_t>(textures.size());
+  header.numInstances = static_cast<uint32_t>(source.instances.size());
+  header.aabbMin      = source.aabb.posMin;
+  header.aabbMax      = source.aabb.posMax;
+  header.name         = strings.Add(source.name);
+
+  std::vector<MeshRecord> meshRecords(meshes.size());
+  std::vector<TextureRecord> textureRecords(textures.size());
+  for (size_t i = 0; i < meshes.size(); i++) {
+    const auto& material     = meshes[i].material;
+    auto& record             = meshRecords[i];
+    record.baseColorFactor   = material.baseColorFactor;
+    record.emissiveFactor    = material.emissiveFactor;
+    record.alphaCutoff       = material.alphaCutoff;
+    record.metallicFactor    = material.metallicFactor;
+    record.roughnessFactor   = material.roughnessFactor;
+    record.occlusionStrength = material.occlusionStrength;
+    record.alphaMode         = material.alphaMode;
+    record.name              = strings.Add(material.name);
+    record.numVertices       = static_cast<uint32_t>(meshes[i].GetVertices().size());
+    record.numIndices        = static_cast<uint32_t>(meshes[i].GetIndices().size());
+    for (int c = 0; c < NumPBRComponents; c++) {
+      if (meshes[i].textures[c] >= static_cast<int32_t>(textures.size())) {
+        LOGE("Mesh of {} references a missing texture, not baking it", source.name);
+        return false;
+      }
+      record.textures[c] = meshes[i].textures[c];
+    }
+    record.numLods = static_cast<uint32_t>(std::min<size_t>(meshes[i].lods.size(), MaxMeshLods));
+    std::copy_n(meshes[i].lods.begin(), record.numLods, record.lods);
+    record.numMeshlets  = static_cast<uint32_t>(meshes[i].meshlets.size());
+    record.quantization = meshes[i].quantization;
+  }
+  std::vector<InstanceRecord> instanceRecords(source.instances.size());
+  for (size_t i = 0; i < source.instances.size(); i++) {
+    const auto& instance = source.instances[i];
+    if (instance.mesh >= meshes.size()) {
+      LOGE("Instance of {} references a missing mesh, not baking it", source.name);
+      return false;
+    }
+    instanceRecords[i] = {instance.modelMatrix, instance.aabb.posMin, instance.mesh,
+                          instance.aabb.posMax, 0};
+  }
+  for (size_t i = 0; i < textures.size(); i++) {
+    const auto& texture   = textures[i];
+    auto& record          = textureRecords[i];
+    record.width          = texture.info.width;
+    record.height         = texture.info.height;
+    record.minFilter      = texture.info.minFilter;
+    record.magFilter      = texture.info.magFilter;
+    record.wrapS          = texture.info.wrapS;
+    record.wrapT          = texture.info.wrapT;
+    record.wrapR          = texture.info.wrapR;
+    record.generateMipmap = texture.info.generateMipmap ? 1 : 0;
+    record.path           = strings.Add(texture.path);
+  }
+
+  // header | mesh records | texture records | instance records | strings | aligned blobs
+  uint64_t offset = sizeof(MeshCacheHeader) + meshRecords.size() * sizeof(MeshRecord) +
+                    textureRecords.size() * sizeof(TextureRecord) +
+                    instanceRecords.size() * sizeof(InstanceRecord) + strings.GetData().size();
+  for (size_t i = 0; i < meshes.size(); i++) {
+    meshRecords[i].vertexOffset = AlignUp(offset, BlobAlignment);
+    offset = meshRecords[i].vertexOffset + meshes[i].GetVertices().size_bytes();
+    meshRecords[i].indexOffset = AlignUp(offset, BlobAlignment);
+    offset = meshRecords[i].indexOffset + meshes[i].GetIndices().size_bytes();
+    meshRecords[i].meshletOffset = AlignUp(offset, BlobAlignment);
+    offset = meshRecords[i].meshletOffset + meshes[i].meshlets.size() * sizeof(Meshlet);
+  }
+  for (size_t i = 0; i < textures.size(); i++) {
+    // images with a file of their own are decoded from it again
+    textureRecords[i].pixelOffset = AlignUp(offset, BlobAlignment);
+    textureRecords[i].pixelSize   = textures[i].path.empty() ? textures[i].GetPixels().size() : 0;
+    offset = textureRecords[i].pixelOffset + textureRecords[i].pixelSize;
+  }
+  header.fileSize = offset;
+
+  // write next to the target and rename, so a crash never leaves a truncated cache behind
+  const auto tempPath = path + ".tmp";
+  {
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      LOGE("Failed to create mesh cache {}", tempPath);
+      return false;
+    }
+    uint64_t written = 0;
+    const auto write = [&](const void* data, uint64_t size) {
+      out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+      written += size;
+    };
+    const auto pad = [&](uint64_t target) {
+      static constexpr char Zeros[BlobAlignment]{};
+      write(Zeros, target - written);
+    };
+    write(&header, sizeof(header));
+    write(meshRecords.data(), meshRecords.size() * sizeof(MeshRecord));
+    write(textureRecords.data(), textureRecords.size() * sizeof(TextureRecord));
+    write(instanceRecords.data(), instanceRecords.size() * sizeof(InstanceRecord));
+    write(strings.GetData().data(), strings.GetData().size());
+    for (size_t i = 0; i < meshes.size(); i++) {
+      pad(meshRecords[i].vertexOffset);
+      write(meshes[i].GetVertices().data(), meshes[i].GetVertices().size_bytes());
+      pad(meshRecords[i].indexOffset);
+      write(meshes[i].GetIndices().data(), meshes[i].GetIndices().size_bytes());
+      pad(meshRecords[i].meshletOffset);
+      write(meshes[i].meshlets.data(), meshes[i].meshlets.size() * sizeof(Meshlet));
+    }
+    for (size_t i = 0; i < textures.size(); i++) {
+      pad(textureRecords[i].pixelOffset);
+      write(textures[i].GetPixels().data(), textureRecords[i].pixelSize);
+    }
+    if (!out) {
+      LOGE("Failed to write mesh cache {}", tempPath);
+      return false;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tempPath, path, ec);
+  if (ec) {
+    LOGE("Failed to move mesh cache into place {}: {}", path, ec.message());
+    std::filesystem::remove(tempPath, ec);
+    return false;
+  }
+  return true;
+}
+
+bool ReadMeshCache(const std::string& path, uint64_t sourceHash, ModelSource& source) {
+  if (!std::filesystem::exists(path)) {
+    return false;
+  }
+  auto file = CreateRef<MappedFile>(path);
+  if (!file->IsOpen() || file->GetSize() < sizeof(MeshCacheHeader)) {
+    return false;
+  }
+  const char* data    = file->GetData();
+  const uint64_t size = file->GetSize();
+  MeshCacheHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (header.magic != MeshCacheMagic || header.version != MeshCacheVersion) {
+    LOGW("Ignoring mesh cache {} with unknown format", path);
+    return false;
+  }
+  if (header.sourceHash != sourceHash) {
+    LOGI("Mesh cache {} is stale", path);
+    return false;
+  }
+  const uint64_t textureTableOffset = sizeof(header) + header.numMeshes * sizeof(MeshRecord);
+  const uint64_t instanceTableOffset =
+      textureTableOffset + header.numTextures * sizeof(TextureRecord);
+  const uint64_t stringsOffset =
+      instanceTableOffset + header.numInstances * sizeof(InstanceRecord);
+  if (header.fileSize != size ||
+      !InRange<MeshRecord>(sizeof(header), header.numMeshes, size) ||
+      !InRange<TextureRecord>(textureTableOffset, header.numTextures, size) ||
+      !InRange<InstanceRecord>(instanceTableOffset, header.numInstances, size) ||
+      stringsOffset > size) {
+    LOGW("Ignoring truncated mesh cache {}", path);
+    return false;
+  }
+  const std::span meshRecords{reinterpret_cast<const MeshRecord*>(data + sizeof(header)),
+                              header.numMeshes};
+  const std::span textureRecords{
+      reinterpret_cast<const TextureRecord*>(data + textureTableOffset), header.numTextures};
+  const std::span instanceRecords{
+      reinterpret_cast<const InstanceRecord*>(data + instanceTableOffset), header.numInstances};
+  bool valid             = true;
+  const auto read_string = [&](StringRef ref) {
+    if (!InRange<char>(stringsOffset + ref.offset, ref.length, size)) {
+      valid = false;
+      return std::string();
+    }
+    return std::string(data + stringsOffset + ref.offset, ref.length);
+  };
+
+  ModelSource result;
+  result.textures.reserve(textureRecords.size());
+  for (const auto& record : textureRecords) {
+    auto& texture               = result.textures.emplace_back();
+    texture.info.width          = record.width;
+    texture.info.height         = record.height;
+    texture.info.minFilter      = record.minFilter;
+    texture.info.magFilter      = record.magFilter;
+    texture.info.wrapS          = record.wrapS;
+    texture.info.wrapT          = record.wrapT;
+    texture.info.wrapR          = record.wrapR;
+    texture.info.generateMipmap = record.generateMipmap != 0;
+    texture.path                = read_string(record.path);
+    if (!texture.path.empty()) {
+      continue;
+    }
+    if (!InRange<char>(record.pixelOffset, record.pixelSize, size) ||
+        record.pixelSize != static_cast<uint64_t>(record.width) * record.height * 4) {
+      valid = false;
+      break;
+    }
+    texture.mappedPixels = {reinterpret_cast<const unsigned char*>(data + record.pixelOffset),
+                            record.pixelSize};
+  }
+
+  result.meshes.reserve(meshRecords.size());
+  for (const auto& record : meshRecords) {
+    if (!InRange<PackedVertex>(record.vertexOffset, record.numVertices, size) ||
+        !InRange<uint32_t>(record.indexOffset, record.numIndices, size) ||
+        !InRange<Meshlet>(record.meshletOffset, record.numMeshlets, size) ||
+        record.vertexOffset % BlobAlignment != 0 || record.indexOffset % BlobAlignment != 0 ||
+        record.meshletOffset % BlobAlignment != 0 || record.numLods > MaxMeshLods) {
+      valid = false;
+      break;
+    }
+    auto& mesh          = result.meshes.emplace_back();
+    mesh.mappedVertices = {reinterpret_cast<const PackedVertex*>(data + record.vertexOffset),
+                           record.numVertices};
+    mesh.quantization   = record.quantization;
+    mesh.mappedIndices  = {reinterpret_cast<const uint32_t*>(data + record.indexOffset),
+                           record.numIndices};
+    const auto in_indices = [&](uint32_t first, uint32_t count) {
+      return first <= record.numIndices && count <= record.numIndices - first;
+    };
+    mesh.lods.assign(record.lods, record.lods + record.numLods);
+    for (const auto& lod : mesh.lods) {
+      valid &= in_indices(lod.firstIndex, lod.numIndices);
+    }
+    const auto* meshlets = reinterpret_cast<const Meshlet*>(data + record.meshletOffset);
+    mesh.meshlets.assign(meshlets, meshlets + record.numMeshlets);
+    for (const auto& meshlet : mesh.meshlets) {
+      valid &= in_indices(meshlet.firstIndex, meshlet.numIndices);
+    }
+    mesh.material.baseColorFactor   = record.baseColorFactor;
+    mesh.material.emissiveFactor    = record.emissiveFactor;
+    mesh.material.alphaCutoff       = record.alphaCutoff;
+    mesh.material.metallicFactor    = record.metallicFactor;
+    mesh.material.roughnessFactor   = record.roughnessFactor;
+    mesh.material.occlusionStrength = record.occlusionStrength;
+    mesh.material.alphaMode         = record.alphaMode;
+    mesh.material.name              = read_string(record.name);
+    for (int c = 0; c < NumPBRComponents; c++) {
+      if (record.textures[c] >= static_cast<int32_t>(textureRecords.size())) {
+        valid = false;
+        break;
+      }
+      mesh.textures[c] = std::max(record.textures[c], -1);
+    }
+  }
+  result.instances.reserve(instanceRecords.size());
+  for (const auto& record : instanceRecords) {
+    valid &= record.mesh < meshRecords.size();
+    result.instances.push_back(
+        {record.mesh, record.modelMatrix, AABB{record.aabbMin, record.aabbMax}});
+  }
+  result.name = read_string(header.name);
+  if (!valid) {
+    LOGW("Ignoring corrupt mesh cache {}", path);
+    return false;
+  }
+  result.aabb    = {header.aabbMin, header.aabbMax};
+  result.mapping = std::move(file);
+  source         = std::move(result);
+  return true;
+}
+}  // namespace photon::util
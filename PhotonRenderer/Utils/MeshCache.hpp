@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "ModelSource.hpp"
+
+namespace photon::util {
+/** Fast non-cryptographic 64-bit hash, good enough to tell baked data apart. */
+uint64_t HashBytes(const void* data, size_t size);
+
+/** Hash of the file contents, used to tell whether a baked cache is stale. */
+bool HashFile(const std::string& path, uint64_t& hash);
+
+/**
+ * Hash of a model file folded with the size and write time of the files it references: the
+ * external buffers and images of a glTF, the material libraries of an OBJ. Editing any of them
+ * makes a cache baked from the model stale.
+ */
+bool HashModelFiles(const std::string& path, uint64_t& hash);
+
+/** Write vertex/index blobs, mesh instances, materials, texture references and bounds. */
+bool WriteMeshCache(const std::string& path, uint64_t sourceHash, const ModelSource& source);
+
+/**
+ * Map a baked cache and describe it in source, with vertices, indices and embedded pixels viewed
+ * straight from the mapping. Textures with a file of their own are left for the caller to decode.
+ * Returns false when the file is missing, malformed or was baked from a different source hash.
+ */
+bool ReadMeshCache(const std::string& path, uint64_t sourceHash, ModelSource& source);
+}  // namespace photon::util
@@ -0,0 +1,350 @@
+#include "MeshOptimizer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <glm/glm.hpp>
+#include "ScratchArena.hpp"
+
+namespace photon::util {
+namespace {
+constexpr uint32_t InvalidIndex = ~0u;
+// what the optimizer assumes of the hardware, small enough to fit every GPU it runs on
+constexpr uint32_t CacheSize     = 16;
+constexpr int OverdrawResolution = 256;
+
+// FIFO cache on time stamps: a vertex is still cached while fewer than cacheSize misses followed
+struct FifoCache {
+  FifoCache(ScratchArena& scratch, size_t numVertices, uint32_t cacheSize)
+      : cacheSize(cacheSize),
+        time(cacheSize + 1),
+        timestamps(scratch.Vector<uint32_t>(numVertices, 0u)) {}
+
+  bool Access(uint32_t vertex) {
+    if (time - timestamps[vertex] > cacheSize) {
+      timestamps[vertex] = time++;
+      return true;
+    }
+    return false;
+  }
+
+  void Flush() { time += cacheSize + 1; }
+
+  uint32_t cacheSize;
+  uint32_t time;
+  std::vector<uint32_t>& timestamps;
+};
+
+float Edge(const glm::vec3& a, const glm::vec3& b, float x, float y) {
+  return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+void RasterizeView(const std::vector<glm::vec3>& points, const std::vector<uint32_t>& indices,
+                   std::vector<float>& depth, OverdrawStats& stats) {
+  std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::max());
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    const auto& a    = points[indices[i]];
+    const auto& b    = points[indices[i + 1]];
+    const auto& c    = points[indices[i + 2]];
+    const float area = Edge(a, b, c.x, c.y);
+    if (area <= 0.0f) {
+      // back facing or degenerate, culled
+      continue;
+    }
+    const int minX = std::max(static_cast<int>(std::min({a.x, b.x, c.x})), 0);
+    const int minY = std::max(static_cast<int>(std::min({a.y, b.y, c.y})), 0);
+    const int maxX = std::min(static_cast<int>(std::max({a.x, b.x, c.x})), OverdrawResolution - 1);
+    const int maxY = std::min(static_cast<int>(std::max({a.y, b.y, c.y})), OverdrawResolution - 1);
+    for (int y = minY; y <= maxY; y++) {
+      for (int x = minX; x <= maxX; x++) {
+        const float px = static_cast<float>(x) + 0.5f, py = static_cast<float>(y) + 0.5f;
+        const float wa = Edge(b, c, px, py), wb = Edge(c, a, px, py), wc = Edge(a, b, px, py);
+        if (wa < 0.0f || wb < 0.0f || wc < 0.0f) {
+          continue;
+        }
+        const float z = (wa * a.z + wb * b.z + wc * c.z) / area;
+        auto& stored  = depth[static_cast<size_t>(y) * OverdrawResolution + x];
+        if (z < stored) {
+          stored = z;
+          stats.numShaded++;
+        }
+      }
+    }
+  }
+  for (const auto value : depth) {
+    stats.numCovered += value != std::numeric_limits<float>::max();
+  }
+}
+}  // namespace
+
+float VertexCacheStats::GetACMR() const {
+  return numTriangles > 0 ? static_cast<float>(numTransforms) / static_cast<float>(numTriangles)
+                          : 0.0f;
+}
+
+float VertexCacheStats::GetATVR() const {
+  return numVertices > 0 ? static_cast<float>(numTransforms) / static_cast<float>(numVertices)
+                         : 0.0f;
+}
+
+float OverdrawStats::GetOverdraw() const {
+  return numCovered > 0 ? static_cast<float>(numShaded) / static_cast<float>(numCovered) : 0.0f;
+}
+
+VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t numVertices,
+                                    uint32_t cacheSize) {
+  VertexCacheStats stats;
+  stats.numTriangles = indices.size() / 3;
+  ScratchArena scratch;
+  FifoCache cache(scratch, numVertices, cacheSize);
+  auto& referenced = scratch.Vector<char>(numVertices, 0);
+  for (const auto index : indices) {
+    stats.numTransforms += cache.Access(index);
+    stats.numVertices += referenced[index] == 0;
+    referenced[index] = 1;
+  }
+  return stats;
+}
+
+OverdrawStats AnalyzeOverdraw(const std::vector<Vertex>& vertices,
+                              const std::vector<uint32_t>& indices) {
+  OverdrawStats stats;
+  if (vertices.empty()) {
+    return stats;
+  }
+  glm::vec3 posMin = vertices.front().position, posMax = posMin;
+  for (const auto& vertex : vertices) {
+    posMin = glm::min(posMin, vertex.position);
+    posMax = glm::max(posMax, vertex.position);
+  }
+  const auto extent = posMax - posMin;
+  const float scale = static_cast<float>(OverdrawResolution - 1) /
+                      std::max({extent.x, extent.y, extent.z, 1e-20f});
+
+  ScratchArena scratch;
+  auto& points = scratch.Vector<glm::vec3>(vertices.size(), glm::vec3(0.0f));
+  auto& depth  = scratch.Vector<float>(static_cast<size_t>(OverdrawResolution) * OverdrawResolution,
+                                      0.0f);
+  for (int axis = 0; axis < 3; axis++) {
+    // (u, v, axis) is right handed, so counter-clockwise stays front facing from either side
+    const int u = (axis + 1) % 3;
+    const int v = (axis + 2) % 3;
+    for (const float side : {1.0f, -1.0f}) {
+      for (size_t i = 0; i < vertices.size(); i++) {
+        const auto position = (vertices[i].position - posMin) * scale;
+        points[i]           = side > 0.0f ? glm::vec3(position[u], position[v], -position[axis])
+                                          : glm::vec3(position[v], position[u], position[axis]);
+      }
+      RasterizeView(points, indices, depth, stats);
+    }
+  }
+  return stats;
+}
+
+void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t numVertices,
+                         std::vector<uint32_t>& clusterStarts) {
+  clusterStarts.assign(1, 0);
+  const size_t numTriangles = indices.size() / 3;
+  if (numTriangles == 0) {
+    return;
+  }
+  ScratchArena scratch;
+  // the triangles around each vertex, in compressed rows
+  auto& offsets = scratch.Vector<uint32_t>(numVertices + 1, 0u);
+  for (const auto index : indices) {
+    offsets[index + 1]++;
+  }
+  for (size_t v = 0; v < numVertices; v++) {
+    offsets[v + 1] += offsets[v];
+  }
+  auto& adjacency = scratch.Vector<uint32_t>(indices.size(), 0u);
+  auto& live      = scratch.Vector<uint32_t>(numVertices, 0u);
+  auto& fill      = scratch.Vector<uint32_t>(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < indices.size(); i++) {
+    adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+  }
+  for (size_t v = 0; v < numVertices; v++) {
+    live[v] = offsets[v + 1] - offsets[v];
+  }
+
+  FifoCache cache(scratch, numVertices, CacheSize);
+  auto& emitted    = scratch.Vector<char>(numTriangles, 0);
+  auto& deadEnds   = scratch.Vector<uint32_t>();
+  auto& candidates = scratch.Vector<uint32_t>();
+  auto& ordered    = scratch.Vector<uint32_t>();
+  deadEnds.reserve(indices.size());
+  ordered.reserve(indices.size());
+  uint32_t cursor = 0;
+  uint32_t fan    = indices.front();
+  while (fan != InvalidIndex) {
+    // emit every triangle left around the fanning vertex
+    candidates.clear();
+    for (auto i = offsets[fan]; i < offsets[fan + 1]; i++) {
+      const auto triangle = adjacency[i];
+      if (emitted[triangle]) {
+        continue;
+      }
+      emitted[triangle] = 1;
+      for (int k = 0; k < 3; k++) {
+        const auto vertex = indices[triangle * 3 + k];
+        ordered.push_back(vertex);
+        deadEnds.push_back(vertex);
+        candidates.push_back(vertex);
+        live[vertex]--;
+        cache.Access(vertex);
+      }
+    }
+    // continue with the oldest candidate that stays cached while its own triangles are emitted
+    uint32_t next = InvalidIndex;
+    int64_t best  = -1;
+    for (const auto vertex : candidates) {
+      if (live[vertex] == 0) {
+        continue;
+      }
+      const int64_t age      = cache.time - cache.timestamps[vertex];
+      const int64_t priority = age + 2 * live[vertex] <= CacheSize ? age : 0;
+      if (priority > best) {
+        best = priority;
+        next = vertex;
+      }
+    }
+    if (next == InvalidIndex) {
+      // dead end: the most recent vertex with triangles left, else the next one in order
+      while (!deadEnds.empty() && next == InvalidIndex) {
+        const auto vertex = deadEnds.back();
+        deadEnds.pop_back();
+        next = live[vertex] > 0 ? vertex : InvalidIndex;
+      }
+      while (next == InvalidIndex && cursor < numVertices) {
+        next = live[cursor] > 0 ? cursor : InvalidIndex;
+        cursor += next == InvalidIndex;
+      }
+      const auto numOrdered = static_cast<uint32_t>(ordered.size() / 3);
+      if (next != InvalidIndex && numOrdered > clusterStarts.back()) {
+        clusterStarts.push_back(numOrdered);
+      }
+    }
+    fan = next;
+  }
+  // copied back, so the capacity reserved for the levels of detail stays
+  std::copy(ordered.begin(), ordered.end(), indices.begin());
+}
+
+void OptimizeOverdraw(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                      const std::vector<uint32_t>& clusterStarts, float threshold) {
+  const auto numTriangles = static_cast<uint32_t>(indices.size() / 3);
+  if (numTriangles == 0 || clusterStarts.empty()) {
+    return;
+  }
+  ScratchArena scratch;
+  FifoCache cache(scratch, vertices.size(), CacheSize);
+  const auto count_misses = [&](uint32_t triangle) {
+    uint32_t misses = 0;
+    for (int k = 0; k < 3; k++) {
+      misses += cache.Access(indices[triangle * 3 + k]);
+    }
+    return misses;
+  };
+  // a new cluster wherever the misses so far are close to what the whole cluster averages
+  auto& starts = scratch.Vector<uint32_t>();
+  for (size_t c = 0; c < clusterStarts.size(); c++) {
+    const auto begin = clusterStarts[c];
+    const auto end   = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : numTriangles;
+    uint32_t misses  = 0;
+    cache.Flush();
+    for (auto t = begin; t < end; t++) {
+      misses += count_misses(t);
+    }
+    const float clusterThreshold =
+        threshold * static_cast<float>(misses) / static_cast<float>(end - begin);
+    starts.push_back(begin);
+    auto start = begin;
+    misses     = 0;
+    cache.Flush();
+    for (auto t = begin; t < end; t++) {
+      misses += count_misses(t);
+      if (t + 1 < end &&
+          static_cast<float>(misses) / static_cast<float>(t + 1 - start) <= clusterThreshold) {
+        starts.push_back(t + 1);
+        start  = t + 1;
+        misses = 0;
+        cache.Flush();
+      }
+    }
+  }
+
+  // clusters facing away from the center of the mesh are in front of the others more often
+  struct Cluster {
+    uint32_t begin;
+    uint32_t end;
+    float sortKey;
+  };
+  auto& clusters  = scratch.Vector<Cluster>();
+  auto& centroids = scratch.Vector<glm::vec3>();
+  auto& normals   = scratch.Vector<glm::vec3>();
+  glm::vec3 meshCentroid(0.0f);
+  float meshArea = 0.0f;
+  for (size_t c = 0; c < starts.size(); c++) {
+    const auto end = c + 1 < starts.size() ? starts[c + 1] : numTriangles;
+    glm::vec3 centroid(0.0f), normal(0.0f);
+    float area = 0.0f;
+    for (auto t = starts[c]; t < end; t++) {
+      const auto& p0        = vertices[indices[t * 3]].position;
+      const auto& p1        = vertices[indices[t * 3 + 1]].position;
+      const auto& p2        = vertices[indices[t * 3 + 2]].position;
+      const auto areaNormal = glm::cross(p1 - p0, p2 - p0);
+      const float weight    = glm::length(areaNormal);
+      centroid += (p0 + p1 + p2) * (weight / 3.0f);
+      normal += areaNormal;
+      area += weight;
+    }
+    meshCentroid += centroid;
+    meshArea += area;
+    clusters.push_back({starts[c], end, 0.0f});
+    centroids.push_back(area > 0.0f ? centroid / area : centroid);
+    normals.push_back(normal);
+  }
+  meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+  for (size_t c = 0; c < clusters.size(); c++) {
+    const float length  = glm::length(normals[c]);
+    clusters[c].sortKey = length > 0.0f
+                              ? glm::dot(centroids[c] - meshCentroid, normals[c] / length)
+                              : 0.0f;
+  }
+  std::stable_sort(clusters.begin(), clusters.end(),
+                   [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+  auto& ordered = scratch.Vector<uint32_t>();
+  ordered.reserve(indices.size());
+  for (const auto& cluster : clusters) {
+    ordered.insert(ordered.end(), indices.begin() + cluster.begin * 3,
+                   indices.begin() + cluster.end * 3);
+  }
+  std::copy(ordered.begin(), ordered.end(), indices.begin());
+}
+
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+  ScratchArena scratch;
+  auto& remap   = scratch.Vector<uint32_t>(vertices.size(), InvalidIndex);
+  auto& ordered = scratch.Vector<Vertex>();
+  ordered.reserve(vertices.size());
+  for (auto& index : indices) {
+    if (remap[index] == InvalidIndex) {
+      remap[index] = static_cast<uint32_t>(ordered.size());
+      ordered.push_back(vertices[index]);
+    }
+    index = remap[index];
+  }
+  vertices.assign(ordered.begin(), ordered.end());
+}
+
+void OptimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+  if (indices.empty() || indices.size() % 3 != 0) {
+    return;
+  }
+  ScratchArena scratch;
+  auto& clusterStarts = scratch.Vector<uint32_t>();
+  OptimizeVertexCache(indices, vertices.size(), clusterStarts);
+  OptimizeOverdraw(vertices, indices, clusterStarts);
+  OptimizeVertexFetch(vertices, indices);
+}
+}  // namespace photon::util
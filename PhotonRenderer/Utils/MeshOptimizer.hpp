@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Renderer/Vertex.hpp"
+
+namespace photon::util {
+/** Post-transform vertex cache behaviour of a triangle list, simulated with a FIFO cache. */
+struct VertexCacheStats {
+  uint64_t numTriangles{0};
+  uint64_t numVertices{0};
+  // cache misses, each one a vertex shader invocation
+  uint64_t numTransforms{0};
+
+  /** Vertices shaded per triangle, 3 without any reuse and about 0.5 at best. */
+  [[nodiscard]] float GetACMR() const;
+  /** Vertices shaded per vertex referenced, 1 at best. */
+  [[nodiscard]] float GetATVR() const;
+};
+
+/** Fragments passing the depth test per covered pixel, 1 when nothing is shaded twice. */
+struct OverdrawStats {
+  uint64_t numCovered{0};
+  uint64_t numShaded{0};
+
+  [[nodiscard]] float GetOverdraw() const;
+};
+
+/** Simulate drawing indices through a FIFO cache of cacheSize vertices. */
+VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t numVertices,
+                                    uint32_t cacheSize = 16);
+
+/**
+ * Rasterize indices into six orthographic views along the axes of its bounds, with backface
+ * culling and a depth test, the way the renderer draws opaque meshes.
+ */
+OverdrawStats AnalyzeOverdraw(const std::vector<Vertex>& vertices,
+                              const std::vector<uint32_t>& indices);
+
+/**
+ * Reorder triangles for the post-transform vertex cache with Tipsify (Sander et al. 2007).
+ * clusterStarts receives the first triangle of each run that began at a dead end.
+ */
+void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t numVertices,
+                         std::vector<uint32_t>& clusterStarts);
+
+/**
+ * Split the clusters where the cache would barely notice, at most threshold times the misses of
+ * their cluster, and draw the ones facing away from the center first so they occlude the rest.
+ */
+void OptimizeOverdraw(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                      const std::vector<uint32_t>& clusterStarts, float threshold = 1.05f);
+
+/** Store vertices in the order they are first drawn, unreferenced ones are dropped. */
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+/**
+ * Run the three passes above on a welded triangle list. Deterministic, so baked caches of the
+ * same source stay byte identical. Measuring the gain is left to the benchmark, the analyses cost
+ * more than the passes.
+ */
+void OptimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+}  // namespace photon::util
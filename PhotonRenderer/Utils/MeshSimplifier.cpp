@@ -0,0 +1,597 @@
+#include "MeshSimplifier.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <glm/glm.hpp>
+#include "MeshOptimizer.hpp"
+#include "ScratchArena.hpp"
+
+namespace photon::util {
+namespace {
+constexpr uint32_t InvalidIndex = ~0u;
+// share of the full triangle count each simplified level aims for
+constexpr std::array<float, MaxMeshLods - 1> LodRatios{0.5f, 0.25f, 0.1f};
+// a level keeping more than this share of the one before is not worth its indices
+constexpr float MaxLodShare      = 0.85f;
+constexpr size_t MinLodTriangles = 32;
+// how much harder borders and seams resist leaving their line than surfaces leaving their plane
+constexpr double BoundaryWeight = 10.0;
+
+enum class VertexKind : uint8_t {
+  // inside the surface, free to collapse onto any neighbour
+  Manifold,
+  // on an open edge, only collapses along it
+  Border,
+  // one of the two vertices splitting attributes at a position, collapses with its twin
+  Seam,
+  // corners, junctions of several seams and anything non-manifold
+  Locked,
+};
+
+// squared distances to a set of weighted planes, the upper half of a symmetric 4x4 matrix
+struct Quadric {
+  double a00{0.0}, a11{0.0}, a22{0.0}, a01{0.0}, a02{0.0}, a12{0.0};
+  double b0{0.0}, b1{0.0}, b2{0.0};
+  double c{0.0};
+  double weight{0.0};
+
+  void AddPlane(const glm::dvec3& n, double d, double w) {
+    a00 += w * n.x * n.x;
+    a11 += w * n.y * n.y;
+    a22 += w * n.z * n.z;
+    a01 += w * n.x * n.y;
+    a02 += w * n.x * n.z;
+    a12 += w * n.y * n.z;
+    b0 += w * n.x * d;
+    b1 += w * n.y * d;
+    b2 += w * n.z * d;
+    c += w * d * d;
+    weight += w;
+  }
+
+  Quadric& operator+=(const Quadric& other) {
+    a00 += other.a00;
+    a11 += other.a11;
+    a22 += other.a22;
+    a01 += other.a01;
+    a02 += other.a02;
+    a12 += other.a12;
+    b0 += other.b0;
+    b1 += other.b1;
+    b2 += other.b2;
+    c += other.c;
+    weight += other.weight;
+    return *this;
+  }
+
+  // mean squared distance of p to the planes
+  [[nodiscard]] double Evaluate(const glm::dvec3& p) const {
+    const double rx    = a00 * p.x + a01 * p.y + a02 * p.z;
+    const double ry    = a01 * p.x + a11 * p.y + a12 * p.z;
+    const double rz    = a02 * p.x + a12 * p.y + a22 * p.z;
+    const double error =
+        p.x * rx + p.y * ry + p.z * rz + 2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+    return weight > 0.0 ? std::abs(error) / weight : 0.0;
+  }
+};
+
+// closest point on a triangle to p, after Ericson's Real-Time Collision Detection 5.1.5
+double SquaredDistanceToTriangle(const glm::dvec3& p, const glm::dvec3& a, const glm::dvec3& b,
+                                 const glm::dvec3& c) {
+  const auto ab = b - a, ac = c - a, ap = p - a;
+  const double d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+  const auto squared = [&](const glm::dvec3& q) { return glm::dot(p - q, p - q); };
+  if (d1 <= 0.0 && d2 <= 0.0) {
+    return squared(a);
+  }
+  const auto bp   = p - b;
+  const double d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+  if (d3 >= 0.0 && d4 <= d3) {
+    return squared(b);
+  }
+  const double vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) {
+    return squared(a + ab * (d1 / (d1 - d3)));
+  }
+  const auto cp   = p - c;
+  const double d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+  if (d6 >= 0.0 && d5 <= d6) {
+    return squared(c);
+  }
+  const double vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) {
+    return squared(a + ac * (d2 / (d2 - d6)));
+  }
+  const double va = d3 * d6 - d5 * d4;
+  if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0) {
+    return squared(b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))));
+  }
+  const double denominator = va + vb + vc;
+  if (denominator <= 0.0) {
+    // degenerate, the nearest corner will do
+    return std::min({squared(a), squared(b), squared(c)});
+  }
+  return squared(a + ab * (vb / denominator) + ac * (vc / denominator));
+}
+
+// corners around every vertex of a triangle list: the edge leaving it and the triangle it is in
+struct Adjacency {
+  explicit Adjacency(ScratchArena& scratch)
+      : offsets(scratch.Vector<uint32_t>()),
+        edges(scratch.Vector<uint32_t>()),
+        triangles(scratch.Vector<uint32_t>()),
+        cursor(scratch.Vector<uint32_t>()) {}
+
+  void Build(std::span<const uint32_t> indices, size_t numVertices) {
+    offsets.assign(numVertices + 1, 0);
+    for (const auto index : indices) {
+      offsets[index + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    edges.resize(indices.size());
+    triangles.resize(indices.size());
+    cursor.assign(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++) {
+      const auto slot = cursor[indices[i]]++;
+      edges[slot]     = indices[i - i % 3 + (i + 1) % 3];
+      triangles[slot] = static_cast<uint32_t>(i / 3);
+    }
+  }
+
+  [[nodiscard]] std::span<const uint32_t> GetEdges(uint32_t vertex) const {
+    return {edges.data() + offsets[vertex], offsets[vertex + 1] - offsets[vertex]};
+  }
+  [[nodiscard]] std::span<const uint32_t> GetTriangles(uint32_t vertex) const {
+    return {triangles.data() + offsets[vertex], offsets[vertex + 1] - offsets[vertex]};
+  }
+  [[nodiscard]] bool IsReferenced(uint32_t vertex) const {
+    return offsets[vertex + 1] > offsets[vertex];
+  }
+  [[nodiscard]] bool HasEdge(uint32_t from, uint32_t to) const {
+    const auto outgoing = GetEdges(from);
+    return std::find(outgoing.begin(), outgoing.end(), to) != outgoing.end();
+  }
+
+  std::vector<uint32_t>& offsets;
+  std::vector<uint32_t>& edges;
+  std::vector<uint32_t>& triangles;
+  // next free slot of every vertex while building
+  std::vector<uint32_t>& cursor;
+};
+
+class Simplifier {
+public:
+  Simplifier(const std::vector<Vertex>& vertices, std::span<const uint32_t> indices)
+      : m_indices(m_scratch.Vector<uint32_t>(indices.begin(), indices.end())) {
+    const auto numVertices = vertices.size();
+    glm::vec3 posMin(std::numeric_limits<float>::max());
+    glm::vec3 posMax(std::numeric_limits<float>::lowest());
+    for (const auto& vertex : vertices) {
+      posMin = glm::min(posMin, vertex.position);
+      posMax = glm::max(posMax, vertex.position);
+    }
+    // errors are measured in the unit cube, then scaled back
+    const auto extent = posMax - posMin;
+    m_extent          = std::max({extent.x, extent.y, extent.z});
+    if (m_extent <= 0.0f) {
+      m_extent = 1.0f;
+    }
+    m_positions.resize(numVertices);
+    for (size_t i = 0; i < numVertices; i++) {
+      m_positions[i] = glm::dvec3(vertices[i].position - posMin) / static_cast<double>(m_extent);
+    }
+    // vertices at one position differ in their attributes, link them in a ring
+    auto& order = m_scratch.Vector<uint32_t>(numVertices, 0u);
+    std::iota(order.begin(), order.end(), 0u);
+    const auto position_less = [&](uint32_t a, uint32_t b) {
+      const auto &pa = vertices[a].position, &pb = vertices[b].position;
+      return std::tie(pa.x, pa.y, pa.z) < std::tie(pb.x, pb.y, pb.z);
+    };
+    std::stable_sort(order.begin(), order.end(), position_less);
+    m_remap.resize(numVertices);
+    m_wedge.resize(numVertices);
+    for (size_t first = 0; first < numVertices;) {
+      size_t last = first + 1;
+      while (last < numVertices && !position_less(order[first], order[last])) {
+        last++;
+      }
+      for (size_t i = first; i < last; i++) {
+        m_remap[order[i]] = order[first];
+        m_wedge[order[i]] = order[i + 1 < last ? i + 1 : first];
+      }
+      first = last;
+    }
+    m_adjacency.Build(m_indices, numVertices);
+    ComputeQuadrics();
+    m_collapsedTo.resize(numVertices);
+    std::iota(m_collapsedTo.begin(), m_collapsedTo.end(), 0u);
+    for (uint32_t v = 0; v < numVertices; v++) {
+      if (m_adjacency.IsReferenced(v)) {
+        m_sources.push_back(v);
+      }
+    }
+  }
+
+  /** Collapse edges that do not touch each other, false once none can go. */
+  bool CollapsePass(size_t targetIndices) {
+    const auto numVertices = m_positions.size();
+    Classify();
+    auto& collapses = m_collapses;
+    collapses.clear();
+    for (size_t i = 0; i < m_indices.size(); i++) {
+      const auto a = m_indices[i];
+      const auto b = m_indices[i - i % 3 + (i + 1) % 3];
+      // inner edges are seen from both triangles, take them once
+      if (a > b && m_adjacency.HasEdge(b, a)) {
+        continue;
+      }
+      Collapse best{InvalidIndex, InvalidIndex, std::numeric_limits<double>::max()};
+      for (const auto& [v0, v1] : {std::pair{a, b}, std::pair{b, a}}) {
+        if (CanCollapse(v0, v1)) {
+          const auto error = GetCollapseError(v0, v1);
+          if (error < best.error) {
+            best = {v0, v1, error};
+          }
+        }
+      }
+      if (best.v0 != InvalidIndex) {
+        collapses.push_back(best);
+      }
+    }
+    std::stable_sort(collapses.begin(), collapses.end(),
+                     [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+    const auto numTriangles    = m_indices.size() / 3;
+    const auto targetTriangles = targetIndices / 3;
+    auto& collapseRemap = m_collapseRemap;
+    collapseRemap.resize(numVertices);
+    std::iota(collapseRemap.begin(), collapseRemap.end(), 0u);
+    auto& touched = m_touched;
+    touched.assign(numVertices, 0);
+    size_t numRemoved = 0, numApplied = 0;
+    for (const auto& collapse : collapses) {
+      if (numTriangles - std::min(numRemoved, numTriangles) <= targetTriangles) {
+        break;
+      }
+      const auto v0 = collapse.v0, v1 = collapse.v1;
+      if (touched[m_remap[v0]] || touched[m_remap[v1]] || !KeepsOrientation(v0, v1)) {
+        continue;
+      }
+      collapseRemap[v0] = v1;
+      if (m_kinds[v0] == VertexKind::Seam) {
+        collapseRemap[m_twins[v0]] = m_twins[v1];
+      }
+      m_quadrics[m_remap[v1]] += m_quadrics[m_remap[v0]];
+      // the fan of v0 changes shape, so its neighbours wait for the next pass
+      ForEachWedge(v0, [&](uint32_t wedge) {
+        for (const auto triangle : m_adjacency.GetTriangles(wedge)) {
+          for (int corner = 0; corner < 3; corner++) {
+            touched[m_remap[m_indices[triangle * 3 + corner]]] = 1;
+          }
+        }
+      });
+      numRemoved += m_kinds[v0] == VertexKind::Border ? 1 : 2;
+      numApplied++;
+    }
+    if (numApplied == 0) {
+      return false;
+    }
+    // a vertex of v0 never takes part in the same pass as v1, so one lookup follows the chain
+    for (auto& target : m_collapsedTo) {
+      target = collapseRemap[target];
+    }
+    size_t count = 0;
+    for (size_t i = 0; i + 2 < m_indices.size(); i += 3) {
+      const auto a = collapseRemap[m_indices[i]];
+      const auto b = collapseRemap[m_indices[i + 1]];
+      const auto c = collapseRemap[m_indices[i + 2]];
+      if (m_remap[a] == m_remap[b] || m_remap[b] == m_remap[c] || m_remap[c] == m_remap[a]) {
+        continue;
+      }
+      m_indices[count++] = a;
+      m_indices[count++] = b;
+      m_indices[count++] = c;
+    }
+    m_indices.resize(count);
+    m_adjacency.Build(m_indices, numVertices);
+    return true;
+  }
+
+  [[nodiscard]] size_t GetNumIndices() const { return m_indices.size(); }
+  [[nodiscard]] std::span<const uint32_t> GetIndices() const { return m_indices; }
+  /**
+   * Farthest a vertex of the source strays from the simplified surface, in model units. Each is
+   * measured against the triangles around the vertex it collapsed into, which are no nearer than
+   * the closest part of the surface, so the error is never underestimated. Quadric errors are
+   * averages over the planes and only order the collapses.
+   */
+  [[nodiscard]] float MeasureError() const {
+    double maxDistance = 0.0;
+    for (const auto source : m_sources) {
+      const auto& point = m_positions[source];
+      double distance   = std::numeric_limits<double>::max();
+      ForEachWedge(m_collapsedTo[source], [&](uint32_t wedge) {
+        for (const auto triangle : m_adjacency.GetTriangles(wedge)) {
+          const auto* corners = &m_indices[triangle * 3];
+          distance            = std::min(distance, SquaredDistanceToTriangle(
+                                                       point, m_positions[corners[0]],
+                                                       m_positions[corners[1]],
+                                                       m_positions[corners[2]]));
+        }
+      });
+      // vertices whose fan went away entirely are only near some other part of the surface
+      if (distance < std::numeric_limits<double>::max()) {
+        maxDistance = std::max(maxDistance, distance);
+      }
+    }
+    return static_cast<float>(std::sqrt(maxDistance)) * m_extent;
+  }
+
+private:
+  struct Collapse {
+    uint32_t v0;
+    uint32_t v1;
+    double error;
+  };
+
+  template <typename Func>
+  void ForEachWedge(uint32_t vertex, Func&& func) const {
+    auto wedge = vertex;
+    do {
+      if (m_adjacency.IsReferenced(wedge)) {
+        func(wedge);
+      }
+      wedge = m_wedge[wedge];
+    } while (wedge != vertex);
+  }
+
+  // whether some vertex at the position of from has an edge to the position of to
+  [[nodiscard]] bool HasPositionEdge(uint32_t from, uint32_t to) const {
+    bool found = false;
+    ForEachWedge(from, [&](uint32_t wedge) {
+      for (const auto target : m_adjacency.GetEdges(wedge)) {
+        found |= m_remap[target] == m_remap[to];
+      }
+    });
+    return found;
+  }
+
+  [[nodiscard]] bool IsOpenEdge(uint32_t a, uint32_t b) const {
+    return m_openOut[a] == b || m_openIn[a] == b;
+  }
+
+  void ComputeQuadrics() {
+    m_quadrics.assign(m_positions.size(), {});
+    for (size_t i = 0; i + 2 < m_indices.size(); i += 3) {
+      const auto& p0 = m_positions[m_indices[i]];
+      const auto& p1 = m_positions[m_indices[i + 1]];
+      const auto& p2 = m_positions[m_indices[i + 2]];
+      auto normal       = glm::cross(p1 - p0, p2 - p0);
+      const double area = glm::length(normal);
+      if (area <= 0.0) {
+        continue;
+      }
+      normal /= area;
+      for (int corner = 0; corner < 3; corner++) {
+        m_quadrics[m_remap[m_indices[i + corner]]].AddPlane(normal, -glm::dot(normal, p0),
+                                                            area * 0.5);
+      }
+      // open edges, borders and seams alike, keep a plane standing on them
+      for (int corner = 0; corner < 3; corner++) {
+        const auto a = m_indices[i + corner], b = m_indices[i + (corner + 1) % 3];
+        if (m_adjacency.HasEdge(b, a)) {
+          continue;
+        }
+        const auto edge   = m_positions[b] - m_positions[a];
+        const auto length = glm::length(edge);
+        if (length <= 0.0) {
+          continue;
+        }
+        const auto side = glm::normalize(glm::cross(edge, normal));
+        const auto d    = -glm::dot(side, m_positions[a]);
+        m_quadrics[m_remap[a]].AddPlane(side, d, BoundaryWeight * length * length);
+        m_quadrics[m_remap[b]].AddPlane(side, d, BoundaryWeight * length * length);
+      }
+    }
+  }
+
+  void Classify() {
+    const auto numVertices = m_positions.size();
+    m_kinds.assign(numVertices, VertexKind::Locked);
+    m_twins.assign(numVertices, InvalidIndex);
+    m_openOut.assign(numVertices, InvalidIndex);
+    m_openIn.assign(numVertices, InvalidIndex);
+    auto& numOpenOut = m_numOpenOut;
+    auto& numOpenIn  = m_numOpenIn;
+    numOpenOut.assign(numVertices, 0);
+    numOpenIn.assign(numVertices, 0);
+    for (uint32_t v = 0; v < numVertices; v++) {
+      for (const auto target : m_adjacency.GetEdges(v)) {
+        if (!m_adjacency.HasEdge(target, v)) {
+          m_openOut[v]      = target;
+          m_openIn[target]  = v;
+          numOpenOut[v]     = std::min(numOpenOut[v] + 1, 2);
+          numOpenIn[target] = std::min(numOpenIn[target] + 1, 2);
+        }
+      }
+    }
+    for (uint32_t v = 0; v < numVertices; v++) {
+      if (m_remap[v] != v) {
+        continue;
+      }
+      std::array<uint32_t, 3> wedges{};
+      size_t numWedges = 0;
+      ForEachWedge(v, [&](uint32_t wedge) {
+        if (numWedges < wedges.size()) {
+          wedges[numWedges] = wedge;
+        }
+        numWedges++;
+      });
+      const auto has_one_open_edge = [&](uint32_t w) {
+        return numOpenOut[w] == 1 && numOpenIn[w] == 1;
+      };
+      if (numWedges == 1) {
+        const auto w = wedges[0];
+        if (numOpenOut[w] == 0 && numOpenIn[w] == 0) {
+          m_kinds[w] = VertexKind::Manifold;
+        } else if (has_one_open_edge(w) && !HasPositionEdge(m_openOut[w], w) &&
+                   !HasPositionEdge(w, m_openIn[w])) {
+          m_kinds[w] = VertexKind::Border;
+        }
+      } else if (numWedges == 2) {
+        const auto a = wedges[0], b = wedges[1];
+        const auto is_seam = [&](uint32_t w) {
+          return has_one_open_edge(w) && HasPositionEdge(m_openOut[w], w) &&
+                 HasPositionEdge(w, m_openIn[w]);
+        };
+        if (is_seam(a) && is_seam(b)) {
+          m_kinds[a] = m_kinds[b] = VertexKind::Seam;
+          m_twins[a]              = b;
+          m_twins[b]              = a;
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] bool CanCollapse(uint32_t v0, uint32_t v1) const {
+    switch (m_kinds[v0]) {
+      case VertexKind::Manifold:
+        return true;
+      case VertexKind::Border:
+        return IsOpenEdge(v0, v1);
+      case VertexKind::Seam:
+        return m_kinds[v1] == VertexKind::Seam && IsOpenEdge(v0, v1) &&
+               IsOpenEdge(m_twins[v0], m_twins[v1]);
+      default:
+        return false;
+    }
+  }
+
+  [[nodiscard]] double GetCollapseError(uint32_t v0, uint32_t v1) const {
+    auto quadric = m_quadrics[m_remap[v0]];
+    quadric += m_quadrics[m_remap[v1]];
+    return quadric.Evaluate(m_positions[v1]);
+  }
+
+  // moving v0 onto v1 must not turn any of the remaining triangles around
+  [[nodiscard]] bool KeepsOrientation(uint32_t v0, uint32_t v1) const {
+    const auto& target = m_positions[v1];
+    bool keeps         = true;
+    ForEachWedge(v0, [&](uint32_t wedge) {
+      for (const auto triangle : m_adjacency.GetTriangles(wedge)) {
+        const auto* corners = &m_indices[triangle * 3];
+        if (m_remap[corners[0]] == m_remap[v1] || m_remap[corners[1]] == m_remap[v1] ||
+            m_remap[corners[2]] == m_remap[v1]) {
+          continue;
+        }
+        std::array<glm::dvec3, 3> points{m_positions[corners[0]], m_positions[corners[1]],
+                                         m_positions[corners[2]]};
+        const auto before = glm::cross(points[1] - points[0], points[2] - points[0]);
+        for (auto& point : points) {
+          if (point == m_positions[wedge]) {
+            point = target;
+          }
+        }
+        const auto after = glm::cross(points[1] - points[0], points[2] - points[0]);
+        keeps &= glm::dot(before, after) > 0.0;
+      }
+    });
+    return keeps;
+  }
+
+  // holds the memory of every vector below, so it is declared first
+  ScratchArena m_scratch;
+  std::vector<uint32_t>& m_indices;
+  std::vector<glm::dvec3>& m_positions = m_scratch.Vector<glm::dvec3>();
+  float m_extent{1.0f};
+  // first vertex at the same position, and the next one in the ring of them
+  std::vector<uint32_t>& m_remap = m_scratch.Vector<uint32_t>();
+  std::vector<uint32_t>& m_wedge = m_scratch.Vector<uint32_t>();
+  // accumulated at the first vertex of each position
+  std::vector<Quadric>& m_quadrics = m_scratch.Vector<Quadric>();
+  Adjacency m_adjacency{m_scratch};
+  std::vector<VertexKind>& m_kinds = m_scratch.Vector<VertexKind>();
+  std::vector<uint32_t>& m_twins   = m_scratch.Vector<uint32_t>();
+  // the open edge leaving and entering each vertex, the last one seen when there are several
+  std::vector<uint32_t>& m_openOut = m_scratch.Vector<uint32_t>();
+  std::vector<uint32_t>& m_openIn  = m_scratch.Vector<uint32_t>();
+  // temporaries of a pass, kept from one to the next
+  std::vector<Collapse>& m_collapses     = m_scratch.Vector<Collapse>();
+  std::vector<uint32_t>& m_collapseRemap = m_scratch.Vector<uint32_t>();
+  std::vector<char>& m_touched           = m_scratch.Vector<char>();
+  std::vector<uint8_t>& m_numOpenOut     = m_scratch.Vector<uint8_t>();
+  std::vector<uint8_t>& m_numOpenIn      = m_scratch.Vector<uint8_t>();
+  // the vertices the source used, and the one each of them collapsed into over all passes
+  std::vector<uint32_t>& m_sources     = m_scratch.Vector<uint32_t>();
+  std::vector<uint32_t>& m_collapsedTo = m_scratch.Vector<uint32_t>();
+};
+}  // namespace
+
+float SimplifyMesh(const std::vector<Vertex>& vertices, std::span<const uint32_t> indices,
+                   size_t targetIndices, std::vector<uint32_t>& result) {
+  if (indices.size() % 3 != 0) {
+    result.assign(indices.begin(), indices.end());
+    return 0.0f;
+  }
+  Simplifier simplifier(vertices, indices);
+  while (simplifier.GetNumIndices() > targetIndices && simplifier.CollapsePass(targetIndices)) {
+  }
+  const auto simplified = simplifier.GetIndices();
+  result.assign(simplified.begin(), simplified.end());
+  return simplifier.MeasureError();
+}
+
+size_t GetMeshLodIndexCapacity(size_t numIndices) {
+  const auto numTriangles = numIndices / 3;
+  size_t capacity         = numIndices;
+  for (const auto ratio : LodRatios) {
+    capacity += static_cast<size_t>(static_cast<float>(numTriangles) * ratio) * 3;
+  }
+  return capacity;
+}
+
+void BuildMeshLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                   std::vector<MeshLod>& lods) {
+  lods.clear();
+  if (indices.empty() || indices.size() % 3 != 0) {
+    return;
+  }
+  const auto numTriangles = indices.size() / 3;
+  indices.reserve(GetMeshLodIndexCapacity(indices.size()));
+  lods.reserve(MaxMeshLods);
+  lods.push_back({0, static_cast<uint32_t>(indices.size()), 0.0f});
+  ScratchArena scratch;
+  auto& simplified    = scratch.Vector<uint32_t>();
+  auto& clusterStarts = scratch.Vector<uint32_t>();
+  // one simplifier goes down the whole chain, so the quadrics and the errors of every level are
+  // those of the full mesh and not of the level before
+  Simplifier simplifier(vertices, indices);
+  size_t previousSize = indices.size();
+  float error         = 0.0f;
+  for (const auto ratio : LodRatios) {
+    const auto targetIndices = static_cast<size_t>(static_cast<float>(numTriangles) * ratio) * 3;
+    if (targetIndices < MinLodTriangles * 3) {
+      break;
+    }
+    while (simplifier.GetNumIndices() > targetIndices &&
+           simplifier.CollapsePass(targetIndices)) {
+    }
+    const auto level = simplifier.GetIndices();
+    if (level.empty() ||
+        static_cast<float>(level.size()) > static_cast<float>(previousSize) * MaxLodShare) {
+      break;
+    }
+    // coarser levels are measured against fewer triangles, the chain never gets more accurate
+    error = std::max(error, simplifier.MeasureError());
+    simplified.assign(level.begin(), level.end());
+    OptimizeVertexCache(simplified, vertices.size(), clusterStarts);
+    lods.push_back({static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()),
+                    error});
+    indices.insert(indices.end(), simplified.begin(), simplified.end());
+    previousSize = simplified.size();
+  }
+}
+}  // namespace photon::util
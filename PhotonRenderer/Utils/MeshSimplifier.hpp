@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Renderer/MeshLod.hpp"
+#include "Renderer/Vertex.hpp"
+
+namespace photon::util {
+/**
+ * Collapse edges of a triangle list in order of quadric error (Garland and Heckbert 1997) until
+ * at most targetIndices are left or no collapse keeps the surface intact. Vertices are shared with
+ * the source and never moved: borders only slide along themselves and attribute seams collapse on
+ * both sides at once. Returns the farthest a vertex of the source strays from the simplified
+ * surface, in model units.
+ */
+float SimplifyMesh(const std::vector<Vertex>& vertices, std::span<const uint32_t> indices,
+                   size_t targetIndices, std::vector<uint32_t>& result);
+
+/**
+ * Append simplified copies of a triangle list to its indices, at about 50, 25 and 10 percent of
+ * its triangles and each optimized for the vertex cache. lods receives the range of every level,
+ * the full list first, with its distance from the full surface; the chain ends early once
+ * simplification stalls.
+ */
+void BuildMeshLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                   std::vector<MeshLod>& lods);
+
+/**
+ * Indices a list of numIndices takes once BuildMeshLods appended levels that reach their targets,
+ * to reserve before it is filled so appending them does not move it.
+ */
+size_t GetMeshLodIndexCapacity(size_t numIndices);
+}  // namespace photon::util
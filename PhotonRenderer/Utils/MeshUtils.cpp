@@ -0,0 +1,153 @@
+#include "Utils/MeshUtils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/glm.hpp>
+#include "Common/Math.hpp"
+#include "ScratchArena.hpp"
+
+namespace photon::util {
+namespace {
+constexpr uint32_t InvalidIndex = ~0u;
+
+static_assert(sizeof(Vertex) % sizeof(uint32_t) == 0, "Vertex must be made of 32-bit words");
+
+// murmur-style mix over the raw bits, so +0/-0 and NaN payloads stay distinct like memcmp
+uint32_t HashVertex(const Vertex& vertex) {
+  uint32_t words[sizeof(Vertex) / sizeof(uint32_t)];
+  memcpy(words, &vertex, sizeof(Vertex));
+  uint32_t hash = 0;
+  for (const auto word : words) {
+    uint32_t k = word * 0x5bd1e995u;
+    k ^= k >> 24;
+    hash = (hash * 0x5bd1e995u) ^ (k * 0x5bd1e995u);
+  }
+  hash ^= hash >> 13;
+  hash *= 0x5bd1e995u;
+  return hash ^ (hash >> 15);
+}
+
+uint16_t ToUnorm16(float value, float offset, float scale) {
+  const float unorm = scale > 0.0f ? std::clamp((value - offset) / scale, 0.0f, 1.0f) : 0.0f;
+  return static_cast<uint16_t>(std::lround(unorm * 65535.0f));
+}
+
+int16_t ToSnorm16(float value) {
+  return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+// the unit sphere folded onto the octahedron |x| + |y| + |z| = 1 and unfolded into a square
+glm::vec2 EncodeOctahedral(const glm::vec3& normal) {
+  const float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+  if (length == 0.0f) {
+    return glm::vec2(0.0f);
+  }
+  glm::vec2 encoded = glm::vec2(normal) / length;
+  if (normal.z < 0.0f) {
+    const glm::vec2 sign(encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f);
+    encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * sign;
+  }
+  return encoded;
+}
+}  // namespace
+
+void WeldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+  const auto numVertices = vertices.size();
+  // open addressing at <= 50% load, slots hold indices into the compacted vertex array
+  const auto capacity =
+      static_cast<size_t>(math::NextPowerOfTwo(static_cast<int>(numVertices * 2) + 1));
+  const auto mask = capacity - 1;
+  ScratchArena scratch;
+  auto& table = scratch.Vector<uint32_t>(capacity, InvalidIndex);
+  auto& remap = scratch.Vector<uint32_t>(numVertices, 0u);
+
+  uint32_t numUnique = 0;
+  for (size_t i = 0; i < numVertices; i++) {
+    auto bucket = HashVertex(vertices[i]) & mask;
+    while (table[bucket] != InvalidIndex &&
+           memcmp(&vertices[table[bucket]], &vertices[i], sizeof(Vertex)) != 0) {
+      bucket = (bucket + 1) & mask;
+    }
+    if (table[bucket] == InvalidIndex) {
+      // compact in place, numUnique <= i so nothing unread is overwritten
+      vertices[numUnique] = vertices[i];
+      table[bucket]       = numUnique++;
+    }
+    remap[i] = table[bucket];
+  }
+  vertices.resize(numUnique);
+
+  if (indices.empty()) {
+    indices.assign(remap.begin(), remap.end());
+  } else {
+    for (auto& index : indices) {
+      index = remap[index];
+    }
+  }
+}
+
+VertexQuantization PackVertices(std::span<const Vertex> vertices,
+                                std::vector<PackedVertex>& packed) {
+  VertexQuantization quantization;
+  packed.resize(vertices.size());
+  if (vertices.empty()) {
+    return quantization;
+  }
+  glm::vec3 posMin = vertices.front().position, posMax = posMin;
+  glm::vec2 uvMin = vertices.front().uv, uvMax = uvMin;
+  for (const auto& vertex : vertices) {
+    posMin = glm::min(posMin, vertex.position);
+    posMax = glm::max(posMax, vertex.position);
+    uvMin  = glm::min(uvMin, vertex.uv);
+    uvMax  = glm::max(uvMax, vertex.uv);
+  }
+  quantization.positionOffset = posMin;
+  quantization.positionScale  = posMax - posMin;
+  quantization.uvOffset       = uvMin;
+  quantization.uvScale        = uvMax - uvMin;
+  for (size_t i = 0; i < vertices.size(); i++) {
+    const auto& vertex = vertices[i];
+    auto& out          = packed[i];
+    for (int c = 0; c < 3; c++) {
+      out.position[c] = ToUnorm16(vertex.position[c], posMin[c], quantization.positionScale[c]);
+    }
+    out.position[3] = 0;
+    for (int c = 0; c < 2; c++) {
+      out.uv[c] = ToUnorm16(vertex.uv[c], uvMin[c], quantization.uvScale[c]);
+    }
+    const auto normal = EncodeOctahedral(vertex.normal);
+    out.normal[0]     = ToSnorm16(normal.x);
+    out.normal[1]     = ToSnorm16(normal.y);
+  }
+  return quantization;
+}
+
+void BuildBoxMesh(const glm::vec3& posMin, const glm::vec3& posMax, std::vector<Vertex>& vertices,
+                  std::vector<uint32_t>& indices) {
+  vertices.clear();
+  indices.clear();
+  const glm::vec2 corners[] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}};
+  for (int axis = 0; axis < 3; axis++) {
+    // u x v points along +axis, so the negative face takes the opposite winding
+    const int u = (axis + 1) % 3;
+    const int v = (axis + 2) % 3;
+    for (const float sign : {-1.0f, 1.0f}) {
+      glm::vec3 normal(0.0f);
+      normal[axis]    = sign;
+      const auto base = static_cast<uint32_t>(vertices.size());
+      for (const auto& uv : corners) {
+        glm::vec3 position;
+        position[axis] = sign > 0.0f ? posMax[axis] : posMin[axis];
+        position[u]    = glm::mix(posMin[u], posMax[u], uv.x);
+        position[v]    = glm::mix(posMin[v], posMax[v], uv.y);
+        vertices.emplace_back(position, uv, normal);
+      }
+      if (sign > 0.0f) {
+        indices.insert(indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+      } else {
+        indices.insert(indices.end(), {base, base + 2, base + 1, base, base + 3, base + 2});
+      }
+    }
+  }
+}
+}  // namespace photon::util
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <glm/vec3.hpp>
+#include "Renderer/Vertex.hpp"
+
+namespace photon::util {
+
+/**
+ * Merge bitwise identical vertices and rewrite the index buffer to reference the unique ones.
+ * An empty index buffer means vertices is a non-indexed triangle list, one vertex per corner.
+ */
+void WeldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+/**
+ * Quantize positions and uvs to 16 bits within the bounds of vertices, and normals to 16-bit
+ * octahedral coordinates. The returned quantization decodes them in the vertex shaders.
+ */
+VertexQuantization PackVertices(std::span<const Vertex> vertices,
+                                std::vector<PackedVertex>& packed);
+
+/** Closed box spanning [posMin, posMax] with flat normals, stands in for models still loading. */
+void BuildBoxMesh(const glm::vec3& posMin, const glm::vec3& posMax, std::vector<Vertex>& vertices,
+                  std::vector<uint32_t>& indices);
+}  // namespace photon::util
@@ -0,0 +1,166 @@
+#include "MeshletBuilder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <glm/glm.hpp>
+#include "ScratchArena.hpp"
+
+namespace photon::util {
+namespace {
+constexpr uint32_t InvalidIndex = ~0u;
+// normals spreading this close to perpendicular of the cone axis leave nothing to cull
+constexpr float MinConeDot = 0.1f;
+
+void ComputeBounds(const std::vector<Vertex>& vertices, std::span<const uint32_t> indices,
+                   Meshlet& meshlet) {
+  glm::vec3 posMin(std::numeric_limits<float>::max());
+  glm::vec3 posMax(std::numeric_limits<float>::lowest());
+  for (const auto index : indices) {
+    posMin = glm::min(posMin, vertices[index].position);
+    posMax = glm::max(posMax, vertices[index].position);
+  }
+  meshlet.center = (posMin + posMax) * 0.5f;
+  meshlet.radius = 0.0f;
+  for (const auto index : indices) {
+    const float distance = glm::length(vertices[index].position - meshlet.center);
+    meshlet.radius       = std::max(meshlet.radius, distance);
+  }
+
+  const auto triangle_normal = [&](size_t i) {
+    const auto& p0 = vertices[indices[i]].position;
+    return glm::cross(vertices[indices[i + 1]].position - p0,
+                      vertices[indices[i + 2]].position - p0);
+  };
+  // area weighted, so slivers do not tilt the axis
+  glm::vec3 axis(0.0f);
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    axis += triangle_normal(i);
+  }
+  const float length = glm::length(axis);
+  if (length <= 0.0f) {
+    return;
+  }
+  axis /= length;
+  float minDot = 1.0f;
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    const auto normal = triangle_normal(i);
+    const float area  = glm::length(normal);
+    if (area > 0.0f) {
+      minDot = std::min(minDot, glm::dot(normal / area, axis));
+    }
+  }
+  if (minDot <= MinConeDot) {
+    return;
+  }
+  // the normals stay within acos(minDot) of the axis, so the cluster is back facing once the
+  // view direction is within 90 degrees minus that, a cosine of sin(acos(minDot))
+  meshlet.coneAxis   = axis;
+  meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+}  // namespace
+
+void BuildMeshlets(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                   size_t numIndices, std::vector<Meshlet>& meshlets) {
+  meshlets.clear();
+  numIndices = std::min(numIndices - numIndices % 3, indices.size() - indices.size() % 3);
+  const auto numTriangles = numIndices / 3;
+  // the fewest meshlets the triangles fit in
+  meshlets.reserve((numTriangles + MaxMeshletTriangles - 1) / MaxMeshletTriangles);
+  ScratchArena scratch;
+  // triangles around each vertex
+  auto& offsets = scratch.Vector<uint32_t>(vertices.size() + 1, 0u);
+  for (size_t i = 0; i < numIndices; i++) {
+    offsets[indices[i] + 1]++;
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  auto& vertexTriangles = scratch.Vector<uint32_t>(numIndices, 0u);
+  auto& cursor          = scratch.Vector<uint32_t>(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < numIndices; i++) {
+    vertexTriangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+  }
+
+  auto& ordered = scratch.Vector<uint32_t>();
+  ordered.reserve(numIndices);
+  auto& emitted = scratch.Vector<char>(numTriangles, 0);
+  // the meshlet a vertex was last added to
+  auto& owner      = scratch.Vector<uint32_t>(vertices.size(), InvalidIndex);
+  auto& candidates = scratch.Vector<uint32_t>();
+  size_t next = 0;
+  const auto skip_emitted = [&] {
+    while (next < numTriangles && emitted[next]) {
+      next++;
+    }
+  };
+  for (skip_emitted(); next < numTriangles; skip_emitted()) {
+    const auto id             = static_cast<uint32_t>(meshlets.size());
+    const auto firstIndex     = ordered.size();
+    uint32_t meshletVertices  = 0;
+    uint32_t meshletTriangles = 0;
+    candidates.clear();
+    const auto count_new_vertices = [&](uint32_t triangle) {
+      uint32_t count = 0;
+      for (int corner = 0; corner < 3; corner++) {
+        count += owner[indices[triangle * 3 + corner]] != id;
+      }
+      return count;
+    };
+    const auto add_triangle = [&](uint32_t triangle) {
+      emitted[triangle] = 1;
+      for (int corner = 0; corner < 3; corner++) {
+        const auto vertex = indices[triangle * 3 + corner];
+        ordered.push_back(vertex);
+        if (owner[vertex] == id) {
+          continue;
+        }
+        owner[vertex] = id;
+        meshletVertices++;
+        for (auto i = offsets[vertex]; i < offsets[vertex + 1]; i++) {
+          if (!emitted[vertexTriangles[i]]) {
+            candidates.push_back(vertexTriangles[i]);
+          }
+        }
+      }
+      meshletTriangles++;
+    };
+
+    add_triangle(static_cast<uint32_t>(next));
+    while (meshletTriangles < MaxMeshletTriangles) {
+      std::erase_if(candidates, [&](uint32_t triangle) { return emitted[triangle] != 0; });
+      // fewest new vertices, ties go to the earlier triangle to keep the vertex cache order
+      uint32_t best    = InvalidIndex;
+      uint32_t bestNew = MaxMeshletVertices;
+      for (const auto triangle : candidates) {
+        const auto numNew = count_new_vertices(triangle);
+        if (meshletVertices + numNew <= MaxMeshletVertices &&
+            (numNew < bestNew || (numNew == bestNew && triangle < best))) {
+          best    = triangle;
+          bestNew = numNew;
+        }
+      }
+      if (best == InvalidIndex) {
+        if (!candidates.empty()) {
+          break;
+        }
+        // nothing connected is left, meshes without shared vertices go on in triangle order
+        skip_emitted();
+        if (next == numTriangles) {
+          break;
+        }
+        best = static_cast<uint32_t>(next);
+        if (meshletVertices + count_new_vertices(best) > MaxMeshletVertices) {
+          break;
+        }
+      }
+      add_triangle(best);
+    }
+
+    auto& meshlet      = meshlets.emplace_back();
+    meshlet.firstIndex = static_cast<uint32_t>(firstIndex);
+    meshlet.numIndices = static_cast<uint32_t>(ordered.size() - firstIndex);
+    ComputeBounds(vertices, std::span(ordered).subspan(firstIndex, meshlet.numIndices), meshlet);
+  }
+  std::copy(ordered.begin(), ordered.end(), indices.begin());
+}
+}  // namespace photon::util
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Renderer/Meshlet.hpp"
+#include "Renderer/Vertex.hpp"
+
+namespace photon::util {
+/**
+ * Split the first numIndices of a triangle list into meshlets of at most MaxMeshletVertices and
+ * MaxMeshletTriangles, grown across shared vertices from the triangles in their current order,
+ * and reorder those indices so each meshlet is one contiguous range.
+ */
+void BuildMeshlets(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                   size_t numIndices, std::vector<Meshlet>& meshlets);
+}  // namespace photon::util
@@ -0,0 +1,369 @@
+#include "MeshoptDecoder.hpp"
+#include <cmath>
+#include <cstring>
+
+namespace photon::util {
+namespace {
+constexpr uint8_t VertexHeader   = 0xa0;
+constexpr uint8_t IndexHeader    = 0xe0;
+constexpr uint8_t SequenceHeader = 0xd0;
+
+constexpr size_t ByteGroupSize = 16;
+// the most a single byte group can consume: 8 bytes of 4-bit codes and 16 escaped bytes
+constexpr size_t ByteGroupDecodeLimit = 24;
+constexpr size_t VertexBlockSizeBytes = 8192;
+constexpr size_t VertexBlockMaxSize   = 256;
+constexpr size_t VertexTailMinSize    = 32;
+
+inline uint8_t Unzigzag8(uint8_t v) {
+  return static_cast<uint8_t>(-(v & 1) ^ (v >> 1));
+}
+
+size_t GetVertexBlockSize(size_t stride) {
+  // a block has to fit the scratch buffer and be a whole number of byte groups
+  size_t result = (VertexBlockSizeBytes / stride) & ~(ByteGroupSize - 1);
+  return result < VertexBlockMaxSize ? result : VertexBlockMaxSize;
+}
+
+// 16 values packed as 0, 2, 4 or 8 bits, all-ones codes escape to a full byte after the codes
+template <int Bits>
+const uint8_t* DecodeBytesGroupPacked(const uint8_t* data, uint8_t* out) {
+  constexpr int CodesPerByte = 8 / Bits;
+  constexpr uint8_t Escape   = (1 << Bits) - 1;
+  const uint8_t* extra       = data + ByteGroupSize / CodesPerByte;
+  for (size_t i = 0; i < ByteGroupSize / CodesPerByte; i++) {
+    uint8_t byte = data[i];
+    for (int k = 0; k < CodesPerByte; k++) {
+      const uint8_t code = byte >> (8 - Bits);
+      byte               = static_cast<uint8_t>(byte << Bits);
+      *out++             = code == Escape ? *extra++ : code;
+    }
+  }
+  return extra;
+}
+
+const uint8_t* DecodeBytesGroup(const uint8_t* data, uint8_t* out, int bitsLog2) {
+  switch (bitsLog2) {
+    case 0:
+      std::memset(out, 0, ByteGroupSize);
+      return data;
+    case 1:
+      return DecodeBytesGroupPacked<2>(data, out);
+    case 2:
+      return DecodeBytesGroupPacked<4>(data, out);
+    default:
+      std::memcpy(out, data, ByteGroupSize);
+      return data + ByteGroupSize;
+  }
+}
+
+const uint8_t* DecodeBytes(const uint8_t* data, const uint8_t* end, uint8_t* out, size_t count) {
+  // 2-bit group modes, four groups per header byte
+  const uint8_t* header    = data;
+  const size_t numGroups   = count / ByteGroupSize;
+  const size_t headerSize  = (numGroups + 3) / 4;
+  if (static_cast<size_t>(end - data) < headerSize) {
+    return nullptr;
+  }
+  data += headerSize;
+  for (size_t group = 0; group < numGroups; group++) {
+    // the stream tail guarantees this much slack for well-formed input
+    if (static_cast<size_t>(end - data) < ByteGroupDecodeLimit) {
+      return nullptr;
+    }
+    const int bitsLog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+    data               = DecodeBytesGroup(data, out + group * ByteGroupSize, bitsLog2);
+  }
+  return data;
+}
+
+const uint8_t* DecodeVertexBlock(const uint8_t* data, const uint8_t* end, uint8_t* vertices,
+                                 size_t count, size_t stride, uint8_t* lastVertex) {
+  uint8_t deltas[VertexBlockMaxSize];
+  const size_t alignedCount = (count + ByteGroupSize - 1) & ~(ByteGroupSize - 1);
+  // each byte of the vertex is a separate stream of deltas against the previous vertex
+  for (size_t k = 0; k < stride; k++) {
+    data = DecodeBytes(data, end, deltas, alignedCount);
+    if (data == nullptr) {
+      return nullptr;
+    }
+    uint8_t previous = lastVertex[k];
+    uint8_t* out     = vertices + k;
+    for (size_t i = 0; i < count; i++) {
+      previous = static_cast<uint8_t>(Unzigzag8(deltas[i]) + previous);
+      *out     = previous;
+      out += stride;
+    }
+    lastVertex[k] = previous;
+  }
+  return data;
+}
+
+inline uint32_t DecodeVByte(const uint8_t*& data) {
+  const uint8_t lead = *data++;
+  if (lead < 128) {
+    return lead;
+  }
+  // at most 4 more bytes, so malformed input can not run away
+  uint32_t result = lead & 127;
+  uint32_t shift  = 7;
+  for (int i = 0; i < 4; i++) {
+    const uint8_t group = *data++;
+    result |= static_cast<uint32_t>(group & 127) << shift;
+    shift += 7;
+    if (group < 128) {
+      break;
+    }
+  }
+  return result;
+}
+
+inline uint32_t DecodeIndex(const uint8_t*& data, uint32_t last) {
+  const uint32_t v = DecodeVByte(data);
+  return last + ((v >> 1) ^ (0u - (v & 1)));
+}
+
+inline void WriteIndex(void* destination, size_t i, size_t indexSize, uint32_t index) {
+  if (indexSize == 2) {
+    static_cast<uint16_t*>(destination)[i] = static_cast<uint16_t>(index);
+  } else {
+    static_cast<uint32_t*>(destination)[i] = index;
+  }
+}
+
+inline void WriteTriangle(void* destination, size_t i, size_t indexSize, uint32_t a, uint32_t b,
+                          uint32_t c) {
+  WriteIndex(destination, i + 0, indexSize, a);
+  WriteIndex(destination, i + 1, indexSize, b);
+  WriteIndex(destination, i + 2, indexSize, c);
+}
+
+struct TriangleFifos {
+  uint32_t edges[16][2];
+  uint32_t vertices[16];
+  size_t edgeOffset{0};
+  size_t vertexOffset{0};
+
+  TriangleFifos() {
+    std::memset(edges, -1, sizeof(edges));
+    std::memset(vertices, -1, sizeof(vertices));
+  }
+
+  // the pushes have to mirror the encoder exactly, including the conditional ones
+  void PushEdge(uint32_t a, uint32_t b) {
+    edges[edgeOffset][0] = a;
+    edges[edgeOffset][1] = b;
+    edgeOffset           = (edgeOffset + 1) & 15;
+  }
+  void PushVertex(uint32_t v, bool cond = true) {
+    vertices[vertexOffset] = v;
+    vertexOffset           = (vertexOffset + (cond ? 1 : 0)) & 15;
+  }
+};
+
+inline int32_t RoundToInt(float v) {
+  return static_cast<int32_t>(v + (v >= 0.0f ? 0.5f : -0.5f));
+}
+
+template <typename T>
+void DecodeFilterOct(T* data, size_t count) {
+  const float max = static_cast<float>((1 << (sizeof(T) * 8 - 1)) - 1);
+  for (size_t i = 0; i < count; i++, data += 4) {
+    // the third component holds the scale of 1.0 at the encoded precision
+    float x = static_cast<float>(data[0]);
+    float y = static_cast<float>(data[1]);
+    float z = static_cast<float>(data[2]) - std::fabs(x) - std::fabs(y);
+    // unfold the lower hemisphere
+    const float t = z >= 0.0f ? 0.0f : z;
+    x += x >= 0.0f ? t : -t;
+    y += y >= 0.0f ? t : -t;
+    const float s = max / std::sqrt(x * x + y * y + z * z);
+    data[0]       = static_cast<T>(RoundToInt(x * s));
+    data[1]       = static_cast<T>(RoundToInt(y * s));
+    data[2]       = static_cast<T>(RoundToInt(z * s));
+  }
+}
+}  // namespace
+
+bool DecodeMeshoptVertexBuffer(void* destination, size_t count, size_t stride,
+                               const uint8_t* buffer, size_t size) {
+  if (stride == 0 || stride > 256 || stride % 4 != 0) {
+    return false;
+  }
+  const size_t tailSize = stride < VertexTailMinSize ? VertexTailMinSize : stride;
+  if (size < 1 + tailSize || (buffer[0] & 0xf0) != VertexHeader || (buffer[0] & 0x0f) > 0) {
+    return false;
+  }
+  const uint8_t* data = buffer + 1;
+  const uint8_t* end  = buffer + size;
+  // the first vertex is delta coded against the last bytes of the stream
+  uint8_t lastVertex[256];
+  std::memcpy(lastVertex, end - stride, stride);
+
+  auto* vertices         = static_cast<uint8_t*>(destination);
+  const size_t blockSize = GetVertexBlockSize(stride);
+  for (size_t offset = 0; offset < count; offset += blockSize) {
+    const size_t blockCount = offset + blockSize < count ? blockSize : count - offset;
+    data = DecodeVertexBlock(data, end, vertices + offset * stride, blockCount, stride, lastVertex);
+    if (data == nullptr) {
+      return false;
+    }
+  }
+  return static_cast<size_t>(end - data) == tailSize;
+}
+
+bool DecodeMeshoptIndexBuffer(void* destination, size_t count, size_t indexSize,
+                              const uint8_t* buffer, size_t size) {
+  if (count % 3 != 0 || (indexSize != 2 && indexSize != 4)) {
+    return false;
+  }
+  // header, one code per triangle and the 16 byte auxiliary code table
+  if (size < 1 + count / 3 + 16 || (buffer[0] & 0xf0) != IndexHeader) {
+    return false;
+  }
+  const int version = buffer[0] & 0x0f;
+  if (version > 1) {
+    return false;
+  }
+  // version 1 codes 13 and 14 are +-1 deltas from the last free index
+  const int maxFifoCode = version >= 1 ? 13 : 15;
+
+  TriangleFifos fifos;
+  uint32_t next = 0;
+  uint32_t last = 0;
+
+  const uint8_t* code      = buffer + 1;
+  const uint8_t* data      = code + count / 3;
+  const uint8_t* dataEnd   = buffer + size - 16;
+  const uint8_t* codeTable = dataEnd;
+  for (size_t i = 0; i < count; i += 3) {
+    // a triangle reads at most 16 bytes, which the code table behind the data covers
+    if (data > dataEnd) {
+      return false;
+    }
+    const uint8_t codeTri = *code++;
+    if (codeTri < 0xf0) {
+      // edge from the fifo plus one vertex
+      const int fe     = codeTri >> 4;
+      const uint32_t a = fifos.edges[(fifos.edgeOffset - 1 - fe) & 15][0];
+      const uint32_t b = fifos.edges[(fifos.edgeOffset - 1 - fe) & 15][1];
+      const int fec    = codeTri & 15;
+      uint32_t c;
+      if (fec < maxFifoCode) {
+        c = fec == 0 ? next++ : fifos.vertices[(fifos.vertexOffset - 1 - fec) & 15];
+        fifos.PushVertex(c, fec == 0);
+      } else {
+        // fec - (fec ^ 3) maps 13 and 14 to -1 and +1
+        c    = fec != 15 ? last + (fec - (fec ^ 3)) : DecodeIndex(data, last);
+        last = c;
+        fifos.PushVertex(c);
+      }
+      WriteTriangle(destination, i, indexSize, a, b, c);
+      fifos.PushEdge(c, b);
+      fifos.PushEdge(a, c);
+    } else {
+      // three vertices, the codes come from the table or from a full byte
+      const bool fromTable  = codeTri < 0xfe;
+      const uint8_t codeAux = fromTable ? codeTable[codeTri & 15] : *data++;
+      const int fea         = fromTable || codeTri == 0xfe ? 0 : 15;
+      const int feb         = codeAux >> 4;
+      const int fec         = codeAux & 15;
+      if (!fromTable && codeAux == 0) {
+        next = 0;
+      }
+      uint32_t a = fea == 0 ? next++ : 0;
+      uint32_t b = feb == 0 ? next++ : fifos.vertices[(fifos.vertexOffset - feb) & 15];
+      uint32_t c = fec == 0 ? next++ : fifos.vertices[(fifos.vertexOffset - fec) & 15];
+      if (fea == 15) {
+        last = a = DecodeIndex(data, last);
+      }
+      if (feb == 15) {
+        last = b = DecodeIndex(data, last);
+      }
+      if (fec == 15) {
+        last = c = DecodeIndex(data, last);
+      }
+      WriteTriangle(destination, i, indexSize, a, b, c);
+      fifos.PushVertex(a);
+      fifos.PushVertex(b, feb == 0 || feb == 15);
+      fifos.PushVertex(c, fec == 0 || fec == 15);
+      fifos.PushEdge(b, a);
+      fifos.PushEdge(c, b);
+      fifos.PushEdge(a, c);
+    }
+  }
+  // all triangle data has to be consumed right up to the code table
+  return data == dataEnd;
+}
+
+bool DecodeMeshoptIndexSequence(void* destination, size_t count, size_t indexSize,
+                                const uint8_t* buffer, size_t size) {
+  if (indexSize != 2 && indexSize != 4) {
+    return false;
+  }
+  // header, at least one byte per index and a 4 byte tail
+  if (size < 1 + count + 4 || (buffer[0] & 0xf0) != SequenceHeader || (buffer[0] & 0x0f) > 1) {
+    return false;
+  }
+  const uint8_t* data    = buffer + 1;
+  const uint8_t* dataEnd = buffer + size - 4;
+  // two baselines, the low bit of every code selects one
+  uint32_t last[2] = {0, 0};
+  for (size_t i = 0; i < count; i++) {
+    // an index reads at most 5 bytes, which the tail covers
+    if (data >= dataEnd) {
+      return false;
+    }
+    uint32_t v             = DecodeVByte(data);
+    const uint32_t current = v & 1;
+    v >>= 1;
+    const uint32_t index = last[current] + ((v >> 1) ^ (0u - (v & 1)));
+    last[current]        = index;
+    WriteIndex(destination, i, indexSize, index);
+  }
+  return data == dataEnd;
+}
+
+void DecodeMeshoptFilterOct(void* data, size_t count, size_t stride) {
+  if (stride == 4) {
+    DecodeFilterOct(static_cast<int8_t*>(data), count);
+  } else {
+    DecodeFilterOct(static_cast<int16_t*>(data), count);
+  }
+}
+
+void DecodeMeshoptFilterQuat(void* data, size_t count) {
+  const float scale = 1.0f / std::sqrt(2.0f);
+  auto* q           = static_cast<int16_t*>(data);
+  for (size_t i = 0; i < count; i++, q += 4) {
+    // the fourth component holds the scale in its upper bits and the dropped component index
+    const float s   = scale / static_cast<float>(q[3] | 3);
+    const float x   = static_cast<float>(q[0]) * s;
+    const float y   = static_cast<float>(q[1]) * s;
+    const float z   = static_cast<float>(q[2]) * s;
+    const float ww  = 1.0f - x * x - y * y - z * z;
+    const float w   = std::sqrt(ww >= 0.0f ? ww : 0.0f);
+    const int index = q[3] & 3;
+    q[(index + 1) & 3] = static_cast<int16_t>(RoundToInt(x * 32767.0f));
+    q[(index + 2) & 3] = static_cast<int16_t>(RoundToInt(y * 32767.0f));
+    q[(index + 3) & 3] = static_cast<int16_t>(RoundToInt(z * 32767.0f));
+    q[index]           = static_cast<int16_t>(RoundToInt(w * 32767.0f));
+  }
+}
+
+void DecodeMeshoptFilterExp(void* data, size_t count, size_t stride) {
+  auto* values    = static_cast<uint32_t*>(data);
+  const size_t n  = count * (stride / 4);
+  for (size_t i = 0; i < n; i++) {
+    // 24-bit signed mantissa and 8-bit signed exponent
+    const int32_t m = static_cast<int32_t>(values[i] << 8) >> 8;
+    const int32_t e = static_cast<int32_t>(values[i]) >> 24;
+    // 2^e built directly in the exponent bits, then scaled by the mantissa
+    const uint32_t bits = static_cast<uint32_t>(e + 127) << 23;
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    f *= static_cast<float>(m);
+    std::memcpy(&values[i], &f, sizeof(f));
+  }
+}
+}  // namespace photon::util
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace photon::util {
+/**
+ * Decoders for the EXT_meshopt_compression bitstreams.
+ * Reference: https://github.com/KhronosGroup/glTF/tree/main/extensions/2.0/Vendor/EXT_meshopt_compression
+ */
+
+/** ATTRIBUTES mode: byte-wise delta coded vertex data, stride must be a multiple of 4. */
+bool DecodeMeshoptVertexBuffer(void* destination, size_t count, size_t stride,
+                               const uint8_t* buffer, size_t size);
+
+/** TRIANGLES mode: edge/vertex FIFO coded triangle list of 2 or 4 byte indices. */
+bool DecodeMeshoptIndexBuffer(void* destination, size_t count, size_t indexSize,
+                              const uint8_t* buffer, size_t size);
+
+/** INDICES mode: delta coded index sequence of 2 or 4 byte indices. */
+bool DecodeMeshoptIndexSequence(void* destination, size_t count, size_t indexSize,
+                                const uint8_t* buffer, size_t size);
+
+/** OCTAHEDRAL filter, in place on 4 or 8 byte elements. */
+void DecodeMeshoptFilterOct(void* data, size_t count, size_t stride);
+
+/** QUATERNION filter, in place on 8 byte elements. */
+void DecodeMeshoptFilterQuat(void* data, size_t count);
+
+/** EXPONENTIAL filter, in place on 32-bit components. */
+void DecodeMeshoptFilterExp(void* data, size_t count, size_t stride);
+}  // namespace photon::util
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Assets/Material.hpp"
+#include "Assets/Texture.hpp"
+#include "Common/Base.hpp"
+#include "Renderer/AABB.hpp"
+#include "Renderer/MeshInstance.hpp"
+#include "Renderer/MeshLod.hpp"
+#include "Renderer/Meshlet.hpp"
+#include "Renderer/Vertex.hpp"
+#include "TextureBaker.hpp"
+
+namespace photon::util {
+class MappedFile;
+
+constexpr int NumPBRComponents = 5;
+
+/** A texture before it has a GL object: an image file, decoded pixels, or both. */
+struct TextureSource {
+  // image file, empty for images embedded in the model
+  std::string path{};
+  asset::TextureInfo info{};
+  std::vector<unsigned char> pixels{};
+  // pixels inside a mapped mesh cache, used instead of the vector when set
+  std::span<const unsigned char> mappedPixels{};
+  // block-compressed mip chain inside the pixels, empty for plain pixels
+  std::vector<asset::TextureLevel> levels{};
+  // hash of the uploaded contents and sampler state, 0 until computed
+  uint64_t contentHash{0};
+  // what the texels are sampled as, which decides the format a file is decoded into
+  TextureUsage usage{TextureUsage::Color};
+
+  [[nodiscard]] std::span<const unsigned char> GetPixels() const {
+    return mappedPixels.empty() ? std::span<const unsigned char>(pixels) : mappedPixels;
+  }
+};
+
+/** One mesh before upload, material textures are indices into ModelSource::textures. */
+struct MeshSource {
+  // what the decoder works on, dropped once packed
+  std::vector<Vertex> vertices;
+  // the vertices the way they are uploaded, and how to turn them back into values
+  std::vector<PackedVertex> packedVertices;
+  VertexQuantization quantization;
+  // every level of detail, one after the other
+  std::vector<uint32_t> indices;
+  std::vector<MeshLod> lods;
+  // clusters of the full level of detail
+  std::vector<Meshlet> meshlets;
+  // blobs inside a mapped mesh cache, used instead of the vectors when set
+  std::span<const PackedVertex> mappedVertices;
+  std::span<const uint32_t> mappedIndices;
+  // factors only, the texture map stays empty
+  asset::PBRMaterial material;
+  std::array<int32_t, NumPBRComponents> textures{-1, -1, -1, -1, -1};
+
+  [[nodiscard]] std::span<const PackedVertex> GetVertices() const {
+    return mappedVertices.empty() ? std::span<const PackedVertex>(packedVertices) : mappedVertices;
+  }
+  [[nodiscard]] std::span<const uint32_t> GetIndices() const {
+    return mappedIndices.empty() ? std::span<const uint32_t>(indices) : mappedIndices;
+  }
+
+  /** Fill in the texture map of target from the GL textures created for ModelSource::textures. */
+  void BindTextures(std::span<const Ref<asset::Texture2D>> created,
+                    asset::PBRMaterial& target) const {
+    for (int c = 0; c < NumPBRComponents; c++) {
+      const auto index = textures[c];
+      if (index >= 0 && index < static_cast<int32_t>(created.size()) && created[index]) {
+        target.textures[static_cast<asset::PBRComponent>(c)] = created[index];
+      }
+    }
+  }
+};
+
+/**
+ * CPU-side description of a model. Decoding one touches no GL state, so it can happen on a worker
+ * thread; the GL objects are created from it later, and it is what gets baked into a mesh cache.
+ */
+struct ModelSource {
+  std::string name;
+  std::vector<MeshSource> meshes;
+  // placements of the meshes, a mesh placed by several nodes is stored once
+  std::vector<MeshInstance> instances;
+  std::vector<TextureSource> textures;
+  AABB aabb{};
+  // keeps the mapped spans alive
+  Ref<MappedFile> mapping;
+};
+}  // namespace photon::util
@@ -0,0 +1,234 @@
+#include "Utils/ObjUtils.hpp"
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include "Common/Logging.hpp"
+#include "ThreadPool.hpp"
+
+namespace photon::util {
+namespace {
+// chunks smaller than this are not worth a job of their own
+constexpr size_t MinChunkSize = 1 << 20;
+
+// 1-based OBJ indices, 0 means the attribute is absent
+struct ObjCorner {
+  uint32_t position{0};
+  uint32_t uv{0};
+  uint32_t normal{0};
+};
+
+struct ObjChunk {
+  const char* begin{nullptr};
+  const char* end{nullptr};
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec2> uvs;
+  std::vector<glm::vec3> normals;
+  std::vector<ObjCorner> corners;
+  glm::vec3 bboxMin{std::numeric_limits<float>::max()};
+  glm::vec3 bboxMax{std::numeric_limits<float>::lowest()};
+  bool valid{true};
+};
+
+inline bool IsBlank(char c) {
+  return c == ' ' || c == '\t';
+}
+
+inline bool IsLineEnd(char c) {
+  return c == '\n' || c == '\r' || c == '#';
+}
+
+inline const char* SkipBlanks(const char* p, const char* end) {
+  while (p < end && IsBlank(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+inline const char* SkipLine(const char* p, const char* end) {
+  while (p < end && *p != '\n') {
+    ++p;
+  }
+  return p < end ? p + 1 : end;
+}
+
+inline const char* ParseFloat(const char* p, const char* end, float& value) {
+  p = SkipBlanks(p, end);
+  if (p < end && *p == '+') {
+    ++p;
+  }
+  value          = 0.0f;
+  auto [ptr, ec] = std::from_chars(p, end, value);
+  // denormals underflow to zero instead of failing the whole record
+  return ec == std::errc() || ec == std::errc::result_out_of_range ? ptr : nullptr;
+}
+
+template <int N>
+inline const char* ParseFloats(const char* p, const char* end, glm::vec<N, float>& value) {
+  for (int i = 0; i < N && p != nullptr; i++) {
+    p = ParseFloat(p, end, value[i]);
+  }
+  return p;
+}
+
+inline const char* ParseIndex(const char* p, const char* end, uint32_t& value) {
+  auto [ptr, ec] = std::from_chars(p, end, value);
+  return ec == std::errc() ? ptr : nullptr;
+}
+
+// v, v/vt, v//vn or v/vt/vn
+const char* ParseCorner(const char* p, const char* end, ObjCorner& corner) {
+  p = ParseIndex(p, end, corner.position);
+  if (p == nullptr || p == end || *p != '/') {
+    return p;
+  }
+  ++p;
+  if (p < end && *p != '/') {
+    p = ParseIndex(p, end, corner.uv);
+    if (p == nullptr || p == end || *p != '/') {
+      return p;
+    }
+  }
+  ++p;
+  return ParseIndex(p, end, corner.normal);
+}
+
+const char* ParseFace(const char* p, const char* end, ObjChunk& chunk) {
+  ObjCorner polygon[3];
+  int numCorners = 0;
+  while (true) {
+    p = SkipBlanks(p, end);
+    if (p == end || IsLineEnd(*p)) {
+      break;
+    }
+    ObjCorner corner{};
+    p = ParseCorner(p, end, corner);
+    if (p == nullptr) {
+      return nullptr;
+    }
+    if (numCorners < 2) {
+      polygon[numCorners] = corner;
+    } else {
+      // fan triangulation: (0, i - 1, i)
+      if (numCorners > 2) {
+        polygon[1] = polygon[2];
+      }
+      polygon[2] = corner;
+      chunk.corners.insert(chunk.corners.end(), std::begin(polygon), std::end(polygon));
+    }
+    numCorners++;
+  }
+  return p;
+}
+
+void ParseChunk(ObjChunk& chunk) {
+  const char* p   = chunk.begin;
+  const char* end = chunk.end;
+  // rough guess of one face corner per 12 bytes to avoid most regrowth
+  chunk.corners.reserve((end - p) / 12);
+  while (p < end) {
+    p = SkipBlanks(p, end);
+    if (end - p > 2 && p[0] == 'v' && IsBlank(p[1])) {
+      glm::vec3 position;
+      p = ParseFloats(p + 1, end, position);
+      chunk.positions.push_back(position);
+    } else if (end - p > 3 && p[0] == 'v' && p[1] == 't' && IsBlank(p[2])) {
+      glm::vec2 uv;
+      p = ParseFloats(p + 2, end, uv);
+      chunk.uvs.push_back(uv);
+    } else if (end - p > 3 && p[0] == 'v' && p[1] == 'n' && IsBlank(p[2])) {
+      glm::vec3 normal;
+      p = ParseFloats(p + 2, end, normal);
+      chunk.normals.push_back(normal);
+    } else if (end - p > 2 && p[0] == 'f' && IsBlank(p[1])) {
+      p = ParseFace(p + 1, end, chunk);
+    }
+    if (p == nullptr) {
+      chunk.valid = false;
+      return;
+    }
+    p = SkipLine(p, end);
+  }
+}
+}  // namespace
+
+bool ParseObjBuffer(const char* data, size_t size, std::vector<Vertex>& vertices,
+                    glm::vec3& bboxMin, glm::vec3& bboxMax) {
+  // the workers and the calling thread, which is often a worker decoding the model itself
+  auto& pool             = ThreadPool::GetShared();
+  const size_t numChunks = std::clamp<size_t>(size / MinChunkSize, 1, pool.GetNumThreads() + 1);
+
+  // split at line boundaries so no record straddles two chunks
+  std::vector<ObjChunk> chunks(numChunks);
+  const char* end    = data + size;
+  const char* cursor = data;
+  for (size_t i = 0; i < numChunks; i++) {
+    const char* chunkEnd = end;
+    if (i + 1 < numChunks) {
+      chunkEnd = SkipLine(std::max(cursor, data + size * (i + 1) / numChunks), end);
+    }
+    chunks[i].begin = cursor;
+    chunks[i].end   = chunkEnd;
+    cursor          = chunkEnd;
+  }
+  pool.ParallelFor(numChunks, [&](size_t i) { ParseChunk(chunks[i]); });
+
+  // merge attributes in file order, OBJ indices are global across the file
+  size_t numPositions = 0, numUvs = 0, numNormals = 0, numCorners = 0;
+  std::vector<size_t> cornerOffsets(numChunks);
+  for (size_t i = 0; i < numChunks; i++) {
+    if (!chunks[i].valid) {
+      LOGE("Malformed OBJ record");
+      return false;
+    }
+    numPositions += chunks[i].positions.size();
+    numUvs += chunks[i].uvs.size();
+    numNormals += chunks[i].normals.size();
+    cornerOffsets[i] = numCorners;
+    numCorners += chunks[i].corners.size();
+  }
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec2> uvs;
+  std::vector<glm::vec3> normals;
+  positions.reserve(numPositions);
+  uvs.reserve(numUvs);
+  normals.reserve(numNormals);
+  for (const auto& chunk : chunks) {
+    positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+    uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+    normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+  }
+
+  // expand face corners into vertices, each chunk writes its own slice
+  vertices.resize(numCorners);
+  pool.ParallelFor(numChunks, [&](size_t i) {
+    auto& chunk = chunks[i];
+    auto* dst   = vertices.data() + cornerOffsets[i];
+    for (const auto& corner : chunk.corners) {
+      if (corner.position == 0 || corner.position > numPositions || corner.uv > numUvs ||
+          corner.normal > numNormals) {
+        chunk.valid = false;
+        return;
+      }
+      const auto& position = positions[corner.position - 1];
+      const auto uv        = corner.uv != 0 ? uvs[corner.uv - 1] : glm::vec2(0.0f);
+      const auto normal    = corner.normal != 0 ? normals[corner.normal - 1] : glm::vec3(0.0f);
+      chunk.bboxMin        = glm::min(chunk.bboxMin, position);
+      chunk.bboxMax        = glm::max(chunk.bboxMax, position);
+      *dst++               = Vertex(position, uv, normal);
+    }
+  });
+
+  bboxMin = glm::vec3(std::numeric_limits<float>::max());
+  bboxMax = glm::vec3(std::numeric_limits<float>::lowest());
+  for (const auto& chunk : chunks) {
+    if (!chunk.valid) {
+      LOGE("OBJ face index out of range");
+      vertices.clear();
+      return false;
+    }
+    bboxMin = glm::min(bboxMin, chunk.bboxMin);
+    bboxMax = glm::max(bboxMax, chunk.bboxMax);
+  }
+  return true;
+}
+}  // namespace photon::util
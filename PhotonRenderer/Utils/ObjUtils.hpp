@@ -0,0 +1,16 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "Renderer/Vertex.hpp"
+
+namespace photon::util {
+
+/**
+ * Parse the v/vt/vn/f records of an in-memory Wavefront OBJ file into one vertex per face corner.
+ * The buffer is split into line-aligned chunks which are parsed in parallel and merged in order,
+ * so the result is identical to a sequential parse. Polygons are fan-triangulated.
+ */
+bool ParseObjBuffer(const char* data, size_t size, std::vector<Vertex>& vertices,
+                    glm::vec3& bboxMin, glm::vec3& bboxMax);
+}  // namespace photon::util
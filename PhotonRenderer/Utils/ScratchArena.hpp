@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+#include "Common/Base.hpp"
+#include "Common/Logging.hpp"
+
+namespace photon::util {
+/**
+ * Vectors for the temporaries of one call, lent from a pool of the calling thread and handed back
+ * with their capacity when the arena goes out of scope. Processing mesh after mesh then allocates
+ * only when a mesh needs more room than the ones before it.
+ */
+class ScratchArena {
+public:
+  ScratchArena() = default;
+  ScratchArena(const ScratchArena&)            = delete;
+  ScratchArena& operator=(const ScratchArena&) = delete;
+  ~ScratchArena() {
+    for (auto i = m_numLeases; i-- > 0;) {
+      m_leases[i].release(m_leases[i].vector);
+    }
+  }
+
+  /** An empty vector, or one filled like std::vector::assign(args...). */
+  template <typename T, typename... Args>
+  [[nodiscard]] std::vector<T>& Vector(Args&&... args) {
+    if (m_numLeases == MaxLeases) {
+      // the vector would be lost to the arena, in release builds as much as in debug ones
+      LOGE("Scratch arena ran out of its {} leases", MaxLeases);
+      std::abort();
+    }
+    auto& pool = GetPool<T>();
+    Unique<std::vector<T>> vector;
+    if (pool.empty()) {
+      vector = CreateUnique<std::vector<T>>();
+    } else {
+      vector = std::move(pool.back());
+      pool.pop_back();
+    }
+    if constexpr (sizeof...(Args) > 0) {
+      vector->assign(std::forward<Args>(args)...);
+    }
+    m_leases[m_numLeases++] = {vector.get(), &Release<T>};
+    return *vector.release();
+  }
+
+private:
+  // vectors one arena lends at most, a user taking more is a bug
+  static constexpr size_t MaxLeases = 32;
+  // anything bigger is freed on return, so one huge mesh does not pin its memory to the thread
+  static constexpr size_t MaxRetainedBytes = size_t{64} << 20;
+
+  struct Lease {
+    void* vector;
+    void (*release)(void*);
+  };
+
+  template <typename T>
+  static std::vector<Unique<std::vector<T>>>& GetPool() {
+    thread_local std::vector<Unique<std::vector<T>>> pool;
+    return pool;
+  }
+
+  template <typename T>
+  static void Release(void* lent) {
+    Unique<std::vector<T>> vector(static_cast<std::vector<T>*>(lent));
+    vector->clear();
+    if (vector->capacity() * sizeof(T) > MaxRetainedBytes) {
+      vector->shrink_to_fit();
+    }
+    GetPool<T>().push_back(std::move(vector));
+  }
+
+  std::array<Lease, MaxLeases> m_leases{};
+  size_t m_numLeases{0};
+};
+}  // namespace photon::util
@@ -0,0 +1,216 @@
+#include "TextureBaker.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "ModelSource.hpp"
+
+namespace photon::util {
+namespace {
+const std::array<float, 256>& GetSRGBToLinearTable() {
+  static const auto table = [] {
+    std::array<float, 256> values{};
+    for (int i = 0; i < 256; i++) {
+      const float c = i / 255.0f;
+      values[i]     = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+    return values;
+  }();
+  return table;
+}
+
+uint8_t LinearToSRGB(float linear) {
+  const float c = linear <= 0.0031308f ? linear * 12.92f
+                                       : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+  return static_cast<uint8_t>(std::clamp(std::lround(c * 255.0f), 0l, 255l));
+}
+
+uint8_t ToUnorm8(float value) {
+  return static_cast<uint8_t>(std::clamp(std::lround(value * 255.0f), 0l, 255l));
+}
+
+// one level down: every texel averages the 2x2 texels above it, clamped at odd edges
+void Downsample(const uint8_t* source, int width, int height, TextureUsage usage,
+                uint8_t* destination) {
+  const auto& toLinear = GetSRGBToLinearTable();
+  const int nextWidth  = std::max(width / 2, 1);
+  const int nextHeight = std::max(height / 2, 1);
+  for (int y = 0; y < nextHeight; y++) {
+    for (int x = 0; x < nextWidth; x++) {
+      const int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+      const int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+      const uint8_t* texels[4] = {source + (static_cast<size_t>(y0) * width + x0) * 4,
+                                  source + (static_cast<size_t>(y0) * width + x1) * 4,
+                                  source + (static_cast<size_t>(y1) * width + x0) * 4,
+                                  source + (static_cast<size_t>(y1) * width + x1) * 4};
+      float sum[4]{};
+      for (const auto* texel : texels) {
+        for (int c = 0; c < 4; c++) {
+          // averaging sRGB values directly would darken every level
+          const bool isSRGB = usage == TextureUsage::Color && c < 3;
+          sum[c] += isSRGB ? toLinear[texel[c]] : texel[c] / 255.0f;
+        }
+      }
+      auto* out = destination + (static_cast<size_t>(y) * nextWidth + x) * 4;
+      if (usage == TextureUsage::Normal) {
+        // keep the averaged normal unit length, short normals would flatten the lighting
+        float normal[3];
+        for (int c = 0; c < 3; c++) {
+          normal[c] = sum[c] / 4.0f * 2.0f - 1.0f;
+        }
+        const float length =
+            std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        for (int c = 0; c < 3; c++) {
+          const float unit = length > 0.0f ? normal[c] / length : (c == 2 ? 1.0f : 0.0f);
+          out[c]           = ToUnorm8(unit * 0.5f + 0.5f);
+        }
+        out[3] = ToUnorm8(sum[3] / 4.0f);
+        continue;
+      }
+      for (int c = 0; c < 4; c++) {
+        const bool isSRGB = usage == TextureUsage::Color && c < 3;
+        out[c]            = isSRGB ? LinearToSRGB(sum[c] / 4.0f) : ToUnorm8(sum[c] / 4.0f);
+      }
+    }
+  }
+}
+
+// EXT_texture_shared_exponent, with the exponents read from the bits rather than with log2
+uint32_t PackRGB9E5Texel(const float* rgb) {
+  constexpr float MaxValue = 65408.0f;  // (511 / 512) * 2^16
+  float channels[3];
+  for (int c = 0; c < 3; c++) {
+    // negative values and NaN become 0
+    channels[c] = rgb[c] > 0.0f ? std::min(rgb[c], MaxValue) : 0.0f;
+  }
+  const float maxChannel = std::max({channels[0], channels[1], channels[2]});
+  const int maxExponent  = static_cast<int>(std::bit_cast<uint32_t>(maxChannel) >> 23) - 127;
+  int sharedExponent     = std::max(maxExponent, -16) + 16;
+  // 2^(9 - 1 - exponent), which turns the largest channel into a 9-bit mantissa
+  auto scale = std::bit_cast<float>(static_cast<uint32_t>(127 + 24 - sharedExponent) << 23);
+  if (static_cast<uint32_t>(maxChannel * scale + 0.5f) == 512) {
+    sharedExponent++;
+    scale *= 0.5f;
+  }
+  uint32_t texel = static_cast<uint32_t>(sharedExponent) << 27;
+  for (int c = 0; c < 3; c++) {
+    texel |= static_cast<uint32_t>(channels[c] * scale + 0.5f) << (9 * c);
+  }
+  return texel;
+}
+
+bool HasAlpha(const std::vector<uint8_t>& rgba) {
+  for (size_t i = 3; i < rgba.size(); i += 4) {
+    if (rgba[i] != 255) {
+      return true;
+    }
+  }
+  return false;
+}
+}  // namespace
+
+BlockFormat ChooseBlockFormat(TextureUsage usage, bool hasAlpha) {
+  switch (usage) {
+    case TextureUsage::Color:
+      return hasAlpha ? BlockFormat::BC3 : BlockFormat::BC1;
+    case TextureUsage::Normal:
+      return BlockFormat::BC5;
+    case TextureUsage::Occlusion:
+      return BlockFormat::BC4;
+    default:
+      return BlockFormat::BC7;
+  }
+}
+
+GLenum GetCompressedFormat(BlockFormat format, bool srgb) {
+  switch (format) {
+    case BlockFormat::BC1:
+      return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case BlockFormat::BC3:
+      return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case BlockFormat::BC4:
+      return GL_COMPRESSED_RED_RGTC1;
+    case BlockFormat::BC5:
+      return GL_COMPRESSED_RG_RGTC2;
+    default:
+      return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+  }
+}
+
+GLenum GetUncompressedFormat(TextureUsage usage) {
+  return usage == TextureUsage::Color ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+}
+
+void PackRGB9E5(const float* rgb, size_t numTexels, uint32_t* packed) {
+  for (size_t i = 0; i < numTexels; i++) {
+    packed[i] = PackRGB9E5Texel(rgb + i * 3);
+  }
+}
+
+void PackR11G11B10F(const float* rgb, size_t numTexels, uint32_t* packed) {
+  for (size_t i = 0; i < numTexels; i++) {
+    packed[i] = glm::packF2x11_1x10(glm::make_vec3(rgb + i * 3));
+  }
+}
+
+int GetMipmapFilter(int minFilter) {
+  switch (minFilter) {
+    case GL_LINEAR:
+      return GL_LINEAR_MIPMAP_LINEAR;
+    case GL_NEAREST:
+      return GL_NEAREST_MIPMAP_NEAREST;
+    default:
+      return minFilter;
+  }
+}
+
+void BuildMipChain(const uint8_t* rgba, int width, int height, TextureUsage usage,
+                   std::vector<std::vector<uint8_t>>& levels) {
+  levels.clear();
+  levels.emplace_back(rgba, rgba + static_cast<size_t>(width) * height * 4);
+  while (width > 1 || height > 1) {
+    const int nextWidth  = std::max(width / 2, 1);
+    const int nextHeight = std::max(height / 2, 1);
+    std::vector<uint8_t> next(static_cast<size_t>(nextWidth) * nextHeight * 4);
+    Downsample(levels.back().data(), width, height, usage, next.data());
+    levels.push_back(std::move(next));
+    width  = nextWidth;
+    height = nextHeight;
+  }
+}
+
+bool BakeTexture(const TextureSource& image, TextureUsage usage, TextureSource& baked) {
+  const auto pixels = image.GetPixels();
+  const int width   = image.info.width;
+  const int height  = image.info.height;
+  if (image.info.dataFormat != GL_RGBA || image.info.dataType != GL_UNSIGNED_BYTE || width <= 0 ||
+      height <= 0 || pixels.size() < static_cast<size_t>(width) * height * 4) {
+    return false;
+  }
+  std::vector<std::vector<uint8_t>> mips;
+  BuildMipChain(pixels.data(), width, height, usage, mips);
+  const auto format = ChooseBlockFormat(usage, HasAlpha(mips.front()));
+
+  baked.path = image.path;
+  baked.info = image.info;
+  baked.pixels.clear();
+  baked.mappedPixels = {};
+  baked.levels.clear();
+  for (size_t level = 0; level < mips.size(); level++) {
+    const int levelWidth  = std::max(width >> level, 1);
+    const int levelHeight = std::max(height >> level, 1);
+    const auto offset     = baked.pixels.size();
+    const auto size       = GetCompressedSize(format, levelWidth, levelHeight);
+    baked.pixels.resize(offset + size);
+    CompressImage(format, mips[level].data(), levelWidth, levelHeight,
+                  baked.pixels.data() + offset);
+    baked.levels.push_back({levelWidth, levelHeight, offset, size});
+  }
+  baked.info.internalFormat = GetCompressedFormat(format, usage == TextureUsage::Color);
+  baked.info.generateMipmap = false;
+  baked.info.minFilter      = GetMipmapFilter(baked.info.minFilter);
+  return true;
+}
+}  // namespace photon::util
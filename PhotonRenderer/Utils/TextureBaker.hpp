@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "BlockCompression.hpp"
+
+// EXT_texture_compression_s3tc and EXT_texture_sRGB, not part of the generated loader
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+namespace photon::util {
+struct TextureSource;
+
+/** What the texels of a texture mean, which decides how it is filtered and compressed. */
+enum class TextureUsage {
+  // sRGB encoded color: decoded by the sampler, BC1 when opaque and BC3 otherwise
+  Color,
+  // linear values in every channel such as metallic-roughness: BC7
+  Data,
+  // tangent space normals in red and green, blue is rebuilt in the shader: BC5
+  Normal,
+  // a single linear channel in red: BC4
+  Occlusion,
+};
+
+BlockFormat ChooseBlockFormat(TextureUsage usage, bool hasAlpha);
+
+/** The internal format, with srgb the sampler decodes to linear light before filtering. */
+GLenum GetCompressedFormat(BlockFormat format, bool srgb);
+
+/** The internal format for 8-bit RGBA pixels that are uploaded without compression. */
+GLenum GetUncompressedFormat(TextureUsage usage);
+
+/** GL_RGB9_E5 texels, three 9-bit mantissas sharing a 5-bit exponent, from 32-bit float RGB. */
+void PackRGB9E5(const float* rgb, size_t numTexels, uint32_t* packed);
+
+/** GL_R11F_G11F_B10F texels, unsigned floats with an exponent per channel, from float RGB. */
+void PackR11G11B10F(const float* rgb, size_t numTexels, uint32_t* packed);
+
+/** The minification filter that also reads the mip chain, mipmap filters are kept. */
+int GetMipmapFilter(int minFilter);
+
+/** Each level halves the previous one with a 2x2 box filter, level 0 is the image itself. */
+void BuildMipChain(const uint8_t* rgba, int width, int height, TextureUsage usage,
+                   std::vector<std::vector<uint8_t>>& levels);
+
+/**
+ * Turn 8-bit RGBA pixels into a compressed texture with a full mip chain: baked.pixels holds every
+ * level back to back and baked.levels says where. The sampler state is kept, with the minification
+ * filter switched to one that reads the mip chain.
+ */
+bool BakeTexture(const TextureSource& image, TextureUsage usage, TextureSource& baked);
+}  // namespace photon::util
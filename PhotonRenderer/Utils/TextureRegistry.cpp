@@ -0,0 +1,177 @@
+#include "TextureRegistry.hpp"
+#include <algorithm>
+#include "AssetLoader.hpp"
+#include "Assets/Texture.hpp"
+#include "MeshCache.hpp"
+#include "ModelSource.hpp"
+#include "TextureBaker.hpp"
+#include "TextureResidency.hpp"
+
+namespace photon::util {
+TextureRegistry& TextureRegistry::GetShared() {
+  static TextureRegistry registry;
+  return registry;
+}
+
+uint64_t TextureRegistry::ComputeContentHash(const TextureSource& texture) {
+  const auto pixels = texture.GetPixels();
+  if (pixels.empty()) {
+    return 0;
+  }
+  // the sampler state lives in the texture object, the same pixels sampled differently are not
+  // interchangeable
+  const auto& info       = texture.info;
+  const int64_t layout[] = {info.width,
+                            info.height,
+                            info.minFilter,
+                            info.magFilter,
+                            info.wrapS,
+                            info.wrapT,
+                            info.wrapR,
+                            info.generateMipmap,
+                            info.internalFormat,
+                            info.dataFormat,
+                            info.dataType,
+                            static_cast<int64_t>(texture.levels.size())};
+
+  const uint64_t seed = HashBytes(layout, sizeof(layout));
+  const uint64_t hash =
+      seed ^ (HashBytes(pixels.data(), pixels.size()) + 0x9e3779b97f4a7c15ull + (seed << 6) +
+              (seed >> 2));
+  // 0 means not computed
+  return hash != 0 ? hash : 1;
+}
+
+Ref<Texture2D> TextureRegistry::Find(const TextureSource& texture) {
+  const auto contentHash =
+      texture.contentHash != 0 ? texture.contentHash : ComputeContentHash(texture);
+  std::lock_guard lock(m_mutex);
+  return FindLocked(texture, contentHash);
+}
+
+Ref<Texture2D> TextureRegistry::Acquire(const TextureSource& texture) {
+  const auto contentHash =
+      texture.contentHash != 0 ? texture.contentHash : ComputeContentHash(texture);
+  {
+    std::lock_guard lock(m_mutex);
+    if (auto shared = FindLocked(texture, contentHash)) {
+      return shared;
+    }
+  }
+  // uploaded unlocked, so decoders calling Find do not wait on the driver
+  auto created = AssetLoader::CreateTexture(texture);
+  if (created == nullptr) {
+    return nullptr;
+  }
+  std::lock_guard lock(m_mutex);
+  // published by another caller during the upload, the first one is shared and this one dropped
+  if (auto shared = FindLocked(texture, contentHash)) {
+    return shared;
+  }
+  m_stats.uploads++;
+  m_stats.uploadedBytes += created->GetMemorySize();
+  RegisterLocked(texture, contentHash, created);
+  TextureResidency::GetShared().Track(created, texture);
+  return created;
+}
+
+void TextureRegistry::Register(const TextureSource& source, const Ref<Texture2D>& texture) {
+  const auto contentHash =
+      source.contentHash != 0 ? source.contentHash : ComputeContentHash(source);
+  std::lock_guard lock(m_mutex);
+  m_stats.uploads++;
+  m_stats.uploadedBytes += texture->GetMemorySize();
+  RegisterLocked(source, contentHash, texture);
+  TextureResidency::GetShared().Track(texture, source);
+}
+
+Ref<Texture2D> TextureRegistry::GetDefaultWhite() {
+  TextureSource texture{.path = DefaultWhitePath};
+  if (auto white = Find(texture)) {
+    return white;
+  }
+  if (!AssetLoader::DecodeImage(texture)) {
+    return nullptr;
+  }
+  return Acquire(texture);
+}
+
+TextureRegistryStats TextureRegistry::GetStats() {
+  std::lock_guard lock(m_mutex);
+  return m_stats;
+}
+
+TextureRegistry::PathEntry TextureRegistry::MakePathEntry(const TextureSource& source,
+                                                          const Ref<Texture2D>& texture) {
+  const auto& info = source.info;
+  return {source.usage, info.minFilter, info.magFilter, info.wrapS, info.wrapT, info.wrapR,
+          texture};
+}
+
+bool TextureRegistry::SamplesAlike(const PathEntry& entry, const TextureSource& source) {
+  const auto& info = source.info;
+  // a baked file has the mipmapped form of the filter it was asked for
+  return entry.usage == source.usage &&
+         GetMipmapFilter(entry.minFilter) == GetMipmapFilter(info.minFilter) &&
+         entry.magFilter == info.magFilter && entry.wrapS == info.wrapS &&
+         entry.wrapT == info.wrapT && entry.wrapR == info.wrapR;
+}
+
+Ref<Texture2D> TextureRegistry::FindLocked(const TextureSource& texture, uint64_t contentHash) {
+  Ref<Texture2D> shared;
+  if (!texture.path.empty()) {
+    if (const auto it = m_byPath.find(texture.path); it != m_byPath.end()) {
+      auto& entries = it->second;
+      std::erase_if(entries, [](const PathEntry& entry) { return entry.texture.expired(); });
+      for (const auto& entry : entries) {
+        if (SamplesAlike(entry, texture)) {
+          shared = entry.texture.lock();
+          break;
+        }
+      }
+      if (entries.empty()) {
+        m_byPath.erase(it);
+      }
+      if (shared != nullptr) {
+        m_stats.pathHits++;
+      }
+    }
+  }
+  if (shared == nullptr && contentHash != 0) {
+    if (const auto it = m_byContent.find(contentHash); it != m_byContent.end()) {
+      shared = it->second.lock();
+      if (shared == nullptr) {
+        m_byContent.erase(it);
+      } else {
+        // another file with the same image, found under its own path from now on
+        m_stats.contentHits++;
+        if (!texture.path.empty()) {
+          m_byPath[texture.path].push_back(MakePathEntry(texture, shared));
+        }
+      }
+    }
+  }
+  if (shared != nullptr) {
+    m_stats.sharedBytes += shared->GetMemorySize();
+  }
+  return shared;
+}
+
+void TextureRegistry::RegisterLocked(const TextureSource& source, uint64_t contentHash,
+                                     const Ref<Texture2D>& texture) {
+  if (!source.path.empty()) {
+    auto& entries = m_byPath[source.path];
+    const auto it = std::find_if(entries.begin(), entries.end(), [&](const PathEntry& entry) {
+      return SamplesAlike(entry, source);
+    });
+    if (it != entries.end()) {
+      *it = MakePathEntry(source, texture);
+    } else {
+      entries.push_back(MakePathEntry(source, texture));
+    }
+  }
+  if (contentHash != 0) {
+    m_byContent[contentHash] = texture;
+  }
+}
+}  // namespace photon::util
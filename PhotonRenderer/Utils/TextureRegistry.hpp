@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Common/Base.hpp"
+namespace photon::asset {
+class Texture2D;
+}
+using photon::asset::Texture2D;
+namespace photon::util {
+struct TextureSource;
+enum class TextureUsage;
+
+struct TextureRegistryStats {
+  uint32_t uploads{0};
+  // requests answered with a live texture, by file path or by identical contents
+  uint32_t pathHits{0};
+  uint32_t contentHits{0};
+  uint64_t uploadedBytes{0};
+  // video memory the hits would have taken as separate textures
+  uint64_t sharedBytes{0};
+};
+
+/**
+ * Textures shared by every model, cache and renderer, keyed by image file and by a hash of their
+ * contents, so an image is decoded and uploaded once however many materials use it. A file is only
+ * shared with loads that sample it alike: the same usage, which decides its format, and the same
+ * filters and wrap modes. Entries do not keep textures alive: a texture goes away with the last
+ * material holding it.
+ */
+class TextureRegistry {
+public:
+  static constexpr const char* DefaultWhitePath = "Data/Textures/white.png";
+
+  static TextureRegistry& GetShared();
+
+  /** Hash of what Acquire uploads for texture, pixels and sampler state. */
+  static uint64_t ComputeContentHash(const TextureSource& texture);
+
+  /**
+   * The live texture with the path and sampling or the contents of texture, if any. Thread safe,
+   * decoders use it to skip files before they have pixels.
+   */
+  Ref<Texture2D> Find(const TextureSource& texture);
+  /**
+   * Share a live texture with the path or contents of texture, or upload it and hand it to
+   * TextureResidency. GL thread only.
+   */
+  Ref<Texture2D> Acquire(const TextureSource& texture);
+  /** Make a texture uploaded elsewhere, like by the streaming stage, available for sharing. */
+  void Register(const TextureSource& source, const Ref<Texture2D>& texture);
+  /** The white texture standing in for missing maps, loaded once. GL thread only. */
+  Ref<Texture2D> GetDefaultWhite();
+
+  [[nodiscard]] TextureRegistryStats GetStats();
+
+private:
+  /** One way a file was loaded, as asked for: baking adds mipmaps but keeps the rest. */
+  struct PathEntry {
+    TextureUsage usage;
+    int minFilter;
+    int magFilter;
+    int wrapS;
+    int wrapT;
+    int wrapR;
+    std::weak_ptr<Texture2D> texture;
+  };
+  static PathEntry MakePathEntry(const TextureSource& source, const Ref<Texture2D>& texture);
+  static bool SamplesAlike(const PathEntry& entry, const TextureSource& source);
+
+  Ref<Texture2D> FindLocked(const TextureSource& texture, uint64_t contentHash);
+  void RegisterLocked(const TextureSource& source, uint64_t contentHash,
+                      const Ref<Texture2D>& texture);
+
+  std::mutex m_mutex;
+  std::unordered_map<std::string, std::vector<PathEntry>> m_byPath;
+  std::unordered_map<uint64_t, std::weak_ptr<Texture2D>> m_byContent;
+  TextureRegistryStats m_stats;
+};
+}  // namespace photon::util
@@ -0,0 +1,132 @@
+#include "TextureResidency.hpp"
+#include <algorithm>
+#include <vector>
+#include "AssetLoader.hpp"
+#include "Assets/Texture.hpp"
+#include "Common/Logging.hpp"
+#include "StopWatch.hpp"
+#include "TextureRegistry.hpp"
+
+namespace photon::util {
+namespace {
+// draws of the frames still in flight may sample textures used that recently
+constexpr uint64_t MinIdleFrames = 3;
+}  // namespace
+
+TextureResidency& TextureResidency::GetShared() {
+  static TextureResidency residency;
+  return residency;
+}
+
+void TextureResidency::Track(const Ref<Texture2D>& texture, const TextureSource& source) {
+  auto& entry         = m_entries[texture.get()];
+  entry.texture       = texture;
+  entry.source.path   = source.path;
+  entry.source.info   = source.info;
+  entry.source.levels = source.levels;
+  entry.source.usage  = source.usage;
+  entry.lastUsedFrame = m_frame;
+}
+
+GLuint64 TextureResidency::Use(const Texture2D& texture) {
+  const auto it = m_entries.find(&texture);
+  if (it == m_entries.end()) {
+    return texture.GetHandle();
+  }
+  auto& entry         = it->second;
+  entry.lastUsedFrame = m_frame;
+  if (!texture.IsResident()) {
+    if (const auto tracked = entry.texture.lock()) {
+      Reload(entry, *tracked);
+    }
+  }
+  return texture.GetHandle();
+}
+
+bool TextureResidency::Reload(Entry& entry, Texture2D& texture) {
+  StopWatch stopWatch;
+  // the usage picks the bake the levels were read from
+  TextureSource decoded{.path   = entry.source.path,
+                        .info   = entry.source.info,
+                        .levels = entry.source.levels,
+                        .usage  = entry.source.usage};
+  if (decoded.path.empty() || !AssetLoader::RedecodeImage(decoded)) {
+    LOGE("Failed to reload evicted texture {}, drawing it white", entry.source.path);
+    // not retried every frame, nor evicted again; a null handle must never reach the shaders
+    entry.source.path.clear();
+    decoded = {};
+    if (!AssetLoader::DecodeTexture(TextureRegistry::DefaultWhitePath, decoded)) {
+      return false;
+    }
+  }
+  const auto fresh = AssetLoader::CreateTexture(decoded);
+  if (fresh == nullptr) {
+    return false;
+  }
+  texture.Swap(*fresh);
+  m_reloads++;
+  m_reloadMs += stopWatch.TimeStep() * 1000.0f;
+  return true;
+}
+
+void TextureResidency::EndFrame() {
+  uint64_t residentBytes = 0;
+  std::vector<std::pair<uint64_t, Ref<Texture2D>>> candidates;
+  for (auto it = m_entries.begin(); it != m_entries.end();) {
+    auto texture = it->second.texture.lock();
+    if (texture == nullptr) {
+      it = m_entries.erase(it);
+      continue;
+    }
+    const auto& entry = it->second;
+    if (texture->IsResident()) {
+      residentBytes += texture->GetMemorySize();
+      if (!entry.source.path.empty() && entry.lastUsedFrame + MinIdleFrames <= m_frame) {
+        candidates.emplace_back(entry.lastUsedFrame, std::move(texture));
+      }
+    }
+    ++it;
+  }
+  if (residentBytes > m_budget) {
+    std::sort(candidates.begin(), candidates.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    uint32_t evicted = 0;
+    for (const auto& [lastUsedFrame, texture] : candidates) {
+      if (residentBytes <= m_budget) {
+        break;
+      }
+      residentBytes -= texture->GetMemorySize();
+      texture->Evict();
+      evicted++;
+    }
+    m_evictions += evicted;
+    if (evicted > 0) {
+      LOGI("Evicted {} textures, {:.2f} MB resident of a {:.2f} MB budget", evicted,
+           static_cast<float>(residentBytes) / (1024.0f * 1024.0f),
+           static_cast<float>(m_budget) / (1024.0f * 1024.0f));
+    }
+  }
+  m_frame++;
+}
+
+TextureResidencyStats TextureResidency::GetStats() const {
+  TextureResidencyStats stats;
+  stats.budgetBytes = m_budget;
+  stats.evictions   = m_evictions;
+  stats.reloads     = m_reloads;
+  stats.reloadMs    = m_reloadMs;
+  for (const auto& [key, entry] : m_entries) {
+    const auto texture = entry.texture.lock();
+    if (texture == nullptr) {
+      continue;
+    }
+    if (texture->IsResident()) {
+      stats.residentBytes += texture->GetMemorySize();
+      stats.residentTextures++;
+    } else {
+      stats.evictedTextures++;
+    }
+  }
+  return stats;
+}
+}  // namespace photon::util
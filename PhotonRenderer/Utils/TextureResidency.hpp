@@ -0,0 +1,65 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <unordered_map>
+#include "Common/Base.hpp"
+#include "ModelSource.hpp"
+namespace photon::asset {
+class Texture2D;
+}
+using photon::asset::Texture2D;
+namespace photon::util {
+struct TextureResidencyStats {
+  uint64_t budgetBytes{0};
+  uint64_t residentBytes{0};
+  uint32_t residentTextures{0};
+  uint32_t evictedTextures{0};
+  // since the manager was created
+  uint32_t evictions{0};
+  uint32_t reloads{0};
+  float reloadMs{0.0f};
+};
+
+/**
+ * Keeps the video memory of tracked textures within a budget. Textures are stamped with the frame
+ * they were last drawn with; at the end of a frame the least recently used ones are evicted until
+ * the rest fits, and an evicted texture is decoded from its file again the next time it is used,
+ * or drawn white when the file cannot be read any more. Textures without a file of their own, like
+ * images embedded in a model, are never evicted.
+ * GL thread only.
+ */
+class TextureResidency {
+public:
+  static constexpr uint64_t DefaultBudget = 1ull << 30;
+
+  static TextureResidency& GetShared();
+
+  /** Track a texture created from source, whose pixels are not kept. */
+  void Track(const Ref<Texture2D>& texture, const TextureSource& source);
+  /** Mark texture as used this frame, reloading it when evicted, and return its handle. */
+  GLuint64 Use(const Texture2D& texture);
+  /** Evict in least recently used order until the resident textures fit the budget. */
+  void EndFrame();
+
+  void SetBudget(uint64_t bytes) { m_budget = bytes; }
+  [[nodiscard]] uint64_t GetBudget() const { return m_budget; }
+  [[nodiscard]] TextureResidencyStats GetStats() const;
+
+private:
+  struct Entry {
+    std::weak_ptr<Texture2D> texture;
+    // everything but the pixels, enough to decode the file again
+    TextureSource source;
+    uint64_t lastUsedFrame{0};
+  };
+
+  bool Reload(Entry& entry, Texture2D& texture);
+
+  std::unordered_map<const Texture2D*, Entry> m_entries;
+  uint64_t m_budget{DefaultBudget};
+  uint64_t m_frame{0};
+  uint32_t m_evictions{0};
+  uint32_t m_reloads{0};
+  float m_reloadMs{0.0f};
+};
+}  // namespace photon::util
@@ -0,0 +1,83 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+namespace photon::util {
+ThreadPool::ThreadPool(uint32_t numThreads) {
+  if (numThreads == 0) {
+    numThreads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+  }
+  m_threads.reserve(numThreads);
+  for (uint32_t i = 0; i < numThreads; i++) {
+    m_threads.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_stopping = true;
+    m_jobs.clear();
+  }
+  m_wakeUp.notify_all();
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+}
+
+ThreadPool& ThreadPool::GetShared() {
+  static ThreadPool pool;
+  return pool;
+}
+
+void ThreadPool::Submit(std::function<void()> job) {
+  {
+    std::lock_guard lock(m_mutex);
+    m_jobs.push_back(std::move(job));
+  }
+  m_wakeUp.notify_one();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& job) {
+  std::vector<std::future<void>> futures;
+  futures.reserve(count);
+  for (size_t i = 1; i < count; i++) {
+    futures.push_back(Async([&job, i] { job(i); }));
+  }
+  if (count > 0) {
+    job(0);
+  }
+  for (auto& future : futures) {
+    Wait(future);
+  }
+}
+
+bool ThreadPool::RunPendingJob() {
+  std::function<void()> job;
+  {
+    std::lock_guard lock(m_mutex);
+    if (m_jobs.empty()) {
+      return false;
+    }
+    job = std::move(m_jobs.front());
+    m_jobs.pop_front();
+  }
+  job();
+  return true;
+}
+
+void ThreadPool::WorkerLoop() {
+  while (true) {
+    std::function<void()> job;
+    {
+      std::unique_lock lock(m_mutex);
+      m_wakeUp.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+      if (m_stopping) {
+        return;
+      }
+      job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+    }
+    job();
+  }
+}
+}  // namespace photon::util
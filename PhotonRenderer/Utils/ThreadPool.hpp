@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace photon::util {
+/**
+ * Fixed set of worker threads running queued jobs in submission order. Jobs still queued when the
+ * pool is destroyed are dropped, running ones are waited for.
+ */
+class ThreadPool {
+public:
+  /** With 0 threads, one per hardware thread is started, leaving one for the render thread. */
+  explicit ThreadPool(uint32_t numThreads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&)            = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /** Pool shared by the loaders for decoding, started on first use. */
+  static ThreadPool& GetShared();
+
+  void Submit(std::function<void()> job);
+
+  /** Submit a job whose result is collected with Wait. */
+  template <typename F>
+  auto Async(F&& job) -> std::future<std::invoke_result_t<F>> {
+    using Result = std::invoke_result_t<F>;
+    // std::function needs a copyable target
+    auto task   = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+    auto future = task->get_future();
+    Submit([task] { (*task)(); });
+    return future;
+  }
+
+  /**
+   * Block until future is ready, running queued jobs on the calling thread meanwhile. Jobs that
+   * wait on other jobs this way never hold a worker idle, so it is also safe inside a job.
+   */
+  template <typename T>
+  T Wait(std::future<T>& future) {
+    while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      // with nothing queued the job is already running on a worker
+      if (!RunPendingJob()) {
+        future.wait();
+      }
+    }
+    return future.get();
+  }
+
+  /** Run job(0) to job(count - 1) on the workers and the caller, returns when all are done. */
+  void ParallelFor(size_t count, const std::function<void(size_t)>& job);
+
+  /** Run the oldest queued job on the calling thread, false when there was none. */
+  bool RunPendingJob();
+
+  [[nodiscard]] uint32_t GetNumThreads() const { return static_cast<uint32_t>(m_threads.size()); }
+
+private:
+  void WorkerLoop();
+
+  std::vector<std::thread> m_threads;
+  std::deque<std::function<void()>> m_jobs;
+  std::mutex m_mutex;
+  std::condition_variable m_wakeUp;
+  bool m_stopping{false};
+};
+}  // namespace photon::util
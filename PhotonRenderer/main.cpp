@@ -1,10 +1,16 @@
+#include <cstring>
 #include "Engine/Engine.hpp"
+#include "Utils/Benchmark.hpp"
 
 extern "C" {
 __declspec(dllexport) unsigned long NvOptimusEnablement = 0x00000001;
 }
 
-int main() {
+int main(int argc, char** argv) {
+  if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0) {
+    photon::util::RunBenchmarks();
+    return 0;
+  }
   photon::Engine engine;
   engine.Initialize("SimpleScene");
   engine.Run();